@@ -42,6 +42,18 @@ extern "C" {
 // local wrapper
 void aes_128_ctr(unsigned char *key, size_t length, unsigned char nonce_counter[16], const unsigned char *input, unsigned char *output);
 
+// an expanded key, for anything that uses the same key for many aes_128_ctr_key() calls
+typedef struct aes_128_key_struct
+{
+  uint32_t rk[44]; // round keys, the same bytes for the table and AES-NI paths
+} *aes_128_key_t;
+
+void aes_128_setkey(aes_128_key_t key, const unsigned char raw[16]);
+void aes_128_ctr_key(aes_128_key_t key, size_t length, unsigned char nonce_counter[16], const unsigned char *input, unsigned char *output);
+
+// x86 AES-NI is used whenever the cpu has it, this turns it off (0) or back on, returns if it's in use
+uint8_t aes_128_hw(uint8_t enable);
+
 /**
  * \brief          AES context structure
  *
@@ -10,6 +10,10 @@ extern "C" {
 // a convert-in-place utility
 uint8_t *chacha20(uint8_t *key, uint8_t *nonce, uint8_t *bytes, uint32_t len);
 
+// limit the vector paths for testing/benchmarking: 2 allows AVX2 (the default), 1 only SSE2, 0 is all scalar
+// returns the level actually in use on this cpu
+uint8_t chacha20_hw(uint8_t level);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -5,23 +5,59 @@
 
 enum chan_states { CHAN_ENDED, CHAN_OPENING, CHAN_OPEN };
 
+// reliable channel defaults
+#ifndef CHAN_WINDOW
+#define CHAN_WINDOW 65536 // bytes in flight, held out of order, and advertised for the other side to send
+#endif
+#ifndef CHAN_RESEND
+#define CHAN_RESEND 2 // unacked packets are sent again after this long (in the link's clock units), doubling each time
+#endif
+#ifndef CHAN_RESEND_MS
+#define CHAN_RESEND_MS 200 // the same on a mesh_clock(), which is in ms
+#endif
+#define CHAN_RETRIES 8 // resends w/o the ack moving before the channel errors
+#define CHAN_MISS 32 // most gaps listed in one ack
+
 // standalone channel packet management, buffering and ordering
 // internal only structure, always use accessors
 struct chan_struct
 {
   link_t link; // so channels can be first-class
-  chan_t next; // links keep lists
   uint32_t id; // wire id (not unique)
   char *type;
   lob_t in;
+  uint32_t buffered, queued; // bytes in in/reorder and in out, also counted against the link's and mesh's caps
 
   // timer stuff
   uint32_t tsent, trecv; // last send, recv at
-  uint32_t timeout; // when in the future to trigger timeout
+  uint32_t timeout; // when to error w/ a timeout, on mesh_process()'s clock
+  uint32_t tindex, rindex; // position+1 in the link's timeout and resend heaps, 0 if not in it
   
   // direct handler
   void *arg;
   void (*handle)(chan_t c, void *arg);
+  void (*writable)(chan_t c, void *arg); // room to send again, see chan_writable()
+
+  // reliable delivery, only when window is set
+  uint32_t window; // bytes, bounds both what's in flight and what's held out of order
+  uint32_t seq; // last one queued
+  uint32_t sent; // highest seq sent so far
+  uint32_t sample, tsample; // seq being timed for the rtt, and when it was sent
+  uint32_t ack; // highest received in order
+  uint32_t acked, peer; // the other side's highest ack and receive window as of it
+  uint32_t adv; // receive window we last told the other side
+  uint32_t missed; // highest already resent because an ack said it was missing
+  uint32_t tresend; // when the oldest in flight is due to be sent again, 0 if none
+  lob_t out; // unacked in seq order, each ->id is when it was last sent (0 if waiting to be)
+  lob_t unsent; // the first in out never sent, nothing after it has been either
+  uint32_t flight, resends; // bytes of out in flight, and how many before unsent are waiting to be sent again
+  chan_t ready; // next in the link's list of channels taking turns sending
+  uint8_t listed; // is in that list
+  lob_t reorder; // received past a gap, in seq order
+  uint8_t retries; // resend timeouts since the ack last moved
+  uint8_t acking; // something was received that hasn't been acked yet
+  uint8_t flushing; // acks can arrive while we're sending
+  uint8_t blocked; // was short on room to send, the writable callback is owed
 
   enum chan_states state;
 };
@@ -30,12 +66,23 @@ struct chan_struct
 chan_t chan_new(lob_t open); // open must be chan_receive or chan_send next yet
 chan_t chan_free(chan_t c);
 
-// sets when in the future this channel should timeout auto-error from no receive, returns current timeout
+// sets the absolute time (on mesh_process()'s clock) this channel errors w/ a timeout, returns the current one (0 for none)
+// it isn't pushed back by traffic, set it again to keep a busy channel going
 uint32_t chan_timeout(chan_t c, uint32_t at);
 
-// returns current inbox cache
+// make this a reliable channel, everything sent is sequenced and resent until acked, received is put back in order
+// window is in bytes (0 for CHAN_WINDOW), call before sending anything, an incoming open w/ a "seq" does this already
+chan_t chan_reliable(chan_t c, uint32_t window);
+
+// bytes buffered in the inbox, and for reliable channels unacked and out of order
 uint32_t chan_size(chan_t c);
 
+// bytes a reliable channel can chan_send before there's more than a window waiting on acks (or the link's/mesh's buffer caps are hit)
+// it's only a credit, past it sends are still queued until a cap refuses them, UINT32_MAX for unreliable channels since nothing is kept
+// when it's down to half a window or less the writable callback fires once there's more than that again (checked as the channel is processed)
+uint32_t chan_writable(chan_t c);
+chan_t chan_on_writable(chan_t c, void (*writable)(chan_t c, void *arg)); // called w/ the chan_handle() arg
+
 // incoming packets
 chan_t chan_receive(chan_t c, lob_t inner); // process into receiving queue
 chan_t chan_sync(chan_t c, uint8_t sync); // false to force start timeouts (after any new handshake), true to cancel and resend last packet (after any e3x_exchange_sync)
@@ -44,17 +91,22 @@ lob_t chan_receiving(chan_t c); // get next avail packet in order, null if nothi
 // outgoing packets
 lob_t chan_oob(chan_t c); // id/ack/miss only headers base packet
 lob_t chan_packet(chan_t c);  // creates a sequenced packet w/ all necessary headers, just a convenience
-chan_t chan_send(chan_t c, lob_t inner); // encrypts and sends packet out link
+chan_t chan_send(chan_t c, lob_t inner); // encrypts and sends packet out link, reliable ones are sequenced and may wait on the window
 chan_t chan_err(chan_t c, char *err); // generates local-only error packet for next chan_process()
 
 // must be called after every send or receive, processes resends/timeouts, fires handlers
 chan_t chan_process(chan_t c, uint32_t now);
 
+// internal, used by link_flush: sends the next waiting packet if it fits the channel's window and the room given, returns its size or 0
+uint32_t chan_transmit(chan_t c, uint32_t room);
+
+// internal, true when it has a packet its own window lets go (only the link's room could be holding it)
+uint8_t chan_ready(chan_t c);
+
 // set up internal handler for all incoming packets on this channel
 chan_t chan_handle(chan_t c, void (*handle)(chan_t c, void *arg), void *arg);
 
 // convenience functions, accessors
-chan_t chan_next(chan_t c); // c->next
 uint32_t chan_id(chan_t c); // c->id
 enum chan_states chan_state(chan_t c);
 
@@ -8,6 +8,16 @@
 #define remote_t void*
 #define ephemeral_t void*
 
+// one signature in a batch for remote_validate_batch, err is set to what remote_validate would return
+typedef struct e3x_validate_struct
+{
+  remote_t remote;
+  lob_t args, sig;
+  uint8_t *data;
+  size_t len;
+  uint8_t err;
+} *e3x_validate_t;
+
 // this is the overall holder for each cipher set, function pointers to cs specific implementations
 typedef struct e3x_cipher_struct
 {
@@ -28,21 +38,28 @@ typedef struct e3x_cipher_struct
   // a remote endpoint identity
   remote_t (*remote_new)(lob_t key, uint8_t *token);
   void (*remote_free)(remote_t remote);
+  remote_t (*remote_dup)(remote_t remote); // optional, an independent copy for use on another thread
   uint8_t (*remote_verify)(remote_t remote, local_t local, lob_t outer);
   lob_t (*remote_encrypt)(remote_t remote, local_t local, lob_t inner);
   uint8_t (*remote_validate)(remote_t remote, lob_t args, lob_t sig, uint8_t *data, size_t len);
+  uint32_t (*remote_validate_batch)(e3x_validate_t *items, uint32_t count); // optional, sets each err and returns how many were valid
   
   // an active session to a remote for channel packets
   ephemeral_t (*ephemeral_new)(remote_t remote, lob_t outer);
   void (*ephemeral_free)(ephemeral_t ephemeral);
   lob_t (*ephemeral_encrypt)(ephemeral_t ephemeral, lob_t inner);
   lob_t (*ephemeral_decrypt)(ephemeral_t ephemeral, lob_t outer);
+  lob_t (*ephemeral_wrap)(ephemeral_t ephemeral, lob_t inner); // optional, encrypts inner in place and returns it as the outer
 
   uint8_t id, csid;
   char hex[3], *alg;
 } *e3x_cipher_t;
 
 
+// room to reserve around channel packets so ephemeral_wrap can frame them w/o a copy
+#define E3X_HEADROOM (2+16+4)
+#define E3X_TAILROOM 4
+
 // all possible cipher sets, as index into cipher_sets global
 #define CS_1a 0
 #define CS_1c 1
@@ -29,6 +29,10 @@ lob_t e3x_exchange_message(e3x_exchange_t x, lob_t inner);
 uint8_t e3x_exchange_verify(e3x_exchange_t x, lob_t outer);
 uint8_t e3x_exchange_validate(e3x_exchange_t x, lob_t args, lob_t sig, uint8_t *data, size_t len);
 
+// many validates at once, each w/ the key from xs[i] (xs and its entries optional) and args/sig/data/len filled in
+// sets each item's remote and err (0 is valid), returns how many were valid
+uint32_t e3x_exchange_validate_batch(e3x_exchange_t *xs, e3x_validate_t items, uint32_t count);
+
 // return the current incoming at value, optional arg to update it
 uint32_t e3x_exchange_in(e3x_exchange_t x, uint32_t at);
 
@@ -38,6 +42,12 @@ uint32_t e3x_exchange_out(e3x_exchange_t x, uint32_t at);
 // synchronize to incoming ephemeral key and set out at = in at, returns x if success, NULL if not
 e3x_exchange_t e3x_exchange_sync(e3x_exchange_t x, lob_t outer);
 
+// an independent copy (w/o any ephemeral) that another thread can verify/sync a handshake on, NULL if the cipher set can't
+e3x_exchange_t e3x_exchange_dup(e3x_exchange_t x);
+
+// does what e3x_exchange_sync() would w/ the ephemeral a dup created for this same handshake, NULL if that dup doesn't apply to x
+e3x_exchange_t e3x_exchange_adopt(e3x_exchange_t x, e3x_exchange_t dup, lob_t outer);
+
 // drops ephemeral state, out=0
 e3x_exchange_t e3x_exchange_down(e3x_exchange_t x);
 
@@ -47,6 +57,7 @@ lob_t e3x_exchange_handshake(e3x_exchange_t x, lob_t inner);
 // simple synchronous encrypt/decrypt conversion of any packet for channels
 lob_t e3x_exchange_receive(e3x_exchange_t x, lob_t outer); // goes to channel, validates cid
 lob_t e3x_exchange_send(e3x_exchange_t x, lob_t inner); // comes from channel 
+lob_t e3x_exchange_wrap(e3x_exchange_t x, lob_t inner); // same as send but consumes inner, in place when possible
 
 // validate the next incoming channel id from the packet, or return the next avail outgoing channel id
 uint32_t e3x_exchange_cid(e3x_exchange_t x, lob_t incoming);
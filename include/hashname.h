@@ -14,7 +14,7 @@ typedef struct hashname_struct
 hashname_t hashname_dup(hashname_t hn);
 hashname_t hashname_free(hashname_t hn);
 
-// everything else returns a pointer to a static global for temporary use
+// everything else returns a pointer to a per-thread static for temporary use
 hashname_t hashname_vchar(const char *str); // from a string
 hashname_t hashname_vbin(const uint8_t *bin);
 hashname_t hashname_vkeys(lob_t keys);
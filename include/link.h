@@ -3,6 +3,11 @@
 #include <stdint.h>
 
 #include "mesh.h"
+#include "util_cc.h"
+
+#ifndef LINK_BUFFER
+#define LINK_BUFFER (4 * 1024 * 1024) // default cap on bytes all of a link's channels buffer
+#endif
 
 struct link_struct
 {
@@ -11,7 +16,24 @@ struct link_struct
   e3x_exchange_t x;
   mesh_t mesh;
   lob_t key;
-  chan_t chans;
+
+  // channels open-addressed by id, and min-heaps of them by next timeout and by next resend (on the cc clock)
+  chan_t *chans, *timers, *resends;
+  uint32_t chans_size, chans_count, timers_count, resends_count;
+
+  // what reliable channels send is paced and windowed together, taking turns
+  struct util_cc_struct cc;
+  chan_t ready, ready_last; // channels w/ something to send, in turn order
+  uint32_t ready_count;
+  uint32_t tpace; // held back by pacing as of then, 0 if not
+  uint32_t paced; // sends pacing held back
+  uint8_t flushing;
+
+  // when it's due on the mesh's heaps (as of the last mesh_link_timer), and position+1 in them, 0 if not in it
+  uint32_t tdue, cdue, tindex, cindex;
+
+  // everything the channels have buffered, in or out
+  uint32_t buffered, buffer_max, refused; // bytes, cap, packets refused for being over it (or the mesh's)
 
   // transport plumbing
   void *send_arg;
@@ -20,6 +42,8 @@ struct link_struct
   // these are for internal link management only
   link_t next;
   uint8_t csid;
+  char hashname[53], hshort[9], token[17]; // mesh index keys
+  char cookie[32]; // base32, our handshakes echo it when the other side asked for one
 };
 
 // these all create or return existing one from the mesh
@@ -43,12 +67,18 @@ link_t link_load(link_t link, uint8_t csid, lob_t key);
 // add a delivery pipe to this link
 link_t link_pipe(link_t link, link_t (*send)(link_t link, lob_t packet, void *arg), void *arg);
 
+// cap the bytes all of this link's channels can buffer (0 for LINK_BUFFER), past it packets from either side are refused
+link_t link_buffer(link_t link, uint32_t max);
+
 // process a decrypted channel packet
 link_t link_receive(link_t link, lob_t inner);
 
 // process an incoming handshake
 link_t link_receive_handshake(link_t link, lob_t handshake);
 
+// same, w/ a dup of link->x that already verified and synced to it on another thread (see e3x_exchange_dup), caller still owns prepared
+link_t link_receive_prepared(link_t link, lob_t handshake, e3x_exchange_t prepared);
+
 // try to deliver this encrypted packet
 link_t link_send(link_t link, lob_t outer);
 
@@ -73,7 +103,26 @@ link_t link_down(link_t link);
 // create/track a new channel for this open
 chan_t link_chan(link_t link, lob_t open);
 
-// process any channel timeouts based on the current/given time
+// get an existing channel by id, NULL if none
+chan_t link_chan_get(link_t link, uint32_t id);
+
+// internal, used by chan.c to stop tracking a channel and to re-sort it when its timeout/state changes
+link_t link_chan_drop(link_t link, chan_t c);
+link_t link_chan_timer(link_t link, chan_t c);
+
+// internal, send what reliable channels have waiting as the congestion window and pacing allow, each queued by chan.c for a turn
+link_t link_chan_ready(link_t link, chan_t c);
+link_t link_flush(link_t link);
+
+// process any channel timeouts based on the current/given time, and w/o a mesh_clock() the resends and pacing too
 link_t link_process(link_t link, uint32_t now);
 
+// the clock reliable channels are timed by (see mesh_clock), processes the resends and paced sends due
+link_t link_clock(link_t link, uint32_t now);
+uint32_t link_clock_due(link_t link); // when the next of those is, 0 if none
+uint32_t link_now(link_t link); // that clock now, caught up to the mesh's
+
+// when the next channel is due to be processed (pass a later time to link_process), 0 if none
+uint32_t link_due(link_t link);
+
 #endif
@@ -20,6 +20,8 @@ typedef struct lob_struct
   // these are internal/private
   struct lob_struct *chain;
   char *cache; // edited copy of the json head
+  struct lob_index_struct *index; // top level key offsets in the head, built on first lookup
+  size_t headroom, tailroom; // unused space allocated before/after raw
 
   // used only by the list utils
   struct lob_struct *next, *prev;
@@ -43,6 +45,15 @@ lob_t lob_unlink(lob_t parent);
 // initialize head/body from raw, parses json
 lob_t lob_parse(const uint8_t *raw, size_t len);
 
+// same as lob_parse but takes ownership of raw instead of copying it (from util_pool_malloc, free'd on failure too)
+lob_t lob_adopt(uint8_t *raw, size_t len);
+
+// make sure there's at least this much space before/after raw so it can be framed in place w/o a realloc
+lob_t lob_reserve(lob_t p, size_t headroom, size_t tailroom);
+
+// turns p in place into a packet w/ no json and a body of [head bytes][original raw][tail bytes], caller fills head/tail
+lob_t lob_wrap(lob_t p, size_t head, size_t tail);
+
 // return full encoded packet
 uint8_t *lob_raw(lob_t p);
 size_t lob_len(lob_t p);
@@ -75,6 +86,14 @@ lob_t lob_set_float(lob_t p, char *key, float val, uint8_t places);
 lob_t lob_set_printf(lob_t p, char *key, const char *format, ...);
 lob_t lob_set_base32(lob_t p, char *key, uint8_t *val, size_t vlen);
 
+// builds a json head in place w/o any duplicate key checks, the head isn't valid json until lob_finish
+lob_t lob_begin(lob_t p); // starts a new head or reopens an existing object
+lob_t lob_add_raw(lob_t p, char *key, size_t klen, char *val, size_t vlen); // raw
+lob_t lob_add(lob_t p, char *key, char *val); // escapes value
+lob_t lob_add_uint(lob_t p, char *key, unsigned int val);
+lob_t lob_add_base32(lob_t p, char *key, uint8_t *val, size_t vlen);
+lob_t lob_finish(lob_t p);
+
 // copies keys from json into p
 lob_t lob_set_json(lob_t p, lob_t json);
 
@@ -5,6 +5,10 @@ typedef struct mesh_struct *mesh_t;
 typedef struct link_struct *link_t;
 typedef struct chan_struct *chan_t;
 
+#ifndef MESH_BUFFER
+#define MESH_BUFFER (16 * 1024 * 1024) // default cap on bytes all channels on all links buffer
+#endif
+
 
 
 #include "e3x.h"
@@ -23,6 +27,16 @@ struct mesh_struct
   uint16_t port_local, port_public;
   char *ipv4_local, *ipv4_public;
   link_t links;
+  // lookup indexes into links, keyed by routing token, full and short hashname
+  xht_t index_token, index_id, index_short;
+  uint32_t index_prime, linked;
+  util_admit_t admit; // handshake admission control, see mesh_admission()
+  uint32_t buffered, buffer_max, refused; // channel buffers on all links, see mesh_buffer()
+  uint8_t clocked; // reliable channels run on mesh_clock() instead of mesh_process()'s now
+  uint32_t clock; // the latest mesh_clock() (or mesh_process() w/o those), see link_now()
+  // min-heaps of the links w/ something due, by link_due() and by link_clock_due(), space for every link
+  link_t *timers, *clocks;
+  uint32_t timers_count, clocks_count, heaps_size;
 };
 
 mesh_t mesh_new(void);
@@ -51,18 +65,54 @@ link_t mesh_add(mesh_t mesh, lob_t json);
 link_t mesh_linked(mesh_t mesh, char *hn, size_t len);
 link_t mesh_linkid(mesh_t mesh, hashname_t id); // TODO, clean this up
 
+// internal, keeps the link lookup indexes current (used by link_new/link_load/link_free)
+mesh_t mesh_index(mesh_t mesh, link_t link);
+mesh_t mesh_unindex(mesh_t mesh, link_t link);
+
+// internal, keeps the heaps of links by when they're due current (used by link.c whenever that may have changed)
+mesh_t mesh_link_room(mesh_t mesh, uint32_t links); // heap space for this many links
+mesh_t mesh_link_timer(mesh_t mesh, link_t link);
+mesh_t mesh_link_drop(mesh_t mesh, link_t link);
+
 // remove this link, will event it down and clean up during next process()
 mesh_t mesh_unlink(link_t link);
 
 // processes incoming packet, it will take ownership of packet, returns link delivered to if success
 link_t mesh_receive(mesh_t mesh, lob_t packet);
 
+// same, from is the transport's address for the sender, when *reply is set it must be sent back to that address
+link_t mesh_receive_from(mesh_t mesh, lob_t packet, uint8_t *from, size_t len, lob_t *reply);
+
+// rate limit handshakes before any public key work is spent on them, options are those of util_admit_new() (NULL turns it off)
+// w/ "cookie":true a sender w/o a cookie is challenged (a *reply) and must resend its handshake echoing it, links do that automatically
+mesh_t mesh_admission(mesh_t mesh, lob_t options);
+
+// cap the bytes all channels on all links can buffer (0 for MESH_BUFFER), past it packets from either side are refused
+mesh_t mesh_buffer(mesh_t mesh, uint32_t max);
+
+// the admission step of mesh_receive_from() alone, returns a bare handshake that's admitted (NULL if not) and any other packet unchanged
+lob_t mesh_admit(mesh_t mesh, lob_t packet, uint8_t *from, size_t len, lob_t *reply);
+
 // process any unencrypted handshake packet
 link_t mesh_receive_handshake(mesh_t mesh, lob_t handshake);
 
+// the rest of mesh_receive() for a handshake decrypted elsewhere (e3x_self_decrypt), inner must have the outer linked
+// prepared is an optional dup of the sender link's exchange already verified/synced to it, takes ownership of both
+link_t mesh_receive_prepared(mesh_t mesh, lob_t inner, e3x_exchange_t prepared);
+
 // process any channel timeouts based on the current/given time
 mesh_t mesh_process(mesh_t mesh, uint32_t now);
 
+// earliest link_due() of all links, 0 if nothing is waiting on a timeout
+uint32_t mesh_due(mesh_t mesh);
+
+// a finer clock (ms) for reliable channels' resends, rtt and pacing, once it's given mesh_process() only drives the channel timeouts
+// (call it often, sends are timed by its latest now, and from the start since it can't mix w/ the now before it)
+mesh_t mesh_clock(mesh_t mesh, uint32_t now);
+
+// earliest resend or paced send due on that clock, 0 if none
+uint32_t mesh_clock_due(mesh_t mesh);
+
 // callback when the mesh is free'd
 void mesh_on_free(mesh_t mesh, char *id, void (*free)(mesh_t mesh));
 
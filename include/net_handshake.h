@@ -0,0 +1,46 @@
+#ifndef net_handshake_h
+#define net_handshake_h
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__)))
+
+#include <stdint.h>
+#include "mesh.h"
+
+// worker threads for the public key work of incoming handshakes, so a burst of them doesn't stall channel packets
+// a handshake is decrypted on a worker, then if it's from a known link it's verified/synced on a copy of that link's exchange
+// on another pass through a worker, and only the cheap bookkeeping is left for the mesh's own thread
+typedef struct net_handshakes_struct *net_handshakes_t;
+
+// queued to completion latency, bucket i counts those under 2^i microseconds (the last one everything slower)
+#define NET_HANDSHAKES_BUCKETS 24
+
+typedef struct net_handshakes_stats_struct
+{
+  uint32_t queued, completed; // completed includes failed
+  uint32_t dropped; // pipeline was full
+  uint32_t failed; // didn't decrypt or verify
+  uint32_t pending; // in the pipeline right now
+  uint32_t latency[NET_HANDSHAKES_BUCKETS];
+} *net_handshakes_stats_t;
+
+// options are "threads" (default 1) and "depth", the most handshakes in the pipeline at once (default 256)
+net_handshakes_t net_handshakes_new(mesh_t mesh, lob_t options);
+
+// any still pending are done w/ a NULL link
+net_handshakes_t net_handshakes_free(net_handshakes_t hs);
+
+// take a received handshake (1 byte head), done is called from net_handshakes_process() w/ the sender's link or NULL if it failed
+// when the pipeline is full it's dropped (freed) and this returns NULL w/o calling done, peers resend
+net_handshakes_t net_handshakes_queue(net_handshakes_t hs, lob_t outer, void (*done)(link_t link, void *arg), void *arg);
+
+// readable when there are results for net_handshakes_process()
+int net_handshakes_fd(net_handshakes_t hs);
+
+// finish any results, must be called on the mesh's thread, returns how many were done
+uint32_t net_handshakes_process(net_handshakes_t hs);
+
+net_handshakes_stats_t net_handshakes_stats(net_handshakes_t hs);
+
+#endif // POSIX
+
+#endif // net_handshake_h
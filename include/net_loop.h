@@ -0,0 +1,34 @@
+#ifndef net_loop_h
+#define net_loop_h
+
+#if defined(__linux__)
+
+#include <stdint.h>
+#include "mesh.h"
+#include "net_udp4.h"
+
+// epoll driven event loop for a mesh and its sockets, replaces polling net_udp4_process() on a socket timeout
+// sockets are switched to non-blocking and edge-triggered, channel timeouts run from a timerfd when they come due
+// the mesh gets a ms mesh_clock() for its reliable channels' resends and pacing, mesh_process() stays in seconds
+typedef struct net_loop_struct *net_loop_t;
+
+// options are "resend":ms, how often peers still waiting to confirm frames get resent to (default 20)
+net_loop_t net_loop_new(mesh_t mesh, lob_t options);
+net_loop_t net_loop_free(net_loop_t loop);
+
+// drive this udp4 transport from the loop
+net_loop_t net_loop_udp4(net_loop_t loop, net_udp4_t udp4);
+
+// any other socket, handler is called w/ the epoll events whenever it's ready (must read/write until EAGAIN)
+net_loop_t net_loop_fd(net_loop_t loop, int fd, void (*handler)(net_loop_t loop, int fd, uint32_t events, void *arg), void *arg);
+net_loop_t net_loop_fd_drop(net_loop_t loop, int fd);
+
+// wait up to ms (-1 forever) for any activity and handle it, returns NULL on error or after net_loop_stop()
+net_loop_t net_loop_run(net_loop_t loop, int ms);
+
+// makes the current/next net_loop_run() return NULL, safe from any handler
+net_loop_t net_loop_stop(net_loop_t loop);
+
+#endif // __linux__
+
+#endif // net_loop_h
@@ -6,10 +6,15 @@
 typedef struct net_loopback_struct
 {
   mesh_t a, b;
+  uint32_t loss, seed; // percent of packets dropped, picked w/ a fixed seed so runs repeat
+  uint32_t sent, dropped;
 } *net_loopback_t;
 
 // connect two mesh instances with each other for packet delivery
 net_loopback_t net_loopback_new(mesh_t a, mesh_t b);
 void net_loopback_free(net_loopback_t pair);
 
+// drop this percent of packets either way (0 for none), for testing reliable channels
+net_loopback_t net_loopback_loss(net_loopback_t pair, uint32_t percent);
+
 #endif
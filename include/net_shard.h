@@ -0,0 +1,38 @@
+#ifndef net_shard_h
+#define net_shard_h
+
+#if defined(__linux__)
+
+#include <stdint.h>
+#include "mesh.h"
+#include "net_udp4.h"
+#include "net_loop.h"
+
+// one hashname served by N threads, each w/ its own mesh, udp4 socket (SO_REUSEPORT on a shared port) and event loop
+// the kernel spreads peer addresses across the sockets, each link lives only in the thread that got its handshake
+// channel packets arriving at any other thread (a peer that roamed to a new address) are queued to the owner by routing token
+typedef struct net_shards_struct *net_shards_t;
+
+// options are "threads" (default one per cpu), "port" (default any) and anything for each udp4 transport
+// "mtu" defaults to 1472 so that any thread can answer an address w/o sharing frame state
+net_shards_t net_shards_new(lob_t secrets, lob_t keys, lob_t options);
+
+// stops and joins all the threads first if started
+net_shards_t net_shards_free(net_shards_t shards);
+
+// each thread's mesh, for adding handlers before starting (same hashname in all of them)
+uint32_t net_shards_count(net_shards_t shards);
+mesh_t net_shards_mesh(net_shards_t shards, uint32_t index);
+
+// runs every thread, the meshes must not be touched from outside again until freed
+net_shards_t net_shards_start(net_shards_t shards);
+
+uint16_t net_shards_port(net_shards_t shards);
+
+// totals across all threads, packets received and those queued to another thread
+uint32_t net_shards_received(net_shards_t shards);
+uint32_t net_shards_forwarded(net_shards_t shards);
+
+#endif // __linux__
+
+#endif // net_shard_h
@@ -0,0 +1,53 @@
+#ifndef net_sim_h
+#define net_sim_h
+
+#include "mesh.h"
+
+// a simulated network between meshes on a virtual clock, the same seed and calls always play out the same
+typedef struct net_sim_struct *net_sim_t;
+typedef struct net_sim_pair_struct *net_sim_pair_t;
+
+// the conditions one way between a pair (times in clock units), and what happened to the packets sent
+typedef struct net_sim_path_struct
+{
+  uint32_t latency, jitter; // each packet takes latency plus up to jitter more
+  uint32_t bandwidth; // bytes per unit, 0 for unlimited
+  uint32_t queue; // bytes that can be waiting on the bandwidth, the rest are dropped (0 for no limit)
+  uint32_t loss, reorder, duplicate; // percent of packets dropped, held back past the ones after them, delivered twice
+  uint64_t busy; // when what's queued is done sending, in 1024ths of a unit
+  uint32_t last; // latest arrival so far, packets stay in order unless reordered
+  uint32_t sent, delivered, lost, overflowed, reordered, duplicated;
+  uint64_t bytes;
+} *net_sim_path_t;
+
+struct net_sim_pair_struct
+{
+  net_sim_t sim;
+  mesh_t a, b;
+  struct net_sim_path_struct ab, ba;
+  net_sim_pair_t next;
+};
+
+net_sim_t net_sim_new(uint32_t seed);
+// free every mesh in it first, their links still pipe through the pairs until then
+void net_sim_free(net_sim_t sim);
+
+// connect (and link) two meshes through the sim, both ways get the same conditions from options
+// {"latency":0,"jitter":0,"bandwidth":0,"queue":0,"loss":0,"reorder":0,"duplicate":0}
+net_sim_pair_t net_sim_pair(net_sim_t sim, mesh_t a, mesh_t b, lob_t options);
+
+// the path packets take from this mesh to the other one, to read or change directly
+net_sim_path_t net_sim_path(net_sim_pair_t pair, mesh_t from);
+
+// the current virtual time
+uint32_t net_sim_now(net_sim_t sim);
+
+// move the clock to the next thing due (a delivery or any mesh_due()) but not past until,
+// delivers everything due by then and runs mesh_process() on every mesh, returns the new time
+// (an until that's not past now does nothing)
+uint32_t net_sim_step(net_sim_t sim, uint32_t until);
+
+// steps until the clock gets to until
+net_sim_t net_sim_run(net_sim_t sim, uint32_t until);
+
+#endif
@@ -9,21 +9,54 @@
 #include <stdlib.h>
 
 #include "mesh.h"
+#include "net_handshake.h"
 
 // overall server
 typedef struct net_udp4_struct *net_udp4_t;
 
-// create a new listening udp server
+// create a new listening udp server, options are:
+//   "port"
+//   "batch":false to use one syscall per frame instead of recvmmsg/sendmmsg
+//   "mtu":1472 sends packets up to that size as single datagrams instead of 128 byte frames, both sides must set it
+//   "pipes":N keeps at most N peer addresses, evicting the least recently heard from
+//   "idle":S evicts any peer address not heard from in S seconds
+//   "reuseport":true lets several transports (one per thread) bind the same port
 net_udp4_t net_udp4_new(mesh_t mesh, lob_t options);
 net_udp4_t net_udp4_free(net_udp4_t net);
 
-// send/receive any waiting frames, delivers packets into mesh
+// send/receive any waiting frames, delivers packets into mesh, also resends to every peer still waiting to confirm
 net_udp4_t net_udp4_process(net_udp4_t net);
 
+// same but without the resends, only handles received frames and new packets to send (for event driven use)
+net_udp4_t net_udp4_receive(net_udp4_t net);
+
+// returns net when new packets are queued and need a receive/process, or sent ones are awaiting confirmation and need a process
+net_udp4_t net_udp4_pending(net_udp4_t net);
+net_udp4_t net_udp4_awaiting(net_udp4_t net);
+
 // return server socket handle / port
 int net_udp4_socket(net_udp4_t net);
 uint16_t net_udp4_port(net_udp4_t net);
 
+// received packets go to this instead of mesh_receive(), it returns the sender's link if any (to send replies via this address)
+net_udp4_t net_udp4_receiver(net_udp4_t net, link_t (*receive)(net_udp4_t net, lob_t packet, struct sockaddr_in *from, void *arg), void *arg);
+
+// process a packet as if it was received from this address (skips any receiver), replies go back out this transport
+net_udp4_t net_udp4_deliver(net_udp4_t net, lob_t packet, struct sockaddr_in *from);
+
+// the address bytes given to mesh_receive_from()/mesh_admit() for a sender (6, the ip and port)
+uint8_t *net_udp4_address(struct sockaddr_in *sa, uint8_t *address);
+
+// queue a packet to this address, for a receiver to send a reply w/o a link (like mesh_receive_from()'s)
+net_udp4_t net_udp4_reply(net_udp4_t net, lob_t packet, struct sockaddr_in *to);
+
+// received handshakes are queued to these workers (not w/ a receiver), and finished in net_udp4_receive/process
+// the workers must be freed before this transport, NULL detaches them
+net_udp4_t net_udp4_handshakes(net_udp4_t net, net_handshakes_t hs);
+
+// number of peer addresses currently tracked
+uint32_t net_udp4_pipes(net_udp4_t net);
+
 // send a packet directly
 net_udp4_t net_udp4_direct(net_udp4_t net, lob_t packet, char *ip, uint16_t port);
 
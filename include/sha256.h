@@ -1,6 +1,9 @@
 #ifndef SHA256_H
 #define SHA256_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -35,6 +38,18 @@ void hmac_256(const unsigned char *key, size_t keylen,
                   const unsigned char *input, size_t ilen,
                   unsigned char output[32]);
 
+// a key w/ its inner and outer pad blocks already hashed, for MAC'ing many messages under the same one
+typedef struct hmac_256_struct
+{
+  uint32_t istate[8], ostate[8];
+} *hmac_256_t;
+
+void hmac_256_key(hmac_256_t hmac, const unsigned char *key, size_t keylen);
+void hmac_256_keyed(hmac_256_t hmac, const unsigned char *input, size_t ilen, unsigned char output[32]);
+
+// the x86 SHA extensions are used whenever the cpu has them, this turns them off (0) or back on, returns if they're in use
+unsigned char sha256_hw(unsigned char enable);
+
 #ifdef __cplusplus
 }
 #endif
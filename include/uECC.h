@@ -70,6 +70,24 @@ to be word aligned on architectures that do not support unaligned accesses. */
     #define uECC_SUPPORT_COMPRESSED_POINT 1
 #endif
 
+/* uECC_FIXED_BASE - If enabled (defined as nonzero), uECC_precompute() can build a table of
+multiples of a curve's generator point, after which key generation and signing on that curve
+use a constant-time fixed-window lookup into it instead of the generic ladder. A table takes
+8 public keys worth of memory per 4 bits of curve order (32KB for secp256r1), and room is
+reserved for uECC_FIXED_BASE_CURVES of them. */
+#ifndef uECC_FIXED_BASE
+    #define uECC_FIXED_BASE 0
+#endif
+#ifndef uECC_FIXED_BASE_CURVES
+    #define uECC_FIXED_BASE_CURVES 2
+#endif
+
+/* uECC_BATCH_SIZE - How many signatures uECC_verify_batch() works on at once. Each one takes
+about 10 public keys worth of stack, and the inversions mod p are shared across all of them. */
+#ifndef uECC_BATCH_SIZE
+    #define uECC_BATCH_SIZE 8
+#endif
+
 struct uECC_Curve_t;
 typedef const struct uECC_Curve_t * uECC_Curve;
 
@@ -233,6 +251,15 @@ Returns 1 if the key was computed successfully, 0 if an error occurred.
 */
 int uECC_compute_public_key(const uint8_t *private_key, uint8_t *public_key, uECC_Curve curve);
 
+/* uECC_precompute() function.
+Build the fixed-base table for a curve (see uECC_FIXED_BASE) so that uECC_make_key(),
+uECC_compute_public_key() and uECC_sign() on it are faster. It is not thread safe, call it
+once at startup before using the curve.
+
+Returns 1 if the table is ready, 0 if uECC_FIXED_BASE is disabled or all the tables are in use.
+*/
+int uECC_precompute(uECC_Curve curve);
+
 /* uECC_sign() function.
 Generate an ECDSA signature for a given hash value.
 
@@ -353,6 +380,32 @@ int uECC_verify(const uint8_t *public_key,
                 const uint8_t *signature,
                 uECC_Curve curve);
 
+/* uECC_verify_batch() function.
+Verify a number of ECDSA signatures on the same curve, each the same as uECC_verify() would.
+ECDSA signatures can't be combined into one check (only r, the x coordinate of each signer's
+point, is known), so they are verified separately but the two inversions mod p each one
+needs are done together, two inversions per uECC_BATCH_SIZE signatures instead.
+
+Inputs:
+    public_keys    - The signer's public key for each signature.
+    message_hashes - The hash of the signed data for each signature.
+    hash_size      - The size of every message hash in bytes.
+    signatures     - The signature values.
+    count          - How many signatures there are.
+
+Outputs:
+    results - Set to 1 for each valid signature, 0 for each invalid one.
+
+Returns the number of valid signatures.
+*/
+int uECC_verify_batch(const uint8_t * const *public_keys,
+                      const uint8_t * const *message_hashes,
+                      unsigned hash_size,
+                      const uint8_t * const *signatures,
+                      unsigned count,
+                      uint8_t *results,
+                      uECC_Curve curve);
+
 #ifdef __cplusplus
 } /* end of extern "C" */
 #endif
@@ -9,6 +9,9 @@
 #include "util_uri.h"
 #include "util_chunks.h"
 #include "util_frames.h"
+#include "util_pool.h"
+#include "util_admit.h"
+#include "util_cc.h"
 #include "util_unix.h"
 
 // make sure out is 2*len + 1
@@ -0,0 +1,45 @@
+#ifndef util_admit_h
+#define util_admit_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include "lob.h"
+
+// admission control for expensive work (handshakes) from many sources, sources are any transport address bytes
+// each source gets a token bucket, all of them share a budget, and optionally must echo a stateless cookie first
+typedef struct util_admit_struct *util_admit_t;
+
+typedef struct util_admit_stats_struct
+{
+  uint32_t admitted;
+  uint32_t limited; // that source was over its rate
+  uint32_t over_budget; // all sources together were over the budget
+  uint32_t challenged; // cookies handed out
+  uint32_t bad_cookies; // wrong or expired ones echoed back
+} *util_admit_stats_t;
+
+#define UTIL_ADMIT_COOKIE 16
+#define UTIL_ADMIT_WINDOW 30 // seconds, a cookie is good for the rest of its window and the next one
+
+// options are "rate" per source per second (default 4), "burst" per source (default 8),
+// "budget" all sources per second (default 0, unlimited), "cookie":true to require cookies, "sources" table size (default 1024)
+// secret keys the cookies and source hashing, it should be random
+util_admit_t util_admit_new(lob_t options, uint8_t *secret, size_t len);
+util_admit_t util_admit_free(util_admit_t admit);
+
+// take a token from this source's bucket and the budget, NULL (and counted) if either is empty, now is in ms
+// w/o any from (len 0) there's no source bucket, only the budget applies
+util_admit_t util_admit_take(util_admit_t admit, uint8_t *from, size_t len, uint64_t now);
+
+// returns admit if cookies are required
+util_admit_t util_admit_cookies(util_admit_t admit);
+
+// fill in this source's current cookie (UTIL_ADMIT_COOKIE bytes), counts it as a challenge, NULL if over the budget
+uint8_t *util_admit_cookie(util_admit_t admit, uint8_t *from, size_t len, uint64_t now, uint8_t *cookie);
+
+// admit if this is a current cookie for this source, NULL (and counted) if not
+util_admit_t util_admit_verify(util_admit_t admit, uint8_t *from, size_t len, uint64_t now, uint8_t *cookie);
+
+util_admit_stats_t util_admit_stats(util_admit_t admit);
+
+#endif
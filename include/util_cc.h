@@ -0,0 +1,59 @@
+#ifndef util_cc_h
+#define util_cc_h
+
+#include <stdint.h>
+#include "lob.h"
+
+// congestion control for everything a link sends reliably, shared by all of its channels
+// the window grows CUBIC-style but counted in round trips (by bytes acked) so it doesn't care what units now is in,
+// and sends are paced to spread a window across the smoothed rtt
+#define UTIL_CC_MSS 1200 // nominal packet size the window moves by
+#define UTIL_CC_INIT 10 // initial window, in packets
+#define UTIL_CC_MIN 2 // smallest window after a loss, in packets
+#define UTIL_CC_MAX (64 * 1024 * 1024) // bytes
+
+typedef struct util_cc_struct
+{
+  uint32_t cwnd, ssthresh, flight; // bytes
+  uint32_t wmax; // window before the last reduction
+  uint32_t epoch, k; // round trips since that reduction and until back at wmax, both in 16ths
+  uint32_t round; // bytes acked towards the next round trip
+  uint32_t srtt, rttvar; // 8x and 4x, like tcp
+  uint32_t now, recover; // latest clock, no more reductions until it's past recover
+  uint32_t tokens, filled; // pacing bucket, and when it was last filled
+  uint32_t sent, lost, timeouts, samples; // counts
+} *util_cc_t;
+
+void util_cc_init(util_cc_t cc);
+
+// the latest now, refills the pacing bucket
+void util_cc_clock(util_cc_t cc, uint32_t now);
+
+// bytes that can be sent right now, limited by the window and the pacing
+uint32_t util_cc_room(util_cc_t cc);
+
+// a packet of this many bytes was sent
+void util_cc_sent(util_cc_t cc, uint32_t bytes);
+
+// these bytes were acked, grows the window (call util_cc_gone too for what was still in flight)
+void util_cc_acked(util_cc_t cc, uint32_t bytes);
+
+// these bytes aren't in flight anymore (acked, lost, or their channel is gone)
+void util_cc_gone(util_cc_t cc, uint32_t bytes);
+
+// a round trip was measured (from a packet only sent once)
+void util_cc_rtt(util_cc_t cc, uint32_t rtt);
+
+// a packet was reported missing, the window shrinks at most once per round trip
+void util_cc_loss(util_cc_t cc);
+
+// nothing was acked in time, back to a minimal window
+void util_cc_timeout(util_cc_t cc);
+
+// how long to wait for an ack before resending, 0 until there's a measured rtt
+uint32_t util_cc_rto(util_cc_t cc);
+
+// adds the estimates to a json object being built (lob_begin'd)
+lob_t util_cc_json(util_cc_t cc, lob_t json);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef util_pool_h
+#define util_pool_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// size-classed block pools w/ per-thread freelists for the hot packet objects (lob, chan, frames, chunks)
+// anything from util_pool_malloc/realloc must only go back through util_pool_realloc/free
+// build w/ -DNOPOOL to pass everything straight through to the system allocator
+
+typedef struct util_pool_stats_struct
+{
+  uint64_t allocs, frees; // all requests
+  uint64_t hits, misses; // allocs served from a freelist or not
+  uint64_t large; // allocs bigger than any size class, always the system allocator
+  uint32_t cached; // blocks currently sitting on freelists
+} *util_pool_stats_t;
+
+void *util_pool_malloc(size_t size);
+void *util_pool_realloc(void *ptr, size_t size);
+void util_pool_free(void *ptr);
+
+// returns the calling thread's freelist blocks to the system allocator
+void util_pool_flush(void);
+
+// the calling thread's counters
+util_pool_stats_t util_pool_stats(void);
+
+#endif
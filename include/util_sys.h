@@ -3,6 +3,12 @@
 
 typedef uint32_t at_t;
 
+// the TEMPORARY results some functions return live in per-thread storage so they're safe from any thread
+// platforms w/o thread-local storage can define this empty (single threaded only then)
+#ifndef UTIL_TLS
+#define UTIL_TLS __thread
+#endif
+
 // returns a number that increments in seconds for comparison (epoch or just since boot)
 at_t util_sys_seconds();
 
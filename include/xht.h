@@ -11,7 +11,7 @@ typedef struct xht_struct *xht_t;
 xht_t xht_new(unsigned int prime);
 
 // caller responsible for key storage, no copies made (don't free it b4 xht_free()!)
-// set val to NULL to clear an entry, memory is reused but never free'd (# of keys only grows to peak usage)
+// set val to NULL to clear an entry (key is released), memory is reused but never free'd (# of keys only grows to peak usage)
 void xht_set(xht_t h, const char *key, void *val);
 
 // ooh! unlike set where key/val is in caller's mem, here they are copied into xht_t and free'd when val is 0 or xht_free()
@@ -4,6 +4,43 @@
 #include <inttypes.h>
 #include "telehash.h"
 
+// not in flight anymore, to be sent again unless it's being freed
+static void chan_landed(chan_t c, lob_t p)
+{
+  if(!p->id) return;
+  c->flight -= (uint32_t)lob_len(p);
+  if(c->link) util_cc_gone(&c->link->cc, (uint32_t)lob_len(p));
+  p->id = 0;
+}
+
+// in flight and presumed lost, it's sent again before anything new
+static void chan_lost(chan_t c, lob_t p)
+{
+  if(!p->id) return;
+  chan_landed(c, p);
+  c->resends++;
+}
+
+// everything buffered is counted against the link and mesh too
+static void chan_count(chan_t c, uint32_t *count, int32_t len)
+{
+  *count += (uint32_t)len;
+  if(!c->link) return;
+  c->link->buffered += (uint32_t)len;
+  if(c->link->mesh) c->link->mesh->buffered += (uint32_t)len;
+}
+
+// under the link's and mesh's caps w/ this many more bytes
+static uint8_t chan_fits(chan_t c, uint32_t len)
+{
+  link_t link = c->link;
+  if(!link) return 1;
+  if(link->buffered + len <= link->buffer_max && (!link->mesh || link->mesh->buffered + len <= link->mesh->buffer_max)) return 1;
+  link->refused++;
+  if(link->mesh) link->mesh->refused++;
+  return 0;
+}
+
 // open must be chan_receive or chan_send next yet
 chan_t chan_new(lob_t open)
 {
@@ -17,18 +54,22 @@ chan_t chan_new(lob_t open)
   type = lob_get(open,"type");
   if(!type) return LOG("missing channel type");
 
-  c = malloc(sizeof (struct chan_struct));
+  if(!(c = util_pool_malloc(sizeof (struct chan_struct)))) return LOG("OOM");
   memset(c,0,sizeof (struct chan_struct));
   c->state = CHAN_OPENING;
   c->id = id;
   c->type = lob_get(open,"type");
 
+  // the other side is sequencing
+  if(lob_get(open,"seq")) chan_reliable(c, 0);
+
   LOG("new channel %d %s",id,type);
   return c;
 }
 
 chan_t chan_free(chan_t c)
 {
+  lob_t cur;
   if(!c) return NULL;
 
   // gotta tell handler (TODO, still buggy)
@@ -38,9 +79,17 @@ chan_t chan_free(chan_t c)
     c->handle(c, c->arg);
   }
 
+  // stop being tracked by the link, and counted in its flight and buffers
+  for(cur = c->out;cur;cur = cur->next) chan_landed(c, cur);
+  chan_count(c, &c->buffered, -(int32_t)c->buffered);
+  chan_count(c, &c->queued, -(int32_t)c->queued);
+  if(c->link) link_chan_drop(c->link, c);
+
   // free any other queued packets
   lob_freeall(c->in);
-  free(c);
+  lob_freeall(c->out);
+  lob_freeall(c->reorder);
+  util_pool_free(c);
   return NULL;
 }
 
@@ -51,7 +100,7 @@ uint32_t chan_id(chan_t c)
   return c->id;
 }
 
-// this will set the default inactivity timeout using this event timer and our uid
+// sets (or with 0 returns) the absolute time this channel errors w/ a timeout
 uint32_t chan_timeout(chan_t c, uint32_t at)
 {
   if(!c) return 0;
@@ -60,37 +109,296 @@ uint32_t chan_timeout(chan_t c, uint32_t at)
   if(!at) return c->timeout;
 
   c->timeout = at;
+  link_chan_timer(c->link, c);
   return c->timeout;
 }
 
-chan_t chan_next(chan_t c)
-{
-  if(!c) return NULL;
-  return c->next;
-}
-
 enum chan_states chan_state(chan_t c)
 {
   if(!c) return CHAN_ENDED;
   return c->state;
 }
 
+chan_t chan_reliable(chan_t c, uint32_t window)
+{
+  if(!c) return LOG("bad args");
+  if(c->seq) return LOG("already sending");
+  c->window = c->peer = c->adv = window ? window : CHAN_WINDOW;
+  return c;
+}
+
+// current resend interval, backed off by the timeouts so far
+static uint32_t chan_interval(chan_t c)
+{
+  util_cc_t cc = c->link ? &c->link->cc : NULL;
+  uint32_t rto = util_cc_rto(cc), backoff = c->retries;
+  uint32_t floor = (c->link && c->link->mesh && c->link->mesh->clocked) ? CHAN_RESEND_MS : CHAN_RESEND;
+  // no rtt yet, stay backed off from the guess or resends keep one from ever being measured
+  if(!rto && cc && cc->timeouts > backoff) backoff = cc->timeouts;
+  if(rto < floor) rto = floor;
+  return rto << ((backoff < 6) ? backoff : 6);
+}
+
+// the link's clock, any channel may send or get acks between its own processing
+static uint32_t chan_now(chan_t c)
+{
+  uint32_t now = c->link ? link_now(c->link) : c->trecv;
+  return now ? now : 1;
+}
+
+// when the oldest packet in flight is due to be sent again, or w/ none in flight and more waiting when to check the other side's window
+// (the first one in flight was sent before the rest unless it was resent, then they only wait up to that much longer)
+static void chan_rearm(chan_t c)
+{
+  lob_t cur;
+  uint32_t oldest = 0;
+  if(c->flight) for(cur = c->out;cur && !(oldest = cur->id);cur = cur->next);
+  if(!oldest && c->out) oldest = chan_now(c);
+  c->tresend = oldest ? oldest + chan_interval(c) : 0; // wraps w/ the clock
+  if(oldest && !c->tresend) c->tresend = 1; // 0 is none
+  if(c->link) link_chan_timer(c->link, c);
+}
+
+// the next packet the channel's own window lets go, resends first since they aren't held back
+static lob_t chan_next(chan_t c)
+{
+  lob_t cur;
+  uint32_t len;
+
+  if(!c->window || !c->link) return NULL;
+  if(c->resends) for(cur = c->out;cur && cur != c->unsent;cur = cur->next) if(!cur->id) return cur;
+  if(!(cur = c->unsent)) return NULL;
+
+  // everything past a resend is stuck in flight until it lands
+  len = (uint32_t)lob_len(cur);
+  if(c->flight && c->flight + len > c->window) return NULL;
+  if(c->flight + len > c->peer) return NULL; // the other side has no room for it yet
+  return cur;
+}
+
+// the link sends what's waiting across all its channels, this one takes a turn when it can
+static void chan_flush(chan_t c)
+{
+  chan_rearm(c);
+  if(!c->link) return;
+  if(chan_next(c)) link_chan_ready(c->link, c);
+  link_flush(c->link);
+}
+
+uint8_t chan_ready(chan_t c)
+{
+  return (c && chan_next(c)) ? 1 : 0;
+}
+
+uint32_t chan_transmit(chan_t c, uint32_t room)
+{
+  lob_t next;
+  uint32_t len, seq;
+
+  if(!c || !(next = chan_next(c))) return 0;
+  len = (uint32_t)lob_len(next);
+  seq = lob_get_uint(next,"seq");
+
+  if(next == c->unsent && len > room && c->link->cc.flight)
+  {
+    // the window has room, only pacing held it, so the link tries again on the next clock
+    if(c->link->cc.flight + len <= c->link->cc.cwnd)
+    {
+      c->link->tpace = chan_now(c);
+      c->link->paced++;
+    }
+    return 0; // a big one can always go by itself
+  }
+
+  // time one packet at a time, never one that was resent since its ack could be for either
+  next->id = c->tsent = chan_now(c);
+  c->flight += len;
+  if(next == c->unsent)
+  {
+    c->unsent = next->next;
+    c->sent = seq;
+    if(!c->sample)
+    {
+      c->sample = seq;
+      c->tsample = next->id;
+    }
+  }else{
+    c->resends--;
+    if(seq == c->sample) c->sample = 0;
+  }
+  util_cc_sent(&c->link->cc, len);
+  if(!c->tresend) chan_rearm(c);
+
+  // only a copy goes out, it's encrypted in place, acks may arrive before this returns
+  c->flushing = 1;
+  link_send(c->link, e3x_exchange_wrap(c->link->x, lob_reserve(lob_copy(next),E3X_HEADROOM,E3X_TAILROOM)));
+  c->flushing = 0;
+  return len;
+}
+
+// done w/ this one (acked or held), whether it was in flight, waiting to be resent, or never sent
+static void chan_done(chan_t c, lob_t p, uint32_t seq)
+{
+  if(p == c->unsent) c->unsent = p->next;
+  else if(!p->id && seq <= c->sent) c->resends--;
+  chan_landed(c, p);
+  chan_count(c, &c->queued, -(int32_t)lob_len(p));
+  c->out = lob_splice(c->out, p);
+  lob_free(p);
+}
+
+// drop what's been acked, and resend what's missing (just once, timeouts cover the rest)
+static void chan_acked(chan_t c, lob_t packet)
+{
+  uint32_t ack, seq, top, i, count, gaps[CHAN_MISS];
+  size_t mlen, vlen;
+  char *miss, *val;
+  lob_t cur, next;
+  util_cc_t cc = c->link ? &c->link->cc : NULL;
+
+  // an older ack arriving late has nothing new, and an out of date window
+  ack = lob_get_uint(packet,"ack");
+  if(ack < c->acked) return;
+  c->acked = ack;
+  if(lob_get(packet,"win")) c->peer = lob_get_uint(packet,"win");
+
+  while((cur = c->out) && (seq = lob_get_uint(cur,"seq")) <= ack)
+  {
+    util_cc_acked(cc, (uint32_t)lob_len(cur));
+    chan_done(c, cur, seq);
+    c->retries = 0;
+  }
+  if(c->sample && c->sample <= ack)
+  {
+    util_cc_rtt(cc, chan_now(c) - c->tsample);
+    c->sample = 0;
+  }
+
+  count = 0;
+  if((miss = lob_get_raw(packet,"miss")))
+  {
+    mlen = lob_get_len(packet,"miss");
+    for(i=0;count < CHAN_MISS && (val = js0n(NULL,i,miss,mlen,&vlen));i++)
+    {
+      seq = gaps[count++] = ack + (uint32_t)strtoul(val,NULL,10);
+      if(seq <= c->missed) continue;
+      c->missed = seq;
+      for(cur = c->out;cur && lob_get_uint(cur,"seq") != seq;cur = cur->next);
+      if(!cur || !cur->id) continue;
+      chan_lost(c, cur);
+      util_cc_loss(cc);
+    }
+  }
+
+  // the rest up to held are being kept past the gaps, they're done here and no longer in flight
+  top = ack + lob_get_uint(packet,"held");
+  for(cur = c->out;cur && (seq = lob_get_uint(cur,"seq")) <= top;cur = next)
+  {
+    next = cur->next;
+    for(i=0;i<count && gaps[i] != seq;i++);
+    if(i < count) continue;
+    if(seq == c->sample)
+    {
+      util_cc_rtt(cc, chan_now(c) - c->tsample);
+      c->sample = 0;
+    }
+    chan_done(c, cur, seq);
+  }
+}
+
 // incoming packets
 
 // process into receiving queue
 chan_t chan_receive(chan_t c, lob_t inner)
 {
+  uint32_t seq, len;
+  lob_t cur, prev;
+
   if(!c || !inner) return LOG("bad args");
-  
-  c->in = lob_push(c->in, inner);
+
+  if(!c->window)
+  {
+    if(!chan_fits(c, lob_len(inner)))
+    {
+      LOG("over the buffer cap, dropping");
+      lob_free(inner);
+      return c;
+    }
+    chan_count(c, &c->buffered, (int32_t)lob_len(inner));
+    c->in = lob_push(c->in, inner);
+    return c;
+  }
+
+  // what that frees up goes out before anything else
+  if(lob_get(inner,"ack") || lob_get(inner,"win"))
+  {
+    chan_acked(c, inner);
+    chan_flush(c);
+  }
+
+  // ack only
+  if(!(seq = lob_get_uint(inner,"seq")))
+  {
+    lob_free(inner);
+    return c;
+  }
+
+  // always answered, even dups since our last ack might be what was lost
+  c->acking = 1;
+  if(seq <= c->ack)
+  {
+    lob_free(inner);
+    return c;
+  }
+
+  // past our window (unless it fills the gap), or the caps, it's dropped w/o being acked and sent again later
+  len = (uint32_t)lob_len(inner);
+  if((c->buffered && c->buffered + len > c->window && (seq != c->ack + 1 || !c->reorder)) || !chan_fits(c, len))
+  {
+    LOG("receive buffer full, dropping %u",seq);
+    lob_free(inner);
+    return c;
+  }
+
+  // the next one in order, and any held that follow it
+  chan_count(c, &c->buffered, (int32_t)len);
+  if(seq == c->ack + 1)
+  {
+    c->in = lob_push(c->in, inner);
+    c->ack++;
+    while((cur = c->reorder) && lob_get_uint(cur,"seq") == c->ack + 1)
+    {
+      c->reorder = lob_splice(c->reorder, cur);
+      c->in = lob_push(c->in, cur);
+      c->ack++;
+    }
+    return c;
+  }
+
+  // held in order past the gap
+  for(prev = NULL, cur = c->reorder;cur && lob_get_uint(cur,"seq") < seq;prev = cur, cur = cur->next);
+  if(cur && lob_get_uint(cur,"seq") == seq)
+  {
+    chan_count(c, &c->buffered, -(int32_t)len);
+    lob_free(inner);
+    return c;
+  }
+  c->reorder = prev ? lob_insert(c->reorder, prev, inner) : lob_unshift(c->reorder, inner);
+
   return c;
 }
 
 // false to force start timers (any new handshake), true to cancel and resend last packet (after any e3x_sync)
 chan_t chan_sync(chan_t c, uint8_t sync)
 {
+  lob_t cur;
   if(!c) return NULL;
-  LOG("%d sync %d TODO",c->id,sync);
+  if(!c->window) return c;
+
+  // new keys, anything in flight under the old ones is likely gone
+  if(sync) for(cur = c->out;cur != c->unsent;cur = cur->next) chan_lost(c, cur);
+  c->retries = 0;
+  chan_flush(c);
   return c;
 }
 
@@ -103,21 +411,62 @@ lob_t chan_receiving(chan_t c)
   ret = lob_shift(c->in);
   c->in = ret->next;
   ret->next = NULL;
+  chan_count(c, &c->buffered, -(int32_t)lob_len(ret));
+
+  // the window was mostly shut and now it's mostly open, tell the other side now instead of when it asks
+  if(c->window && c->adv <= c->window / 2 && c->window - c->buffered > c->window / 2 && c->link)
+    link_send(c->link, e3x_exchange_wrap(c->link->x, chan_oob(c)));
 
-  if(lob_get(ret,"end")) c->state = CHAN_ENDED;
+  if(lob_get(ret,"end"))
+  {
+    c->state = CHAN_ENDED;
+    link_chan_timer(c->link, c); // gets cleaned up next process
+  }
 
   return ret;
 }
 
 // outgoing packets
 
-// ack/miss only base packet
+// ack/miss/win only base packet
 lob_t chan_oob(chan_t c)
 {
   if(!c) return NULL;
 
-  lob_t ret = lob_new();
-  lob_set_uint(ret,"c",c->id);
+  lob_t ret = lob_begin(lob_reserve(lob_new(),E3X_HEADROOM,E3X_TAILROOM));
+  lob_add_uint(ret,"c",c->id);
+
+  // how much more we'll take
+  if(c->window)
+  {
+    c->adv = (c->buffered < c->window) ? c->window - c->buffered : 0;
+    lob_add_uint(ret,"win",c->adv);
+  }
+
+  // what we've received, and the gaps as offsets from that
+  if(c->window && (c->ack || c->reorder))
+  {
+    char miss[2 + (CHAN_MISS * 11)];
+    size_t len = 0;
+    uint32_t next = c->ack + 1, seq, count = 0;
+    lob_t cur;
+
+    lob_add_uint(ret,"ack",c->ack);
+    for(cur = c->reorder;cur && count < CHAN_MISS;cur = cur->next)
+    {
+      for(seq = lob_get_uint(cur,"seq");next < seq && count < CHAN_MISS;next++, count++)
+        len += (size_t)sprintf(miss+len,"%c%" PRIu32,len ? ',' : '[',next - c->ack);
+      next = seq + 1;
+    }
+    if(len)
+    {
+      miss[len++] = ']';
+      lob_add_raw(ret,"miss",4,miss,len);
+      lob_add_uint(ret,"held",next - 1 - c->ack); // everything up to here is either missing or held
+    }
+    c->acking = 0;
+  }
+  lob_finish(ret);
   
   return ret;
 }
@@ -138,20 +487,53 @@ chan_t chan_send(chan_t c, lob_t inner)
 {
   if(!c || !inner) return LOG("bad args");
   
-  LOG("channel send %d %s",c->id,lob_json(inner));
+  LOG("channel send %d len %d",c->id,lob_len(inner));
   if(!c->link)
   {
     lob_free(inner);
     return LOG("dropping packet, no link");
   }
 
-  link_send(c->link, e3x_exchange_send(c->link->x, inner));
+  // kept until acked, sent when the window allows
+  if(c->window)
+  {
+    lob_set_uint(inner,"seq",c->seq + 1);
+    if(!chan_fits(c, lob_len(inner)))
+    {
+      c->blocked = 1;
+      lob_free(inner);
+      return LOG("dropping packet, over the buffer cap");
+    }
+    c->seq++;
+    chan_count(c, &c->queued, (int32_t)lob_len(inner));
+    c->out = lob_push(c->out, inner);
+    if(!c->unsent) c->unsent = inner;
+    chan_flush(c);
+    return c;
+  }
 
-  lob_free(inner);
+  // inner becomes the outer
+  link_send(c->link, e3x_exchange_wrap(c->link->x, inner));
 
   return c;
 }
 
+// what's left of the window to queue into, and of the link's and mesh's caps
+static uint32_t chan_room(chan_t c)
+{
+  uint32_t room;
+  link_t link = c->link;
+  if(!link) return 0;
+  if(!c->window) return UINT32_MAX;
+  room = (c->queued < c->window) ? c->window - c->queued : 0;
+  if(link->buffered >= link->buffer_max) return 0;
+  if(link->buffer_max - link->buffered < room) room = link->buffer_max - link->buffered;
+  if(!link->mesh) return room;
+  if(link->mesh->buffered >= link->mesh->buffer_max) return 0;
+  if(link->mesh->buffer_max - link->mesh->buffered < room) room = link->mesh->buffer_max - link->mesh->buffered;
+  return room;
+}
+
 // generates local-only error packet for next chan_process()
 chan_t chan_err(chan_t c, char *msg)
 {
@@ -161,6 +543,7 @@ chan_t chan_err(chan_t c, char *msg)
   lob_set_uint(err,"c",c->id);
   lob_set_raw(err, "end", 3, "true", 4);
   lob_set(err, "err", msg);
+  chan_count(c, &c->buffered, (int32_t)lob_len(err));
   c->in = lob_push(c->in, err); // top of the queue
   return c;
 }
@@ -171,27 +554,63 @@ chan_t chan_process(chan_t c, uint32_t now)
   if(!c) return NULL;
 
   // do timeout checks
-  if(now)
+  if(now && c->state != CHAN_ENDED)
   {
-    if(c->timeout)
+    // an absolute deadline, the link only processes this once it's past
+    if(c->timeout && now > c->timeout)
     {
-      // trigger error
-      if(now > c->timeout)
+      c->timeout = 0;
+      chan_err(c, "timeout");
+    }
+    c->trecv = now;
+  }
+
+  // resend what's been unacked too long (on the link's clock), backing off each time
+  if(c->tresend && (int32_t)(chan_now(c) - c->tresend) > 0)
+  {
+    uint32_t interval = chan_interval(c), at = chan_now(c);
+    lob_t cur;
+    if(!c->flight)
+    {
+      // nothing's lost, the other side's window is shut, resending a seq it has gets a fresh one back
+      if(c->acked && c->link) link_send(c->link, e3x_exchange_wrap(c->link->x, lob_set_uint(chan_oob(c),"seq",c->acked)));
+      chan_rearm(c);
+    }else if(++c->retries > CHAN_RETRIES){
+      for(cur = c->out;cur;cur = cur->next) chan_landed(c, cur);
+      c->out = lob_freeall(c->out);
+      c->unsent = NULL;
+      c->resends = 0;
+      chan_count(c, &c->queued, -(int32_t)c->queued);
+      c->tresend = 0;
+      chan_err(c, "timeout");
+    }else{
+      // anything lost again waits for the next timeout
+      for(cur = c->out;cur != c->unsent;cur = cur->next)
       {
-        c->timeout = 0;
-        chan_err(c, "timeout");
-      }else if(c->trecv){
-        // kick forward when we have a time difference
-        c->timeout += (now - c->trecv);
+        if(!cur->id) continue;
+        c->missed = lob_get_uint(cur,"seq");
+        if(at - cur->id >= interval) chan_lost(c, cur);
       }
+      if(c->link) util_cc_timeout(&c->link->cc);
+      chan_flush(c);
     }
-    c->trecv = now;
   }
   
   // fire receiving handlers
   if(c->in && c->handle) c->handle(c, c->arg);
 
-  if(c->state == CHAN_ENDED)
+  // ack on its own if nothing sent by the handler carried it
+  if(c->acking && c->link) link_send(c->link, e3x_exchange_wrap(c->link->x, chan_oob(c)));
+
+  // acks made room to send again
+  if(c->blocked && c->writable && chan_room(c) > c->window / 2)
+  {
+    c->blocked = 0;
+    c->writable(c, c->arg);
+  }
+
+  // not while sending, it's cleaned up on the next link_process instead
+  if(c->state == CHAN_ENDED && !c->flushing)
   {
     LOG("channel is now ended, freeing it");
     c = chan_free(c);
@@ -203,19 +622,24 @@ chan_t chan_process(chan_t c, uint32_t now)
 // size (in bytes) of buffered data in or out
 uint32_t chan_size(chan_t c)
 {
-  uint32_t size = 0;
-  lob_t cur;
   if(!c) return 0;
+  return c->buffered + c->queued;
+}
 
-  // add up the sizes of the in and out buffers
-  cur = c->in;
-  while(cur)
-  {
-    size += lob_len(cur);
-    cur = cur->next;
-  }
+uint32_t chan_writable(chan_t c)
+{
+  uint32_t room;
+  if(!c) return 0;
+  room = chan_room(c);
+  if(room <= c->window / 2) c->blocked = 1;
+  return room;
+}
 
-  return size;
+chan_t chan_on_writable(chan_t c, void (*writable)(chan_t c, void *arg))
+{
+  if(!c) return LOG("bad args");
+  c->writable = writable;
+  return c;
 }
 
 // set up internal handler for all incoming packets on this channel
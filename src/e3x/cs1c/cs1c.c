@@ -25,12 +25,16 @@ typedef struct remote_struct
 {
   uint8_t key[KEY_BYTES];
   uint8_t esecret[SECRET_BYTES], ekey[KEY_BYTES], ecomp[COMP_BYTES];
+  struct aes_128_key_struct okey; // aes key for the handshakes we send, both keys are fixed so it's made (and expanded) once
+  uint8_t shared[SHARED_BYTES]; // static-static secret for the hmac, made on first use w/ local
+  local_t local;
   uint32_t seq;
 } *remote_t;
 
 typedef struct ephemeral_struct
 {
   uint8_t enckey[16], deckey[16], token[16];
+  struct aes_128_key_struct enc, dec; // expanded once here instead of for every packet
   uint32_t seq;
 } *ephemeral_t;
 
@@ -47,13 +51,16 @@ static lob_t local_sign(local_t local, lob_t args, uint8_t *data, size_t len);
 
 static remote_t remote_new(lob_t key, uint8_t *token);
 static void remote_free(remote_t remote);
+static remote_t remote_dup(remote_t remote);
 static uint8_t remote_verify(remote_t remote, local_t local, lob_t outer);
 static lob_t remote_encrypt(remote_t remote, local_t local, lob_t inner);
 static uint8_t remote_validate(remote_t remote, lob_t args, lob_t sig, uint8_t *data, size_t len);
+static uint32_t remote_validate_batch(e3x_validate_t *items, uint32_t count);
 
 static ephemeral_t ephemeral_new(remote_t remote, lob_t outer);
 static void ephemeral_free(ephemeral_t ephemeral);
 static lob_t ephemeral_encrypt(ephemeral_t ephemeral, lob_t inner);
+static lob_t ephemeral_wrap(ephemeral_t ephemeral, lob_t inner);
 static lob_t ephemeral_decrypt(ephemeral_t ephemeral, lob_t outer);
 
 
@@ -79,6 +86,7 @@ e3x_cipher_t cs1c_init(lob_t options)
 
   // normal init stuff
   uECC_set_rng(&RNG);
+  uECC_precompute(curve); // faster keys/ephemerals/signing when built w/ uECC_FIXED_BASE
 
   // configure our callbacks (no RNG, default to platform's)
   ret->hash = cipher_hash;
@@ -92,12 +100,15 @@ e3x_cipher_t cs1c_init(lob_t options)
   ret->local_sign = (lob_t (*)(void *, lob_t, uint8_t *, size_t))local_sign;
   ret->remote_new = (void *(*)(lob_t, uint8_t *))remote_new;
   ret->remote_free = (void (*)(void *))remote_free;
+  ret->remote_dup = (void *(*)(void *))remote_dup;
   ret->remote_verify = (uint8_t (*)(void *, void *, lob_t))remote_verify;
   ret->remote_encrypt = (lob_t (*)(void *, void *, lob_t))remote_encrypt;
   ret->remote_validate = (uint8_t (*)(void *, lob_t, lob_t, uint8_t *, size_t))remote_validate;
+  ret->remote_validate_batch = remote_validate_batch;
   ret->ephemeral_new = (void *(*)(void *, lob_t))ephemeral_new;
   ret->ephemeral_free = (void (*)(void *))ephemeral_free;
   ret->ephemeral_encrypt = (lob_t (*)(void *, lob_t))ephemeral_encrypt;
+  ret->ephemeral_wrap = (lob_t (*)(void *, lob_t))ephemeral_wrap;
   ret->ephemeral_decrypt = (lob_t (*)(void *, lob_t))ephemeral_decrypt;
 
   return ret;
@@ -242,7 +253,7 @@ lob_t local_sign(local_t local, lob_t args, uint8_t *data, size_t len)
 
 remote_t remote_new(lob_t key, uint8_t *token)
 {
-  uint8_t hash[32];
+  uint8_t shared[SHARED_BYTES], hash[32];
   remote_t remote;
   if(!key || key->body_len != COMP_BYTES) return LOG("invalid key %d != %d",(key)?key->body_len:0,COMP_BYTES);
 
@@ -253,6 +264,17 @@ remote_t remote_new(lob_t key, uint8_t *token)
   uECC_decompress(key->body,remote->key, curve);
   uECC_make_key(remote->ekey, remote->esecret, curve);
   uECC_compress(remote->ekey, remote->ecomp, curve);
+
+  // the key for the open aes of every handshake we send
+  if(!uECC_shared_secret(remote->key, remote->esecret, shared, curve))
+  {
+    free(remote);
+    return LOG("ECDH failed");
+  }
+  e3x_hash(shared,SHARED_BYTES,hash);
+  fold1(hash,hash);
+  aes_128_setkey(&(remote->okey),hash);
+
   if(token)
   {
     cipher_hash(remote->ecomp,16,hash);
@@ -270,6 +292,23 @@ void remote_free(remote_t remote)
   free(remote);
 }
 
+remote_t remote_dup(remote_t remote)
+{
+  remote_t dup;
+  if(!remote || !(dup = malloc(sizeof(struct remote_struct)))) return NULL;
+  memcpy(dup,remote,sizeof(struct remote_struct));
+  return dup;
+}
+
+// the static-static secret, only computed again for a different local
+static uint8_t *remote_shared(remote_t remote, local_t local)
+{
+  if(remote->local == local) return remote->shared;
+  if(!uECC_shared_secret(remote->key, local->secret, remote->shared, curve)) return NULL;
+  remote->local = local;
+  return remote->shared;
+}
+
 uint8_t remote_verify(remote_t remote, local_t local, lob_t outer)
 {
   uint8_t shared[SHARED_BYTES+4], hash[32];
@@ -278,7 +317,8 @@ uint8_t remote_verify(remote_t remote, local_t local, lob_t outer)
   if(outer->head_len != 1 || outer->head[0] != 0x1c) return 2;
 
   // generate the key for the hmac, combining the shared secret and IV
-  if(!uECC_shared_secret(remote->key, local->secret, shared, curve)) return 3;
+  if(!remote_shared(remote, local)) return 3;
+  memcpy(shared,remote->shared,SHARED_BYTES);
   memcpy(shared+SHARED_BYTES,outer->body+33,4);
 
   // verify
@@ -307,20 +347,18 @@ lob_t remote_encrypt(remote_t remote, local_t local, lob_t inner)
   // copy in the ephemeral public key
   memcpy(outer->body, remote->ecomp, COMP_BYTES);
 
-  // get the shared secret to create the iv+key for the open aes
-  if(!uECC_shared_secret(remote->key, remote->esecret, shared, curve)) return lob_free(outer);
-  e3x_hash(shared,SHARED_BYTES,hash);
-  fold1(hash,hash);
+  // create the iv, the key for the open aes was made in remote_new
   memset(iv,0,16);
   memcpy(iv,&(remote->seq),4);
   remote->seq++; // increment seq after every use
   memcpy(outer->body+33,iv,4); // send along the used IV
 
   // encrypt the inner into the outer
-  aes_128_ctr(hash,inner_len,iv,lob_raw(inner),outer->body+33+4);
+  aes_128_ctr_key(&(remote->okey),inner_len,iv,lob_raw(inner),outer->body+33+4);
 
   // generate secret for hmac
-  if(!uECC_shared_secret(remote->key, local->secret, shared, curve)) return lob_free(outer);
+  if(!remote_shared(remote, local)) return lob_free(outer);
+  memcpy(shared,remote->shared,SHARED_BYTES);
   memcpy(shared+SHARED_BYTES,outer->body+33,4); // use the IV too
 
   hmac_256(shared,SHARED_BYTES+4,outer->body,33+4+inner_len,hash);
@@ -341,7 +379,7 @@ uint8_t remote_validate(remote_t remote, lob_t args, lob_t sig, uint8_t *data, s
     return (util_ct_memcmp(sig->body,hash,32) == 0) ? 0 : 3;
   }
 
-  if(lob_get_cmp(args,"alg","ES160") == 0)
+  if(lob_get_cmp(args,"alg","ES256") == 0)
   {
     if(!remote || sig->body_len != KEY_BYTES) return 2;
     // hash data first
@@ -352,6 +390,51 @@ uint8_t remote_validate(remote_t remote, lob_t args, lob_t sig, uint8_t *data, s
   return 3;
 }
 
+// the ES256 ones in a batch are verified together so uECC can share its inversions across them
+static uint32_t validate_es(e3x_validate_t *es, uint32_t count)
+{
+  const uint8_t *keys[uECC_BATCH_SIZE], *hashes[uECC_BATCH_SIZE], *sigs[uECC_BATCH_SIZE];
+  uint8_t hash[uECC_BATCH_SIZE][32], ok[uECC_BATCH_SIZE];
+  uint32_t i, valid;
+
+  for(i=0;i<count;i++)
+  {
+    e3x_hash(es[i]->data,es[i]->len,hash[i]);
+    keys[i] = ((remote_t)es[i]->remote)->key;
+    hashes[i] = hash[i];
+    sigs[i] = es[i]->sig->body;
+  }
+  valid = (uint32_t)uECC_verify_batch(keys, hashes, 32, sigs, count, ok, curve);
+  for(i=0;i<count;i++) es[i]->err = ok[i] ? 0 : 3;
+  return valid;
+}
+
+uint32_t remote_validate_batch(e3x_validate_t *items, uint32_t count)
+{
+  e3x_validate_t item, es[uECC_BATCH_SIZE];
+  uint32_t i, num = 0, valid = 0;
+
+  for(i=0;i<count;i++)
+  {
+    item = items[i];
+    // anything else goes one at a time
+    if(!item->remote || !item->args || !item->sig || !item->data || !item->len || item->sig->body_len != KEY_BYTES || lob_get_cmp(item->args,"alg","ES256") != 0)
+    {
+      if(!(item->err = remote_validate(item->remote,item->args,item->sig,item->data,item->len))) valid++;
+      continue;
+    }
+    es[num++] = item;
+    if(num == uECC_BATCH_SIZE)
+    {
+      valid += validate_es(es, num);
+      num = 0;
+    }
+  }
+  if(num) valid += validate_es(es, num);
+
+  return valid;
+}
+
 ephemeral_t ephemeral_new(remote_t remote, lob_t outer)
 {
   uint8_t ekey[KEY_BYTES], shared[SHARED_BYTES+((COMP_BYTES)*2)], hash[32];
@@ -389,6 +472,9 @@ ephemeral_t ephemeral_new(remote_t remote, lob_t outer)
   e3x_hash(shared,SHARED_BYTES+((COMP_BYTES)*2),hash);
   fold1(hash,ephem->deckey);
 
+  aes_128_setkey(&(ephem->enc),ephem->enckey);
+  aes_128_setkey(&(ephem->dec),ephem->deckey);
+
   return ephem;
 }
 
@@ -397,15 +483,10 @@ void ephemeral_free(ephemeral_t ephem)
   free(ephem);
 }
 
-lob_t ephemeral_encrypt(ephemeral_t ephem, lob_t inner)
+// the outer body already has the plaintext inner at body+16+4, encrypt it there and frame it
+static lob_t ephemeral_seal(ephemeral_t ephem, lob_t outer, size_t inner_len)
 {
-  lob_t outer;
   uint8_t iv[16], hmac[32];
-  size_t inner_len;
-
-  outer = lob_new();
-  inner_len = lob_len(inner);
-  if(!lob_body(outer,NULL,16+4+inner_len+4)) return lob_free(outer);
 
   // copy in token and create/copy iv
   memcpy(outer->body,ephem->token,16);
@@ -414,8 +495,8 @@ lob_t ephemeral_encrypt(ephemeral_t ephem, lob_t inner)
   ephem->seq++;
   memcpy(outer->body+16,iv,4);
 
-  // encrypt full inner into the outer
-  aes_128_ctr(ephem->enckey,inner_len,iv,lob_raw(inner),outer->body+16+4);
+  // encrypt full inner in place
+  aes_128_ctr_key(&(ephem->enc),inner_len,iv,outer->body+16+4,outer->body+16+4);
 
   // generate mac key and mac the ciphertext
   memcpy(hmac,ephem->enckey,16);
@@ -426,6 +507,27 @@ lob_t ephemeral_encrypt(ephemeral_t ephem, lob_t inner)
   return outer;
 }
 
+lob_t ephemeral_encrypt(ephemeral_t ephem, lob_t inner)
+{
+  lob_t outer;
+  size_t inner_len;
+
+  outer = lob_new();
+  inner_len = lob_len(inner);
+  if(!lob_body(outer,NULL,16+4+inner_len+4)) return lob_free(outer);
+  memcpy(outer->body+16+4,lob_raw(inner),inner_len);
+
+  return ephemeral_seal(ephem,outer,inner_len);
+}
+
+// same as ephemeral_encrypt but turns inner into the outer, no copy if it has the room
+lob_t ephemeral_wrap(ephemeral_t ephem, lob_t inner)
+{
+  size_t inner_len = lob_len(inner);
+  if(!lob_wrap(inner,16+4,4)) return NULL;
+  return ephemeral_seal(ephem,inner,inner_len);
+}
+
 lob_t ephemeral_decrypt(ephemeral_t ephem, lob_t outer)
 {
   uint8_t iv[16], hmac[32];
@@ -442,7 +544,7 @@ lob_t ephemeral_decrypt(ephemeral_t ephem, lob_t outer)
   if(util_ct_memcmp(hmac,outer->body+(outer->body_len-4),4) != 0) return LOG("hmac failed");
 
   // decrypt in place
-  aes_128_ctr(ephem->deckey,outer->body_len-(16+4+4),iv,outer->body+16+4,outer->body+16+4);
+  aes_128_ctr_key(&(ephem->dec),outer->body_len-(16+4+4),iv,outer->body+16+4,outer->body+16+4);
 
   // return parse attempt
   return lob_parse(outer->body+16+4, outer->body_len-(16+4+4));
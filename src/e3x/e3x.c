@@ -13,6 +13,11 @@ uint8_t e3x_init(lob_t options)
   util_sys_random_init();
   err = e3x_cipher_init(options);
   if(err) return err;
+
+  // aes builds its tables on first use, do that now so threads only ever read them
+  uint8_t zero[16] = {0};
+  aes_128_ctr(zero,0,zero,zero,zero);
+
   _initialized = 1;
   return 0;
 }
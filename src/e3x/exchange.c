@@ -90,6 +90,54 @@ uint8_t e3x_exchange_validate(e3x_exchange_t x, lob_t args, lob_t sig, uint8_t *
   return cs->remote_validate(remote,args,sig,data,len);
 }
 
+// which cs validates this item, if any
+static e3x_cipher_t exchange_validator(lob_t args)
+{
+  char *alg = lob_get(args,"alg");
+  e3x_cipher_t cs = alg ? e3x_cipher_set(0,alg) : NULL;
+  if(!cs || !cs->remote_validate) return NULL;
+  return cs;
+}
+
+uint32_t e3x_exchange_validate_batch(e3x_exchange_t *xs, e3x_validate_t items, uint32_t count)
+{
+  e3x_validate_t *batch;
+  e3x_cipher_t cs;
+  uint32_t i, num, set, valid = 0;
+  if(!items || !count) return 0;
+
+  // first anything that can't be batched
+  for(i=0;i<count;i++)
+  {
+    items[i].remote = NULL;
+    items[i].err = 1;
+    if(!items[i].data || !items[i].len || !(cs = exchange_validator(items[i].args)))
+    {
+      LOG("no validate support for item %u",i);
+      continue;
+    }
+    if(xs && xs[i] && xs[i]->cs == cs) items[i].remote = xs[i]->remote;
+    if(cs->remote_validate_batch) continue;
+    if(!(items[i].err = cs->remote_validate(items[i].remote,items[i].args,items[i].sig,items[i].data,items[i].len))) valid++;
+  }
+
+  // then the rest together per cs
+  if(!(batch = malloc(count * sizeof(e3x_validate_t))))
+  {
+    LOG("OOM");
+    return valid;
+  }
+  for(set=0;set<CS_MAX;set++)
+  {
+    if(!(cs = e3x_cipher_sets[set]) || !cs->remote_validate_batch) continue;
+    for(num=i=0;i<count;i++) if(items[i].data && items[i].len && exchange_validator(items[i].args) == cs) batch[num++] = &items[i];
+    if(num) valid += cs->remote_validate_batch(batch, num);
+  }
+  free(batch);
+
+  return valid;
+}
+
 // will return the current outgoing at value, optional arg to update it
 uint32_t e3x_exchange_out(e3x_exchange_t x, uint32_t at)
 {
@@ -161,6 +209,47 @@ e3x_exchange_t e3x_exchange_sync(e3x_exchange_t x, lob_t outer)
   return x;
 }
 
+// a copy sharing nothing mutable with x, so verify/sync can run on it from another thread
+e3x_exchange_t e3x_exchange_dup(e3x_exchange_t x)
+{
+  e3x_exchange_t dup;
+  if(!x) return LOG("bad args");
+  if(!x->cs->remote_dup) return LOG("%s can't dup",x->cs->hex);
+
+  if(!(dup = malloc(sizeof (struct e3x_exchange_struct)))) return LOG("OOM");
+  memcpy(dup,x,sizeof (struct e3x_exchange_struct));
+  dup->ephem = NULL; // eid is kept, syncing to the same one again is free
+  if(!(dup->remote = x->cs->remote_dup(x->remote)))
+  {
+    free(dup);
+    return LOG("remote dup failed");
+  }
+  return dup;
+}
+
+// e3x_exchange_sync() but takes the ephemeral a dup already synced to this handshake, NULL if the dup doesn't apply
+e3x_exchange_t e3x_exchange_adopt(e3x_exchange_t x, e3x_exchange_t dup, lob_t outer)
+{
+  if(!x || !dup || !outer || outer->body_len < 16) return LOG("bad args");
+
+  // the token is unique to each remote instance, so a different one means x was reloaded since
+  if(x->cs != dup->cs || memcmp(x->token,dup->token,16) != 0) return LOG("dup is from another remote");
+  if(util_ct_memcmp(outer->body,dup->eid,16) != 0) return LOG("dup not synced to this handshake");
+  if(!dup->ephem && util_ct_memcmp(outer->body,x->eid,16) != 0) return LOG("dup has no ephemeral for this handshake");
+
+  if(x->in > x->out) x->out = x->in;
+  if(util_ct_memcmp(outer->body,x->eid,16) != 0)
+  {
+    x->cs->ephemeral_free(x->ephem);
+    x->ephem = dup->ephem;
+    dup->ephem = NULL;
+    memcpy(x->eid,outer->body,16);
+    x->last = 0;
+  }
+
+  return x;
+}
+
 // just a convenience, generates handshake w/ current e3x_exchange_at value
 lob_t e3x_exchange_handshake(e3x_exchange_t x, lob_t inner)
 {
@@ -224,6 +313,32 @@ lob_t e3x_exchange_send(e3x_exchange_t x, lob_t inner)
   return outer;
 }
 
+// same as e3x_exchange_send but consumes inner, encrypting it in place when the cipher set supports it
+lob_t e3x_exchange_wrap(e3x_exchange_t x, lob_t inner)
+{
+  lob_t outer;
+  if(!x || !inner) return lob_free(inner);
+  if(!x->cs->ephemeral_wrap)
+  {
+    outer = e3x_exchange_send(x,inner);
+    lob_free(inner);
+    return outer;
+  }
+  if(!x->ephem)
+  {
+    lob_free(inner);
+    return LOG("no handshake");
+  }
+  LOG("encrypting head %d body %d",inner->head_len,inner->body_len);
+  outer = x->cs->ephemeral_wrap(x->ephem,inner);
+  if(!outer)
+  {
+    lob_free(inner);
+    return LOG("encryption failed %s",x->cs->err());
+  }
+  return outer;
+}
+
 // validate the next incoming channel id from the packet, or return the next avail outgoing channel id
 uint32_t e3x_exchange_cid(e3x_exchange_t x, lob_t incoming)
 {
@@ -29,16 +29,110 @@
 #include <string.h>
 #include "aes128.h"
 
+// AES-NI, the cpu is checked at runtime
+#if !defined(AES_128_NO_HW) && defined(__x86_64__) && defined(__GNUC__)
+#define AES_128_NI 1
+#include <wmmintrin.h>
+#define AES_128_BLOCKS 8 // in flight at once, aesenc has ~4 cycles latency and 1/cycle throughput
+#endif
+
+static uint8_t aes_hw_off = 0;
+
 void aes_128_ctr(unsigned char *key, size_t length, unsigned char iv[16], const unsigned char *input, unsigned char *output)
+{
+  struct aes_128_key_struct expanded;
+  aes_128_setkey(&expanded,key);
+  aes_128_ctr_key(&expanded,length,iv,input,output);
+}
+
+void aes_128_setkey(aes_128_key_t key, const unsigned char raw[16])
+{
+  mbedtls_aes_context ctx;
+  mbedtls_aes_setkey_enc(&ctx,raw,128);
+  memcpy(key->rk,ctx.rk,sizeof(key->rk));
+}
+
+#ifdef AES_128_NI
+// the whole 16 bytes are a big-endian counter (the same as mbedtls_aes_crypt_ctr), kept as two halves here
+__attribute__((target("aes,sse2")))
+static void aes_128_ctr_ni(aes_128_key_t key, size_t length, unsigned char iv[16], const unsigned char *input, unsigned char *output)
+{
+  __m128i rk[11], b[AES_128_BLOCKS];
+  unsigned char stream[16];
+  uint64_t hi, lo;
+  size_t i, j, n;
+
+  for(i=0;i<11;i++) rk[i] = _mm_loadu_si128((const __m128i*)(key->rk+(i*4)));
+  memcpy(&hi,iv,8);
+  memcpy(&lo,iv+8,8);
+  hi = __builtin_bswap64(hi);
+  lo = __builtin_bswap64(lo);
+
+  while(length)
+  {
+    n = (length + 15) / 16;
+    if(n > AES_128_BLOCKS) n = AES_128_BLOCKS;
+    for(i=0;i<n;i++)
+    {
+      b[i] = _mm_xor_si128(_mm_set_epi64x((long long)__builtin_bswap64(lo), (long long)__builtin_bswap64(hi)), rk[0]);
+      if(++lo == 0) hi++;
+    }
+    for(j=1;j<10;j++) for(i=0;i<n;i++) b[i] = _mm_aesenc_si128(b[i], rk[j]);
+    for(i=0;i<n;i++) b[i] = _mm_aesenclast_si128(b[i], rk[10]);
+
+    for(i=0;i<n;i++)
+    {
+      if(length < 16)
+      {
+        _mm_storeu_si128((__m128i*)stream, b[i]);
+        for(j=0;j<length;j++) output[j] = input[j] ^ stream[j];
+        length = 0;
+        break;
+      }
+      _mm_storeu_si128((__m128i*)output, _mm_xor_si128(b[i], _mm_loadu_si128((const __m128i*)input)));
+      input += 16;
+      output += 16;
+      length -= 16;
+    }
+  }
+
+  hi = __builtin_bswap64(hi);
+  lo = __builtin_bswap64(lo);
+  memcpy(iv,&hi,8);
+  memcpy(iv+8,&lo,8);
+}
+#endif
+
+void aes_128_ctr_key(aes_128_key_t key, size_t length, unsigned char iv[16], const unsigned char *input, unsigned char *output)
 {
   mbedtls_aes_context ctx;
   size_t off = 0;
   unsigned char block[16];
 
-  mbedtls_aes_setkey_enc(&ctx,key,128);
+#ifdef AES_128_NI
+  if(!aes_hw_off && __builtin_cpu_supports("aes"))
+  {
+    aes_128_ctr_ni(key,length,iv,input,output);
+    return;
+  }
+#endif
+
+  // the tables use the round keys in place
+  ctx.nr = 10;
+  ctx.rk = key->rk;
   mbedtls_aes_crypt_ctr(&ctx,length,&off,iv,block,input,output);
 }
 
+uint8_t aes_128_hw(uint8_t enable)
+{
+  aes_hw_off = !enable;
+#ifdef AES_128_NI
+  return (!aes_hw_off && __builtin_cpu_supports("aes")) ? 1 : 0;
+#else
+  return 0;
+#endif
+}
+
 /* Implementation that should never be optimized out by the compiler */
 static void mbedtls_zeroize( void *v, size_t n ) {
     volatile unsigned char *p = v; while( n-- ) *p++ = 0;
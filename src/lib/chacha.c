@@ -246,15 +246,199 @@ void chacha_encrypt_bytes (chacha_ctx *x, const u8 *m, u8 *c, u32 bytes)
 }
 
 
+// SSE2 (4 blocks) and AVX2 (8 blocks) at once, the cpu is checked at runtime
+#if !defined(CHACHA_NO_HW) && defined(__x86_64__) && defined(__GNUC__)
+#define CHACHA_SIMD 1
+#include <immintrin.h>
+#endif
+
+static uint8_t chacha_level = 2; // the most chacha20_hw() allows
+
+#ifdef CHACHA_SIMD
+// each vector holds one state word from every block, the 64 bit counter is per block
+static void chacha_counters(chacha_ctx *x, u32 n, u32 *lo, u32 *hi)
+{
+	u32 i;
+	for (i = 0; i < n; i++) {
+		lo[i] = x->input[12] + i;
+		hi[i] = x->input[13] + (lo[i] < x->input[12]);
+	}
+}
+
+static void chacha_advance(chacha_ctx *x, u32 n)
+{
+	x->input[12] += n;
+	if (x->input[12] < n)
+		x->input[13]++;
+}
+
+#define SSE_ROTATE(v,c) _mm_or_si128(_mm_slli_epi32(v, c), _mm_srli_epi32(v, 32 - (c)))
+#define SSE_ROTATE16(v) _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xb1), 0xb1)
+#define SSE_QUARTERROUND(a,b,c,d) \
+  a = _mm_add_epi32(a, b); d = SSE_ROTATE16(_mm_xor_si128(d, a)); \
+  c = _mm_add_epi32(c, d); b = SSE_ROTATE(_mm_xor_si128(b, c), 12); \
+  a = _mm_add_epi32(a, b); d = SSE_ROTATE(_mm_xor_si128(d, a), 8); \
+  c = _mm_add_epi32(c, d); b = SSE_ROTATE(_mm_xor_si128(b, c), 7);
+
+// 4 blocks of keystream xor'd from m into c, or just the keystream when m is NULL, the caller advances the counter
+__attribute__((target("sse2")))
+static void chacha_blocks_sse2(chacha_ctx *x, const u8 *m, u8 *c)
+{
+	__m128i v[16], j[16], t0, t1, t2, t3;
+	u32 lo[4], hi[4], i, g, b;
+
+	chacha_counters(x, 4, lo, hi);
+	for (i = 0; i < 16; i++)
+		j[i] = _mm_set1_epi32((int)x->input[i]);
+	j[12] = _mm_loadu_si128((const __m128i *)lo);
+	j[13] = _mm_loadu_si128((const __m128i *)hi);
+	for (i = 0; i < 16; i++)
+		v[i] = j[i];
+
+	for (i = 20; i > 0; i -= 2) {
+		SSE_QUARTERROUND(v[0], v[4], v[8], v[12])
+		SSE_QUARTERROUND(v[1], v[5], v[9], v[13])
+		SSE_QUARTERROUND(v[2], v[6], v[10], v[14])
+		SSE_QUARTERROUND(v[3], v[7], v[11], v[15])
+		SSE_QUARTERROUND(v[0], v[5], v[10], v[15])
+		SSE_QUARTERROUND(v[1], v[6], v[11], v[12])
+		SSE_QUARTERROUND(v[2], v[7], v[8], v[13])
+		SSE_QUARTERROUND(v[3], v[4], v[9], v[14])
+	}
+	for (i = 0; i < 16; i++)
+		v[i] = _mm_add_epi32(v[i], j[i]);
+
+	// transpose each group of 4 words back into per-block order
+	for (g = 0; g < 16; g += 4) {
+		t0 = _mm_unpacklo_epi32(v[g], v[g + 1]);
+		t1 = _mm_unpacklo_epi32(v[g + 2], v[g + 3]);
+		t2 = _mm_unpackhi_epi32(v[g], v[g + 1]);
+		t3 = _mm_unpackhi_epi32(v[g + 2], v[g + 3]);
+		j[0] = _mm_unpacklo_epi64(t0, t1);
+		j[1] = _mm_unpackhi_epi64(t0, t1);
+		j[2] = _mm_unpacklo_epi64(t2, t3);
+		j[3] = _mm_unpackhi_epi64(t2, t3);
+		for (b = 0; b < 4; b++) {
+			if (m)
+				j[b] = _mm_xor_si128(j[b], _mm_loadu_si128((const __m128i *)(m + b * 64 + g * 4)));
+			_mm_storeu_si128((__m128i *)(c + b * 64 + g * 4), j[b]);
+		}
+	}
+}
+
+#define AVX_ROTATE(v,c) _mm256_or_si256(_mm256_slli_epi32(v, c), _mm256_srli_epi32(v, 32 - (c)))
+#define AVX_QUARTERROUND(a,b,c,d) \
+  a = _mm256_add_epi32(a, b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot16); \
+  c = _mm256_add_epi32(c, d); b = AVX_ROTATE(_mm256_xor_si256(b, c), 12); \
+  a = _mm256_add_epi32(a, b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot8); \
+  c = _mm256_add_epi32(c, d); b = AVX_ROTATE(_mm256_xor_si256(b, c), 7);
+
+// 8 whole blocks xor'd from m into c
+__attribute__((target("avx2")))
+static void chacha_blocks_avx2(chacha_ctx *x, const u8 *m, u8 *c)
+{
+	__m256i v[16], j[16], t0, t1, t2, t3, rot16, rot8;
+	u32 lo[8], hi[8], i, g, b;
+
+	rot16 = _mm256_set_epi8(13,12,15,14, 9,8,11,10, 5,4,7,6, 1,0,3,2, 13,12,15,14, 9,8,11,10, 5,4,7,6, 1,0,3,2);
+	rot8 = _mm256_set_epi8(14,13,12,15, 10,9,8,11, 6,5,4,7, 2,1,0,3, 14,13,12,15, 10,9,8,11, 6,5,4,7, 2,1,0,3);
+
+	chacha_counters(x, 8, lo, hi);
+	for (i = 0; i < 16; i++)
+		j[i] = _mm256_set1_epi32((int)x->input[i]);
+	j[12] = _mm256_loadu_si256((const __m256i *)lo);
+	j[13] = _mm256_loadu_si256((const __m256i *)hi);
+	for (i = 0; i < 16; i++)
+		v[i] = j[i];
+
+	for (i = 20; i > 0; i -= 2) {
+		AVX_QUARTERROUND(v[0], v[4], v[8], v[12])
+		AVX_QUARTERROUND(v[1], v[5], v[9], v[13])
+		AVX_QUARTERROUND(v[2], v[6], v[10], v[14])
+		AVX_QUARTERROUND(v[3], v[7], v[11], v[15])
+		AVX_QUARTERROUND(v[0], v[5], v[10], v[15])
+		AVX_QUARTERROUND(v[1], v[6], v[11], v[12])
+		AVX_QUARTERROUND(v[2], v[7], v[8], v[13])
+		AVX_QUARTERROUND(v[3], v[4], v[9], v[14])
+	}
+	for (i = 0; i < 16; i++)
+		v[i] = _mm256_add_epi32(v[i], j[i]);
+
+	// the unpacks work within each 128 bit lane, so the low lane ends up blocks 0-3 and the high lane 4-7
+	for (g = 0; g < 16; g += 4) {
+		t0 = _mm256_unpacklo_epi32(v[g], v[g + 1]);
+		t1 = _mm256_unpacklo_epi32(v[g + 2], v[g + 3]);
+		t2 = _mm256_unpackhi_epi32(v[g], v[g + 1]);
+		t3 = _mm256_unpackhi_epi32(v[g + 2], v[g + 3]);
+		j[0] = _mm256_unpacklo_epi64(t0, t1);
+		j[1] = _mm256_unpackhi_epi64(t0, t1);
+		j[2] = _mm256_unpacklo_epi64(t2, t3);
+		j[3] = _mm256_unpackhi_epi64(t2, t3);
+		for (b = 0; b < 4; b++) {
+			_mm_storeu_si128((__m128i *)(c + b * 64 + g * 4),
+			    _mm_xor_si128(_mm256_castsi256_si128(j[b]), _mm_loadu_si128((const __m128i *)(m + b * 64 + g * 4))));
+			_mm_storeu_si128((__m128i *)(c + (b + 4) * 64 + g * 4),
+			    _mm_xor_si128(_mm256_extracti128_si256(j[b], 1), _mm_loadu_si128((const __m128i *)(m + (b + 4) * 64 + g * 4))));
+		}
+	}
+}
+
+// as much as the vector paths can do, returns how many bytes are left for chacha_encrypt_bytes()
+static u32 chacha_encrypt_simd(chacha_ctx *x, const u8 *m, u8 *c, u32 bytes)
+{
+	u8 tmp[256];
+	u32 i;
+
+	if (chacha_level >= 2 && __builtin_cpu_supports("avx2")) {
+		for (; bytes >= 512; bytes -= 512, m += 512, c += 512) {
+			chacha_blocks_avx2(x, m, c);
+			chacha_advance(x, 8);
+		}
+	}
+	if (chacha_level < 1)
+		return bytes;
+	for (; bytes >= 256; bytes -= 256, m += 256, c += 256) {
+		chacha_blocks_sse2(x, m, c);
+		chacha_advance(x, 4);
+	}
+
+	// one or two blocks are as quick in scalar, three or four are quicker as 4 then trimmed
+	if (bytes <= 128)
+		return bytes;
+	chacha_blocks_sse2(x, NULL, tmp);
+	for (i = 0; i < bytes; i++)
+		c[i] = m[i] ^ tmp[i];
+	chacha_advance(x, (bytes + 63) / 64);
+	return 0;
+}
+#endif
+
+uint8_t chacha20_hw(uint8_t level)
+{
+	chacha_level = level;
+#ifdef CHACHA_SIMD
+	if (level >= 2 && __builtin_cpu_supports("avx2"))
+		return 2;
+	return level ? 1 : 0;
+#else
+	return 0;
+#endif
+}
+
 uint8_t *chacha20(uint8_t *key, uint8_t *nonce, uint8_t *bytes, uint32_t len)
 {
   struct chacha_ctx ctx;
+  uint32_t left = len;
   if(!len) return bytes;
 
   chacha_keysetup (&ctx, key, 32 * 8);
   chacha_ivsetup (&ctx, nonce, NULL);
 
-  chacha_encrypt_bytes (&ctx, bytes, bytes, len);
+#ifdef CHACHA_SIMD
+  // the rest picks up at the counter the vector paths left off at
+  left = chacha_encrypt_simd (&ctx, bytes, bytes, len);
+#endif
+  chacha_encrypt_bytes (&ctx, bytes + (len - left), bytes + (len - left), left);
   return bytes;
 }
 
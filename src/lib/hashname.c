@@ -9,8 +9,8 @@
 // how many csids can be used to make a hashname
 #define MAX_CSIDS 8
 
-// v* methods return this
-static struct hashname_struct hn_vtmp;
+// v* methods return this, per thread
+static UTIL_TLS struct hashname_struct hn_vtmp;
 
 hashname_t hashname_dup(hashname_t id)
 {
@@ -108,7 +108,7 @@ uint8_t *hashname_bin(hashname_t hn)
 }
 
 // 52 byte base32 string w/ \0 (TEMPORARY)
-static char hn_ctmp[53];
+static UTIL_TLS char hn_ctmp[53];
 char *hashname_char(hashname_t hn)
 {
   if(!hn) return NULL;
@@ -188,7 +188,7 @@ lob_t hashname_im(lob_t keys, uint8_t id)
 // 8 byte base32 string w/ \0 (TEMPORARY)
 char *hashname_short(hashname_t hn)
 {
-  static uint8_t tog = 1;
+  static UTIL_TLS uint8_t tog = 1;
   if(!hn) return NULL;
   tog = tog ? 0 : 26; // fit two short names in hn_ctmp for easier LOG() args
   base32_encode(hn->bin,5,hn_ctmp+tog,53-tog);
@@ -1,7 +1,12 @@
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 #include "telehash.h"
+#include "uECC.h"
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__)))
+#include <pthread.h>
+#endif
 
 // this lib implements basic JWT support using the crypto/lob utilities in telehash-c
 
@@ -121,6 +126,132 @@ lob_t jwt_verify(lob_t token, e3x_exchange_t x)
   return token;
 }
 
+// the encoded data for each, any bad ones are left w/o and fail
+static e3x_validate_t jwt_items(lob_t *tokens, uint32_t count)
+{
+  e3x_validate_t items;
+  char *dot;
+  uint32_t i;
+
+  if(!(items = malloc(count * sizeof(struct e3x_validate_struct)))) return LOG("OOM");
+  memset(items,0,count * sizeof(struct e3x_validate_struct));
+
+  for(i=0;i<count;i++)
+  {
+    if(!tokens[i] || !jwt_claims(tokens[i]) || !lob_get(tokens[i],"alg")) continue;
+    items[i].args = tokens[i];
+    items[i].sig = jwt_claims(tokens[i]);
+    if(!(items[i].data = (uint8_t*)jwt_encode(tokens[i]))) continue;
+    dot = strchr((char*)items[i].data,'.');
+    dot = strchr(dot+1,'.');
+    items[i].len = (size_t)(dot-(char*)items[i].data);
+  }
+  return items;
+}
+
+static void jwt_items_free(e3x_validate_t items, uint32_t count, uint8_t *ok)
+{
+  uint32_t i;
+  for(i=0;i<count;i++)
+  {
+    if(ok) ok[i] = (items[i].err == 0);
+    free(items[i].data);
+  }
+  free(items);
+}
+
+// verify many tokens at once, so the public key ones can be checked together
+uint32_t jwt_verify_batch(lob_t *tokens, e3x_exchange_t *xs, uint32_t count, uint8_t *ok)
+{
+  e3x_validate_t items;
+  uint32_t valid;
+  if(!tokens || !count) return 0;
+  if(!(items = jwt_items(tokens, count))) return 0;
+  valid = e3x_exchange_validate_batch(xs, items, count);
+  jwt_items_free(items, count, ok);
+  return valid;
+}
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__)))
+
+// a run of whole batches for one thread
+typedef struct jwt_slice_struct
+{
+  e3x_exchange_t *xs;
+  e3x_validate_t items;
+  uint32_t count, valid;
+  pthread_t thread;
+  uint8_t started;
+} *jwt_slice_t;
+
+static void *jwt_worker(void *arg)
+{
+  jwt_slice_t slice = arg;
+  slice->valid = e3x_exchange_validate_batch(slice->xs, slice->items, slice->count);
+  util_pool_flush(); // this thread's cache
+  return NULL;
+}
+
+// the tokens are all read (and their lob indexes built) here first, the workers only check signatures
+uint32_t jwt_verify_threads(lob_t *tokens, e3x_exchange_t *xs, uint32_t count, uint8_t *ok, uint32_t threads)
+{
+  struct jwt_slice_struct *slices;
+  e3x_validate_t items;
+  uint32_t i, at, per, valid = 0;
+  if(!tokens || !count) return 0;
+
+  // each gets whole uECC batches, more threads than that is no help
+  per = (count + uECC_BATCH_SIZE - 1) / uECC_BATCH_SIZE;
+  if(threads > per) threads = per;
+  if(threads <= 1) return jwt_verify_batch(tokens, xs, count, ok);
+  per = ((per + threads - 1) / threads) * uECC_BATCH_SIZE;
+
+  if(!(items = jwt_items(tokens, count))) return 0;
+  if(!(slices = malloc(threads * sizeof(struct jwt_slice_struct))))
+  {
+    LOG("OOM");
+    valid = e3x_exchange_validate_batch(xs, items, count);
+    jwt_items_free(items, count, ok);
+    return valid;
+  }
+  memset(slices,0,threads * sizeof(struct jwt_slice_struct));
+
+  for(i=at=0;i<threads && at<count;i++,at+=per)
+  {
+    slices[i].xs = xs ? xs+at : NULL;
+    slices[i].items = items+at;
+    slices[i].count = (count-at < per) ? count-at : per;
+  }
+
+  // the first slice is done on this thread, and any that a thread couldn't start for
+  for(i=1;i<threads;i++)
+  {
+    if(!slices[i].count) continue;
+    if(pthread_create(&(slices[i].thread), NULL, jwt_worker, &slices[i]) == 0) slices[i].started = 1;
+    else LOG("failed to start verify thread %u",i);
+  }
+  for(i=0;i<threads;i++)
+  {
+    if(!slices[i].count) continue;
+    if(slices[i].started) pthread_join(slices[i].thread, NULL);
+    else slices[i].valid = e3x_exchange_validate_batch(slices[i].xs, slices[i].items, slices[i].count);
+    valid += slices[i].valid;
+  }
+
+  free(slices);
+  jwt_items_free(items, count, ok);
+  return valid;
+}
+
+#else
+
+uint32_t jwt_verify_threads(lob_t *tokens, e3x_exchange_t *xs, uint32_t count, uint8_t *ok, uint32_t threads)
+{
+  return jwt_verify_batch(tokens, xs, count, ok);
+}
+
+#endif // POSIX
+
 // sign this token, adds signature to the claims body
 lob_t jwt_sign(lob_t token, e3x_self_t self)
 {
@@ -10,17 +10,45 @@
 #include "telehash.h"
 #include "telehash.h"
 
-lob_t lob_new()
+static char *lob_find(lob_t p, char *key, size_t klen, size_t *vlen);
+
+// struct only, raw is up to the caller
+static lob_t lob_alloc(void)
 {
   lob_t p;
-  if(!(p = malloc(sizeof (struct lob_struct)))) return LOG("OOM");
+  if(!(p = util_pool_malloc(sizeof (struct lob_struct)))) return LOG("OOM");
   memset(p,0,sizeof (struct lob_struct));
-  if(!(p->raw = malloc(2))) return lob_free(p);
+  return p;
+}
+
+lob_t lob_new()
+{
+  lob_t p;
+  if(!(p = lob_alloc())) return NULL;
+  if(!(p->raw = util_pool_malloc(2))) return lob_free(p);
   memset(p->raw,0,2);
 //  LOG("LOB++ %p",p);
   return p;
 }
 
+// make sure raw can hold len bytes, grows into any tailroom before reallocating (keeps headroom)
+static lob_t lob_space(lob_t p, size_t len)
+{
+  uint8_t *base;
+  size_t have = lob_len(p) + p->tailroom;
+
+  if(len <= have)
+  {
+    p->tailroom = have - len;
+    return p;
+  }
+
+  if(!(base = util_pool_realloc(p->raw - p->headroom, p->headroom + len))) return NULL;
+  p->raw = base + p->headroom;
+  p->tailroom = 0;
+  return p;
+}
+
 lob_t lob_copy(lob_t p)
 {
   lob_t np;
@@ -67,9 +95,10 @@ lob_t lob_free(lob_t p)
   if(p->next) LOG("possible mem leak, lob is in a list: %s->%s",lob_json(p),lob_json(p->next));
 //  LOG("LOB-- %p",p);
   if(p->chain) lob_free(p->chain);
-  if(p->cache) free(p->cache);
-  if(p->raw) free(p->raw);
-  free(p);
+  if(p->cache) util_pool_free(p->cache);
+  if(p->index) util_pool_free(p->index);
+  if(p->raw) util_pool_free(p->raw - p->headroom);
+  util_pool_free(p);
   return NULL;
 }
 
@@ -98,8 +127,8 @@ lob_t lob_parse(const uint8_t *raw, size_t len)
   if(hlen > len-2) return NULL;
 
   // copy in and update pointers
-  p = lob_new();
-  if(!(p->raw = realloc(p->raw,len))) return lob_free(p);
+  if(!(p = lob_new())) return NULL;
+  if(!lob_space(p,len)) return lob_free(p);
   memcpy(p->raw,raw,len);
   p->head_len = hlen;
   p->head = p->raw+2;
@@ -114,15 +143,98 @@ lob_t lob_parse(const uint8_t *raw, size_t len)
   return p;
 }
 
+lob_t lob_adopt(uint8_t *raw, size_t len)
+{
+  lob_t p;
+  uint16_t nlen, hlen;
+  size_t jtest;
+
+  if(!raw) return NULL;
+  if(len < 2)
+  {
+    util_pool_free(raw);
+    return NULL;
+  }
+  memcpy(&nlen,raw,2);
+  hlen = util_sys_short(nlen);
+  if(hlen > len-2 || !(p = lob_alloc()))
+  {
+    util_pool_free(raw);
+    return NULL;
+  }
+
+  // use as-is
+  p->raw = raw;
+  p->head_len = hlen;
+  p->head = p->raw+2;
+  p->body_len = len-(2+p->head_len);
+  p->body = p->raw+(2+p->head_len);
+
+  jtest = 0;
+  if(p->head_len >= 7) js0n("\0",1,(char*)p->head,p->head_len,&jtest);
+  if(jtest) return lob_free(p);
+
+  return p;
+}
+
+lob_t lob_reserve(lob_t p, size_t headroom, size_t tailroom)
+{
+  uint8_t *base;
+  size_t len;
+  if(!p) return LOG("bad args");
+  if(p->headroom >= headroom && p->tailroom >= tailroom) return p;
+
+  len = lob_len(p);
+  if(p->headroom >= headroom)
+  {
+    // only the end needs to grow
+    if(!(base = util_pool_realloc(p->raw - p->headroom, p->headroom + len + tailroom))) return LOG("OOM");
+    p->raw = base + p->headroom;
+  }else{
+    if(tailroom < p->tailroom) tailroom = p->tailroom;
+    if(!(base = util_pool_malloc(headroom + len + tailroom))) return LOG("OOM");
+    memcpy(base + headroom, p->raw, len);
+    util_pool_free(p->raw - p->headroom);
+    p->raw = base + headroom;
+    p->headroom = headroom;
+  }
+  p->tailroom = tailroom;
+  p->head = p->raw+2;
+  p->body = p->raw+(2+p->head_len);
+  return p;
+}
+
+lob_t lob_wrap(lob_t p, size_t head, size_t tail)
+{
+  size_t len;
+  if(!p) return LOG("bad args");
+
+  len = lob_len(p);
+  if(!lob_reserve(p, 2+head, tail)) return NULL;
+
+  // grow raw back into the headroom and forward into the tailroom
+  p->raw -= 2+head;
+  p->headroom -= 2+head;
+  p->tailroom -= tail;
+  memset(p->raw,0,2);
+  p->head = p->raw+2;
+  p->head_len = 0;
+  p->body = p->raw+2;
+  p->body_len = head+len+tail;
+  util_pool_free(p->cache);
+  p->cache = NULL;
+  util_pool_free(p->index);
+  p->index = NULL;
+  return p;
+}
+
 uint8_t *lob_head(lob_t p, uint8_t *head, size_t len)
 {
   uint16_t nlen;
-  void *ptr;
   if(!p) return NULL;
 
   // new space and update pointers
-  if(!(ptr = realloc(p->raw,2+len+p->body_len))) return NULL;
-  p->raw = (uint8_t *)ptr;
+  if(!lob_space(p,2+len+p->body_len)) return NULL;
   p->head = p->raw+2;
   p->body = p->raw+(2+len);
   // move the body forward to make space
@@ -133,17 +245,17 @@ uint8_t *lob_head(lob_t p, uint8_t *head, size_t len)
   p->head_len = len;
   nlen = util_sys_short((uint16_t)len);
   memcpy(p->raw,&nlen,2);
-  free(p->cache);
+  util_pool_free(p->cache);
   p->cache = NULL;
+  util_pool_free(p->index);
+  p->index = NULL;
   return p->head;
 }
 
 uint8_t *lob_body(lob_t p, uint8_t *body, size_t len)
 {
-  void *ptr;
   if(!p) return NULL;
-  if(!(ptr = realloc(p->raw,2+len+p->head_len))) return NULL;
-  p->raw = (uint8_t *)ptr;
+  if(!lob_space(p,2+len+p->head_len)) return NULL;
   p->head = p->raw+2;
   p->body = p->raw+(2+p->head_len);
   if(body) memcpy(p->body,body,len); // allows lob_body(p,NULL,100) to allocate space
@@ -154,10 +266,8 @@ uint8_t *lob_body(lob_t p, uint8_t *body, size_t len)
 
 lob_t lob_append(lob_t p, uint8_t *chunk, size_t len)
 {
-  void *ptr;
   if(!p || !chunk || !len) return LOG("bad args");
-  if(!(ptr = realloc(p->raw,2+len+p->body_len+p->head_len))) return NULL;
-  p->raw = (unsigned char *)ptr;
+  if(!lob_space(p,2+len+p->body_len+p->head_len)) return NULL;
   p->head = p->raw+2;
   p->body = p->raw+(2+p->head_len);
   memcpy(p->body+p->body_len,chunk,len);
@@ -195,75 +305,95 @@ uint8_t *lob_body_get(lob_t p)
   return p->body;
 }
 
-// TODO allow empty val to remove existing
-lob_t lob_set_raw(lob_t p, char *key, size_t klen, char *val, size_t vlen)
+// replace cut bytes of the head at offset at w/ len bytes of space, grows w/ spare room so repeated edits amortize
+static uint8_t *lob_gap(lob_t p, size_t at, size_t cut, size_t len)
 {
-  char *json, *at, *eval;
-  size_t len, evlen;
+  size_t head_len = p->head_len - cut + len;
+  uint16_t nlen;
 
-  if(!p || !key || !val) return LOG("bad args (%d,%d,%d)",p,key,val);
-  if(p->head_len < 2) lob_head(p, (uint8_t*)"{}", 2);
-  // convenience
-  if(!klen) klen = strlen(key);
-  if(!vlen) vlen = strlen(val);
+  if(head_len > 0xffff) return LOG("head too large");
+  if(len > cut && p->tailroom < len - cut && !lob_reserve(p, p->headroom, (len - cut) + lob_len(p))) return LOG("OOM");
 
-  // make space and copy
-  if(!(json = malloc(klen+vlen+p->head_len+4))) return LOG("OOM");
-  memcpy(json,p->head,p->head_len);
+  memmove(p->head + at + len, p->head + at + cut, (p->head_len - (at + cut)) + p->body_len);
+  p->tailroom += cut;
+  p->tailroom -= len;
+  p->head_len = head_len;
+  p->body = p->head + head_len;
+  nlen = util_sys_short((uint16_t)head_len);
+  memcpy(p->raw,&nlen,2);
+  util_pool_free(p->cache);
+  p->cache = NULL;
+  util_pool_free(p->index);
+  p->index = NULL;
+  return p->head + at;
+}
+
+// returns space for a vlen value of key, replacing any existing one
+static char *lob_set_space(lob_t p, char *key, size_t klen, size_t vlen)
+{
+  char *at, *eval;
+  size_t evlen = 0;
+  uint8_t comma;
+
+  if(p->head_len < 2) lob_head(p, (uint8_t*)"{}", 2);
 
   // if it's already set, replace the value
-  eval = js0n(key,klen,json,p->head_len,&evlen);
+  eval = p->index ? lob_find(p,key,klen,&evlen) : js0n(key,klen,(char*)p->head,p->head_len,&evlen);
   if(eval)
   {
-    // looks ugly, but is just adjusting the space avail for the value to the new size
     // if existing was in quotes, include them
     if(*(eval-1) == '"')
     {
       eval--;
       evlen += 2;
     }
-    memmove(eval+vlen,eval+evlen,(json+p->head_len) - (eval+evlen)); // frowney face
-    memcpy(eval,val,vlen);
-    len = p->head_len - evlen;
-    len += vlen;
-  }else{
-    at = json+(p->head_len-1); // points to the "}"
-    // if there's other keys already, add comma
-    if(p->head_len >= 7)
+    return (char*)lob_gap(p, (size_t)(eval - (char*)p->head), evlen, vlen);
+  }
+
+  // insert before the "}", if there's other keys already add comma
+  comma = (p->head_len >= 7) ? 1 : 0;
+  if(!(at = (char*)lob_gap(p, p->head_len-1, 0, comma + klen + 3 + vlen))) return NULL;
+  if(comma) *at++ = ',';
+  *at++ = '"';
+  memcpy(at,key,klen); at+=klen;
+  *at++ = '"';
+  *at++ = ':';
+  return at;
+}
+
+// writes val as a quoted/escaped json string to out (when given), returns the length
+static size_t lob_escape(char *out, char *val, size_t vlen)
+{
+  size_t i, len = 0;
+  if(out) out[len] = '"';
+  len++;
+  for(i=0;i<vlen;i++)
+  {
+    if(val[i] == '"' || val[i] == '\\')
     {
-      *at = ','; at++;
+      if(out) out[len] = '\\';
+      len++;
     }
-    *at = '"'; at++;
-    memcpy(at,key,klen); at+=klen;
-    *at = '"'; at++;
-    *at = ':'; at++;
-    memcpy(at,val,vlen); at+=vlen;
-    *at = '}'; at++;
-    len = (size_t)(at - json);
+    if(out) out[len] = val[i];
+    len++;
   }
-  lob_head(p, (uint8_t*)json, len);
-  free(json);
-  return p;
+  if(out) out[len] = '"';
+  len++;
+  return len;
 }
 
-lob_t lob_set_printf(lob_t p, char *key, const char *format, ...)
+// TODO allow empty val to remove existing
+lob_t lob_set_raw(lob_t p, char *key, size_t klen, char *val, size_t vlen)
 {
-  va_list ap, cp;
-  char *val;
-
-  if(!p || !key || !format) return LOG("bad args");
-
-  va_start(ap, format);
-  va_copy(cp, ap);
-
-  vasprintf(&val, format, ap);
+  char *at;
 
-  va_end(ap);
-  va_end(cp);
-  if(!val) return NULL;
+  if(!p || !key || !val) return LOG("bad args (%d,%d,%d)",p,key,val);
+  // convenience
+  if(!klen) klen = strlen(key);
+  if(!vlen) vlen = strlen(val);
 
-  lob_set(p, key, val);
-  free(val);
+  if(!(at = lob_set_space(p, key, klen, vlen))) return NULL;
+  memcpy(at,val,vlen);
   return p;
 }
 
@@ -347,35 +477,139 @@ lob_t lob_set(lob_t p, char *key, char *val)
 
 lob_t lob_set_len(lob_t p, char *key, size_t klen, char *val, size_t vlen)
 {
-  char *escaped;
-  size_t i, len;
+  char *at;
   if(!p || !key || !val) return LOG("bad args");
   // TODO escape key too
-  if(!(escaped = malloc(vlen*2+2))) return LOG("OOM"); // enough space worst case
-  len = 0;
-  escaped[len++] = '"';
-  for(i=0;i<vlen;i++)
+  if(!klen) klen = strlen(key);
+  if(!(at = lob_set_space(p, key, klen, lob_escape(NULL,val,vlen)))) return NULL;
+  lob_escape(at,val,vlen);
+  return p;
+}
+
+lob_t lob_set_printf(lob_t p, char *key, const char *format, ...)
+{
+  va_list ap;
+  char buf[128], *val = buf;
+  int len;
+
+  if(!p || !key || !format) return LOG("bad args");
+
+  // most fit on the stack, only bigger ones are formatted twice
+  va_start(ap, format);
+  len = vsnprintf(buf, sizeof(buf), format, ap);
+  va_end(ap);
+  if(len < 0) return LOG("bad format");
+  if((size_t)len >= sizeof(buf))
   {
-    if(val[i] == '"' || val[i] == '\\') escaped[len++]='\\';
-    escaped[len++]=val[i];
+    if(!(val = malloc(len+1))) return LOG("OOM");
+    va_start(ap, format);
+    vsnprintf(val, len+1, format, ap);
+    va_end(ap);
   }
-  escaped[len++] = '"';
-  lob_set_raw(p, key, klen, escaped, len);
-  free(escaped);
+
+  p = lob_set_len(p, key, 0, val, len);
+  if(val != buf) free(val);
   return p;
 }
 
 lob_t lob_set_base32(lob_t p, char *key, uint8_t *bin, size_t blen)
 {
-  char *val;
+  char *at;
   if(!p || !key || !bin || !blen) return LOG("bad args");
   size_t vlen = base32_encode_length(blen)-1; // remove the auto-added \0 space
-  if(!(val = malloc(vlen+2))) return LOG("OOM"); // include surrounding quotes
-  val[0] = '"';
-  base32_encode(bin, blen, val+1,vlen+1);
-  val[vlen+1] = '"';
-  lob_set_raw(p,key,0,val,vlen+2);
-  free(val);
+  if(!(at = lob_set_space(p, key, strlen(key), vlen+2))) return NULL; // include surrounding quotes
+  at[0] = '"';
+  base32_encode(bin, blen, at+1, vlen); // exact fit, no \0 written
+  at[vlen+1] = '"';
+  return p;
+}
+
+// space for the next key:val in a head opened by lob_begin
+static char *lob_add_space(lob_t p, char *key, size_t klen, size_t vlen)
+{
+  char *at;
+  if(!p || !key || !p->head_len || (p->head[p->head_len-1] != '{' && p->head[p->head_len-1] != ',')) return LOG("not building");
+  if(!klen) klen = strlen(key);
+  if(!(at = (char*)lob_gap(p, p->head_len, 0, klen + 4 + vlen))) return NULL;
+  *at++ = '"';
+  memcpy(at,key,klen); at+=klen;
+  *at++ = '"';
+  *at++ = ':';
+  at[vlen] = ',';
+  return at;
+}
+
+lob_t lob_begin(lob_t p)
+{
+  if(!p) return LOG("bad args");
+  if(p->head_len < 2)
+  {
+    if(!lob_gap(p, 0, p->head_len, 1)) return NULL;
+    *p->head = '{';
+    return p;
+  }
+  if(p->head[p->head_len-1] != '}') return LOG("head is not an object");
+  // reopen, "{}" becomes "{" and "{...}" becomes "{...,"
+  if(p->head_len == 2) return lob_gap(p, 1, 1, 0) ? p : NULL;
+  p->head[p->head_len-1] = ',';
+  util_pool_free(p->cache);
+  p->cache = NULL;
+  util_pool_free(p->index);
+  p->index = NULL;
+  return p;
+}
+
+lob_t lob_add_raw(lob_t p, char *key, size_t klen, char *val, size_t vlen)
+{
+  char *at;
+  if(!val) return LOG("bad args");
+  if(!vlen) vlen = strlen(val);
+  if(!(at = lob_add_space(p, key, klen, vlen))) return NULL;
+  memcpy(at,val,vlen);
+  return p;
+}
+
+lob_t lob_add(lob_t p, char *key, char *val)
+{
+  char *at;
+  size_t vlen;
+  if(!val) return LOG("bad args");
+  vlen = strlen(val);
+  if(!(at = lob_add_space(p, key, 0, lob_escape(NULL,val,vlen)))) return NULL;
+  lob_escape(at,val,vlen);
+  return p;
+}
+
+lob_t lob_add_uint(lob_t p, char *key, unsigned int val)
+{
+  char num[16];
+  sprintf(num,"%u",val);
+  return lob_add_raw(p, key, 0, num, 0);
+}
+
+lob_t lob_add_base32(lob_t p, char *key, uint8_t *bin, size_t blen)
+{
+  char *at;
+  size_t vlen;
+  if(!bin || !blen) return LOG("bad args");
+  vlen = base32_encode_length(blen)-1;
+  if(!(at = lob_add_space(p, key, 0, vlen+2))) return NULL;
+  at[0] = '"';
+  base32_encode(bin, blen, at+1, vlen);
+  at[vlen+1] = '"';
+  return p;
+}
+
+lob_t lob_finish(lob_t p)
+{
+  if(!p || !p->head_len) return LOG("bad args");
+  if(p->head[p->head_len-1] == '{')
+  {
+    if(!lob_gap(p, p->head_len, 0, 1)) return NULL;
+  }else if(p->head[p->head_len-1] != ','){
+    return LOG("not building");
+  }
+  p->head[p->head_len-1] = '}';
   return p;
 }
 
@@ -383,8 +617,8 @@ lob_t lob_set_base32(lob_t p, char *key, uint8_t *bin, size_t blen)
 char *lob_cache(lob_t p, size_t len)
 {
   if(!p) return NULL;
-  if(p->cache) free(p->cache);
-  if(!(p->cache = malloc(len+1))) return LOG("OOM");
+  if(p->cache) util_pool_free(p->cache);
+  if(!(p->cache = util_pool_malloc(len+1))) return LOG("OOM");
   p->cache[0] = 0; // flag
   return p->cache+1;
 }
@@ -437,12 +671,201 @@ char *unescape(lob_t p, char *start, size_t len)
   return start;
 }
 
+// top level keys indexed per head, more than this and misses fall back to js0n
+#define LOB_INDEX_MAX 32
+
+typedef struct lob_key_struct
+{
+  uint32_t hash;
+  uint16_t key, klen; // offset/length of the key in the head
+  uint16_t val, vlen; // offset/length of the value, same as js0n returns
+} *lob_key_t;
+
+struct lob_index_struct
+{
+  uint8_t count, mask, partial, bad; // bad is any head this scanner doesn't understand, always uses js0n
+  struct lob_key_struct keys[]; // followed by mask+1 slots of key index+1
+};
+
+// fnv-1a
+static uint32_t lob_hash(const char *key, size_t len)
+{
+  uint32_t hash = 2166136261U;
+  while(len--)
+  {
+    hash ^= (uint8_t)*key++;
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+#define LOB_WS(c) ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')
+
+// returns just past the closing quote of the string at at
+static char *lob_skip_string(char *at, char *end)
+{
+  for(at++; at < end; at++)
+  {
+    if(*at == '"') return at+1;
+    if((uint8_t)*at < 32) return NULL;
+    if(*at == '\\') at++;
+  }
+  return NULL;
+}
+
+// returns just past the value at at
+static char *lob_skip_value(char *at, char *end)
+{
+  int depth = 0;
+  if(*at == '"') return lob_skip_string(at,end);
+  if(*at == '{' || *at == '[')
+  {
+    while(at < end)
+    {
+      if(*at == '"')
+      {
+        if(!(at = lob_skip_string(at,end))) return NULL;
+        continue;
+      }
+      if(*at == '{' || *at == '[') depth++;
+      if(*at == '}' || *at == ']')
+      {
+        if(--depth == 0) return at+1;
+      }
+      at++;
+    }
+    return NULL;
+  }
+  // bare words end like js0n's do
+  for(;at < end && !LOB_WS(*at) && *at != ',' && *at != ']' && *at != '}' && *at != ':';at++)
+  {
+    if((uint8_t)*at < 32 || (uint8_t)*at > 126) return NULL;
+  }
+  return at;
+}
+
+// one pass over the head for the offsets of every top level key/value
+static struct lob_index_struct *lob_index(lob_t p)
+{
+  struct lob_key_struct keys[LOB_INDEX_MAX];
+  struct lob_index_struct *index;
+  char *head = (char*)p->head, *end = head + p->head_len, *at, *key, *val;
+  size_t klen;
+  uint8_t count = 0, partial = 0, bad = 0, mask, *slots, slot, i;
+
+  if(p->index) return p->index;
+
+  at = head;
+  while(at < end && LOB_WS(*at)) at++;
+  if(p->head_len > 0xffff || at == end || *at != '{') bad = 1;
+  else at++;
+  while(!bad)
+  {
+    while(at < end && LOB_WS(*at)) at++;
+    if(at < end && *at == '}' && !count && !partial) break;
+    if(at == end || *at != '"' || !(at = lob_skip_string((key = at),end)))
+    {
+      bad = 1;
+      break;
+    }
+    klen = (size_t)(at - key) - 2;
+    while(at < end && LOB_WS(*at)) at++;
+    if(at == end || *at != ':')
+    {
+      bad = 1;
+      break;
+    }
+    for(at++;at < end && LOB_WS(*at);at++);
+    if(at == end || !(at = lob_skip_value((val = at),end)))
+    {
+      bad = 1;
+      break;
+    }
+    if(count == LOB_INDEX_MAX)
+    {
+      partial = 1;
+    }else{
+      keys[count].key = (uint16_t)(key+1-head);
+      keys[count].klen = (uint16_t)klen;
+      if(*val == '"')
+      {
+        keys[count].val = (uint16_t)(val+1-head);
+        keys[count].vlen = (uint16_t)(at-1 - (val+1));
+      }else{
+        keys[count].val = (uint16_t)(val-head);
+        keys[count].vlen = (uint16_t)(at - val);
+      }
+      keys[count].hash = lob_hash(key+1,klen);
+      count++;
+    }
+    while(at < end && LOB_WS(*at)) at++;
+    if(at < end && *at == ',')
+    {
+      at++;
+      continue;
+    }
+    if(at == end || *at != '}') bad = 1;
+    break;
+  }
+  if(bad) count = partial = 0;
+
+  // slots are at least twice the keys
+  for(mask = 1; mask < count*2; mask = (uint8_t)((mask << 1) | 1));
+  if(!(index = util_pool_malloc(sizeof (struct lob_index_struct) + count * sizeof (struct lob_key_struct) + mask + 1))) return NULL;
+  index->count = count;
+  index->mask = mask;
+  index->partial = partial;
+  index->bad = bad;
+  memcpy(index->keys,keys,count * sizeof (struct lob_key_struct));
+  slots = (uint8_t*)(index->keys + count);
+  memset(slots,0,mask+1);
+  for(i=0;i<count;i++)
+  {
+    for(slot = keys[i].hash & mask; slots[slot]; slot = (slot+1) & mask)
+    {
+      // first one wins, like js0n
+      if(keys[slots[slot]-1].hash == keys[i].hash && keys[slots[slot]-1].klen == keys[i].klen && memcmp(head+keys[slots[slot]-1].key,head+keys[i].key,keys[i].klen) == 0) break;
+    }
+    if(!slots[slot]) slots[slot] = i+1;
+  }
+
+  p->index = index;
+  return index;
+}
+
+// same as js0n(key,klen,head) but from the index
+static char *lob_find(lob_t p, char *key, size_t klen, size_t *vlen)
+{
+  struct lob_index_struct *index;
+  lob_key_t k;
+  uint32_t hash;
+  uint8_t slot, *slots;
+
+  *vlen = 0;
+  if(!p->head_len) return NULL;
+  if(!klen) klen = strlen(key);
+  if(!klen || !(index = lob_index(p)) || index->bad) return js0n(key,klen,(char*)p->head,p->head_len,vlen);
+
+  hash = lob_hash(key,klen);
+  slots = (uint8_t*)(index->keys + index->count);
+  for(slot = hash & index->mask; slots[slot]; slot = (slot+1) & index->mask)
+  {
+    k = &index->keys[slots[slot]-1];
+    if(k->hash != hash || k->klen != klen || memcmp(p->head + k->key,key,klen) != 0) continue;
+    *vlen = k->vlen;
+    return (char*)p->head + k->val;
+  }
+
+  if(index->partial) return js0n(key,klen,(char*)p->head,p->head_len,vlen);
+  return NULL;
+}
+
 char *lob_get(lob_t p, char *key)
 {
   char *val;
   size_t len = 0;
   if(!p || !key || p->head_len < 5) return NULL;
-  val = js0n(key,0,(char*)p->head,p->head_len,&len);
+  val = lob_find(p,key,0,&len);
   return unescape(p,val,len);
 }
 
@@ -451,7 +874,7 @@ char *lob_get_raw(lob_t p, char *key)
   char *val;
   size_t len = 0;
   if(!p || !key || p->head_len < 5) return NULL;
-  val = js0n(key,0,(char*)p->head,p->head_len,&len);
+  val = lob_find(p,key,0,&len);
   if(!val) return NULL;
   // if it's a string value, return start of quotes
   if(*(val-1) == '"') return val-1;
@@ -464,7 +887,7 @@ size_t lob_get_len(lob_t p, char *key)
   char *val;
   size_t len = 0;
   if(!p || !key || p->head_len < 5) return 0;
-  val = js0n(key,0,(char*)p->head,p->head_len,&len);
+  val = lob_find(p,key,0,&len);
   if(!val) return 0;
   // if it's a string value, include quotes
   if(*(val-1) == '"') return len+2;
@@ -511,7 +934,7 @@ lob_t lob_get_json(lob_t p, char *key)
   size_t len = 0;
   if(!p || !key) return NULL;
 
-  val = js0n(key,0,(char*)p->head,p->head_len,&len);
+  val = lob_find(p,key,0,&len);
   if(!val) return NULL;
 
   pp = lob_new();
@@ -557,7 +980,7 @@ lob_t lob_get_base32(lob_t p, char *key)
   size_t len = 0;
   if(!p || !key) return NULL;
 
-  val = js0n(key,0,(char*)p->head,p->head_len,&len);
+  val = lob_find(p,key,0,&len);
   if(!val) return NULL;
 
   ret = lob_new();
@@ -26,6 +26,13 @@
 #include <sys/types.h>
 #include <stdint.h>
 #include <string.h>
+#include "sha256.h"
+
+/* x86 SHA extensions, the cpu is checked at runtime */
+#if !defined(SHA256_NO_HW) && defined(__x86_64__) && defined(__GNUC__)
+#define SHA256_NI 1
+#include <immintrin.h>
+#endif
 
 static inline uint32_t
 be32dec(const void *pp)
@@ -279,6 +286,111 @@ SHA256_Transform(uint32_t * state, const unsigned char block[64])
 	t0 = t1 = 0;
 }
 
+#ifdef SHA256_NI
+static const uint32_t SHA256_K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* set by sha256_hw(0), the cpu itself is only asked through the (thread safe) builtin */
+static unsigned char sha256_ni_off = 0;
+
+static int
+SHA256_NI_Supported(void)
+{
+
+	return (!sha256_ni_off && __builtin_cpu_supports("sha") &&
+	    __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("ssse3"));
+}
+
+/*
+ * The same compression using sha256rnds2, four rounds per message vector. The
+ * state is kept as ABEF/CDGH, the order the instructions want it in.
+ */
+__attribute__((target("sha,sse4.1,ssse3")))
+static void
+SHA256_Transform_NI(uint32_t * state, const unsigned char * src, size_t blocks)
+{
+	const __m128i MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	__m128i STATE0, STATE1, MSG, TMP, ABEF, CDGH, M[4];
+	int i;
+
+	TMP = _mm_loadu_si128((const __m128i *)&state[0]);
+	STATE1 = _mm_loadu_si128((const __m128i *)&state[4]);
+	TMP = _mm_shuffle_epi32(TMP, 0xB1);		/* CDAB */
+	STATE1 = _mm_shuffle_epi32(STATE1, 0x1B);	/* EFGH */
+	STATE0 = _mm_alignr_epi8(TMP, STATE1, 8);	/* ABEF */
+	STATE1 = _mm_blend_epi16(STATE1, TMP, 0xF0);	/* CDGH */
+
+	for (; blocks > 0; blocks--, src += 64) {
+		ABEF = STATE0;
+		CDGH = STATE1;
+
+		for (i = 0; i < 16; i++) {
+			if (i < 4)
+				M[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + i * 16)), MASK);
+			MSG = _mm_add_epi32(M[i & 3], _mm_loadu_si128((const __m128i *)&SHA256_K[i * 4]));
+			STATE1 = _mm_sha256rnds2_epu32(STATE1, STATE0, MSG);
+
+			/* W[i*4+4..] from the four vectors before it */
+			if (i >= 3 && i < 15) {
+				TMP = _mm_alignr_epi8(M[i & 3], M[(i + 3) & 3], 4);
+				M[(i + 1) & 3] = _mm_add_epi32(M[(i + 1) & 3], TMP);
+				M[(i + 1) & 3] = _mm_sha256msg2_epu32(M[(i + 1) & 3], M[i & 3]);
+			}
+
+			MSG = _mm_shuffle_epi32(MSG, 0x0E);
+			STATE0 = _mm_sha256rnds2_epu32(STATE0, STATE1, MSG);
+			if (i >= 1 && i < 13)
+				M[(i + 3) & 3] = _mm_sha256msg1_epu32(M[(i + 3) & 3], M[i & 3]);
+		}
+
+		STATE0 = _mm_add_epi32(STATE0, ABEF);
+		STATE1 = _mm_add_epi32(STATE1, CDGH);
+	}
+
+	TMP = _mm_shuffle_epi32(STATE0, 0x1B);		/* FEBA */
+	STATE1 = _mm_shuffle_epi32(STATE1, 0xB1);	/* DCHG */
+	STATE0 = _mm_blend_epi16(TMP, STATE1, 0xF0);	/* DCBA */
+	STATE1 = _mm_alignr_epi8(STATE1, TMP, 8);	/* HGFE */
+	_mm_storeu_si128((__m128i *)&state[0], STATE0);
+	_mm_storeu_si128((__m128i *)&state[4], STATE1);
+}
+#endif
+
+/* Any number of whole blocks, w/ the SHA extensions when the cpu has them. */
+static void
+SHA256_Blocks(uint32_t * state, const unsigned char * src, size_t blocks)
+{
+
+#ifdef SHA256_NI
+	if (SHA256_NI_Supported()) {
+		SHA256_Transform_NI(state, src, blocks);
+		return;
+	}
+#endif
+	for (; blocks > 0; blocks--, src += 64)
+		SHA256_Transform(state, src);
+}
+
+unsigned char
+sha256_hw(unsigned char enable)
+{
+
+#ifdef SHA256_NI
+	sha256_ni_off = !enable;
+	return (SHA256_NI_Supported() ? 1 : 0);
+#else
+	return (0);
+#endif
+}
+
 /* SHA-256 initialization.  Begins a SHA-256 operation. */
 void
 SHA256_Init(SHA256_CTX * ctx)
@@ -326,16 +438,14 @@ SHA256_Update(SHA256_CTX * ctx, const void *in, size_t len)
 
 	/* Finish the current block */
 	memcpy(&ctx->buf[r], src, 64 - r);
-	SHA256_Transform(ctx->state, ctx->buf);
+	SHA256_Blocks(ctx->state, ctx->buf, 1);
 	src += 64 - r;
 	len -= 64 - r;
 
 	/* Perform complete blocks */
-	while (len >= 64) {
-		SHA256_Transform(ctx->state, src);
-		src += 64;
-		len -= 64;
-	}
+	SHA256_Blocks(ctx->state, src, len / 64);
+	src += len & ~(size_t)63;
+	len &= 63;
 
 	/* Copy left over data into buffer */
 	memcpy(ctx->buf, src, len);
@@ -531,3 +641,25 @@ void hmac_256(const unsigned char *key, size_t keylen, const unsigned char *inpu
 {
   sha256_hmac(key, keylen, input, ilen, output, 0);
 }
+
+void hmac_256_key(hmac_256_t hmac, const unsigned char *key, size_t keylen)
+{
+  HMAC_SHA256_CTX hctx;
+  HMAC_SHA256_Init(&hctx, key, keylen);
+  memcpy(hmac->istate, hctx.ictx.state, 32);
+  memcpy(hmac->ostate, hctx.octx.state, 32);
+  memset(&hctx, 0, sizeof(hctx));
+}
+
+void hmac_256_keyed(hmac_256_t hmac, const unsigned char *input, size_t ilen, unsigned char output[32])
+{
+  HMAC_SHA256_CTX hctx;
+
+  // pick up right after each pad block
+  memcpy(hctx.ictx.state, hmac->istate, 32);
+  memcpy(hctx.octx.state, hmac->ostate, 32);
+  hctx.ictx.count[0] = hctx.octx.count[0] = 0;
+  hctx.ictx.count[1] = hctx.octx.count[1] = 512;
+  HMAC_SHA256_Update(&hctx, input, ilen);
+  HMAC_SHA256_Final(output, &hctx);
+}
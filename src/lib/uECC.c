@@ -181,6 +181,10 @@ static cmpresult_t uECC_vli_cmp_unsafe(const uECC_word_t *left,
     #include "asm_avr.inc"
 #endif
 
+#if (uECC_PLATFORM == uECC_x86_64)
+    #include "asm_x86_64.inc"
+#endif
+
 #if default_RNG_defined
 static uECC_RNG_Function g_rng_function = &default_RNG;
 #else
@@ -912,6 +916,250 @@ static uECC_word_t regularize_k(const uECC_word_t * const k,
     return carry;
 }
 
+#if uECC_FIXED_BASE
+
+/* Fixed-base multiplication for the generator point, from tables made once by uECC_precompute().
+Window i of the table holds the odd multiples (1, 3, ..., 15) * 16^i * G in affine form. The scalar
+is recoded into odd signed 4-bit digits so every window adds exactly one (possibly negated) table
+entry, read by scanning the whole window, with no branches or lookups that depend on the scalar. */
+
+#define FIXED_BASE_WINDOWS (((uECC_MAX_WORDS * uECC_WORD_SIZE * 8) + 4) / 4)
+
+static struct {
+    uECC_Curve curve;
+    uECC_word_t points[FIXED_BASE_WINDOWS][8][uECC_MAX_WORDS * 2];
+} g_fixed_base[uECC_FIXED_BASE_CURVES];
+
+/* (X1, Y1, Z1) += (x2, y2) with the second point affine.
+   Doesn't handle P == Q or P == -Q, the tables and digits only hit those for a few specific
+   scalars near the top of a curve's order (a 2^-160 chance for a random one). */
+static void EccPoint_add_affine(uECC_word_t * X1,
+                                uECC_word_t * Y1,
+                                uECC_word_t * Z1,
+                                const uECC_word_t * const x2,
+                                const uECC_word_t * const y2,
+                                uECC_Curve curve) {
+    uECC_word_t t1[uECC_MAX_WORDS];
+    uECC_word_t t2[uECC_MAX_WORDS];
+    uECC_word_t t3[uECC_MAX_WORDS];
+    wordcount_t num_words = curve->num_words;
+
+    uECC_vli_modSquare_fast(t1, Z1, curve);                  /* t1 = z1^2 */
+    uECC_vli_modMult_fast(t2, t1, Z1, curve);                /* t2 = z1^3 */
+    uECC_vli_modMult_fast(t1, t1, x2, curve);                /* t1 = x2*z1^2 = U2 */
+    uECC_vli_modMult_fast(t2, t2, y2, curve);                /* t2 = y2*z1^3 = S2 */
+    uECC_vli_modSub(t1, t1, X1, curve->p, num_words); /* t1 = U2 - x1 = H */
+    uECC_vli_modSub(t2, t2, Y1, curve->p, num_words); /* t2 = S2 - y1 = R */
+    uECC_vli_modMult_fast(Z1, Z1, t1, curve);                /* z3 = z1*H */
+
+    uECC_vli_modSquare_fast(t3, t1, curve);                  /* t3 = H^2 */
+    uECC_vli_modMult_fast(t1, t1, t3, curve);                /* t1 = H^3 */
+    uECC_vli_modMult_fast(t3, t3, X1, curve);                /* t3 = x1*H^2 = V */
+    uECC_vli_modMult_fast(Y1, Y1, t1, curve);                /* t4 = y1*H^3 */
+
+    uECC_vli_modSquare_fast(X1, t2, curve);                  /* t1 = R^2 */
+    uECC_vli_modSub(X1, X1, t1, curve->p, num_words); /* R^2 - H^3 */
+    uECC_vli_modSub(X1, X1, t3, curve->p, num_words); /* R^2 - H^3 - V */
+    uECC_vli_modSub(X1, X1, t3, curve->p, num_words); /* x3 = R^2 - H^3 - 2V */
+
+    uECC_vli_modSub(t3, t3, X1, curve->p, num_words); /* t3 = V - x3 */
+    uECC_vli_modMult_fast(t3, t3, t2, curve);                /* t3 = R*(V - x3) */
+    uECC_vli_modSub(Y1, t3, Y1, curve->p, num_words); /* y3 = R*(V - x3) - y1*H^3 */
+}
+
+/* (X, Y, Z) => (x, y) */
+static void EccPoint_to_affine(uECC_word_t * result,
+                               const uECC_word_t * const X,
+                               const uECC_word_t * const Y,
+                               const uECC_word_t * const Z,
+                               uECC_Curve curve) {
+    uECC_word_t z[uECC_MAX_WORDS];
+    uECC_word_t t1[uECC_MAX_WORDS];
+    wordcount_t num_words = curve->num_words;
+
+    uECC_vli_modInv(z, Z, curve->p, num_words);    /* 1/z */
+    uECC_vli_modSquare_fast(t1, z, curve);                /* 1/z^2 */
+    uECC_vli_modMult_fast(result, X, t1, curve);          /* x = X/z^2 */
+    uECC_vli_modMult_fast(t1, t1, z, curve);              /* 1/z^3 */
+    uECC_vli_modMult_fast(result + num_words, Y, t1, curve); /* y = Y/z^3 */
+}
+
+/* Returns the 'count' bits of 'vli' starting at 'bit'. */
+static uECC_word_t vli_bits(const uECC_word_t *vli, bitcount_t bit, bitcount_t count) {
+    uECC_word_t bits = 0;
+    bitcount_t i;
+    for (i = 0; i < count; ++i) {
+        bits |= (uECC_vli_testBit(vli, bit + i) ? 1 : 0) << i;
+    }
+    return bits;
+}
+
+/* Constant-time read of a window's entry for the digit v - 16 (v is odd, 1..31), negated if it is. */
+static void fixed_base_select(uECC_word_t * x,
+                              uECC_word_t * y,
+                              uECC_word_t (*window)[uECC_MAX_WORDS * 2],
+                              uECC_word_t v,
+                              uECC_Curve curve) {
+    uECC_word_t neg[uECC_MAX_WORDS];
+    uECC_word_t sign = (~v >> 4) & 1;
+    uECC_word_t index = ((v ^ (0 - sign)) & 15) >> 1; /* (|v - 16| - 1) / 2 */
+    uECC_word_t mask;
+    uECC_word_t j;
+    wordcount_t num_words = curve->num_words;
+    wordcount_t i;
+
+    uECC_vli_clear(x, num_words);
+    uECC_vli_clear(y, num_words);
+    for (j = 0; j < 8; ++j) {
+        mask = 0 - (uECC_word_t)(j == index);
+        for (i = 0; i < num_words; ++i) {
+            x[i] |= window[j][i] & mask;
+            y[i] |= window[j][num_words + i] & mask;
+        }
+    }
+
+    uECC_vli_sub(neg, curve->p, y, num_words);
+    mask = 0 - sign;
+    for (i = 0; i < num_words; ++i) {
+        y[i] = (neg[i] & mask) | (y[i] & ~mask);
+    }
+}
+
+static uECC_word_t (*fixed_base_table(uECC_Curve curve))[8][uECC_MAX_WORDS * 2] {
+    int c;
+    for (c = 0; c < uECC_FIXED_BASE_CURVES; ++c) {
+        if (g_fixed_base[c].curve == curve) {
+            return g_fixed_base[c].points;
+        }
+    }
+    return 0;
+}
+
+/* result = k * G from the curve's table, k must be in [1, n-1].
+   Returns 0 if there's no table for the curve. */
+static uECC_word_t EccPoint_mult_fixed(uECC_word_t * result,
+                                       const uECC_word_t * k,
+                                       uECC_Curve curve) {
+    uECC_word_t (*table)[8][uECC_MAX_WORDS * 2] = fixed_base_table(curve);
+    uECC_word_t odd[uECC_MAX_WORDS + 1];
+    uECC_word_t X[uECC_MAX_WORDS];
+    uECC_word_t Y[uECC_MAX_WORDS];
+    uECC_word_t Z[uECC_MAX_WORDS];
+    uECC_word_t x[uECC_MAX_WORDS];
+    uECC_word_t y[uECC_MAX_WORDS];
+    uECC_word_t even, mask;
+    wordcount_t num_words = curve->num_words;
+    wordcount_t num_n_words = BITS_TO_WORDS(curve->num_n_bits);
+    bitcount_t windows = (curve->num_n_bits + 3) / 4;
+    bitcount_t i;
+    wordcount_t w;
+
+    if (!table) {
+        return 0;
+    }
+
+    /* The recoding needs an odd scalar, n - k is odd when k isn't (and (n - k) * G = -(k * G)). */
+    uECC_vli_clear(odd, uECC_MAX_WORDS + 1);
+    uECC_vli_sub(odd, curve->n, k, num_n_words);
+    even = !uECC_vli_testBit(k, 0);
+    mask = 0 - even;
+    for (w = 0; w < num_n_words; ++w) {
+        odd[w] = (odd[w] & mask) | (k[w] & ~mask);
+    }
+
+    /* Digit i is bits 4i..4i+4 forced odd, minus 16; the last is just the top bits forced odd. */
+    fixed_base_select(X, Y, table[0], vli_bits(odd, 0, 5) | 1, curve);
+    uECC_vli_clear(Z, num_words);
+    Z[0] = 1;
+    for (i = 1; i < windows; ++i) {
+        if (i == windows - 1) {
+            fixed_base_select(x, y, table[i], (vli_bits(odd, 4 * i, 4) | 1) + 16, curve);
+        } else {
+            fixed_base_select(x, y, table[i], vli_bits(odd, 4 * i, 5) | 1, curve);
+        }
+        EccPoint_add_affine(X, Y, Z, x, y, curve);
+    }
+
+    EccPoint_to_affine(result, X, Y, Z, curve);
+    uECC_vli_sub(y, curve->p, result + num_words, num_words);
+    for (w = 0; w < num_words; ++w) {
+        result[num_words + w] = (y[w] & mask) | (result[num_words + w] & ~mask);
+    }
+    return 1;
+}
+
+int uECC_precompute(uECC_Curve curve) {
+    uECC_word_t (*table)[8][uECC_MAX_WORDS * 2] = fixed_base_table(curve);
+    uECC_word_t base[uECC_MAX_WORDS * 2];
+    uECC_word_t twice[uECC_MAX_WORDS * 2];
+    uECC_word_t X[uECC_MAX_WORDS];
+    uECC_word_t Y[uECC_MAX_WORDS];
+    uECC_word_t Z[uECC_MAX_WORDS];
+    wordcount_t num_words = curve->num_words;
+    bitcount_t windows = (curve->num_n_bits + 3) / 4;
+    bitcount_t i;
+    int c, j;
+
+    if (table) {
+        return 1;
+    }
+    for (c = 0; !table && c < uECC_FIXED_BASE_CURVES; ++c) {
+        if (!g_fixed_base[c].curve) {
+            table = g_fixed_base[c].points;
+        }
+    }
+    if (!table) {
+        return 0;
+    }
+
+    /* Each window is the odd multiples of base = 16^i * G, stepping by 2 * base. */
+    uECC_vli_set(base, curve->G, num_words * 2);
+    for (i = 0; i < windows; ++i) {
+        uECC_vli_set(table[i][0], base, num_words * 2);
+
+        uECC_vli_set(X, base, num_words);
+        uECC_vli_set(Y, base + num_words, num_words);
+        uECC_vli_clear(Z, num_words);
+        Z[0] = 1;
+        curve->double_jacobian(X, Y, Z, curve);
+        EccPoint_to_affine(twice, X, Y, Z, curve);
+
+        for (j = 1; j < 8; ++j) {
+            uECC_vli_set(X, table[i][j - 1], num_words);
+            uECC_vli_set(Y, table[i][j - 1] + num_words, num_words);
+            uECC_vli_clear(Z, num_words);
+            Z[0] = 1;
+            EccPoint_add_affine(X, Y, Z, twice, twice + num_words, curve);
+            EccPoint_to_affine(table[i][j], X, Y, Z, curve);
+        }
+
+        uECC_vli_set(X, base, num_words);
+        uECC_vli_set(Y, base + num_words, num_words);
+        uECC_vli_clear(Z, num_words);
+        Z[0] = 1;
+        for (j = 0; j < 4; ++j) {
+            curve->double_jacobian(X, Y, Z, curve);
+        }
+        EccPoint_to_affine(base, X, Y, Z, curve);
+    }
+
+    /* Only claim the slot once it's filled in. */
+    for (c = 0; c < uECC_FIXED_BASE_CURVES; ++c) {
+        if (g_fixed_base[c].points == table) {
+            g_fixed_base[c].curve = curve;
+        }
+    }
+    return 1;
+}
+
+#else
+
+int uECC_precompute(uECC_Curve curve) {
+    return 0;
+}
+
+#endif /* uECC_FIXED_BASE */
+
 static uECC_word_t EccPoint_compute_public_key(uECC_word_t *result,
                                                uECC_word_t *private,
                                                uECC_Curve curve) {
@@ -922,6 +1170,12 @@ static uECC_word_t EccPoint_compute_public_key(uECC_word_t *result,
 
     /* Regularize the bitcount for the private key so that attackers cannot use a side channel
        attack to learn the number of leading zeros. */
+#if uECC_FIXED_BASE
+    if (EccPoint_mult_fixed(result, private, curve)) {
+        return 1;
+    }
+#endif
+
     carry = regularize_k(private, tmp1, tmp2, curve);
 
     EccPoint_mult(result, curve->G, p2[!carry], 0, curve->num_n_bits + 1, curve);
@@ -1254,8 +1508,13 @@ static int uECC_sign_with_k(const uint8_t *private_key,
         return 0;
     }
 
-    carry = regularize_k(k, tmp, s, curve);
-    EccPoint_mult(p, curve->G, k2[!carry], 0, num_n_bits + 1, curve);
+#if uECC_FIXED_BASE
+    if (!EccPoint_mult_fixed(p, k, curve))
+#endif
+    {
+        carry = regularize_k(k, tmp, s, curve);
+        EccPoint_mult(p, curve->G, k2[!carry], 0, num_n_bits + 1, curve);
+    }
     if (uECC_vli_isZero(p, num_words)) {
         return 0;
     }
@@ -1451,6 +1710,57 @@ static bitcount_t smax(bitcount_t a, bitcount_t b) {
     return (a > b ? a : b);
 }
 
+/* Shamir's trick to calculate u1*G + u2*Q, given sum = G + Q. The result is left in
+   Jacobian form, x/y are (rx, ry) over z^2 and z^3. */
+static void verify_shamir(uECC_word_t *rx,
+                          uECC_word_t *ry,
+                          uECC_word_t *z,
+                          const uECC_word_t *u1,
+                          const uECC_word_t *u2,
+                          const uECC_word_t *public,
+                          const uECC_word_t *sum,
+                          uECC_Curve curve) {
+    uECC_word_t tx[uECC_MAX_WORDS];
+    uECC_word_t ty[uECC_MAX_WORDS];
+    uECC_word_t tz[uECC_MAX_WORDS];
+    const uECC_word_t *points[4];
+    const uECC_word_t *point;
+    bitcount_t num_bits;
+    bitcount_t i;
+    wordcount_t num_words = curve->num_words;
+    wordcount_t num_n_words = BITS_TO_WORDS(curve->num_n_bits);
+
+    points[0] = 0;
+    points[1] = curve->G;
+    points[2] = public;
+    points[3] = sum;
+    num_bits = smax(uECC_vli_numBits(u1, num_n_words),
+                    uECC_vli_numBits(u2, num_n_words));
+
+    point = points[(!!uECC_vli_testBit(u1, num_bits - 1)) |
+                   ((!!uECC_vli_testBit(u2, num_bits - 1)) << 1)];
+    uECC_vli_set(rx, point, num_words);
+    uECC_vli_set(ry, point + num_words, num_words);
+    uECC_vli_clear(z, num_words);
+    z[0] = 1;
+
+    for (i = num_bits - 2; i >= 0; --i) {
+        uECC_word_t index;
+        curve->double_jacobian(rx, ry, z, curve);
+
+        index = (!!uECC_vli_testBit(u1, i)) | ((!!uECC_vli_testBit(u2, i)) << 1);
+        point = points[index];
+        if (point) {
+            uECC_vli_set(tx, point, num_words);
+            uECC_vli_set(ty, point + num_words, num_words);
+            apply_z(tx, ty, z, curve);
+            uECC_vli_modSub(tz, rx, tx, curve->p, num_words); /* Z = x2 - x1 */
+            XYcZ_add(tx, ty, rx, ry, curve);
+            uECC_vli_modMult_fast(z, z, tz, curve);
+        }
+    }
+}
+
 int uECC_verify(const uint8_t *public_key,
                 const uint8_t *message_hash,
                 unsigned hash_size,
@@ -1463,11 +1773,6 @@ int uECC_verify(const uint8_t *public_key,
     uECC_word_t ry[uECC_MAX_WORDS];
     uECC_word_t tx[uECC_MAX_WORDS];
     uECC_word_t ty[uECC_MAX_WORDS];
-    uECC_word_t tz[uECC_MAX_WORDS];
-    const uECC_word_t *points[4];
-    const uECC_word_t *point;
-    bitcount_t num_bits;
-    bitcount_t i;
 #if uECC_VLI_NATIVE_LITTLE_ENDIAN
     uECC_word_t *public = (uECC_word_t *)public_key;
 #else
@@ -1520,36 +1825,7 @@ int uECC_verify(const uint8_t *public_key,
     uECC_vli_modInv(z, z, curve->p, num_words); /* z = 1/z */
     apply_z(sum, sum + num_words, z, curve);
 
-    /* Use Shamir's trick to calculate u1*G + u2*Q */
-    points[0] = 0;
-    points[1] = curve->G;
-    points[2] = public;
-    points[3] = sum;
-    num_bits = smax(uECC_vli_numBits(u1, num_n_words),
-                    uECC_vli_numBits(u2, num_n_words));
-
-    point = points[(!!uECC_vli_testBit(u1, num_bits - 1)) |
-                   ((!!uECC_vli_testBit(u2, num_bits - 1)) << 1)];
-    uECC_vli_set(rx, point, num_words);
-    uECC_vli_set(ry, point + num_words, num_words);
-    uECC_vli_clear(z, num_words);
-    z[0] = 1;
-
-    for (i = num_bits - 2; i >= 0; --i) {
-        uECC_word_t index;
-        curve->double_jacobian(rx, ry, z, curve);
-
-        index = (!!uECC_vli_testBit(u1, i)) | ((!!uECC_vli_testBit(u2, i)) << 1);
-        point = points[index];
-        if (point) {
-            uECC_vli_set(tx, point, num_words);
-            uECC_vli_set(ty, point + num_words, num_words);
-            apply_z(tx, ty, z, curve);
-            uECC_vli_modSub(tz, rx, tx, curve->p, num_words); /* Z = x2 - x1 */
-            XYcZ_add(tx, ty, rx, ry, curve);
-            uECC_vli_modMult_fast(z, z, tz, curve);
-        }
-    }
+    verify_shamir(rx, ry, z, u1, u2, public, sum, curve);
 
     uECC_vli_modInv(z, z, curve->p, num_words); /* Z = 1/Z */
     apply_z(rx, ry, z, curve);
@@ -1563,6 +1839,181 @@ int uECC_verify(const uint8_t *public_key,
     return (int)(uECC_vli_equal(rx, r, num_words));
 }
 
+/* Montgomery's trick, replaces each value with its inverse mod p using one uECC_vli_modInv()
+   and three multiplies per value. Zero values are left as zero. (Not worth it mod n, where
+   uECC_vli_modMult() is nearly as slow as an inversion.) */
+static void vli_modInv_batch(uECC_word_t (*values)[uECC_MAX_WORDS],
+                             unsigned count,
+                             uECC_Curve curve) {
+    uECC_word_t prefix[uECC_BATCH_SIZE][uECC_MAX_WORDS];
+    uECC_word_t inv[uECC_MAX_WORDS], tmp[uECC_MAX_WORDS];
+    wordcount_t num_words = curve->num_words;
+    unsigned i;
+
+    /* prefix[i] = product of the non-zero values up to i */
+    for (i = 0; i < count; ++i) {
+        if (uECC_vli_isZero(values[i], num_words)) {
+            if (i) {
+                uECC_vli_set(prefix[i], prefix[i - 1], num_words);
+            } else {
+                uECC_vli_clear(prefix[i], num_words);
+                prefix[i][0] = 1;
+            }
+        } else if (i == 0) {
+            uECC_vli_set(prefix[i], values[i], num_words);
+        } else {
+            uECC_vli_modMult_fast(prefix[i], prefix[i - 1], values[i], curve);
+        }
+    }
+
+    uECC_vli_modInv(inv, prefix[count - 1], curve->p, num_words);
+
+    /* walk back, inv is the inverse of prefix[i] at each step */
+    for (i = count; i-- > 0;) {
+        if (uECC_vli_isZero(values[i], num_words)) {
+            continue;
+        }
+        if (i == 0) {
+            uECC_vli_set(tmp, inv, num_words);
+        } else {
+            uECC_vli_modMult_fast(tmp, inv, prefix[i - 1], curve);
+        }
+        uECC_vli_modMult_fast(inv, inv, values[i], curve);
+        uECC_vli_set(values[i], tmp, num_words);
+    }
+}
+
+/* Up to uECC_BATCH_SIZE signatures, the same steps as uECC_verify() but the inversions mod p
+   are batched. results[i] doubles as the still-valid flag along the way. */
+static int verify_batch_chunk(const uint8_t * const *public_keys,
+                              const uint8_t * const *message_hashes,
+                              unsigned hash_size,
+                              const uint8_t * const *signatures,
+                              unsigned count,
+                              uint8_t *results,
+                              uECC_Curve curve) {
+    uECC_word_t u1[uECC_BATCH_SIZE][uECC_MAX_WORDS], u2[uECC_BATCH_SIZE][uECC_MAX_WORDS];
+    uECC_word_t r[uECC_BATCH_SIZE][uECC_MAX_WORDS];
+    uECC_word_t z[uECC_BATCH_SIZE][uECC_MAX_WORDS];
+    uECC_word_t rx[uECC_BATCH_SIZE][uECC_MAX_WORDS];
+    uECC_word_t ry[uECC_BATCH_SIZE][uECC_MAX_WORDS];
+    uECC_word_t public[uECC_BATCH_SIZE][uECC_MAX_WORDS * 2];
+    uECC_word_t sum[uECC_BATCH_SIZE][uECC_MAX_WORDS * 2];
+    uECC_word_t s[uECC_MAX_WORDS];
+    uECC_word_t tx[uECC_MAX_WORDS];
+    uECC_word_t ty[uECC_MAX_WORDS];
+    wordcount_t num_words = curve->num_words;
+    wordcount_t num_n_words = BITS_TO_WORDS(curve->num_n_bits);
+    unsigned i;
+    int valid = 0;
+
+    /* Parse, range check, and calculate u1 and u2. */
+    for (i = 0; i < count; ++i) {
+        results[i] = 0;
+        s[num_n_words - 1] = 0;
+        r[i][num_n_words - 1] = 0;
+        rx[i][num_n_words - 1] = 0;
+        uECC_vli_bytesToNative(public[i], public_keys[i], curve->num_bytes);
+        uECC_vli_bytesToNative(
+            public[i] + num_words, public_keys[i] + curve->num_bytes, curve->num_bytes);
+        uECC_vli_bytesToNative(r[i], signatures[i], curve->num_bytes);
+        uECC_vli_bytesToNative(s, signatures[i] + curve->num_bytes, curve->num_bytes);
+
+        /* r, s must not be 0, and must be < n. */
+        if (uECC_vli_isZero(r[i], num_words) || uECC_vli_isZero(s, num_words) ||
+                uECC_vli_cmp_unsafe(curve->n, r[i], num_n_words) != 1 ||
+                uECC_vli_cmp_unsafe(curve->n, s, num_n_words) != 1) {
+            continue;
+        }
+        results[i] = 1;
+
+        uECC_vli_modInv(z[i], s, curve->n, num_n_words); /* z = 1/s */
+        u1[i][num_n_words - 1] = 0;
+        bits2int(u1[i], message_hashes[i], hash_size, curve);
+        uECC_vli_modMult(u1[i], u1[i], z[i], curve->n, num_n_words); /* u1 = e/s */
+        uECC_vli_modMult(u2[i], r[i], z[i], curve->n, num_n_words); /* u2 = r/s */
+    }
+
+    /* Calculate sum = G + Q. */
+    for (i = 0; i < count; ++i) {
+        uECC_vli_clear(z[i], num_words);
+        if (!results[i]) {
+            continue;
+        }
+        uECC_vli_set(sum[i], public[i], num_words);
+        uECC_vli_set(sum[i] + num_words, public[i] + num_words, num_words);
+        uECC_vli_set(tx, curve->G, num_words);
+        uECC_vli_set(ty, curve->G + num_words, num_words);
+        uECC_vli_modSub(z[i], sum[i], tx, curve->p, num_words); /* z = x2 - x1 */
+        XYcZ_add(tx, ty, sum[i], sum[i] + num_words, curve);
+    }
+    vli_modInv_batch(z, count, curve); /* z = 1/z */
+    for (i = 0; i < count; ++i) {
+        /* Q = +-G has no sum this way, and nothing would sign with that key. */
+        if (results[i] && uECC_vli_isZero(z[i], num_words)) {
+            results[i] = 0;
+        }
+        if (results[i]) {
+            apply_z(sum[i], sum[i] + num_words, z[i], curve);
+        }
+    }
+
+    for (i = 0; i < count; ++i) {
+        if (results[i]) {
+            verify_shamir(rx[i], ry[i], z[i], u1[i], u2[i], public[i], sum[i], curve);
+        } else {
+            uECC_vli_clear(z[i], num_words);
+        }
+    }
+
+    vli_modInv_batch(z, count, curve); /* Z = 1/Z */
+    for (i = 0; i < count; ++i) {
+        /* A zero Z is the point at infinity, which has no x to match. */
+        if (!results[i] || uECC_vli_isZero(z[i], num_words)) {
+            results[i] = 0;
+            continue;
+        }
+        apply_z(rx[i], ry[i], z[i], curve);
+
+        /* v = x1 (mod n) */
+        if (uECC_vli_cmp_unsafe(curve->n, rx[i], num_n_words) != 1) {
+            uECC_vli_sub(rx[i], rx[i], curve->n, num_n_words);
+        }
+
+        /* Accept only if v == r. */
+        results[i] = (uint8_t)uECC_vli_equal(rx[i], r[i], num_words);
+        valid += results[i];
+    }
+
+    return valid;
+}
+
+int uECC_verify_batch(const uint8_t * const *public_keys,
+                      const uint8_t * const *message_hashes,
+                      unsigned hash_size,
+                      const uint8_t * const *signatures,
+                      unsigned count,
+                      uint8_t *results,
+                      uECC_Curve curve) {
+    unsigned done, num;
+    int valid = 0;
+
+    for (done = 0; done < count; done += num) {
+        num = count - done;
+        if (num > uECC_BATCH_SIZE) {
+            num = uECC_BATCH_SIZE;
+        }
+        valid += verify_batch_chunk(public_keys + done,
+                                    message_hashes + done,
+                                    hash_size,
+                                    signatures + done,
+                                    num,
+                                    results + done,
+                                    curve);
+    }
+    return valid;
+}
+
 #if uECC_ENABLE_VLI_API
 
 unsigned uECC_curve_num_words(uECC_Curve curve) {
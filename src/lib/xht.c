@@ -100,6 +100,9 @@ void _xht_set(xht_t h, const char *key, void *val, char flag)
         free(n->val);
     }
 
+    /* clearing drops the key too, caller may free its storage after */
+    if(val == 0) key = 0;
+
     n->flag = flag;
     n->key = key;
     n->val = val;
@@ -11,14 +11,19 @@ link_t link_new(mesh_t mesh, hashname_t id)
   if(!mesh || !id) return LOG("invalid args");
 
   LOG("adding link %s",hashname_short(id));
+  if(!mesh_link_room(mesh, mesh->linked + 1)) return NULL;
   if(!(link = malloc(sizeof (struct link_struct)))) return LOG("OOM");
   memset(link,0,sizeof (struct link_struct));
+  util_cc_init(&link->cc);
+  link->buffer_max = LINK_BUFFER;
 
   link->id = hashname_dup(id);
   link->csid = 0x01; // default state
   link->mesh = mesh;
   link->next = mesh->links;
   mesh->links = link;
+  mesh->linked++;
+  mesh_index(mesh, link);
 
   return link;
 }
@@ -39,6 +44,9 @@ void link_free(link_t link)
       li->next = link->next;
     }
   }
+  mesh->linked--;
+  mesh_unindex(mesh, link);
+  mesh_link_drop(mesh, link);
 
   // drop
   if(link->x)
@@ -50,13 +58,19 @@ void link_free(link_t link)
   // notify pipe w/ NULL packet
   if(link->send_cb) link->send_cb(link, NULL, link->send_arg);
 
-  // go through link->chans
-  chan_t c, cnext;
-  for(c = link->chans;c;c = cnext)
+  // free all channels, detached first so they don't update the table (or the counts)
+  mesh->buffered -= (link->buffered < mesh->buffered) ? link->buffered : mesh->buffered;
+  uint32_t i;
+  chan_t c;
+  for(i=0;i<link->chans_size;i++)
   {
-    cnext = chan_next(c);
+    if(!(c = link->chans[i])) continue;
+    c->link = NULL;
     chan_free(c);
   }
+  free(link->chans);
+  free(link->timers);
+  free(link->resends);
 
   hashname_free(link->id);
   lob_free(link->key);
@@ -66,9 +80,11 @@ void link_free(link_t link)
 link_t link_get(mesh_t mesh, hashname_t id)
 {
   link_t link;
+  char key[53];
 
   if(!mesh || !id) return LOG("invalid args");
-  for(link = mesh->links;link;link = link->next) if(hashname_cmp(id,link->id) == 0) return link;
+  base32_encode(id->bin,32,key,53);
+  if((link = xht_get(mesh->index_id,key))) return link;
   return link_new(mesh,id);
 }
 
@@ -85,18 +101,234 @@ lob_t link_key(link_t link)
   return link->key;
 }
 
+// home slot for a channel id in the table, size is always a power of two
+static uint32_t chan_slot(link_t link, uint32_t id)
+{
+  return (id * 2654435761U) & (link->chans_size - 1);
+}
+
 // get existing channel id if any
 chan_t link_chan_get(link_t link, uint32_t id)
 {
+  uint32_t i;
   chan_t c;
-  if(!link || !id) return NULL;
-  for(c = link->chans;c;c = chan_next(c)) {
-    LOG("<%d><%d>",chan_id(c), id);
-    if(chan_id(c) == id) return c;
+  if(!link || !id || !link->chans_size) return NULL;
+  for(i = chan_slot(link, id);(c = link->chans[i]);i = (i + 1) & (link->chans_size - 1))
+  {
+    if(c->id == id) return c;
   }
   return NULL;
 }
 
+// add to the table, doubling it (and the heap space) to stay under half full
+static link_t link_chan_add(link_t link, chan_t c)
+{
+  uint32_t i, size;
+  chan_t *chans, *timers, *resends;
+
+  if((link->chans_count + 1) * 2 > link->chans_size)
+  {
+    size = link->chans_size ? link->chans_size * 2 : 8;
+    // all or nothing, the channels keep their heap positions in the old ones until these are in place
+    chans = malloc(size * sizeof(chan_t));
+    timers = malloc(size * sizeof(chan_t));
+    resends = malloc(size * sizeof(chan_t));
+    if(!chans || !timers || !resends)
+    {
+      free(chans);
+      free(timers);
+      free(resends);
+      return LOG("OOM");
+    }
+    if(link->timers_count) memcpy(timers, link->timers, link->timers_count * sizeof(chan_t));
+    if(link->resends_count) memcpy(resends, link->resends, link->resends_count * sizeof(chan_t));
+    free(link->timers);
+    free(link->resends);
+    link->timers = timers;
+    link->resends = resends;
+    memset(chans, 0, size * sizeof(chan_t));
+
+    // rehash existing into the new table
+    chan_t *old = link->chans;
+    uint32_t old_size = link->chans_size;
+    link->chans = chans;
+    link->chans_size = size;
+    for(i=0;i<old_size;i++)
+    {
+      if(!old[i]) continue;
+      uint32_t j = chan_slot(link, old[i]->id);
+      while(chans[j]) j = (j + 1) & (size - 1);
+      chans[j] = old[i];
+    }
+    free(old);
+  }
+
+  for(i = chan_slot(link, c->id);link->chans[i];i = (i + 1) & (link->chans_size - 1));
+  link->chans[i] = c;
+  link->chans_count++;
+  return link;
+}
+
+// timeout heap ordering, ended channels sort first to be cleaned up
+static uint32_t chan_due(chan_t c)
+{
+  if(c->state == CHAN_ENDED) return 1;
+  return c->timeout;
+}
+
+// both heaps are kept the same way, resend picks which
+static chan_t *heap_chans(link_t link, uint8_t resend)
+{
+  return resend ? link->resends : link->timers;
+}
+
+static uint32_t *heap_count(link_t link, uint8_t resend)
+{
+  return resend ? &(link->resends_count) : &(link->timers_count);
+}
+
+static uint32_t *heap_index(chan_t c, uint8_t resend)
+{
+  return resend ? &(c->rindex) : &(c->tindex);
+}
+
+static uint32_t heap_due(chan_t c, uint8_t resend)
+{
+  return resend ? c->tresend : chan_due(c);
+}
+
+// which is due first, the resends are on the ms clock that wraps so by how far apart they are
+static int32_t heap_cmp(chan_t a, chan_t b, uint8_t resend)
+{
+  if(resend) return (int32_t)(a->tresend - b->tresend);
+  return (chan_due(a) > chan_due(b)) - (chan_due(a) < chan_due(b));
+}
+
+static void heap_swap(link_t link, uint8_t resend, uint32_t a, uint32_t b)
+{
+  chan_t *heap = heap_chans(link, resend);
+  chan_t tmp = heap[a];
+  heap[a] = heap[b];
+  heap[b] = tmp;
+  *heap_index(heap[a], resend) = a + 1;
+  *heap_index(heap[b], resend) = b + 1;
+}
+
+// restore heap order around the given position
+static void heap_sift(link_t link, uint8_t resend, uint32_t i)
+{
+  chan_t *heap = heap_chans(link, resend);
+  uint32_t parent, child, count = *heap_count(link, resend);
+
+  // up
+  while(i > 0)
+  {
+    parent = (i - 1) / 2;
+    if(heap_cmp(heap[parent], heap[i], resend) <= 0) break;
+    heap_swap(link, resend, parent, i);
+    i = parent;
+  }
+
+  // down
+  while((child = (i * 2) + 1) < count)
+  {
+    if(child + 1 < count && heap_cmp(heap[child + 1], heap[child], resend) < 0) child++;
+    if(heap_cmp(heap[i], heap[child], resend) <= 0) break;
+    heap_swap(link, resend, i, child);
+    i = child;
+  }
+}
+
+static void heap_remove(link_t link, uint8_t resend, chan_t c)
+{
+  chan_t *heap = heap_chans(link, resend);
+  uint32_t i, *count = heap_count(link, resend);
+  if(!*heap_index(c, resend)) return;
+  i = *heap_index(c, resend) - 1;
+  *heap_index(c, resend) = 0;
+  (*count)--;
+  if(i == *count) return;
+  heap[i] = heap[*count];
+  *heap_index(heap[i], resend) = i + 1;
+  heap_sift(link, resend, i);
+}
+
+// in the heap at its due time, or out of it w/o one
+static void heap_update(link_t link, uint8_t resend, chan_t c)
+{
+  uint32_t *index = heap_index(c, resend);
+  if(!heap_due(c, resend))
+  {
+    heap_remove(link, resend, c);
+    return;
+  }
+
+  // heap space always matches the table size
+  if(!*index)
+  {
+    heap_chans(link, resend)[*heap_count(link, resend)] = c;
+    *index = ++(*heap_count(link, resend));
+  }
+  heap_sift(link, resend, *index - 1);
+}
+
+// internal, re-sorts a channel in the timeout and resend heaps after its timeout/state/resend changes
+link_t link_chan_timer(link_t link, chan_t c)
+{
+  if(!link || !c) return NULL;
+  heap_update(link, 0, c);
+  heap_update(link, 1, c);
+  mesh_link_timer(link->mesh, link);
+  return link;
+}
+
+// take it out of the ready list, wherever it is
+static void ready_remove(link_t link, chan_t c)
+{
+  chan_t prev = NULL, cur;
+  if(!c->listed) return;
+  for(cur = link->ready;cur && cur != c;prev = cur, cur = cur->ready);
+  if(!cur) return;
+  if(prev) prev->ready = c->ready;
+  else link->ready = c->ready;
+  if(link->ready_last == c) link->ready_last = prev;
+  c->ready = NULL;
+  c->listed = 0;
+  link->ready_count--;
+}
+
+// internal, stop tracking this channel
+link_t link_chan_drop(link_t link, chan_t c)
+{
+  uint32_t i, j, home;
+  if(!link || !c || !link->chans_size) return NULL;
+
+  heap_remove(link, 0, c);
+  heap_remove(link, 1, c);
+  ready_remove(link, c);
+
+  // find it
+  for(i = chan_slot(link, c->id);link->chans[i] && link->chans[i] != c;i = (i + 1) & (link->chans_size - 1));
+  if(!link->chans[i]) return LOG("channel %d not found on link",c->id);
+  link->chans[i] = NULL;
+  link->chans_count--;
+  c->link = NULL;
+
+  // shift back any following entries that can't be found past the gap anymore
+  for(j = (i + 1) & (link->chans_size - 1);link->chans[j];j = (j + 1) & (link->chans_size - 1))
+  {
+    home = chan_slot(link, link->chans[j]->id);
+    // still reachable if its home is cyclically within (i, j]
+    if((i <= j) ? (i < home && home <= j) : (i < home || home <= j)) continue;
+    link->chans[i] = link->chans[j];
+    link->chans[j] = NULL;
+    i = j;
+  }
+
+  mesh_link_timer(link->mesh, link);
+  return link;
+}
+
 // get link info json
 lob_t link_json(link_t link)
 {
@@ -104,14 +336,17 @@ lob_t link_json(link_t link)
   lob_t json;
   if(!link) return LOG("bad args");
 
-  json = lob_new();
-  lob_set(json,"hashname",hashname_char(link->id));
-  lob_set(json,"csid",util_hex(&link->csid, 1, hex));
-  lob_set_base32(json,"key",link->key->body,link->key->body_len);
+  json = lob_begin(lob_new());
+  lob_add(json,"hashname",hashname_char(link->id));
+  lob_add(json,"csid",util_hex(&link->csid, 1, hex));
+  if(link->key) lob_add_base32(json,"key",link->key->body,link->key->body_len);
+  util_cc_json(&link->cc, json);
+  lob_add_uint(json,"buffered",link->buffered);
+  lob_add_uint(json,"refused",link->refused);
 //  paths = lob_array(mesh->paths);
-//  lob_set_raw(json,"paths",0,(char*)paths->head,paths->head_len);
+//  lob_add_raw(json,"paths",0,(char*)paths->head,paths->head_len);
 //  lob_free(paths);
-  return json;
+  return lob_finish(json);
 }
 
 link_t link_get_keys(mesh_t mesh, lob_t keys)
@@ -177,6 +412,7 @@ link_t link_load(link_t link, uint8_t csid, lob_t key)
 
   link->csid = csid;
   link->key = copy;
+  mesh_index(link->mesh, link); // now has a token
 
   e3x_exchange_out(link->x, util_sys_seconds());
   LOG("new exchange session to %s",hashname_short(link->id));
@@ -199,6 +435,13 @@ link_t link_pipe(link_t link, link_t (*send)(link_t link, lob_t packet, void *ar
   return link_sync(link);
 }
 
+link_t link_buffer(link_t link, uint32_t max)
+{
+  if(!link) return LOG("bad args");
+  link->buffer_max = max ? max : LINK_BUFFER;
+  return link;
+}
+
 // is the link ready/available
 link_t link_up(link_t link)
 {
@@ -211,6 +454,11 @@ link_t link_up(link_t link)
 
 // process an incoming handshake
 link_t link_receive_handshake(link_t link, lob_t inner)
+{
+  return link_receive_prepared(link, inner, NULL);
+}
+
+link_t link_receive_prepared(link_t link, lob_t inner, e3x_exchange_t prepared)
 {
   uint32_t in, out, at, err;
   uint8_t csid = 0;
@@ -229,7 +477,9 @@ link_t link_receive_handshake(link_t link, lob_t inner)
     }
   }
 
-  if((err = e3x_exchange_verify(link->x,outer)))
+  // a dup of this exchange was only synced if it verified
+  if(prepared && memcmp(prepared->token,link->x->token,16) != 0) prepared = NULL;
+  if(!prepared && (err = e3x_exchange_verify(link->x,outer)))
   {
     lob_free(inner);
     return LOG("handshake verification fail: %d",err);
@@ -250,7 +500,7 @@ link_t link_receive_handshake(link_t link, lob_t inner)
   }
 
   // try to sync ephemeral key
-  if(!e3x_exchange_sync(link->x,outer))
+  if(!(prepared && e3x_exchange_adopt(link->x,prepared,outer)) && !e3x_exchange_sync(link->x,outer))
   {
     lob_free(inner);
     return LOG("sync failed");
@@ -270,8 +520,6 @@ link_t link_receive_handshake(link_t link, lob_t inner)
   return link;
 }
 
-// forward declare
-chan_t link_process_chan(chan_t c, uint32_t now);
 // process a decrypted channel packet
 link_t link_receive(link_t link, lob_t inner)
 {
@@ -279,15 +527,13 @@ link_t link_receive(link_t link, lob_t inner)
 
   if(!link || !inner) return LOG("bad args");
 
-  LOG("<-- %d",lob_get_int(inner,"c"));
   // see if existing channel and send there
-  if((c = link_chan_get(link, lob_get_int(inner,"c"))))
+  if((c = link_chan_get(link, lob_get_uint(inner,"c"))))
   {
-    LOG("found chan");
-    // consume inner
+    // consume inner and process only this channel, may free it (acks in it time and window on the current clock)
+    link_now(link);
     chan_receive(c, inner);
-    // process any changes
-    link->chans = link_process_chan(link->chans, 0);
+    chan_process(c, 0);
     return link;
   }
 
@@ -350,6 +596,15 @@ lob_t link_handshake(link_t link)
   handshake = e3x_exchange_handshake(link->x, tmp);
   lob_free(tmp);
 
+  // wrapped to echo their cookie
+  if(handshake && link->cookie[0])
+  {
+    tmp = handshake;
+    handshake = lob_set(lob_new(),"cookie",link->cookie);
+    lob_body(handshake, lob_raw(tmp), lob_len(tmp));
+    lob_free(tmp);
+  }
+
   return handshake;
 }
 
@@ -382,13 +637,14 @@ chan_t link_chan(link_t link, lob_t open)
 
   // add an outgoing cid if none set
   if(!lob_get_int(open,"c")) lob_set_uint(open,"c",e3x_exchange_cid(link->x, NULL));
+  if(link_chan_get(link, lob_get_uint(open,"c"))) return LOG("channel %u already open",lob_get_uint(open,"c"));
   c = chan_new(open);
   if(!c) return LOG("invalid open %s",lob_json(open));
   LOG("new outgoing channel %d open: %s",chan_id(c), lob_get(open,"type"));
 
+  if(!link_chan_add(link, c)) return chan_free(c);
   c->link = link;
-  c->next = link->chans;
-  link->chans = c;
+  link_chan_timer(link, c);
 
   return c;
 }
@@ -406,10 +662,7 @@ link_t link_direct(link_t link, lob_t inner)
   // add an outgoing cid if none set
   if(!lob_get_int(inner,"c")) lob_set_uint(inner,"c",e3x_exchange_cid(link->x, NULL));
 
-  lob_t outer = e3x_exchange_send(link->x, inner);
-  lob_free(inner);
-
-  return link_send(link, outer);
+  return link_send(link, e3x_exchange_wrap(link->x, inner));
 }
 
 // force link down, end channels and generate all events
@@ -426,13 +679,19 @@ link_t link_down(link_t link)
     mesh_link(link->mesh, link);
   }
 
-  // end all channels
-  chan_t c, cnext;
-  for(c = link->chans;c;c = cnext)
+  // end all channels, by id since processing changes the table
+  uint32_t i, count = 0, *ids;
+  chan_t c;
+  if(link->chans_count && (ids = malloc(link->chans_count * sizeof(uint32_t))))
   {
-    cnext = chan_next(c);
-    chan_err(c, "disconnected");
-    chan_process(c, 0);
+    for(i=0;i<link->chans_size;i++) if(link->chans[i]) ids[count++] = link->chans[i]->id;
+    for(i=0;i<count;i++)
+    {
+      if(!(c = link_chan_get(link, ids[i]))) continue;
+      chan_err(c, "disconnected");
+      chan_process(c, 0);
+    }
+    free(ids);
   }
 
   // remove pipe
@@ -446,22 +705,117 @@ link_t link_down(link_t link)
   return NULL;
 }
 
-// recursive to handle deletes
-chan_t link_process_chan(chan_t c, uint32_t now)
+uint32_t link_due(link_t link)
 {
-  if(!c) return NULL;
-  chan_t next = link_process_chan(chan_next(c), now);
-  if(!chan_process(c, now)) return next;
-  LOG("alive: %d", chan_id(c));
-  c->next = next;
-  return c;
+  uint32_t due, clock;
+  if(!link) return 0;
+  if(!link->csid) return 1; // flagged to be removed on the next process
+  due = link->timers_count ? chan_due(link->timers[0]) : 0;
+  if(link->mesh && link->mesh->clocked) return due;
+  clock = link_clock_due(link);
+  if(clock && (!due || clock < due)) due = clock;
+  return due;
+}
+
+uint32_t link_clock_due(link_t link)
+{
+  uint32_t due;
+  if(!link) return 0;
+  due = link->resends_count ? link->resends[0]->tresend : 0;
+  if(link->tpace && (!due || (int32_t)(link->tpace - due) < 0)) due = link->tpace;
+  return due;
+}
+
+link_t link_chan_ready(link_t link, chan_t c)
+{
+  if(!link || !c) return NULL;
+  if(c->listed) return link;
+  c->listed = 1;
+  c->ready = NULL;
+  if(link->ready_last) link->ready_last->ready = c;
+  else link->ready = c;
+  link->ready_last = c;
+  link->ready_count++;
+  return link;
+}
+
+link_t link_flush(link_t link)
+{
+  uint32_t idle, room;
+  chan_t c;
+  if(!link) return NULL;
+
+  // acks arriving during a send can get here again, the loop below already picks up what they free
+  if(link->flushing) return link;
+  link->flushing = 1;
+  link->tpace = 0;
+  link_now(link); // the pacing tokens up to now
+
+  // a packet from each ready channel in turn until none can send any more (w/o room only resends can),
+  // the ones their own window holds back leave the list until an ack or timeout puts them back
+  for(idle = 0;(c = link->ready) && idle < link->ready_count;)
+  {
+    room = util_cc_room(&link->cc);
+    link->ready = c->ready;
+    if(!link->ready) link->ready_last = NULL;
+    c->ready = NULL;
+    c->listed = 0;
+    link->ready_count--;
+    if(chan_transmit(c, room)) idle = 0;
+    else idle++;
+    if(c->link == link && chan_ready(c)) link_chan_ready(link, c);
+  }
+
+  link->flushing = 0;
+  mesh_link_timer(link->mesh, link); // may be paced now, or not anymore
+  return link;
+}
+
+uint32_t link_now(link_t link)
+{
+  if(!link) return 0;
+  if(link->mesh && link->mesh->clock) util_cc_clock(&link->cc, link->mesh->clock);
+  return link->cc.now;
+}
+
+link_t link_clock(link_t link, uint32_t now)
+{
+  chan_t c;
+  if(!link || !now) return LOG("bad args");
+  util_cc_clock(&link->cc, now);
+
+  // only the channels w/ a resend due, in order
+  while(link->resends_count && (int32_t)(link->resends[0]->tresend - now) < 0)
+  {
+    c = link->resends[0];
+    heap_remove(link, 1, c);
+    if(!chan_process(c, 0)) continue; // freed
+    link_chan_timer(link, c);
+  }
+
+  // pacing held some back
+  if(link->tpace && (int32_t)(link->tpace - now) < 0) link_flush(link);
+  return link;
 }
 
 // process any channel timeouts based on the current/given time
 link_t link_process(link_t link, uint32_t now)
 {
+  chan_t c;
   if(!link || !now) return LOG("bad args");
-  link->chans = link_process_chan(link->chans, now);
+
+  // one clock for everything unless the mesh has a finer one
+  if(!link->mesh || !link->mesh->clocked) link_clock(link, now);
+
+  // only the channels that are due, in timeout order
+  while(link->timers_count && chan_due(link->timers[0]) < now)
+  {
+    c = link->timers[0];
+    heap_remove(link, 0, c);
+    if(!chan_process(c, now)) continue; // freed
+    link_chan_timer(link, c);
+  }
+
   if(link->csid) return link;
 
   // flagged to remove, do that now
@@ -20,6 +20,9 @@ typedef struct on_struct
 on_t on_get(mesh_t mesh, char *id);
 on_t on_free(on_t on);
 
+// link index sizes, stepped up as the number of links grows
+static const uint32_t index_primes[] = {11, 47, 191, 769, 3079, 12289, 49157, 196613, 786433, 0};
+
 mesh_t mesh_new(void)
 {
   mesh_t mesh;
@@ -29,6 +32,7 @@ mesh_t mesh_new(void)
 
   if(!(mesh = malloc(sizeof (struct mesh_struct)))) return NULL;
   memset(mesh, 0, sizeof(struct mesh_struct));
+  mesh->buffer_max = MESH_BUFFER;
   
   LOG_INFO("mesh created version %d.%d.%d",TELEHASH_VERSION_MAJOR,TELEHASH_VERSION_MINOR,TELEHASH_VERSION_PATCH);
 
@@ -40,6 +44,14 @@ mesh_t mesh_free(mesh_t mesh)
   on_t on;
   if(!mesh) return NULL;
 
+  // drop the indexes so link_free doesn't need to maintain them
+  xht_free(mesh->index_token);
+  xht_free(mesh->index_id);
+  xht_free(mesh->index_short);
+  mesh->index_token = mesh->index_id = mesh->index_short = NULL;
+  mesh->admit = util_admit_free(mesh->admit);
+  mesh->index_prime = 0;
+
   // free all links first
   link_t link, next;
   for(link = mesh->links;link;link = next)
@@ -47,6 +59,8 @@ mesh_t mesh_free(mesh_t mesh)
     next = link->next;
     link_free(link);
   }
+  free(mesh->timers);
+  free(mesh->clocks);
   
   // free any triggers first
   while(mesh->on)
@@ -110,13 +124,13 @@ lob_t mesh_json(mesh_t mesh)
   lob_t json, paths;
   if(!mesh) return LOG_ERROR("bad args");
 
-  json = lob_new();
-  lob_set(json,"hashname",hashname_char(mesh->id));
-  lob_set_raw(json,"keys",0,(char*)mesh->keys->head,mesh->keys->head_len);
+  json = lob_begin(lob_new());
+  lob_add(json,"hashname",hashname_char(mesh->id));
+  lob_add_raw(json,"keys",0,(char*)mesh->keys->head,mesh->keys->head_len);
   paths = lob_array(mesh->paths);
-  lob_set_raw(json,"paths",0,(char*)paths->head,paths->head_len);
+  lob_add_raw(json,"paths",0,(char*)paths->head,paths->head_len);
   lob_free(paths);
-  return json;
+  return lob_finish(json);
 }
 
 // generate json for all links, returns lob list
@@ -132,20 +146,195 @@ lob_t mesh_links(mesh_t mesh)
   return links;
 }
 
-// process any channel timeouts based on the current/given time
+// both heaps of links are kept the same way, clock picks which
+static link_t *links_heap(mesh_t mesh, uint8_t clock)
+{
+  return clock ? mesh->clocks : mesh->timers;
+}
+
+static uint32_t *links_count(mesh_t mesh, uint8_t clock)
+{
+  return clock ? &(mesh->clocks_count) : &(mesh->timers_count);
+}
+
+static uint32_t *links_index(link_t link, uint8_t clock)
+{
+  return clock ? &(link->cindex) : &(link->tindex);
+}
+
+// which is due first, mesh_clock()'s time wraps so those by how far apart they are
+static int32_t links_cmp(link_t a, link_t b, uint8_t clock)
+{
+  if(clock) return (int32_t)(a->cdue - b->cdue);
+  return (a->tdue > b->tdue) - (a->tdue < b->tdue);
+}
+
+static void links_swap(mesh_t mesh, uint8_t clock, uint32_t a, uint32_t b)
+{
+  link_t *heap = links_heap(mesh, clock);
+  link_t tmp = heap[a];
+  heap[a] = heap[b];
+  heap[b] = tmp;
+  *links_index(heap[a], clock) = a + 1;
+  *links_index(heap[b], clock) = b + 1;
+}
+
+// restore heap order around the given position
+static void links_sift(mesh_t mesh, uint8_t clock, uint32_t i)
+{
+  link_t *heap = links_heap(mesh, clock);
+  uint32_t parent, child, count = *links_count(mesh, clock);
+
+  while(i > 0)
+  {
+    parent = (i - 1) / 2;
+    if(links_cmp(heap[parent], heap[i], clock) <= 0) break;
+    links_swap(mesh, clock, parent, i);
+    i = parent;
+  }
+
+  while((child = (i * 2) + 1) < count)
+  {
+    if(child + 1 < count && links_cmp(heap[child + 1], heap[child], clock) < 0) child++;
+    if(links_cmp(heap[i], heap[child], clock) <= 0) break;
+    links_swap(mesh, clock, i, child);
+    i = child;
+  }
+}
+
+static void links_remove(mesh_t mesh, uint8_t clock, link_t link)
+{
+  link_t *heap = links_heap(mesh, clock);
+  uint32_t i, *count = links_count(mesh, clock);
+  if(!*links_index(link, clock)) return;
+  i = *links_index(link, clock) - 1;
+  *links_index(link, clock) = 0;
+  (*count)--;
+  if(i == *count) return;
+  heap[i] = heap[*count];
+  *links_index(heap[i], clock) = i + 1;
+  links_sift(mesh, clock, i);
+}
+
+// in the heap at its due time, or out of it w/o one
+static void links_update(mesh_t mesh, uint8_t clock, link_t link, uint32_t due)
+{
+  uint32_t *index = links_index(link, clock);
+  if(!due)
+  {
+    links_remove(mesh, clock, link);
+    return;
+  }
+  if(clock) link->cdue = due;
+  else link->tdue = due;
+
+  // mesh_link_room() always keeps space for every link
+  if(!*index)
+  {
+    if(*links_count(mesh, clock) >= mesh->heaps_size)
+    {
+      LOG_WARN("no heap space for link %s",link->hshort);
+      return;
+    }
+    links_heap(mesh, clock)[*links_count(mesh, clock)] = link;
+    *index = ++(*links_count(mesh, clock));
+  }
+  links_sift(mesh, clock, *index - 1);
+}
+
+mesh_t mesh_link_room(mesh_t mesh, uint32_t links)
+{
+  uint32_t size;
+  link_t *timers, *clocks;
+  if(!mesh) return LOG("bad args");
+  if(links <= mesh->heaps_size) return mesh;
+
+  // all or nothing, like the links' own heaps
+  size = mesh->heaps_size ? mesh->heaps_size * 2 : 16;
+  while(size < links) size *= 2;
+  timers = malloc(size * sizeof(link_t));
+  clocks = malloc(size * sizeof(link_t));
+  if(!timers || !clocks)
+  {
+    free(timers);
+    free(clocks);
+    return LOG("OOM");
+  }
+  if(mesh->timers_count) memcpy(timers, mesh->timers, mesh->timers_count * sizeof(link_t));
+  if(mesh->clocks_count) memcpy(clocks, mesh->clocks, mesh->clocks_count * sizeof(link_t));
+  free(mesh->timers);
+  free(mesh->clocks);
+  mesh->timers = timers;
+  mesh->clocks = clocks;
+  mesh->heaps_size = size;
+  return mesh;
+}
+
+mesh_t mesh_link_timer(mesh_t mesh, link_t link)
+{
+  if(!mesh || !link) return NULL;
+  links_update(mesh, 0, link, link_due(link));
+  links_update(mesh, 1, link, link_clock_due(link));
+  return mesh;
+}
+
+mesh_t mesh_link_drop(mesh_t mesh, link_t link)
+{
+  if(!mesh || !link) return NULL;
+  links_remove(mesh, 0, link);
+  links_remove(mesh, 1, link);
+  return mesh;
+}
+
+// process the links w/ any channel timeouts (or w/o a mesh_clock() resends) before the current/given time
 mesh_t mesh_process(mesh_t mesh, uint32_t now)
 {
-  link_t link, next;
+  link_t link;
   if(!mesh || !now) return LOG("bad args");
-  for(link = mesh->links;link;link = next)
+  if(!mesh->clocked) mesh->clock = now;
+
+  // each out of the heap while it runs, back in by whatever's due next unless it was freed (flagged ones are first, and always are)
+  while(mesh->timers_count && (mesh->timers[0]->tdue < now || !mesh->timers[0]->csid))
   {
-    next = link->next;
-    link_process(link, now);
+    link = mesh->timers[0];
+    links_remove(mesh, 0, link);
+    if(!link_process(link, now)) continue;
+    mesh_link_timer(mesh, link);
   }
   
   return mesh;
 }
 
+uint32_t mesh_due(mesh_t mesh)
+{
+  if(!mesh || !mesh->timers_count) return 0;
+  return mesh->timers[0]->tdue;
+}
+
+mesh_t mesh_clock(mesh_t mesh, uint32_t now)
+{
+  link_t link;
+  if(!mesh || !now) return LOG("bad args");
+  mesh->clocked = 1;
+  mesh->clock = now;
+
+  // only the links w/ a resend or paced send due, the rest catch up in link_now() when they're used
+  while(mesh->clocks_count && (int32_t)(mesh->clocks[0]->cdue - now) < 0)
+  {
+    link = mesh->clocks[0];
+    links_remove(mesh, 1, link);
+    link_clock(link, now);
+    mesh_link_timer(mesh, link);
+  }
+  return mesh;
+}
+
+uint32_t mesh_clock_due(mesh_t mesh)
+{
+  if(!mesh || !mesh->clocks_count) return 0;
+  return mesh->clocks[0]->cdue;
+}
+
 link_t mesh_add(mesh_t mesh, lob_t json)
 {
   link_t link;
@@ -176,22 +365,114 @@ link_t mesh_add(mesh_t mesh, lob_t json)
 link_t mesh_linked(mesh_t mesh, char *hn, size_t len)
 {
   link_t link;
+  char key[53];
   if(!mesh || !hn) return NULL;
   if(!len) len = strlen(hn);
-  
-  for(link = mesh->links;link;link = link->next) if(strncmp(hashname_char(link->id),hn,len) == 0) return link;
+
+  // full and short hashnames are indexed
+  if(len == 52 || len == 8)
+  {
+    memcpy(key,hn,len);
+    key[len] = 0;
+    return xht_get((len == 8) ? mesh->index_short : mesh->index_id, key);
+  }
+
+  // any other prefix length has to walk them
+  for(link = mesh->links;link;link = link->next) if(strncmp(link->hashname,hn,len) == 0) return link;
   
   return NULL;
 }
 
 link_t mesh_linkid(mesh_t mesh, hashname_t id)
 {
-  link_t link;
+  char key[9];
   if(!mesh || !id) return NULL;
   
-  for(link = mesh->links;link;link = link->next) if(hashname_scmp(link->id,id) == 0) return link;
-  
-  return NULL;
+  base32_encode(id->bin,5,key,9);
+  return xht_get(mesh->index_short,key);
+}
+
+// add the link's keys to the current indexes
+static void mesh_index_set(mesh_t mesh, link_t link)
+{
+  xht_set(mesh->index_id, link->hashname, link);
+  // short ids can collide, first one wins
+  if(!xht_get(mesh->index_short, link->hshort)) xht_set(mesh->index_short, link->hshort, link);
+  if(link->x)
+  {
+    util_hex(link->x->token, 8, link->token);
+    xht_set(mesh->index_token, link->token, link);
+  }
+}
+
+// (re)create the indexes at the next size up and add all current links, NULL if there's no bigger size
+static mesh_t mesh_index_grow(mesh_t mesh)
+{
+  uint32_t i;
+  link_t link;
+
+  for(i=0;index_primes[i] && index_primes[i] <= mesh->index_prime;i++);
+  if(!index_primes[i]) return NULL; // biggest already, chains just get longer
+
+  xht_free(mesh->index_token);
+  xht_free(mesh->index_id);
+  xht_free(mesh->index_short);
+  mesh->index_token = xht_new(index_primes[i]);
+  mesh->index_id = xht_new(index_primes[i]);
+  mesh->index_short = xht_new(index_primes[i]);
+  if(!mesh->index_token || !mesh->index_id || !mesh->index_short)
+  {
+    xht_free(mesh->index_token);
+    xht_free(mesh->index_id);
+    xht_free(mesh->index_short);
+    mesh->index_token = mesh->index_id = mesh->index_short = NULL;
+    mesh->index_prime = 0;
+    return LOG_ERROR("OOM");
+  }
+  mesh->index_prime = index_primes[i];
+  LOG("link index resized to %u for %u links",mesh->index_prime,mesh->linked);
+
+  for(link = mesh->links;link;link = link->next) mesh_index_set(mesh, link);
+
+  return mesh;
+}
+
+// internal, keeps the link lookup indexes current (used by link_new/link_load/link_free)
+mesh_t mesh_index(mesh_t mesh, link_t link)
+{
+  if(!mesh || !link) return LOG("bad args");
+
+  // the index keys are stored on the link itself
+  base32_encode(link->id->bin,32,link->hashname,53);
+  base32_encode(link->id->bin,5,link->hshort,9);
+
+  // keep chains short, growing re-indexes every link including this one
+  if(mesh->linked > (mesh->index_prime * 2) && mesh_index_grow(mesh)) return mesh;
+
+  mesh_index_set(mesh, link);
+  return mesh;
+}
+
+mesh_t mesh_unindex(mesh_t mesh, link_t link)
+{
+  link_t li;
+  if(!mesh || !link) return LOG("bad args");
+  if(!mesh->index_prime) return mesh;
+
+  if(xht_get(mesh->index_id, link->hashname) == link) xht_set(mesh->index_id, link->hashname, NULL);
+  if(link->token[0] && xht_get(mesh->index_token, link->token) == link) xht_set(mesh->index_token, link->token, NULL);
+  if(xht_get(mesh->index_short, link->hshort) == link)
+  {
+    xht_set(mesh->index_short, link->hshort, NULL);
+    // hand the short id to any other link that collided with it
+    for(li = mesh->links;li;li = li->next) if(li != link && strcmp(li->hshort,link->hshort) == 0)
+    {
+      xht_set(mesh->index_short, li->hshort, li);
+      break;
+    }
+  }
+
+  return mesh;
 }
 
 // remove this link, will event it down and clean up during next process()
@@ -199,6 +480,7 @@ mesh_t mesh_unlink(link_t link)
 {
   if(!link) return NULL;
   link->csid = 0; // removal indicator
+  mesh_link_timer(link->mesh, link); // due right away
   return link->mesh;
 }
 
@@ -281,8 +563,15 @@ void mesh_discover(mesh_t mesh, lob_t discovered)
   for(on = mesh->on; on; on = on->next) if(on->discover) on->discover(mesh, discovered);
 }
 
+static link_t mesh_handshake(mesh_t mesh, lob_t handshake, e3x_exchange_t prepared);
+
 // process any unencrypted handshake packet
 link_t mesh_receive_handshake(mesh_t mesh, lob_t handshake)
+{
+  return mesh_handshake(mesh, handshake, NULL);
+}
+
+static link_t mesh_handshake(mesh_t mesh, lob_t handshake, e3x_exchange_t prepared)
 {
   uint32_t now;
   hashname_t from = NULL;
@@ -299,8 +588,18 @@ link_t mesh_receive_handshake(mesh_t mesh, lob_t handshake)
   
   // normalize handshake
   handshake->id = now; // save when we cached it
-  if(!lob_get(handshake,"type")) lob_set(handshake,"type","link"); // default to link type
-  if(!lob_get_uint(handshake,"at")) lob_set_uint(handshake,"at",now); // require an at
+  uint8_t add_type = lob_get_raw(handshake,"type") ? 0 : 1;
+  uint8_t add_at = lob_get_raw(handshake,"at") ? 0 : 1;
+  if(!add_type && !lob_get(handshake,"type")) lob_set(handshake,"type","link"); // default to link type
+  if(!add_at && !lob_get_uint(handshake,"at")) lob_set_uint(handshake,"at",now); // require an at
+  if(add_type || add_at)
+  {
+    // missing ones are just appended
+    lob_begin(handshake);
+    if(add_type) lob_add(handshake,"type","link");
+    if(add_at) lob_add_uint(handshake,"at",now);
+    lob_finish(handshake);
+  }
   LOG("handshake at %d id %s",now,lob_get(handshake,"id"));
   
   // validate/extend link handshakes immediately
@@ -342,7 +641,7 @@ link_t mesh_receive_handshake(mesh_t mesh, lob_t handshake)
 
     // short-cut, if it's a key from an existing link, pass it on
     // TODO: using mesh_linked here is a stack issue during loopback peer test!
-    if((link = mesh_linkid(mesh,from))) return link_receive_handshake(link, handshake);
+    if((link = mesh_linkid(mesh,from))) return link_receive_prepared(link, handshake, prepared);
     LOG("no link found for handshake from %s",hashname_char(from));
 
     // extend the key json to make it compatible w/ normal patterns
@@ -358,15 +657,177 @@ link_t mesh_receive_handshake(mesh_t mesh, lob_t handshake)
   return from == NULL ? NULL : mesh_linkid(mesh, from);
 }
 
-// processes incoming packet, it will take ownership of outer
+// a handshake decrypted elsewhere, inner has the outer linked
+link_t mesh_receive_prepared(mesh_t mesh, lob_t inner, e3x_exchange_t prepared)
+{
+  char token[17] = {0};
+  lob_t outer = lob_linked(inner);
+  link_t link;
+
+  if(!mesh || !outer || outer->body_len < 10)
+  {
+    lob_free(inner);
+    e3x_exchange_free(prepared);
+    return LOG("bad args");
+  }
+
+  // set the unique id string based on some of the first 16 (routing token) bytes in the body
+  base32_encode(outer->body,10,token,17);
+  lob_set(inner,"id",token);
+
+  // process the handshake
+  link = mesh_handshake(mesh, inner, prepared);
+  e3x_exchange_free(prepared);
+  return link;
+}
+
+mesh_t mesh_admission(mesh_t mesh, lob_t options)
+{
+  uint8_t secret[32];
+  if(!mesh) return LOG("bad args");
+  mesh->admit = util_admit_free(mesh->admit);
+  if(!options) return mesh;
+  e3x_rand(secret, sizeof(secret));
+  if(!(mesh->admit = util_admit_new(options, secret, sizeof(secret)))) return LOG("admission failed");
+  return mesh;
+}
+
+mesh_t mesh_buffer(mesh_t mesh, uint32_t max)
+{
+  if(!mesh) return LOG("bad args");
+  mesh->buffer_max = max ? max : MESH_BUFFER;
+  return mesh;
+}
+
+// a handshake echoing a cookie, {"cookie":"..."} w/ the original as the body
+static uint8_t mesh_echo(lob_t outer)
+{
+  return (outer->head_len > 5 && lob_get(outer,"cookie") && !lob_get(outer,"type"));
+}
+
+lob_t mesh_admit(mesh_t mesh, lob_t outer, uint8_t *from, size_t len, lob_t *reply)
+{
+  uint8_t hash[32], cookie[UTIL_ADMIT_COOKIE];
+  uint8_t cookied = 0;
+  uint64_t now;
+  lob_t inner, echo;
+
+  if(reply) *reply = NULL;
+  if(!mesh || !outer)
+  {
+    lob_free(outer);
+    return LOG("bad args");
+  }
+  if(outer->head_len != 1 && !mesh_echo(outer)) return outer;
+  now = util_sys_ms(0);
+
+  // unwrap an echo, the cookie only matters when we're checking them
+  if(mesh_echo(outer))
+  {
+    inner = lob_parse(outer->body, outer->body_len);
+    echo = lob_get_base32(outer,"cookie");
+    if(inner && inner->head_len == 1 && mesh->admit && util_admit_cookies(mesh->admit)
+      && echo && echo->body_len == UTIL_ADMIT_COOKIE && util_admit_verify(mesh->admit, from, len, now, echo->body)) cookied = 1;
+    lob_free(echo);
+    lob_free(outer);
+    if(!inner || inner->head_len != 1)
+    {
+      lob_free(inner);
+      return LOG("bad cookie echo");
+    }
+    // a stale or wrong cookie is treated like no cookie, it gets a fresh challenge below
+    outer = inner;
+  }
+
+  if(!mesh->admit) return outer;
+
+  // challenge anyone we can reply to, the cookie is the only state and it's theirs to keep
+  if(!cookied && from && reply && util_admit_cookies(mesh->admit))
+  {
+    memset(cookie,0,sizeof(cookie));
+    *reply = lob_new();
+    lob_set(*reply,"type","cookie");
+    lob_set_base32(*reply,"cookie",cookie,UTIL_ADMIT_COOKIE);
+    lob_body(*reply,NULL,16);
+
+    // never send back more than was received, or any spoofed source gets amplified (and they count against the budget)
+    if(outer->body_len < 16 || lob_len(*reply) > lob_len(outer) || !util_admit_cookie(mesh->admit, from, len, now, cookie))
+    {
+      *reply = lob_free(*reply);
+      lob_free(outer);
+      return LOG("handshake not challenged");
+    }
+    lob_set_base32(*reply,"cookie",cookie,UTIL_ADMIT_COOKIE);
+    // their routing token, so it finds its link
+    e3x_hash(outer->body,16,hash);
+    memcpy((*reply)->body,hash,16);
+    lob_free(outer);
+    return NULL;
+  }
+
+  if(!util_admit_take(mesh->admit, from, len, now))
+  {
+    lob_free(outer);
+    return LOG("handshake over the admission limits, dropped");
+  }
+
+  return outer;
+}
+
+// a peer wants our handshakes to echo a cookie
+static link_t mesh_cookie(mesh_t mesh, lob_t outer)
+{
+  char token[17], *cookie = lob_get(outer,"cookie");
+  link_t link;
+
+  if(outer->body_len != 16 || !cookie || strlen(cookie) >= sizeof(link->cookie))
+  {
+    lob_free(outer);
+    return LOG("bad cookie");
+  }
+
+  util_hex(outer->body,8,token);
+  link = xht_get(mesh->index_token,token);
+  if(!link || !link->x || memcmp(link->x->token,outer->body,16) != 0)
+  {
+    lob_free(outer);
+    return LOG("no link found for cookie %s",token);
+  }
+
+  // the same one again means it wasn't accepted, resending would only loop
+  if(strcmp(link->cookie,cookie) == 0)
+  {
+    lob_free(outer);
+    return LOG("cookie for %s is unchanged",hashname_short(link->id));
+  }
+  strcpy(link->cookie,cookie);
+  lob_free(outer);
+
+  // w/o a pipe yet (the first handshake was sent directly) this is the one, the transport's link_pipe() resends
+  if(!link->send_cb) return link;
+  LOG("resending handshake to %s w/ its cookie",hashname_short(link->id));
+  link_sync(link);
+  return NULL;
+}
+
 link_t mesh_receive(mesh_t mesh, lob_t outer)
+{
+  return mesh_receive_from(mesh, outer, NULL, 0, NULL);
+}
+
+// processes incoming packet, it will take ownership of outer
+link_t mesh_receive_from(mesh_t mesh, lob_t outer, uint8_t *from, size_t len, lob_t *reply)
 {
   lob_t inner = NULL;
   link_t link = NULL;
   char token[17] = {0};
   hashname_t id;
 
+  if(reply) *reply = NULL;
   if(!mesh || !outer) return LOG("bad args");
+
+  // anything that costs public key work has to be admitted first
+  if((outer->head_len == 1 || mesh_echo(outer)) && !(outer = mesh_admit(mesh, outer, from, len, reply))) return NULL;
   
   LOG("mesh receiving %s to %s",outer->head_len?"handshake":"channel",hashname_short(mesh->id));
 
@@ -402,13 +863,7 @@ link_t mesh_receive(mesh_t mesh, lob_t outer)
     
     // couple the two together, inner->outer
     lob_link(inner,outer);
-
-    // set the unique id string based on some of the first 16 (routing token) bytes in the body
-    base32_encode(outer->body,10,token,17);
-    lob_set(inner,"id",token);
-
-    // process the handshake
-    return mesh_receive_handshake(mesh, inner);
+    return mesh_receive_prepared(mesh, inner, NULL);
   }
 
   // handle channel packets
@@ -421,9 +876,10 @@ link_t mesh_receive(mesh_t mesh, lob_t outer)
       return NULL;
     }
 
-    for(link = mesh->links;link;link = link->next) if(link->x && memcmp(link->x->token,outer->body,8) == 0) break;
+    util_hex(outer->body,8,token);
+    link = xht_get(mesh->index_token,token);
 
-    if(!link)
+    if(!link || !link->x || memcmp(link->x->token,outer->body,8) != 0)
     {
       LOG("no link found for token %s",util_hex(outer->body,8,NULL));
       lob_free(outer);
@@ -439,6 +895,8 @@ link_t mesh_receive(mesh_t mesh, lob_t outer)
     
   }
 
+  if(lob_get_cmp(outer,"type","cookie") == 0) return mesh_cookie(mesh, outer);
+
   // transform incoming bare link json format into handshake for discovery
   if((inner = lob_get_json(outer,"keys")))
   {
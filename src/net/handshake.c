@@ -0,0 +1,309 @@
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__)))
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "net_handshake.h"
+#include "telehash.h"
+
+// each handshake going through the pipeline
+typedef struct hs_job_struct
+{
+  lob_t outer, inner; // inner (w/ outer linked) once decrypted
+  e3x_exchange_t dup; // sender link's exchange to verify/sync on
+  void (*done)(link_t link, void *arg);
+  void *arg;
+  uint64_t start; // microseconds
+  uint8_t failed;
+  struct hs_job_struct *next;
+} *hs_job_t;
+
+struct net_handshakes_struct
+{
+  mesh_t mesh;
+  pthread_t *threads;
+  uint32_t count, depth;
+  int wake[2]; // pipe, readable when there's anything done
+
+  // guarded by the lock, workers wait on todo
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  hs_job_t todo, todo_last, done, done_last;
+  uint8_t stopping;
+
+  struct net_handshakes_stats_struct stats; // only used on the mesh thread
+};
+
+static uint64_t hs_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+// append to a list, lock must be held
+static void hs_push(hs_job_t *list, hs_job_t *last, hs_job_t job)
+{
+  job->next = NULL;
+  if(*last) (*last)->next = job;
+  else *list = job;
+  *last = job;
+}
+
+static void hs_todo(net_handshakes_t hs, hs_job_t job)
+{
+  pthread_mutex_lock(&(hs->lock));
+  hs_push(&(hs->todo), &(hs->todo_last), job);
+  pthread_cond_signal(&(hs->cond));
+  pthread_mutex_unlock(&(hs->lock));
+}
+
+// all the public key work, only reads the mesh's self
+static void hs_work(net_handshakes_t hs, hs_job_t job)
+{
+  // second pass, the same as link_receive_handshake() would do on the link's exchange
+  if(job->dup)
+  {
+    if(e3x_exchange_verify(job->dup, lob_linked(job->inner)) || !e3x_exchange_sync(job->dup, lob_linked(job->inner))) job->failed = 1;
+    return;
+  }
+
+  if(!(job->inner = e3x_self_decrypt(hs->mesh->self, job->outer)))
+  {
+    job->failed = 1;
+    return;
+  }
+  lob_link(job->inner, job->outer);
+  job->outer = NULL;
+}
+
+static void *hs_worker(void *arg)
+{
+  net_handshakes_t hs = arg;
+  hs_job_t job;
+  uint8_t wake;
+
+  pthread_mutex_lock(&(hs->lock));
+  while(!hs->stopping)
+  {
+    if(!(job = hs->todo))
+    {
+      pthread_cond_wait(&(hs->cond), &(hs->lock));
+      continue;
+    }
+    if(!(hs->todo = job->next)) hs->todo_last = NULL;
+    pthread_mutex_unlock(&(hs->lock));
+
+    hs_work(hs, job);
+
+    // only the first one done needs to wake the mesh thread
+    pthread_mutex_lock(&(hs->lock));
+    wake = (hs->done == NULL);
+    hs_push(&(hs->done), &(hs->done_last), job);
+    if(wake && write(hs->wake[1], &wake, 1) < 0) LOG_WARN("wake failed %s",strerror(errno));
+  }
+  pthread_mutex_unlock(&(hs->lock));
+  util_pool_flush(); // this thread's cache
+  return NULL;
+}
+
+net_handshakes_t net_handshakes_new(mesh_t mesh, lob_t options)
+{
+  net_handshakes_t hs;
+  uint32_t i;
+  int flags;
+
+  if(!mesh || !mesh->self) return LOG_WARN("bad args");
+  if(!(hs = malloc(sizeof (struct net_handshakes_struct)))) return LOG_ERROR("OOM");
+  memset(hs,0,sizeof (struct net_handshakes_struct));
+  hs->mesh = mesh;
+  hs->wake[0] = hs->wake[1] = -1;
+  pthread_mutex_init(&(hs->lock), NULL);
+  pthread_cond_init(&(hs->cond), NULL);
+
+  hs->depth = lob_get_uint(options,"depth");
+  if(!hs->depth) hs->depth = 256;
+  hs->count = lob_get_uint(options,"threads");
+  if(!hs->count) hs->count = 1;
+
+  if(pipe(hs->wake) < 0)
+  {
+    LOG_ERROR("pipe failed %s",strerror(errno));
+    return net_handshakes_free(hs);
+  }
+  for(i=0;i<2;i++)
+  {
+    if((flags = fcntl(hs->wake[i], F_GETFL, 0)) >= 0) fcntl(hs->wake[i], F_SETFL, flags | O_NONBLOCK);
+    fcntl(hs->wake[i], F_SETFD, FD_CLOEXEC);
+  }
+
+  if(!(hs->threads = malloc(hs->count * sizeof(pthread_t))))
+  {
+    LOG_ERROR("OOM");
+    return net_handshakes_free(hs);
+  }
+  for(i=0;i<hs->count;i++)
+  {
+    if(pthread_create(&(hs->threads[i]), NULL, hs_worker, hs) == 0) continue;
+    LOG_ERROR("failed to start handshake worker %u",i);
+    hs->count = i;
+    return net_handshakes_free(hs);
+  }
+
+  return hs;
+}
+
+static void hs_finish(net_handshakes_t hs, hs_job_t job, link_t link)
+{
+  uint64_t us = hs_now() - job->start;
+  uint32_t bucket = 0;
+
+  while(bucket < NET_HANDSHAKES_BUCKETS-1 && us >= (1ULL << bucket)) bucket++;
+  hs->stats.latency[bucket]++;
+  hs->stats.completed++;
+  hs->stats.pending--;
+  if(!link) hs->stats.failed += job->failed;
+
+  if(job->done) job->done(link, job->arg);
+  lob_free(job->outer);
+  lob_free(job->inner);
+  e3x_exchange_free(job->dup);
+  free(job);
+}
+
+net_handshakes_t net_handshakes_free(net_handshakes_t hs)
+{
+  hs_job_t job;
+  uint32_t i;
+  if(!hs) return NULL;
+
+  pthread_mutex_lock(&(hs->lock));
+  hs->stopping = 1;
+  pthread_cond_broadcast(&(hs->cond));
+  pthread_mutex_unlock(&(hs->lock));
+  for(i=0;i<hs->count;i++) pthread_join(hs->threads[i], NULL);
+  free(hs->threads);
+
+  // nothing else touches the lists now
+  while((job = hs->todo) || (job = hs->done))
+  {
+    if(job == hs->todo) hs->todo = job->next;
+    else hs->done = job->next;
+    hs_finish(hs, job, NULL);
+  }
+
+  if(hs->wake[0] >= 0) close(hs->wake[0]);
+  if(hs->wake[1] >= 0) close(hs->wake[1]);
+  pthread_cond_destroy(&(hs->cond));
+  pthread_mutex_destroy(&(hs->lock));
+  free(hs);
+  return NULL;
+}
+
+net_handshakes_t net_handshakes_queue(net_handshakes_t hs, lob_t outer, void (*done)(link_t link, void *arg), void *arg)
+{
+  hs_job_t job;
+  if(!hs || !outer || outer->head_len != 1)
+  {
+    lob_free(outer);
+    return LOG_WARN("bad args");
+  }
+
+  if(hs->stats.pending >= hs->depth)
+  {
+    hs->stats.dropped++;
+    lob_free(outer);
+    return LOG_DEBUG("handshake pipeline full, dropping");
+  }
+
+  if(!(job = malloc(sizeof (struct hs_job_struct))))
+  {
+    lob_free(outer);
+    return LOG_ERROR("OOM");
+  }
+  memset(job,0,sizeof (struct hs_job_struct));
+  job->outer = outer;
+  job->done = done;
+  job->arg = arg;
+  job->start = hs_now();
+
+  hs->stats.queued++;
+  hs->stats.pending++;
+  hs_todo(hs, job);
+  return hs;
+}
+
+int net_handshakes_fd(net_handshakes_t hs)
+{
+  if(!hs) return -1;
+  return hs->wake[0];
+}
+
+// a decrypted handshake from a known link goes back for the verify/sync on a copy of its exchange
+static uint8_t hs_second(net_handshakes_t hs, hs_job_t job)
+{
+  lob_t outer = lob_linked(job->inner), key;
+  char *type = lob_get(job->inner,"type");
+  hashname_t id;
+  link_t link;
+
+  if(type && strcmp(type,"link") != 0) return 0;
+  if(!(key = lob_parse(job->inner->body, job->inner->body_len))) return 0;
+  id = hashname_vkey(key, outer->head[0]);
+  lob_free(key);
+  if(!id || !(link = mesh_linkid(hs->mesh, id)) || !link->x || link->x->csid != outer->head[0]) return 0;
+  if(!(job->dup = e3x_exchange_dup(link->x))) return 0;
+
+  hs_todo(hs, job);
+  return 1;
+}
+
+uint32_t net_handshakes_process(net_handshakes_t hs)
+{
+  hs_job_t job, next;
+  uint8_t buf[64];
+  uint32_t count = 0;
+  link_t link;
+
+  if(!hs) return 0;
+  while(read(hs->wake[0], buf, sizeof(buf)) > 0);
+
+  pthread_mutex_lock(&(hs->lock));
+  job = hs->done;
+  hs->done = hs->done_last = NULL;
+  pthread_mutex_unlock(&(hs->lock));
+
+  for(;job;job = next)
+  {
+    next = job->next;
+    if(job->failed)
+    {
+      LOG_DEBUG("handshake failed to decrypt or verify");
+      hs_finish(hs, job, NULL);
+      count++;
+      continue;
+    }
+
+    // first pass done, is there a second
+    if(!job->dup && hs_second(hs, job)) continue;
+
+    link = mesh_receive_prepared(hs->mesh, job->inner, job->dup);
+    job->inner = NULL;
+    job->dup = NULL;
+    hs_finish(hs, job, link);
+    count++;
+  }
+
+  return count;
+}
+
+net_handshakes_stats_t net_handshakes_stats(net_handshakes_t hs)
+{
+  if(!hs) return NULL;
+  return &(hs->stats);
+}
+
+#endif // POSIX
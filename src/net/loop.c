@@ -0,0 +1,275 @@
+#if defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include "net_loop.h"
+
+// max events handled per wakeup, any others are still there for the next
+#define LOOP_EVENTS 64
+
+// each registered socket
+typedef struct loop_fd_struct
+{
+  int fd;
+  net_udp4_t udp4; // transport driven directly, else the handler
+  void (*handler)(net_loop_t loop, int fd, uint32_t events, void *arg);
+  void *arg;
+  uint8_t dropped; // freed after the current run, events may still point at it
+  struct loop_fd_struct *next;
+} *loop_fd_t;
+
+struct net_loop_struct
+{
+  mesh_t mesh;
+  loop_fd_t fds;
+  int epoll, timer;
+  uint32_t resend; // ms
+  uint64_t epoch; // the mesh_clock() is ms since, on CLOCK_MONOTONIC like the timer
+  uint8_t running, stopped;
+};
+
+static uint64_t loop_monotonic(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// the reliable channels' clock, fine enough for their rtt and pacing, it wraps after ~49 days (0 is skipped)
+static uint32_t loop_ms(net_loop_t loop)
+{
+  uint32_t ms = (uint32_t)(loop_monotonic() - loop->epoch);
+  return ms ? ms : 1;
+}
+
+net_loop_t net_loop_new(mesh_t mesh, lob_t options)
+{
+  net_loop_t loop;
+  struct epoll_event ev;
+  if(!mesh) return LOG_WARN("bad args");
+
+  if(!(loop = malloc(sizeof (struct net_loop_struct)))) return LOG_ERROR("OOM");
+  memset(loop,0,sizeof (struct net_loop_struct));
+  loop->mesh = mesh;
+  loop->resend = lob_get_uint(options,"resend");
+  if(!loop->resend) loop->resend = 20;
+  loop->epoch = loop_monotonic() - 1000;
+  mesh_clock(mesh, loop_ms(loop));
+
+  loop->epoll = epoll_create1(EPOLL_CLOEXEC);
+  loop->timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if(loop->epoll < 0 || loop->timer < 0)
+  {
+    LOG_ERROR("failed to create epoll/timerfd %s",strerror(errno));
+    return net_loop_free(loop);
+  }
+
+  // the loop itself marks timer events
+  memset(&ev,0,sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.ptr = loop;
+  if(epoll_ctl(loop->epoll, EPOLL_CTL_ADD, loop->timer, &ev) < 0)
+  {
+    LOG_ERROR("failed to add timerfd %s",strerror(errno));
+    return net_loop_free(loop);
+  }
+
+  return loop;
+}
+
+net_loop_t net_loop_free(net_loop_t loop)
+{
+  loop_fd_t f;
+  if(!loop) return NULL;
+  while((f = loop->fds))
+  {
+    loop->fds = f->next;
+    free(f);
+  }
+  if(loop->epoll >= 0) close(loop->epoll);
+  if(loop->timer >= 0) close(loop->timer);
+  free(loop);
+  return NULL;
+}
+
+static loop_fd_t loop_add(net_loop_t loop, int fd)
+{
+  loop_fd_t f;
+  struct epoll_event ev;
+  int flags;
+
+  // edge-triggered needs reads/writes that never block
+  if((flags = fcntl(fd, F_GETFL, 0)) < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) return LOG_WARN("failed to set non-blocking %s",strerror(errno));
+
+  if(!(f = malloc(sizeof (struct loop_fd_struct)))) return LOG_ERROR("OOM");
+  memset(f,0,sizeof (struct loop_fd_struct));
+  f->fd = fd;
+
+  memset(&ev,0,sizeof(ev));
+  ev.events = EPOLLIN | EPOLLET;
+  ev.data.ptr = f;
+  if(epoll_ctl(loop->epoll, EPOLL_CTL_ADD, fd, &ev) < 0)
+  {
+    free(f);
+    return LOG_WARN("epoll add failed %s",strerror(errno));
+  }
+
+  f->next = loop->fds;
+  loop->fds = f;
+  return f;
+}
+
+net_loop_t net_loop_udp4(net_loop_t loop, net_udp4_t udp4)
+{
+  loop_fd_t f;
+  if(!loop || !udp4) return LOG_WARN("bad args");
+  if(!(f = loop_add(loop, net_udp4_socket(udp4)))) return NULL;
+  f->udp4 = udp4;
+  return loop;
+}
+
+net_loop_t net_loop_fd(net_loop_t loop, int fd, void (*handler)(net_loop_t loop, int fd, uint32_t events, void *arg), void *arg)
+{
+  loop_fd_t f;
+  if(!loop || fd < 0 || !handler) return LOG_WARN("bad args");
+  if(!(f = loop_add(loop, fd))) return NULL;
+  f->handler = handler;
+  f->arg = arg;
+  return loop;
+}
+
+// free any dropped while running
+static void loop_reap(net_loop_t loop)
+{
+  loop_fd_t f, *at = &(loop->fds);
+  while((f = *at))
+  {
+    if(!f->dropped)
+    {
+      at = &(f->next);
+      continue;
+    }
+    *at = f->next;
+    free(f);
+  }
+}
+
+net_loop_t net_loop_fd_drop(net_loop_t loop, int fd)
+{
+  loop_fd_t f;
+  if(!loop) return LOG_WARN("bad args");
+  for(f = loop->fds;f && (f->dropped || f->fd != fd);f = f->next);
+  if(!f) return LOG_WARN("fd %d not in loop",fd);
+  epoll_ctl(loop->epoll, EPOLL_CTL_DEL, fd, NULL);
+  f->dropped = 1;
+  if(!loop->running) loop_reap(loop);
+  return loop;
+}
+
+net_loop_t net_loop_stop(net_loop_t loop)
+{
+  if(!loop) return NULL;
+  loop->stopped = 1;
+  return loop;
+}
+
+// send anything newly queued on a transport, from handlers, mesh_process or the app between runs
+static void loop_flush(net_loop_t loop)
+{
+  loop_fd_t f;
+  for(f = loop->fds;f;f = f->next) if(f->udp4 && !f->dropped && net_udp4_pending(f->udp4)) net_udp4_receive(f->udp4);
+}
+
+// timer for the sooner of the resend interval (only when needed), a channel resend or paced send, or the next channel timeout
+static void loop_arm(net_loop_t loop)
+{
+  struct itimerspec its;
+  unsigned long long now, at;
+  uint32_t due, clock, ms = 0;
+  loop_fd_t f;
+
+  for(f = loop->fds;f;f = f->next) if(f->udp4 && !f->dropped && net_udp4_awaiting(f->udp4)) ms = loop->resend;
+
+  // those are processed once the clock is past them
+  if((due = mesh_clock_due(loop->mesh)))
+  {
+    clock = loop_ms(loop);
+    at = ((int32_t)(due - clock) >= 0) ? (due - clock) + 1 : 1;
+    if(!ms || at < ms) ms = (uint32_t)at;
+  }
+
+  // channel timeouts are in seconds and processed once the time is past them
+  if((due = mesh_due(loop->mesh)))
+  {
+    now = util_sys_ms(0);
+    at = ((unsigned long long)due + 1) * 1000;
+    at = (at > now) ? (at - now) : 1;
+    if(!ms || at < ms) ms = (uint32_t)at;
+  }
+
+  // all zero disarms
+  memset(&its,0,sizeof(its));
+  its.it_value.tv_sec = ms / 1000;
+  its.it_value.tv_nsec = (long)(ms % 1000) * 1000000L;
+  timerfd_settime(loop->timer, 0, &its, NULL);
+}
+
+net_loop_t net_loop_run(net_loop_t loop, int ms)
+{
+  struct epoll_event events[LOOP_EVENTS];
+  uint64_t expired;
+  uint32_t now, due;
+  uint8_t tick = 0;
+  loop_fd_t f;
+  int i, count;
+
+  if(!loop) return LOG_WARN("bad args");
+  if(loop->stopped) return NULL;
+
+  mesh_clock(loop->mesh, loop_ms(loop));
+  loop_flush(loop);
+  loop_arm(loop);
+
+  count = epoll_wait(loop->epoll, events, LOOP_EVENTS, ms);
+  if(count < 0)
+  {
+    if(errno == EINTR) return loop;
+    return LOG_ERROR("epoll_wait failed %s",strerror(errno));
+  }
+
+  // anything received is timed by this, and any resends or paced sends due go now
+  loop->running = 1;
+  mesh_clock(loop->mesh, loop_ms(loop));
+  for(i=0;i<count;i++)
+  {
+    if(events[i].data.ptr == loop)
+    {
+      if(read(loop->timer, &expired, sizeof(expired)) > 0) tick = 1;
+      continue;
+    }
+    f = events[i].data.ptr;
+    if(f->dropped) continue;
+    if(f->udp4) net_udp4_receive(f->udp4);
+    else f->handler(loop, f->fd, events[i].events, f->arg);
+  }
+
+  if(tick)
+  {
+    now = util_sys_seconds();
+    if((due = mesh_due(loop->mesh)) && due < now) mesh_process(loop->mesh, now);
+    for(f = loop->fds;f;f = f->next) if(f->udp4 && !f->dropped && net_udp4_awaiting(f->udp4)) net_udp4_process(f->udp4);
+  }
+
+  loop_flush(loop);
+  loop->running = 0;
+  loop_reap(loop);
+
+  return loop->stopped ? NULL : loop;
+}
+
+#endif // __linux__
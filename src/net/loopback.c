@@ -1,13 +1,35 @@
 #include <string.h>
 #include "net_loopback.h"
 
+// the sending mesh is the address, any reply goes straight back to it
+static void pair_deliver(mesh_t from, mesh_t to, lob_t packet)
+{
+  lob_t reply = NULL;
+  mesh_receive_from(to, packet, (uint8_t*)&from, sizeof(from), &reply);
+  if(reply) mesh_receive_from(from, reply, (uint8_t*)&to, sizeof(to), NULL);
+}
+
 link_t pair_send(link_t link, lob_t packet, void *arg)
 {
   net_loopback_t pair = (net_loopback_t)arg;
   if(!pair || !packet || !link) return link;
   LOG("pair pipe from %s",hashname_short(link->id));
-  if(link->mesh == pair->a) mesh_receive(pair->b,packet);
-  else if(link->mesh == pair->b) mesh_receive(pair->a,packet);
+  pair->sent++;
+  if(pair->loss)
+  {
+    // xorshift32
+    pair->seed ^= pair->seed << 13;
+    pair->seed ^= pair->seed >> 17;
+    pair->seed ^= pair->seed << 5;
+    if(pair->seed % 100 < pair->loss)
+    {
+      pair->dropped++;
+      lob_free(packet);
+      return link;
+    }
+  }
+  if(link->mesh == pair->a) pair_deliver(pair->a,pair->b,packet);
+  else if(link->mesh == pair->b) pair_deliver(pair->b,pair->a,packet);
   else lob_free(packet);
   return link;
 }
@@ -28,6 +50,14 @@ net_loopback_t net_loopback_new(mesh_t a, mesh_t b)
   return pair;
 }
 
+net_loopback_t net_loopback_loss(net_loopback_t pair, uint32_t percent)
+{
+  if(!pair || percent > 100) return LOG("bad args");
+  pair->loss = percent;
+  pair->seed = 2463534242U;
+  return pair;
+}
+
 void net_loopback_free(net_loopback_t pair)
 {
   free(pair);
@@ -0,0 +1,355 @@
+#if defined(__linux__)
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include "net_shard.h"
+#include "telehash.h"
+
+// routing token directory slots, direct-mapped (a newer link overwrites an older colliding one)
+#ifndef SHARD_TOKENS
+#define SHARD_TOKENS 16384
+#endif
+
+// addresses each thread has seen roam to another, direct-mapped too
+#ifndef SHARD_ROAMED
+#define SHARD_ROAMED 1024
+#endif
+
+// the mtu used unless one is given
+#define SHARD_MTU 1472
+
+// a packet queued to the thread that owns its link
+typedef struct shard_item_struct
+{
+  lob_t packet;
+  struct sockaddr_in from;
+  struct shard_item_struct *next;
+} *shard_item_t;
+
+// which thread has the link for a token, first 8 bytes like the mesh index
+typedef struct shard_token_struct
+{
+  uint8_t token[8];
+  uint32_t index; // +1, 0 is unused
+} *shard_token_t;
+
+// once a packet from an address is forwarded so is everything else from it (handshakes too)
+typedef struct shard_roamed_struct
+{
+  struct in_addr addr;
+  uint16_t port;
+  uint32_t index; // +1, 0 is unused
+} *shard_roamed_t;
+
+typedef struct shard_struct
+{
+  net_shards_t shards;
+  uint32_t index;
+  mesh_t mesh;
+  net_udp4_t udp4;
+  net_loop_t loop;
+  pthread_t thread;
+  uint8_t started;
+
+  // forwarded packets in, guarded by the lock and signalled on the eventfd
+  pthread_mutex_t lock;
+  shard_item_t queue, last;
+  int wake;
+
+  uint32_t received, forwarded; // only written by this thread
+  struct shard_roamed_struct roamed[SHARD_ROAMED]; // only used by this thread
+} *shard_t;
+
+struct net_shards_struct
+{
+  uint32_t count;
+  uint16_t port;
+  uint8_t stopping;
+  pthread_rwlock_t lock;
+  struct shard_token_struct tokens[SHARD_TOKENS];
+  struct shard_struct shard[];
+};
+
+// tokens are random, any bytes make a fine hash
+static shard_token_t shard_slot(net_shards_t shards, uint8_t *token)
+{
+  uint32_t hash;
+  memcpy(&hash, token, 4);
+  return &(shards->tokens[hash % SHARD_TOKENS]);
+}
+
+// thread index+1 that has the link for this token, 0 if none
+static uint32_t shard_owner(net_shards_t shards, uint8_t *token)
+{
+  shard_token_t slot = shard_slot(shards, token);
+  uint32_t index = 0;
+  pthread_rwlock_rdlock(&(shards->lock));
+  if(slot->index && memcmp(slot->token, token, 8) == 0) index = slot->index;
+  pthread_rwlock_unlock(&(shards->lock));
+  return index;
+}
+
+static void shard_claim(shard_t shard, uint8_t *token)
+{
+  net_shards_t shards = shard->shards;
+  shard_token_t slot = shard_slot(shards, token);
+  pthread_rwlock_wrlock(&(shards->lock));
+  memcpy(slot->token, token, 8);
+  slot->index = shard->index + 1;
+  pthread_rwlock_unlock(&(shards->lock));
+}
+
+static shard_roamed_t shard_roam(shard_t shard, struct sockaddr_in *from)
+{
+  uint32_t hash = ((uint32_t)from->sin_addr.s_addr * 2654435761U) ^ from->sin_port;
+  return &(shard->roamed[(hash ^ (hash >> 16)) % SHARD_ROAMED]);
+}
+
+// hand a packet to another thread's queue
+static void shard_forward(shard_t to, lob_t packet, struct sockaddr_in *from)
+{
+  shard_item_t item;
+  uint64_t one = 1;
+  if(!(item = malloc(sizeof (struct shard_item_struct))))
+  {
+    LOG_WARN("OOM");
+    lob_free(packet);
+    return;
+  }
+  item->packet = packet;
+  item->from = *from;
+  item->next = NULL;
+
+  pthread_mutex_lock(&(to->lock));
+  if(to->last) to->last->next = item;
+  else to->queue = item;
+  to->last = item;
+  pthread_mutex_unlock(&(to->lock));
+
+  if(write(to->wake, &one, sizeof(one)) < 0) LOG_WARN("wake failed %s",strerror(errno));
+}
+
+// every packet this thread's socket receives
+static link_t shard_receive(net_udp4_t udp4, lob_t packet, struct sockaddr_in *from, void *arg)
+{
+  shard_t shard = arg;
+  net_shards_t shards = shard->shards;
+  uint8_t handshake = (packet->head_len == 1 || (packet->head_len > 1 && lob_get(packet,"cookie"))); // or echoing a cookie
+  uint8_t address[6];
+  uint32_t owner;
+  char token[17];
+  link_t link;
+  lob_t reply = NULL;
+  shard_roamed_t roamed = shard_roam(shard, from);
+
+  __atomic_fetch_add(&(shard->received), 1, __ATOMIC_RELAXED);
+
+  // channel packets for links we don't have go to whoever does, and so does the rest from that address
+  owner = 0;
+  if(roamed->index && roamed->addr.s_addr == from->sin_addr.s_addr && roamed->port == from->sin_port) owner = roamed->index;
+  else if(!packet->head_len && packet->body_len >= 16 && !xht_get(shard->mesh->index_token, util_hex(packet->body,8,token)))
+  {
+    if((owner = shard_owner(shards, packet->body)) && owner != shard->index + 1)
+    {
+      LOG_DEBUG("forwarding %s:%u to shard %u for token %s",inet_ntoa(from->sin_addr),ntohs(from->sin_port),owner-1,token);
+      roamed->addr = from->sin_addr;
+      roamed->port = from->sin_port;
+      roamed->index = owner;
+    }
+  }
+  if(owner && owner != shard->index + 1)
+  {
+    __atomic_fetch_add(&(shard->forwarded), 1, __ATOMIC_RELAXED);
+    shard_forward(&(shards->shard[owner-1]), packet, from);
+    return NULL;
+  }
+
+  // admission is per sender like w/o shards, and any challenge goes straight back to them
+  link = mesh_receive_from(shard->mesh, packet, net_udp4_address(from, address), sizeof(address), &reply);
+  if(reply) net_udp4_reply(udp4, reply, from);
+
+  // a link is only synced after a handshake, so that's when its token can change
+  if(link && handshake && link->x) shard_claim(shard, e3x_exchange_token(link->x));
+
+  return link;
+}
+
+// drain our queue, replies go out our own socket (same port) to their address
+static void shard_wake(net_loop_t loop, int fd, uint32_t events, void *arg)
+{
+  shard_t shard = arg;
+  shard_item_t item, next;
+  uint64_t count;
+
+  while(read(fd, &count, sizeof(count)) > 0);
+
+  pthread_mutex_lock(&(shard->lock));
+  item = shard->queue;
+  shard->queue = shard->last = NULL;
+  pthread_mutex_unlock(&(shard->lock));
+
+  for(;item;item = next)
+  {
+    next = item->next;
+    net_udp4_deliver(shard->udp4, item->packet, &(item->from));
+    free(item);
+  }
+
+  if(__atomic_load_n(&(shard->shards->stopping), __ATOMIC_ACQUIRE)) net_loop_stop(loop);
+}
+
+static void *shard_run(void *arg)
+{
+  shard_t shard = arg;
+  LOG_DEBUG("shard %u running on %u",shard->index,net_udp4_port(shard->udp4));
+  while(net_loop_run(shard->loop, -1));
+  util_pool_flush(); // this thread's cache
+  return NULL;
+}
+
+net_shards_t net_shards_new(lob_t secrets, lob_t keys, lob_t options)
+{
+  net_shards_t shards;
+  shard_t shard;
+  lob_t opts;
+  long cpus;
+  uint32_t i, count;
+
+  if(!secrets || !keys) return LOG_WARN("bad args");
+
+  count = lob_get_uint(options,"threads");
+  if(!count && (cpus = sysconf(_SC_NPROCESSORS_ONLN)) > 0) count = (uint32_t)cpus;
+  if(!count) count = 1;
+
+  if(!(shards = malloc(sizeof (struct net_shards_struct) + count * sizeof (struct shard_struct)))) return LOG_ERROR("OOM");
+  memset(shards,0,sizeof (struct net_shards_struct) + count * sizeof (struct shard_struct));
+  pthread_rwlock_init(&(shards->lock), NULL);
+  for(i=0;i<count;i++)
+  {
+    shards->shard[i].wake = -1;
+    pthread_mutex_init(&(shards->shard[i].lock), NULL);
+  }
+  shards->count = count;
+
+  // every transport shares the first one's port
+  opts = options ? lob_copy(options) : lob_new();
+  lob_set_raw(opts,"reuseport",0,"true",4);
+  if(!lob_get(opts,"mtu")) lob_set_uint(opts,"mtu",SHARD_MTU);
+
+  for(i=0;i<count;i++)
+  {
+    shard = &(shards->shard[i]);
+    shard->shards = shards;
+    shard->index = i;
+    if(i) lob_set_uint(opts,"port",shards->port);
+    if(!(shard->mesh = mesh_new()) || mesh_load(shard->mesh, secrets, keys)
+      || !(shard->udp4 = net_udp4_new(shard->mesh, opts))
+      || !(shard->loop = net_loop_new(shard->mesh, options))
+      || (shard->wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0
+      || !net_loop_udp4(shard->loop, shard->udp4)
+      || !net_loop_fd(shard->loop, shard->wake, shard_wake, shard))
+    {
+      LOG_ERROR("failed to create shard %u",i);
+      lob_free(opts);
+      return net_shards_free(shards);
+    }
+    net_udp4_receiver(shard->udp4, shard_receive, shard);
+    if(!i) shards->port = net_udp4_port(shard->udp4);
+  }
+  lob_free(opts);
+
+  return shards;
+}
+
+net_shards_t net_shards_free(net_shards_t shards)
+{
+  shard_t shard;
+  shard_item_t item;
+  uint64_t one = 1;
+  uint32_t i;
+  if(!shards) return NULL;
+
+  // every started thread wakes up to see it's stopping
+  __atomic_store_n(&(shards->stopping), 1, __ATOMIC_RELEASE);
+  for(i=0;i<shards->count;i++)
+  {
+    shard = &(shards->shard[i]);
+    if(!shard->started) continue;
+    if(write(shard->wake, &one, sizeof(one)) < 0) LOG_WARN("wake failed %s",strerror(errno));
+    pthread_join(shard->thread, NULL);
+  }
+
+  // links drop their pipes as they're freed, so the meshes go first
+  for(i=0;i<shards->count;i++)
+  {
+    shard = &(shards->shard[i]);
+    while((item = shard->queue))
+    {
+      shard->queue = item->next;
+      lob_free(item->packet);
+      free(item);
+    }
+    net_loop_free(shard->loop);
+    mesh_free(shard->mesh);
+    net_udp4_free(shard->udp4);
+    if(shard->wake >= 0) close(shard->wake);
+    pthread_mutex_destroy(&(shard->lock));
+  }
+  pthread_rwlock_destroy(&(shards->lock));
+  free(shards);
+  return NULL;
+}
+
+uint32_t net_shards_count(net_shards_t shards)
+{
+  if(!shards) return 0;
+  return shards->count;
+}
+
+mesh_t net_shards_mesh(net_shards_t shards, uint32_t index)
+{
+  if(!shards || index >= shards->count) return LOG_WARN("bad args");
+  return shards->shard[index].mesh;
+}
+
+net_shards_t net_shards_start(net_shards_t shards)
+{
+  shard_t shard;
+  uint32_t i;
+  if(!shards) return LOG_WARN("bad args");
+  for(i=0;i<shards->count;i++)
+  {
+    shard = &(shards->shard[i]);
+    if(shard->started) continue;
+    if(pthread_create(&(shard->thread), NULL, shard_run, shard) != 0) return LOG_ERROR("failed to start shard %u %s",i,strerror(errno));
+    shard->started = 1;
+  }
+  return shards;
+}
+
+uint16_t net_shards_port(net_shards_t shards)
+{
+  if(!shards) return 0;
+  return shards->port;
+}
+
+uint32_t net_shards_received(net_shards_t shards)
+{
+  uint32_t i, total = 0;
+  if(!shards) return 0;
+  for(i=0;i<shards->count;i++) total += __atomic_load_n(&(shards->shard[i].received), __ATOMIC_RELAXED);
+  return total;
+}
+
+uint32_t net_shards_forwarded(net_shards_t shards)
+{
+  uint32_t i, total = 0;
+  if(!shards) return 0;
+  for(i=0;i<shards->count;i++) total += __atomic_load_n(&(shards->shard[i].forwarded), __ATOMIC_RELAXED);
+  return total;
+}
+
+#endif // __linux__
@@ -0,0 +1,285 @@
+#include <string.h>
+#include <stdlib.h>
+#include "net_sim.h"
+
+// a packet on its way, delivered in at order (then the order sent)
+typedef struct sim_packet_struct
+{
+  uint32_t at, order;
+  net_sim_pair_t pair;
+  mesh_t to;
+  lob_t packet;
+} *sim_packet_t;
+
+struct net_sim_struct
+{
+  uint32_t now, seed, order;
+  net_sim_pair_t pairs;
+  mesh_t *meshes;
+  uint32_t meshes_count;
+  struct sim_packet_struct *heap;
+  uint32_t heap_size, heap_count;
+};
+
+// xorshift32
+static uint32_t sim_rand(net_sim_t sim)
+{
+  sim->seed ^= sim->seed << 13;
+  sim->seed ^= sim->seed >> 17;
+  sim->seed ^= sim->seed << 5;
+  return sim->seed;
+}
+
+static uint8_t sim_chance(net_sim_t sim, uint32_t percent)
+{
+  if(!percent) return 0;
+  return (sim_rand(sim) % 100) < percent;
+}
+
+static uint8_t sim_before(sim_packet_t a, sim_packet_t b)
+{
+  return (a->at < b->at) || (a->at == b->at && a->order < b->order);
+}
+
+static net_sim_t sim_push(net_sim_t sim, net_sim_pair_t pair, mesh_t to, lob_t packet, uint32_t at)
+{
+  struct sim_packet_struct tmp;
+  uint32_t i, parent;
+
+  if(sim->heap_count == sim->heap_size)
+  {
+    uint32_t size = sim->heap_size ? sim->heap_size * 2 : 64;
+    sim_packet_t heap = realloc(sim->heap, size * sizeof (struct sim_packet_struct));
+    if(!heap)
+    {
+      lob_free(packet);
+      return LOG("OOM");
+    }
+    sim->heap = heap;
+    sim->heap_size = size;
+  }
+
+  i = sim->heap_count++;
+  sim->heap[i].at = at;
+  sim->heap[i].order = sim->order++;
+  sim->heap[i].pair = pair;
+  sim->heap[i].to = to;
+  sim->heap[i].packet = packet;
+  for(;i && sim_before(&sim->heap[i], &sim->heap[parent = (i - 1) / 2]);i = parent)
+  {
+    tmp = sim->heap[i];
+    sim->heap[i] = sim->heap[parent];
+    sim->heap[parent] = tmp;
+  }
+  return sim;
+}
+
+static struct sim_packet_struct sim_pop(net_sim_t sim)
+{
+  struct sim_packet_struct top = sim->heap[0], tmp;
+  uint32_t i = 0, child;
+
+  sim->heap[0] = sim->heap[--sim->heap_count];
+  while((child = (i * 2) + 1) < sim->heap_count)
+  {
+    if(child + 1 < sim->heap_count && sim_before(&sim->heap[child + 1], &sim->heap[child])) child++;
+    if(!sim_before(&sim->heap[child], &sim->heap[i])) break;
+    tmp = sim->heap[i];
+    sim->heap[i] = sim->heap[child];
+    sim->heap[child] = tmp;
+    i = child;
+  }
+  return top;
+}
+
+// queue for the bandwidth, then across the wire
+static link_t sim_send(link_t link, lob_t packet, void *arg)
+{
+  net_sim_pair_t pair = (net_sim_pair_t)arg;
+  net_sim_t sim;
+  net_sim_path_t path;
+  mesh_t to;
+  uint64_t start;
+  uint32_t at;
+
+  if(!pair || !link) return link;
+  if(!packet) return link; // the link is going away
+  sim = pair->sim;
+  path = net_sim_path(pair, link->mesh);
+  to = (link->mesh == pair->a) ? pair->b : pair->a;
+  if(!path)
+  {
+    lob_free(packet);
+    return link;
+  }
+  path->sent++;
+  path->bytes += lob_len(packet);
+
+  // waits behind what's still sending, dropped when that's too much
+  start = (uint64_t)sim->now << 10;
+  if(path->busy > start) start = path->busy;
+  if(path->bandwidth)
+  {
+    if(path->queue && ((start - ((uint64_t)sim->now << 10)) * path->bandwidth) >> 10 > path->queue)
+    {
+      path->overflowed++;
+      lob_free(packet);
+      return link;
+    }
+    path->busy = start + (((uint64_t)lob_len(packet) << 10) / path->bandwidth);
+    start = path->busy;
+  }
+
+  if(sim_chance(sim, path->loss))
+  {
+    path->lost++;
+    lob_free(packet);
+    return link;
+  }
+
+  // in order w/ the rest unless reordered, then late enough for the next ones to pass it
+  at = (uint32_t)((start + 1023) >> 10) + path->latency;
+  if(path->jitter) at += sim_rand(sim) % (path->jitter + 1);
+  if(sim_chance(sim, path->reorder))
+  {
+    path->reordered++;
+    at += path->latency + path->jitter + 1;
+  }else{
+    if(at < path->last) at = path->last;
+    path->last = at;
+  }
+
+  if(sim_chance(sim, path->duplicate))
+  {
+    path->duplicated++;
+    sim_push(sim, pair, to, lob_copy(packet), at);
+  }
+  sim_push(sim, pair, to, packet, at);
+  return link;
+}
+
+net_sim_t net_sim_new(uint32_t seed)
+{
+  net_sim_t sim;
+  if(!(sim = malloc(sizeof (struct net_sim_struct)))) return LOG("OOM");
+  memset(sim,0,sizeof (struct net_sim_struct));
+  sim->seed = seed ? seed : 2463534242U;
+  return sim;
+}
+
+void net_sim_free(net_sim_t sim)
+{
+  net_sim_pair_t pair;
+  if(!sim) return;
+  while(sim->heap_count) lob_free(sim_pop(sim).packet);
+  while((pair = sim->pairs))
+  {
+    sim->pairs = pair->next;
+    free(pair);
+  }
+  free(sim->heap);
+  free(sim->meshes);
+  free(sim);
+}
+
+static void sim_path(net_sim_path_t path, lob_t options)
+{
+  memset(path,0,sizeof (struct net_sim_path_struct));
+  path->latency = lob_get_uint(options,"latency");
+  path->jitter = lob_get_uint(options,"jitter");
+  path->bandwidth = lob_get_uint(options,"bandwidth");
+  path->queue = lob_get_uint(options,"queue");
+  path->loss = lob_get_uint(options,"loss");
+  path->reorder = lob_get_uint(options,"reorder");
+  path->duplicate = lob_get_uint(options,"duplicate");
+}
+
+// every mesh is processed as the clock moves
+static net_sim_t sim_mesh(net_sim_t sim, mesh_t mesh)
+{
+  uint32_t i;
+  mesh_t *meshes;
+  for(i=0;i<sim->meshes_count;i++) if(sim->meshes[i] == mesh) return sim;
+  if(!(meshes = realloc(sim->meshes, (sim->meshes_count + 1) * sizeof (mesh_t)))) return LOG("OOM");
+  sim->meshes = meshes;
+  sim->meshes[sim->meshes_count++] = mesh;
+  return sim;
+}
+
+net_sim_pair_t net_sim_pair(net_sim_t sim, mesh_t a, mesh_t b, lob_t options)
+{
+  net_sim_pair_t pair;
+  if(!sim || !a || !b || a == b) return LOG("bad args");
+  if(!sim_mesh(sim, a) || !sim_mesh(sim, b)) return NULL;
+
+  if(!(pair = malloc(sizeof (struct net_sim_pair_struct)))) return LOG("OOM");
+  memset(pair,0,sizeof (struct net_sim_pair_struct));
+  pair->sim = sim;
+  pair->a = a;
+  pair->b = b;
+  sim_path(&pair->ab, options);
+  sim_path(&pair->ba, options);
+  pair->next = sim->pairs;
+  sim->pairs = pair;
+
+  // ensure they're linked and piped together, any handshake goes out on the next step
+  link_pipe(link_get_keys(a,b->keys),sim_send,pair);
+  link_pipe(link_get_keys(b,a->keys),sim_send,pair);
+
+  return pair;
+}
+
+net_sim_path_t net_sim_path(net_sim_pair_t pair, mesh_t from)
+{
+  if(!pair) return NULL;
+  if(from == pair->a) return &pair->ab;
+  if(from == pair->b) return &pair->ba;
+  return NULL;
+}
+
+uint32_t net_sim_now(net_sim_t sim)
+{
+  if(!sim) return 0;
+  return sim->now;
+}
+
+uint32_t net_sim_step(net_sim_t sim, uint32_t until)
+{
+  struct sim_packet_struct next;
+  uint32_t i, due, at;
+  mesh_t from;
+  lob_t reply;
+
+  if(!sim) return 0;
+  if(until <= sim->now) return sim->now;
+
+  // whatever's soonest, timers are run once they're past due
+  at = until;
+  if(sim->heap_count && sim->heap[0].at < at) at = sim->heap[0].at;
+  for(i=0;i<sim->meshes_count;i++) if((due = mesh_due(sim->meshes[i])) && due + 1 < at) at = due + 1;
+  if(at <= sim->now) at = sim->now + 1; // still not past until
+  sim->now = at;
+
+  // the sender is the address, any reply goes back the way it came
+  while(sim->heap_count && sim->heap[0].at <= sim->now)
+  {
+    next = sim_pop(sim);
+    next.pair->ab.delivered += (next.to == next.pair->b);
+    next.pair->ba.delivered += (next.to == next.pair->a);
+    reply = NULL;
+    from = (next.to == next.pair->a) ? next.pair->b : next.pair->a;
+    mesh_receive_from(next.to, next.packet, (uint8_t*)&from, sizeof(mesh_t), &reply);
+    if(reply) sim_push(sim, next.pair, from, reply, sim->now + net_sim_path(next.pair, next.to)->latency);
+  }
+
+  for(i=0;i<sim->meshes_count;i++) mesh_process(sim->meshes[i], sim->now);
+
+  return sim->now;
+}
+
+net_sim_t net_sim_run(net_sim_t sim, uint32_t until)
+{
+  if(!sim) return LOG("bad args");
+  while(sim->now < until) net_sim_step(sim, until);
+  return sim;
+}
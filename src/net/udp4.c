@@ -1,48 +1,225 @@
 #if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__)))
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // recvmmsg/sendmmsg
+#endif
+
 #include <errno.h>
 #include <string.h>
 #include <unistd.h>
 #include "net_udp4.h"
+#include "net_handshake.h"
+
+// many frames per syscall where the platform has it, else one recvfrom/sendto each
+#if defined(__linux__) && defined(MSG_WAITFORONE) && !defined(NOMMSG)
+#define UDP4_MMSG
+#ifndef UDP4_BATCH
+#define UDP4_BATCH 64
+#endif
+
+// preallocated datagram slots and their message headers
+typedef struct udp4_ring_struct
+{
+  struct mmsghdr msgs[UDP4_BATCH];
+  struct iovec iov[UDP4_BATCH];
+  struct sockaddr_in sa[UDP4_BATCH];
+  lob_t held[UDP4_BATCH]; // whole packets being sent straight from their raw
+  uint32_t count;
+  uint32_t size; // of each slot
+  uint8_t slots[];
+} *udp4_ring_t;
+#endif
+
+// frames are always sent full size, any other length is a whole packet (mtu mode only)
+#define UDP4_FRAME 128
+#define UDP4_MTU_MAX 65507
 
 // individual pipe local info
 typedef struct pipe_struct
 {
-  link_t link;
+  link_t link; // only set while this is the link's current pipe
   util_frames_t frames;
+  lob_t inbox, outbox; // whole packets when in mtu mode
   net_udp4_t net;
-  struct pipe_struct *next;
+  struct pipe_struct *next, *prev; // most recently heard from first
+  struct pipe_struct *wnext, *wprev; // in the work list for its state
   struct sockaddr_in sa;
+  uint32_t seen; // last received from, in seconds
+  uint8_t work;
 } *pipe_t;
 
+// pipe work states, only pipes w/ something to do are visited by process
+#define PIPE_IDLE 0
+#define PIPE_ACTIVE 1 // received frames or has new packets to send
+#define PIPE_LATER 2 // sent, waiting on the other side to confirm
+
 // overall server
 struct net_udp4_struct
 {
   mesh_t mesh;
-  pipe_t pipes;
+  pipe_t pipes, oldest; // lru order
+  pipe_t work[3]; // by state, PIPE_IDLE is unused
+  pipe_t *table; // pipes open-addressed by address and port
+  uint32_t table_size, count;
+  uint32_t max, idle; // evict the oldest pipe past this many, or any not heard from in this many seconds (0 is no limit)
   int server;
   uint16_t port;
+  uint16_t mtu; // largest whole packet to send as one datagram, 0 is frames only
+  uint8_t *buf; // for single receives, big enough for the mtu
+  link_t (*receive)(net_udp4_t net, lob_t packet, struct sockaddr_in *from, void *arg); // instead of mesh_receive
+  void *receive_arg;
+  net_handshakes_t handshakes; // handshakes go to these workers when set
+#ifdef UDP4_MMSG
+  udp4_ring_t rx, tx; // only when batching
+#endif
 };
 
+// home slot for an address in the table, size is always a power of two
+static uint32_t pipe_slot(net_udp4_t net, struct sockaddr_in *sa)
+{
+  uint32_t hash = ((uint32_t)sa->sin_addr.s_addr * 2654435761U) ^ sa->sin_port;
+  hash *= 2654435761U;
+  return (hash ^ (hash >> 16)) & (net->table_size - 1);
+}
+
+static uint8_t pipe_match(pipe_t pipe, struct sockaddr_in *sa)
+{
+  return (pipe->sa.sin_addr.s_addr == sa->sin_addr.s_addr && pipe->sa.sin_port == sa->sin_port);
+}
+
+// add to the table, doubling it to stay under half full
+static net_udp4_t pipe_add(net_udp4_t net, pipe_t pipe)
+{
+  uint32_t i, j, size, old_size;
+  pipe_t *table, *old;
+
+  if((net->count + 1) * 2 > net->table_size)
+  {
+    size = net->table_size ? net->table_size * 2 : 16;
+    if(!(table = malloc(size * sizeof(pipe_t)))) return LOG("OOM");
+    memset(table, 0, size * sizeof(pipe_t));
+
+    // rehash existing into the new table
+    old = net->table;
+    old_size = net->table_size;
+    net->table = table;
+    net->table_size = size;
+    for(i=0;i<old_size;i++)
+    {
+      if(!old[i]) continue;
+      for(j = pipe_slot(net, &(old[i]->sa));table[j];j = (j + 1) & (size - 1));
+      table[j] = old[i];
+    }
+    free(old);
+  }
+
+  for(i = pipe_slot(net, &(pipe->sa));net->table[i];i = (i + 1) & (net->table_size - 1));
+  net->table[i] = pipe;
+  net->count++;
+  return net;
+}
+
+static void pipe_drop(net_udp4_t net, pipe_t pipe)
+{
+  uint32_t i, j, home;
+  if(!net->table_size) return;
+
+  for(i = pipe_slot(net, &(pipe->sa));net->table[i] && net->table[i] != pipe;i = (i + 1) & (net->table_size - 1));
+  if(!net->table[i])
+  {
+    LOG_WARN("pipe not found for %s:%u",inet_ntoa(pipe->sa.sin_addr), ntohs(pipe->sa.sin_port));
+    return;
+  }
+  net->table[i] = NULL;
+  net->count--;
+
+  // shift back any following entries that can't be found past the gap anymore
+  for(j = (i + 1) & (net->table_size - 1);net->table[j];j = (j + 1) & (net->table_size - 1))
+  {
+    home = pipe_slot(net, &(net->table[j]->sa));
+    // still reachable if its home is cyclically within (i, j]
+    if((i <= j) ? (i < home && home <= j) : (i < home || home <= j)) continue;
+    net->table[i] = net->table[j];
+    net->table[j] = NULL;
+    i = j;
+  }
+}
+
+// lru list maintenance
+static void pipe_unlist(net_udp4_t net, pipe_t pipe)
+{
+  if(pipe->prev) pipe->prev->next = pipe->next;
+  else net->pipes = pipe->next;
+  if(pipe->next) pipe->next->prev = pipe->prev;
+  else net->oldest = pipe->prev;
+  pipe->next = pipe->prev = NULL;
+}
+
+static void pipe_list(net_udp4_t net, pipe_t pipe)
+{
+  pipe->next = net->pipes;
+  if(net->pipes) net->pipes->prev = pipe;
+  net->pipes = pipe;
+  if(!net->oldest) net->oldest = pipe;
+}
+
+// move to the work list for this state
+static void pipe_work(pipe_t pipe, uint8_t work)
+{
+  net_udp4_t net = pipe->net;
+  if(pipe->work == work) return;
+  if(pipe->work)
+  {
+    if(pipe->wprev) pipe->wprev->wnext = pipe->wnext;
+    else net->work[pipe->work] = pipe->wnext;
+    if(pipe->wnext) pipe->wnext->wprev = pipe->wprev;
+    pipe->wnext = pipe->wprev = NULL;
+  }
+  pipe->work = work;
+  if(!work) return;
+  pipe->wnext = net->work[work];
+  if(pipe->wnext) pipe->wnext->wprev = pipe;
+  net->work[work] = pipe;
+}
+
 static pipe_t pipe_free(pipe_t pipe)
 {
   if(!pipe || !pipe->net || !pipe->net->pipes) return LOG("bad args");
   LOG_DEBUG("dropping pipe %s:%u",inet_ntoa(pipe->sa.sin_addr), ntohs(pipe->sa.sin_port));
 
-  // remove from pipes list
-  if(pipe == pipe->net->pipes) pipe->net->pipes = pipe->next;
-  else {
-    pipe_t p = pipe->net->pipes;
-    while(p && p->next != pipe) p = p->next;
-    if(!p) LOG_WARN("pipe not found for %s:%u",inet_ntoa(pipe->sa.sin_addr), ntohs(pipe->sa.sin_port));
-    else p->next = pipe->next;
-  }
+  pipe_drop(pipe->net, pipe);
+  pipe_unlist(pipe->net, pipe);
+  pipe_work(pipe, PIPE_IDLE);
 
   pipe->frames = util_frames_free(pipe->frames);
+  lob_freeall(pipe->inbox);
+  lob_freeall(pipe->outbox);
   free(pipe);
   return NULL;
 }
 
+link_t udp4_send(link_t link, lob_t packet, void *arg);
+
+// detach from any link still using it and free, the link needs a new pipe from the next packet it sends or receives
+static void pipe_evict(pipe_t pipe)
+{
+  LOG_DEBUG("evicting idle pipe %s:%u",inet_ntoa(pipe->sa.sin_addr), ntohs(pipe->sa.sin_port));
+  if(pipe->link && pipe->link->send_cb == udp4_send && pipe->link->send_arg == pipe)
+  {
+    pipe->link->send_cb = NULL;
+    pipe->link->send_arg = NULL;
+  }
+  pipe_free(pipe);
+}
+
+// whole datagram if it fits the mtu, otherwise (or a len that would look like a frame) it's framed
+static void udp4_queue(pipe_t pipe, lob_t packet)
+{
+  size_t len = lob_len(packet);
+  if(pipe->net->mtu && len <= pipe->net->mtu && len != UDP4_FRAME) pipe->outbox = lob_push(pipe->outbox,packet);
+  else util_frames_send(pipe->frames,packet);
+  pipe_work(pipe, PIPE_ACTIVE);
+}
 
 link_t udp4_send(link_t link, lob_t packet, void *arg)
 {
@@ -57,7 +234,7 @@ link_t udp4_send(link_t link, lob_t packet, void *arg)
   }
 
   LOG_CRAZY("send to %s at %s:%u",hashname_short(link->id),inet_ntoa(pipe->sa.sin_addr), ntohs(pipe->sa.sin_port));
-  util_frames_send(pipe->frames,packet);
+  udp4_queue(pipe,packet);
 
   return link;
 }
@@ -65,13 +242,20 @@ link_t udp4_send(link_t link, lob_t packet, void *arg)
 // internal, get or create a pipe
 pipe_t udp4_pipe(net_udp4_t net, struct sockaddr_in *from)
 {
+  uint32_t i;
   pipe_t to;
 
   // find existing
-  for(to = net->pipes; to; to = to->next) if(memcmp(&(to->sa.sin_addr),&(from->sin_addr),sizeof(struct in_addr)) == 0 && to->sa.sin_port == from->sin_port) return to;
+  if(net->table_size) for(i = pipe_slot(net, from);(to = net->table[i]);i = (i + 1) & (net->table_size - 1))
+  {
+    if(pipe_match(to, from)) return to;
+  }
 
   LOG("new pipe to %s:%u",inet_ntoa(from->sin_addr), ntohs(from->sin_port));
 
+  // make room
+  if(net->max && net->count >= net->max && net->oldest) pipe_evict(net->oldest);
+
   // create new udp4 pipe
   if(!(to = malloc(sizeof (struct pipe_struct)))) return LOG("OOM");
   memset(to,0,sizeof (struct pipe_struct));
@@ -79,18 +263,53 @@ pipe_t udp4_pipe(net_udp4_t net, struct sockaddr_in *from)
   to->sa.sin_family = AF_INET;
   to->sa.sin_addr = from->sin_addr;
   to->sa.sin_port = from->sin_port;
-  to->frames = util_frames_new(128);
-  
-  // link into list
-  to->next = net->pipes;
-  net->pipes = to;
+  to->frames = util_frames_new(UDP4_FRAME);
+  to->seen = util_sys_seconds();
+  if(!pipe_add(net, to))
+  {
+    util_frames_free(to->frames);
+    free(to);
+    return NULL;
+  }
+  pipe_list(net, to);
 
   return to;
 }
 
+// most recently heard from goes first
+static void pipe_touch(pipe_t pipe)
+{
+  pipe->seen = util_sys_seconds();
+  if(pipe == pipe->net->pipes) return;
+  pipe_unlist(pipe->net, pipe);
+  pipe_list(pipe->net, pipe);
+}
+
+#ifdef UDP4_MMSG
+static udp4_ring_t udp4_ring_new(uint32_t size)
+{
+  udp4_ring_t ring;
+  uint32_t i;
+  if(!(ring = malloc(sizeof (struct udp4_ring_struct) + (UDP4_BATCH * size)))) return LOG_ERROR("OOM");
+  memset(ring,0,sizeof (struct udp4_ring_struct));
+  ring->size = size;
+  for(i=0;i<UDP4_BATCH;i++)
+  {
+    ring->iov[i].iov_base = ring->slots + (i * size);
+    ring->iov[i].iov_len = size;
+    ring->msgs[i].msg_hdr.msg_iov = &(ring->iov[i]);
+    ring->msgs[i].msg_hdr.msg_iovlen = 1;
+    ring->msgs[i].msg_hdr.msg_name = &(ring->sa[i]);
+    ring->msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+  }
+  return ring;
+}
+#endif
+
 net_udp4_t net_udp4_new(mesh_t mesh, lob_t options)
 {
   int port, sock;
+  uint32_t mtu;
   net_udp4_t net;
   struct sockaddr_in sa;
   socklen_t size = sizeof(struct sockaddr_in);
@@ -104,6 +323,16 @@ net_udp4_t net_udp4_new(mesh_t mesh, lob_t options)
   // TODO this needs to be modified for app usage
   util_sock_timeout(sock,1);
 
+#ifdef SO_REUSEPORT
+  // several sockets on one port, the kernel spreads peers across them by address
+  int on = 1;
+  if(lob_get_cmp(options,"reuseport","true") == 0 && setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0)
+  {
+    close(sock);
+    return LOG_ERROR("failed to set SO_REUSEPORT %s",strerror(errno));
+  }
+#endif
+
   memset(&sa,0,sizeof(sa));
   sa.sin_family = AF_INET;
   sa.sin_port = htons(port);
@@ -125,6 +354,26 @@ net_udp4_t net_udp4_new(mesh_t mesh, lob_t options)
   net->server = sock;
   net->port = ntohs(sa.sin_port);
   if(!mesh->port_local) mesh->port_local = (uint16_t)net->port; // use ours as the default if no others
+  net->max = lob_get_uint(options,"pipes");
+  net->idle = lob_get_uint(options,"idle");
+
+  // anything at or below a frame is just frames
+  mtu = lob_get_uint(options,"mtu");
+  if(mtu > UDP4_MTU_MAX) mtu = UDP4_MTU_MAX;
+  net->mtu = (mtu > UDP4_FRAME) ? (uint16_t)mtu : 0;
+  if(!(net->buf = malloc(net->mtu ? net->mtu : UDP4_FRAME)))
+  {
+    net_udp4_free(net);
+    return LOG_ERROR("OOM");
+  }
+
+#ifdef UDP4_MMSG
+  if(lob_get_cmp(options,"batch","false") != 0)
+  {
+    net->rx = udp4_ring_new(net->mtu ? net->mtu : UDP4_FRAME);
+    net->tx = udp4_ring_new(UDP4_FRAME);
+  }
+#endif
 
   return net;
 }
@@ -134,56 +383,243 @@ net_udp4_t net_udp4_free(net_udp4_t net)
   if(!net) return NULL;
   LOG_DEBUG("closing udp4 transport on %u",net->port);
   close(net->server);
+  free(net->table);
+  free(net->buf);
+#ifdef UDP4_MMSG
+  free(net->rx);
+  free(net->tx);
+#endif
   free(net);
   return NULL;
 }
 
-net_udp4_t net_udp4_process(net_udp4_t net)
+// this becomes the link's pipe
+static void udp4_link(pipe_t pipe, link_t link)
+{
+  if(!link || link == pipe->link) return;
+  LOG_DEBUG("adding new link to pipe for %s",hashname_short(link->id));
+  if(link->send_cb == udp4_send && link->send_arg) ((pipe_t)link->send_arg)->link = NULL;
+  pipe->link = link;
+  link_pipe(link,udp4_send,pipe);
+}
+
+// where a handshake came from while it's with the workers
+typedef struct udp4_from_struct
+{
+  net_udp4_t net;
+  struct sockaddr_in sa;
+} *udp4_from_t;
+
+// back from the workers, the pipe may have been evicted meanwhile
+static void udp4_handshake(link_t link, void *arg)
+{
+  udp4_from_t from = arg;
+  pipe_t pipe;
+  if(link && (pipe = udp4_pipe(from->net, &(from->sa)))) udp4_link(pipe, link);
+  free(from);
+}
+
+uint8_t *net_udp4_address(struct sockaddr_in *sa, uint8_t *address)
+{
+  if(!sa || !address) return LOG_WARN("bad args");
+  memcpy(address, &(sa->sin_addr), 4);
+  memcpy(address+4, &(sa->sin_port), 2);
+  return address;
+}
+
+// a whole packet arrived on this pipe, it becomes the link's pipe when it's for one
+static void udp4_deliver(pipe_t pipe, lob_t packet, uint8_t hook)
+{
+  net_udp4_t net = pipe->net;
+  udp4_from_t from;
+  link_t link;
+  lob_t reply = NULL;
+  uint8_t address[6];
+
+  net_udp4_address(&(pipe->sa), address);
+  if(hook && net->receive) link = net->receive(net, packet, &(pipe->sa), net->receive_arg);
+  else if(hook && net->handshakes && (packet = mesh_admit(net->mesh, packet, address, sizeof(address), &reply)) && packet->head_len == 1)
+  {
+    if(!(from = malloc(sizeof (struct udp4_from_struct))))
+    {
+      LOG_WARN("OOM");
+      lob_free(packet);
+      return;
+    }
+    from->net = net;
+    from->sa = pipe->sa;
+    if(!net_handshakes_queue(net->handshakes, packet, udp4_handshake, from)) free(from);
+    return;
+  }
+  else if(packet) link = mesh_receive_from(net->mesh, packet, address, sizeof(address), &reply);
+  else link = NULL;
+  if(reply) udp4_queue(pipe, reply);
+  udp4_link(pipe, link);
+}
+
+// hand a received datagram to its pipe, pipe is the last one used
+static pipe_t udp4_frame(net_udp4_t net, pipe_t pipe, struct sockaddr_in *sa, uint8_t *data, size_t len)
+{
+  if(!pipe || !pipe_match(pipe, sa))
+  {
+    if(!(pipe = udp4_pipe(net, sa))) return NULL;
+    pipe_touch(pipe);
+  }
+  LOG_CRAZY("receive from %s at %s:%u",(pipe->link)?hashname_short(pipe->link->id):"unknown",inet_ntoa(pipe->sa.sin_addr), ntohs(pipe->sa.sin_port));
+  if(!net->mtu || len == UDP4_FRAME) util_frames_inbox(pipe->frames, data, NULL);
+  else pipe->inbox = lob_push(pipe->inbox, lob_parse(data, len));
+  pipe_work(pipe, PIPE_ACTIVE);
+  return pipe;
+}
+
+#ifdef UDP4_MMSG
+// waits for the first frame like recvfrom would, then takes whatever else is already there
+static net_udp4_t udp4_receive_batch(net_udp4_t net)
+{
+  udp4_ring_t ring = net->rx;
+  pipe_t pipe = NULL;
+  int i, count, flags = MSG_WAITFORONE;
+
+  while(1)
+  {
+    for(i=0;i<UDP4_BATCH;i++) ring->msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+    count = recvmmsg(net->server, ring->msgs, UDP4_BATCH, flags, NULL);
+    if(count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    if(count <= 0) return LOG_WARN("recvmmsg error %s",strerror(errno));
+    for(i=0;i<count;i++) if(ring->msgs[i].msg_len) pipe = udp4_frame(net, pipe, &(ring->sa[i]), ring->iov[i].iov_base, ring->msgs[i].msg_len);
+    if(count < UDP4_BATCH) break;
+    flags = MSG_DONTWAIT;
+  }
+
+  return net;
+}
+
+// send everything queued in the tx ring, frames that fail are dropped and recovered by the frames protocol
+static void udp4_send_batch(net_udp4_t net)
+{
+  udp4_ring_t ring = net->tx;
+  uint32_t at = 0;
+  int sent;
+
+  while(at < ring->count)
+  {
+    sent = sendmmsg(net->server, ring->msgs + at, ring->count - at, 0);
+    if(sent <= 0)
+    {
+      LOG_WARN("sendmmsg failed: %s, dropping %u datagrams",strerror(errno),ring->count - at);
+      break;
+    }
+    at += (uint32_t)sent;
+  }
+
+  // reset slots that were pointed at whole packets
+  for(at = 0; at < ring->count; at++)
+  {
+    if(!ring->held[at]) continue;
+    ring->held[at] = lob_free(ring->held[at]);
+    ring->iov[at].iov_base = ring->slots + (at * ring->size);
+    ring->iov[at].iov_len = ring->size;
+  }
+  ring->count = 0;
+}
+
+// takes the next tx slot for this pipe, flushing first if full
+static uint32_t udp4_slot(net_udp4_t net, pipe_t pipe)
+{
+  udp4_ring_t ring = net->tx;
+  if(ring->count == UDP4_BATCH) udp4_send_batch(net);
+  ring->sa[ring->count] = pipe->sa;
+  ring->msgs[ring->count].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+  return ring->count;
+}
+#endif
+
+net_udp4_t net_udp4_receive(net_udp4_t net)
 {
   if(!net) return LOG_WARN("bad args");
 
+  // finish any handshakes the workers are done with first, their replies go out below
+  net_handshakes_process(net->handshakes);
+
   struct sockaddr_in sa;
   size_t salen = sizeof(sa);
   memset(&sa,0,salen);
-  uint8_t frame[128];
+  uint8_t frame[UDP4_FRAME];
+  lob_t packet = NULL;
   
   // try receiving anything waiting
   pipe_t pipe = NULL;
+#ifdef UDP4_MMSG
+  if(net->rx)
+  {
+    if(!udp4_receive_batch(net)) return NULL;
+  }else
+#endif
   while(1)
   {
-    ssize_t len = recvfrom(net->server, frame, sizeof(frame), 0, (struct sockaddr *)&sa, (socklen_t *)&salen);
+    ssize_t len = recvfrom(net->server, net->buf, net->mtu ? net->mtu : UDP4_FRAME, 0, (struct sockaddr *)&sa, (socklen_t *)&salen);
     if(len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
     if(len <= 0) return LOG_WARN("recvfrom error %s",strerror(errno));
     
     // get the pipe and return
-    if(!pipe || memcmp(&(pipe->sa.sin_addr), &(sa.sin_addr), sizeof(struct in_addr)) || pipe->sa.sin_port != sa.sin_port) pipe = udp4_pipe(net, &sa);
-    if(pipe)
-    {
-      LOG_CRAZY("receive from %s at %s:%u",(pipe->link)?hashname_short(pipe->link->id):"unknown",inet_ntoa(pipe->sa.sin_addr), ntohs(pipe->sa.sin_port));
-      util_frames_inbox(pipe->frames, frame, NULL);
-    }
+    pipe = udp4_frame(net, pipe, &sa, net->buf, (size_t)len);
+  }
+
+  // drop any pipes that have gone quiet
+  if(net->idle)
+  {
+    uint32_t now = util_sys_seconds();
+    while(net->oldest && net->oldest->seen + net->idle < now) pipe_evict(net->oldest);
   }
 
-  // process each pipe also
-  pipe_t next = NULL;
-  for(pipe = net->pipes;pipe;pipe = next)
+  // process each pipe w/ something to do, may be re-activated by sends from mesh_receive
+  while((pipe = net->work[PIPE_ACTIVE]))
   {
-    next = pipe->next;
+    pipe_work(pipe, PIPE_IDLE);
+
+    // process received full packets, whole datagrams first
+    while((packet = pipe->inbox) || (packet = util_frames_receive(pipe->frames)))
+    {
+      if(packet == pipe->inbox) pipe->inbox = lob_splice(pipe->inbox, packet);
+      udp4_deliver(pipe, packet, 1);
+    }
     
-    // process received full packets
-    lob_t packet = NULL;
-    while((packet = util_frames_receive(pipe->frames)))
+    // idle pipes have nothing to say, a sender waiting on us drives any resends
+    if(!pipe->outbox && !util_frames_waiting(pipe->frames)) continue;
+
+#ifdef UDP4_MMSG
+    // queue whole packets and all/any waiting frames straight into the tx ring
+    if(net->tx)
     {
-      link_t link = mesh_receive(net->mesh, packet);
-      if(!link) continue;
-      if(link != pipe->link)
+      udp4_ring_t ring = net->tx;
+      uint32_t at;
+      while((packet = pipe->outbox))
       {
-        LOG_DEBUG("adding new link to pipe for %s",hashname_short(link->id));
-        pipe->link = link;
-        link_pipe(link,udp4_send,pipe);
+        pipe->outbox = lob_splice(pipe->outbox, packet);
+        at = udp4_slot(net, pipe);
+        ring->held[at] = packet;
+        ring->iov[at].iov_base = lob_raw(packet);
+        ring->iov[at].iov_len = lob_len(packet);
+        ring->count++;
       }
+      while(util_frames_outbox(pipe->frames,ring->iov[at = udp4_slot(net, pipe)].iov_base,NULL))
+      {
+        ring->count++;
+        if(!util_frames_sent(pipe->frames)) break;
+      }
+      if(!pipe->work && util_frames_waiting(pipe->frames)) pipe_work(pipe, PIPE_LATER);
+      continue;
     }
-    
+#endif
+
+    // send whole packets, a failed one is dropped like any lost datagram
+    while((packet = pipe->outbox))
+    {
+      pipe->outbox = lob_splice(pipe->outbox, packet);
+      if(sendto(net->server, lob_raw(packet), lob_len(packet), 0, (struct sockaddr *)&(pipe->sa), sizeof(struct sockaddr_in)) < 0) LOG_WARN("sendto failed: %s to %s:%u",strerror(errno),inet_ntoa(pipe->sa.sin_addr), ntohs(pipe->sa.sin_port));
+      lob_free(packet);
+    }
+
     // send all/any waiting frames
     while(util_frames_outbox(pipe->frames,frame,NULL))
     {
@@ -195,7 +631,12 @@ net_udp4_t net_udp4_process(net_udp4_t net)
       // only continue if sent says there's more
       if(!util_frames_sent(pipe->frames)) break;
     }
+    if(!pipe->work && util_frames_waiting(pipe->frames)) pipe_work(pipe, PIPE_LATER);
   }
+
+#ifdef UDP4_MMSG
+  if(net->tx) udp4_send_batch(net);
+#endif
   
   return net;
 }
@@ -206,6 +647,76 @@ int net_udp4_socket(net_udp4_t net)
   return net->server;
 }
 
+net_udp4_t net_udp4_process(net_udp4_t net)
+{
+  pipe_t pipe;
+  if(!net) return LOG_WARN("bad args");
+
+  // everything waiting on the other side gets another go, resending its last meta frame
+  while((pipe = net->work[PIPE_LATER])) pipe_work(pipe, PIPE_ACTIVE);
+  return net_udp4_receive(net);
+}
+
+net_udp4_t net_udp4_pending(net_udp4_t net)
+{
+  if(!net || !net->work[PIPE_ACTIVE]) return NULL;
+  return net;
+}
+
+net_udp4_t net_udp4_awaiting(net_udp4_t net)
+{
+  if(!net || !net->work[PIPE_LATER]) return NULL;
+  return net;
+}
+
+net_udp4_t net_udp4_receiver(net_udp4_t net, link_t (*receive)(net_udp4_t net, lob_t packet, struct sockaddr_in *from, void *arg), void *arg)
+{
+  if(!net) return LOG_WARN("bad args");
+  net->receive = receive;
+  net->receive_arg = arg;
+  return net;
+}
+
+net_udp4_t net_udp4_handshakes(net_udp4_t net, net_handshakes_t hs)
+{
+  if(!net) return LOG_WARN("bad args");
+  net->handshakes = hs;
+  return net;
+}
+
+net_udp4_t net_udp4_deliver(net_udp4_t net, lob_t packet, struct sockaddr_in *from)
+{
+  pipe_t pipe;
+  if(!net || !packet || !from) return LOG_WARN("bad args");
+  if(!(pipe = udp4_pipe(net, from)))
+  {
+    lob_free(packet);
+    return LOG_WARN("no pipe for %s:%u",inet_ntoa(from->sin_addr),ntohs(from->sin_port));
+  }
+  pipe_touch(pipe);
+  udp4_deliver(pipe, packet, 0);
+  return net;
+}
+
+net_udp4_t net_udp4_reply(net_udp4_t net, lob_t packet, struct sockaddr_in *to)
+{
+  pipe_t pipe;
+  if(!net || !packet || !to) return LOG_WARN("bad args");
+  if(!(pipe = udp4_pipe(net, to)))
+  {
+    lob_free(packet);
+    return LOG_WARN("no pipe for %s:%u",inet_ntoa(to->sin_addr),ntohs(to->sin_port));
+  }
+  udp4_queue(pipe, packet);
+  return net;
+}
+
+uint32_t net_udp4_pipes(net_udp4_t net)
+{
+  if(!net) return 0;
+  return net->count;
+}
+
 uint16_t net_udp4_port(net_udp4_t net)
 {
   if(!net) return 0;
@@ -226,7 +737,7 @@ net_udp4_t net_udp4_direct(net_udp4_t net, lob_t packet, char *ip, uint16_t port
     lob_free(packet);
     return LOG_WARN("direct pipe failed to %s:%u",ip,port);
   }
-  util_frames_send(pipe->frames,packet);
+  udp4_queue(pipe,packet);
   return net;
 }
 
@@ -0,0 +1,198 @@
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "telehash.h"
+
+// tokens are kept in thousandths so a per-second rate refills evenly per millisecond
+#define ADMIT_ONE 1000
+
+// only as many address bytes as this are looked at
+#define ADMIT_FROM 32
+
+// a source's bucket, direct-mapped (a colliding source just starts over w/ a full bucket)
+typedef struct admit_source_struct
+{
+  uint32_t hash;
+  uint32_t tokens;
+  uint64_t last;
+} *admit_source_t;
+
+typedef struct admit_bucket_struct
+{
+  uint32_t tokens, rate, burst; // rate and burst in whole tokens
+  uint64_t last;
+} *admit_bucket_t;
+
+struct util_admit_struct
+{
+  struct hmac_256_struct cookie; // keyed once, every cookie is a MAC under it
+  uint32_t seed;
+  uint32_t rate, burst, budget;
+  uint8_t cookies;
+  struct admit_bucket_struct global;
+  struct util_admit_stats_struct stats;
+  uint32_t count;
+  struct admit_source_struct sources[];
+};
+
+// fnv-1a, seeded so slots can't be picked from outside
+static uint32_t admit_hash(util_admit_t admit, uint8_t *from, size_t len)
+{
+  uint32_t hash = 2166136261U ^ admit->seed;
+  size_t i;
+  for(i=0;i<len && i<ADMIT_FROM;i++) hash = (hash ^ from[i]) * 16777619U;
+  return hash ? hash : 1; // 0 is an empty slot
+}
+
+// add what's accrued since last, capped at burst
+static uint32_t admit_refill(uint32_t tokens, uint64_t *last, uint64_t now, uint32_t rate, uint32_t burst)
+{
+  uint64_t more;
+  if(now > *last)
+  {
+    more = (now - *last) * rate;
+    tokens = (more >= (uint64_t)burst * ADMIT_ONE - tokens) ? burst * ADMIT_ONE : tokens + (uint32_t)more;
+  }
+  *last = now;
+  return tokens;
+}
+
+util_admit_t util_admit_new(lob_t options, uint8_t *secret, size_t len)
+{
+  util_admit_t admit;
+  uint32_t count;
+  uint8_t key[32], hash[32];
+
+  if(!secret || !len) return LOG("bad args");
+  count = lob_get_uint(options,"sources");
+  if(!count) count = 1024;
+
+  if(!(admit = malloc(sizeof (struct util_admit_struct) + count * sizeof (struct admit_source_struct)))) return LOG("OOM");
+  memset(admit,0,sizeof (struct util_admit_struct) + count * sizeof (struct admit_source_struct));
+  admit->count = count;
+
+  // separate keys for the cookies and the source hashing
+  hmac_256(secret, len, (uint8_t*)"cookie", 6, key);
+  hmac_256_key(&(admit->cookie), key, sizeof(key));
+  hmac_256(secret, len, (uint8_t*)"sources", 7, hash);
+  memcpy(&(admit->seed), hash, 4);
+
+  admit->rate = lob_get_uint(options,"rate");
+  if(!admit->rate) admit->rate = 4;
+  admit->burst = lob_get_uint(options,"burst");
+  if(!admit->burst) admit->burst = admit->rate * 2;
+  admit->budget = lob_get_uint(options,"budget");
+  admit->global.rate = admit->global.burst = admit->budget;
+  admit->global.tokens = admit->budget * ADMIT_ONE;
+  admit->cookies = (lob_get_cmp(options,"cookie","true") == 0);
+
+  return admit;
+}
+
+util_admit_t util_admit_free(util_admit_t admit)
+{
+  if(!admit) return NULL;
+  free(admit);
+  return NULL;
+}
+
+// take one from the budget, if there is one
+static util_admit_t admit_budget(util_admit_t admit, uint64_t now)
+{
+  if(!admit->budget) return admit;
+  admit->global.tokens = admit_refill(admit->global.tokens, &(admit->global.last), now, admit->global.rate, admit->global.burst);
+  if(admit->global.tokens < ADMIT_ONE)
+  {
+    admit->stats.over_budget++;
+    return NULL;
+  }
+  admit->global.tokens -= ADMIT_ONE;
+  return admit;
+}
+
+util_admit_t util_admit_take(util_admit_t admit, uint8_t *from, size_t len, uint64_t now)
+{
+  uint32_t hash;
+  admit_source_t source;
+  if(!admit) return NULL;
+
+  // w/o an address there's no source to hold to a rate, only the budget
+  if(!from || !len)
+  {
+    if(!admit_budget(admit, now)) return NULL;
+    admit->stats.admitted++;
+    return admit;
+  }
+
+  hash = admit_hash(admit, from, len);
+  source = &(admit->sources[hash % admit->count]);
+  if(source->hash != hash)
+  {
+    source->hash = hash;
+    source->tokens = admit->burst * ADMIT_ONE;
+    source->last = now;
+  }
+  source->tokens = admit_refill(source->tokens, &(source->last), now, admit->rate, admit->burst);
+  if(source->tokens < ADMIT_ONE)
+  {
+    admit->stats.limited++;
+    return NULL;
+  }
+
+  // the source isn't charged when the budget turns it away
+  if(!admit_budget(admit, now)) return NULL;
+  source->tokens -= ADMIT_ONE;
+
+  admit->stats.admitted++;
+  return admit;
+}
+
+util_admit_t util_admit_cookies(util_admit_t admit)
+{
+  if(!admit || !admit->cookies) return NULL;
+  return admit;
+}
+
+// hmac of the window and address
+static uint8_t *admit_cookie(util_admit_t admit, uint8_t *from, size_t len, uint32_t window, uint8_t *cookie)
+{
+  uint8_t buf[4+ADMIT_FROM], hash[32];
+  if(len > ADMIT_FROM) len = ADMIT_FROM;
+  buf[0] = (uint8_t)(window >> 24);
+  buf[1] = (uint8_t)(window >> 16);
+  buf[2] = (uint8_t)(window >> 8);
+  buf[3] = (uint8_t)window;
+  if(len) memcpy(buf+4, from, len);
+  hmac_256_keyed(&(admit->cookie), buf, 4+len, hash);
+  memcpy(cookie, hash, UTIL_ADMIT_COOKIE);
+  return cookie;
+}
+
+uint8_t *util_admit_cookie(util_admit_t admit, uint8_t *from, size_t len, uint64_t now, uint8_t *cookie)
+{
+  if(!admit || !cookie) return LOG("bad args");
+  if(!admit_budget(admit, now)) return NULL;
+  admit->stats.challenged++;
+  return admit_cookie(admit, from, len, (uint32_t)(now / 1000 / UTIL_ADMIT_WINDOW), cookie);
+}
+
+util_admit_t util_admit_verify(util_admit_t admit, uint8_t *from, size_t len, uint64_t now, uint8_t *cookie)
+{
+  uint8_t check[UTIL_ADMIT_COOKIE];
+  uint32_t window;
+  if(!admit || !cookie) return LOG("bad args");
+
+  // this window or the one before
+  window = (uint32_t)(now / 1000 / UTIL_ADMIT_WINDOW);
+  if(util_ct_memcmp(admit_cookie(admit, from, len, window, check), cookie, UTIL_ADMIT_COOKIE) == 0) return admit;
+  if(window && util_ct_memcmp(admit_cookie(admit, from, len, window - 1, check), cookie, UTIL_ADMIT_COOKIE) == 0) return admit;
+
+  admit->stats.bad_cookies++;
+  return NULL;
+}
+
+util_admit_stats_t util_admit_stats(util_admit_t admit)
+{
+  if(!admit) return NULL;
+  return &(admit->stats);
+}
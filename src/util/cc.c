@@ -0,0 +1,192 @@
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "telehash.h"
+
+// cubic's C is 0.4 packets per round trip cubed, beta 0.7
+#define CC_C_NUM 4
+#define CC_C_DEN 10
+#define CC_BETA_NUM 7
+#define CC_BETA_DEN 10
+
+static uint32_t cc_cbrt(uint64_t x)
+{
+  uint64_t lo = 0, hi = 2097152, mid; // 2^21 cubed is past any window here
+  while(lo < hi)
+  {
+    mid = (lo + hi + 1) / 2;
+    if(mid * mid * mid <= x) lo = mid;
+    else hi = mid - 1;
+  }
+  return (uint32_t)lo;
+}
+
+// round trips (in 16ths) for the curve to climb from the current window back to wmax
+static void cc_epoch(util_cc_t cc, uint32_t from)
+{
+  cc->epoch = cc->round = 0;
+  cc->k = (cc->wmax > from) ? cc_cbrt(((uint64_t)(cc->wmax - from) * CC_C_DEN * 4096) / (CC_C_NUM * UTIL_CC_MSS)) : 0;
+}
+
+void util_cc_init(util_cc_t cc)
+{
+  if(!cc) return;
+  memset(cc,0,sizeof (struct util_cc_struct));
+  cc->cwnd = UTIL_CC_INIT * UTIL_CC_MSS;
+  cc->ssthresh = UINT32_MAX;
+  cc->tokens = UINT32_MAX; // unpaced until there's an rtt
+}
+
+void util_cc_clock(util_cc_t cc, uint32_t now)
+{
+  uint64_t rate, cap;
+  // the clock wraps, anything not after the last one (until there is one) is ignored, nothing's accrued
+  if(!cc || (cc->now && (int32_t)(now - cc->now) <= 0)) return;
+  cc->now = now;
+
+  // can't spread sends any finer than one unit of now
+  if(cc->srtt < 8)
+  {
+    cc->tokens = UINT32_MAX;
+    cc->filled = now;
+    return;
+  }
+
+  // a window per rtt, w/ some gain to keep probing (more in slow start)
+  rate = ((uint64_t)cc->cwnd * 8) / cc->srtt;
+  rate = (cc->cwnd < cc->ssthresh) ? rate * 2 : (rate * 5) / 4;
+  cap = (rate > 2 * UTIL_CC_MSS) ? rate : 2 * UTIL_CC_MSS;
+  rate = (uint64_t)cc->tokens + (rate * (now - cc->filled));
+  cc->tokens = (uint32_t)((rate > cap) ? cap : rate);
+  cc->filled = now;
+}
+
+uint32_t util_cc_room(util_cc_t cc)
+{
+  uint32_t room;
+  if(!cc || cc->flight >= cc->cwnd) return 0;
+  room = cc->cwnd - cc->flight;
+  return (room < cc->tokens) ? room : cc->tokens;
+}
+
+void util_cc_sent(util_cc_t cc, uint32_t bytes)
+{
+  if(!cc) return;
+  cc->flight += bytes;
+  cc->sent++;
+  if(cc->tokens != UINT32_MAX) cc->tokens -= (bytes < cc->tokens) ? bytes : cc->tokens;
+}
+
+void util_cc_gone(util_cc_t cc, uint32_t bytes)
+{
+  if(!cc) return;
+  cc->flight -= (bytes < cc->flight) ? bytes : cc->flight;
+}
+
+void util_cc_acked(util_cc_t cc, uint32_t bytes)
+{
+  int64_t d;
+  uint64_t target, grow, reno;
+  if(!cc || !bytes) return;
+
+  // not using the window, no reason to grow it
+  if(cc->flight + bytes < cc->cwnd / 2 || cc->cwnd >= UTIL_CC_MAX) return;
+
+  // slow start
+  if(cc->cwnd < cc->ssthresh)
+  {
+    cc->cwnd += bytes;
+    return;
+  }
+
+  // a window's worth of acks is a round trip
+  cc->round += bytes;
+  while(cc->round >= cc->cwnd)
+  {
+    cc->round -= cc->cwnd;
+    cc->epoch += 16;
+  }
+
+  // W(t) = C(t-K)^3 + wmax, t and K in 16ths of a round trip
+  d = (int64_t)(cc->epoch + ((cc->round * 16) / cc->cwnd)) - (int64_t)cc->k;
+  if(d > 16 * 1024) d = 16 * 1024; // far enough out either way, and no overflow
+  d = (d * d * d * CC_C_NUM * UTIL_CC_MSS) / (CC_C_DEN * 4096);
+  target = ((int64_t)cc->wmax + d > 0) ? (uint64_t)((int64_t)cc->wmax + d) : 0;
+  grow = (target > cc->cwnd) ? ((target - cc->cwnd) * bytes) / cc->cwnd : 0;
+  if(grow > bytes / 2) grow = bytes / 2; // at most 1.5x a round trip
+
+  // never slower than reno
+  reno = ((uint64_t)UTIL_CC_MSS * bytes) / cc->cwnd;
+  cc->cwnd += (uint32_t)((grow > reno) ? grow : reno);
+}
+
+void util_cc_rtt(util_cc_t cc, uint32_t rtt)
+{
+  uint32_t delta;
+  if(!cc) return;
+  if(!cc->samples++)
+  {
+    cc->srtt = rtt * 8;
+    cc->rttvar = rtt * 2;
+    return;
+  }
+  delta = (rtt * 8 > cc->srtt) ? rtt - (cc->srtt / 8) : (cc->srtt / 8) - rtt;
+  cc->rttvar = cc->rttvar - (cc->rttvar / 4) + delta;
+  cc->srtt = cc->srtt - (cc->srtt / 8) + rtt;
+}
+
+// one reduction per round trip, anything else lost in it was from the same congestion
+static uint8_t cc_reduce(util_cc_t cc)
+{
+  if(cc->recover && (int32_t)(cc->now - cc->recover) < 0) return 0; // wraps w/ the clock
+  cc->recover = cc->now + (cc->srtt / 8) + 1;
+  return 1;
+}
+
+void util_cc_loss(util_cc_t cc)
+{
+  uint32_t cwnd;
+  if(!cc) return;
+  cc->lost++;
+  if(!cc_reduce(cc)) return;
+
+  // fast convergence, give up more room when the last peak wasn't reached
+  cwnd = cc->cwnd;
+  cc->wmax = (cwnd < cc->wmax) ? (uint32_t)(((uint64_t)cwnd * (CC_BETA_DEN + CC_BETA_NUM)) / (2 * CC_BETA_DEN)) : cwnd;
+  cwnd = (uint32_t)(((uint64_t)cwnd * CC_BETA_NUM) / CC_BETA_DEN);
+  cc->cwnd = cc->ssthresh = (cwnd > UTIL_CC_MIN * UTIL_CC_MSS) ? cwnd : UTIL_CC_MIN * UTIL_CC_MSS;
+  cc_epoch(cc, cc->cwnd);
+}
+
+void util_cc_timeout(util_cc_t cc)
+{
+  if(!cc) return;
+  cc->timeouts++;
+  if(!cc_reduce(cc)) return; // other channels timing out from the same loss
+  cc->wmax = cc->cwnd;
+  cc->ssthresh = (cc->cwnd / 2 > UTIL_CC_MIN * UTIL_CC_MSS) ? cc->cwnd / 2 : UTIL_CC_MIN * UTIL_CC_MSS;
+  cc->cwnd = UTIL_CC_MIN * UTIL_CC_MSS;
+  cc_epoch(cc, cc->ssthresh);
+}
+
+uint32_t util_cc_rto(util_cc_t cc)
+{
+  if(!cc || !cc->samples) return 0;
+  return (cc->srtt / 8) + (cc->rttvar ? cc->rttvar : 1);
+}
+
+lob_t util_cc_json(util_cc_t cc, lob_t json)
+{
+  if(!cc || !json) return json;
+  if(cc->samples)
+  {
+    lob_add_uint(json,"rtt",cc->srtt / 8);
+    lob_add_uint(json,"rttvar",cc->rttvar / 4);
+  }
+  lob_add_uint(json,"cwnd",cc->cwnd);
+  lob_add_uint(json,"inflight",cc->flight);
+  lob_add_uint(json,"sent",cc->sent);
+  lob_add_uint(json,"lost",cc->lost);
+  lob_add_uint(json,"timeouts",cc->timeouts);
+  return json;
+}
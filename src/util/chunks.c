@@ -3,13 +3,13 @@
 #include <stdint.h>
 #include "telehash.h"
 
-// one malloc per chunk, put storage after it
+// one pooled block per chunk, put storage after it
 util_chunks_t util_chunk_new(util_chunks_t chunks, uint8_t len)
 {
   util_chunk_t chunk;
   size_t size = sizeof (struct util_chunk_struct);
   size += len;
-  if(!(chunk = malloc(size))) return LOG("OOM");
+  if(!(chunk = util_pool_malloc(size))) return LOG("OOM");
   memset(chunk,0,size);
   chunk->size = len;
   // point to extra space after struct, less opaque
@@ -27,7 +27,7 @@ util_chunk_t util_chunk_free(util_chunk_t chunk)
 {
   if(!chunk) return NULL;
   util_chunk_t prev = chunk->prev;
-  free(chunk);
+  util_pool_free(chunk);
   return util_chunk_free(prev);
 }
 
@@ -114,13 +114,13 @@ lob_t util_chunks_receive(util_chunks_t chunks)
   
   // pop off empty flush
   chunk = flush->prev;
-  free(flush);
+  util_pool_free(flush);
 
   // if lone flush, just recurse
   if(!chunk) return util_chunks_receive(chunks);
 
-  // TODO make a lob_new that creates space to prevent double-copy here
-  uint8_t *buf = malloc(len);
+  // assembled in place and adopted by the packet
+  uint8_t *buf = util_pool_malloc(len);
   if(!buf) return LOG("OOM");
   
   // eat chunks copying in
@@ -132,14 +132,13 @@ lob_t util_chunks_receive(util_chunks_t chunks)
     // backfill since we're inverted
     memcpy(buf+(at-chunk->size),chunk->data,chunk->size);
     at -= chunk->size;
-    free(chunk);
+    util_pool_free(chunk);
   }
   
   chunks->ack = 1; // make sure ack is set after any full packets too
 //  LOG("parsing chunked packet length %d hash %d",len,murmur4((uint32_t*)buf,len));
-  lob_t ret = lob_parse(buf,len);
+  lob_t ret = lob_adopt(buf,len);
   chunks->err = ret ? 0 : 1;
-  free(buf);
   return ret;
 }
 
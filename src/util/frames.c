@@ -7,13 +7,13 @@
 // max payload size per frame
 #define PAYLOAD(f) (f->size - 4)
 
-// one malloc per frame, put storage after it
+// one pooled block per frame, put storage after it
 util_frames_t util_frame_new(util_frames_t frames)
 {
   util_frame_t frame;
   size_t size = sizeof (struct util_frame_struct);
   size += PAYLOAD(frames);
-  if(!(frame = malloc(size))) return LOG_WARN("OOM");
+  if(!(frame = util_pool_malloc(size))) return LOG_WARN("OOM");
   memset(frame,0,size);
   
   // add to inbox
@@ -28,7 +28,7 @@ util_frame_t util_frame_free(util_frame_t frame)
 {
   if(!frame) return NULL;
   util_frame_t prev = frame->prev;
-  free(frame);
+  util_pool_free(frame);
   return util_frame_free(prev);
 }
 
@@ -300,8 +300,8 @@ util_frames_t util_frames_inbox(util_frames_t frames, uint8_t *data, uint8_t *me
 
   size_t tlen = (frames->in * size) + tail;
 
-  // TODO make a lob_new that creates space to prevent double-copy here
-  uint8_t *buf = malloc(tlen);
+  // assembled in place and adopted by the packet
+  uint8_t *buf = util_pool_malloc(tlen);
   if(!buf) return LOG_WARN("OOM");
   
   // copy in tail
@@ -317,9 +317,8 @@ util_frames_t util_frames_inbox(util_frames_t frames, uint8_t *data, uint8_t *me
   }
   frames->cache = util_frame_free(frames->cache);
   
-  lob_t packet = lob_parse(buf,tlen);
-  if(!packet) LOG_WARN("packet parsing failed: %s",util_hex(buf,tlen,NULL));
-  free(buf);
+  lob_t packet = lob_adopt(buf,tlen);
+  if(!packet) LOG_WARN("packet parsing failed, %lu bytes",(unsigned long)tlen);
   frames->inbox = lob_push(frames->inbox,packet);
   return frames;
 }
@@ -0,0 +1,161 @@
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "telehash.h"
+
+// size classes are POOL_MIN << 0..POOL_CLASSES-1 (32 to 2048 bytes)
+#define POOL_MIN 32
+#define POOL_CLASSES 7
+
+// max blocks kept on each freelist per thread, beyond that they go back to the system
+#ifndef POOL_CACHE
+#define POOL_CACHE 512
+#endif
+
+// platforms w/o thread-local storage can define this empty (single threaded) or use NOPOOL
+#ifndef POOL_TLS
+#define POOL_TLS UTIL_TLS
+#endif
+
+#ifdef NOPOOL
+
+static struct util_pool_stats_struct pool_stats;
+
+void *util_pool_malloc(size_t size)
+{
+  pool_stats.allocs++;
+  pool_stats.misses++;
+  return malloc(size);
+}
+
+void *util_pool_realloc(void *ptr, size_t size)
+{
+  return realloc(ptr,size);
+}
+
+void util_pool_free(void *ptr)
+{
+  if(!ptr) return;
+  pool_stats.frees++;
+  free(ptr);
+}
+
+void util_pool_flush(void)
+{
+}
+
+util_pool_stats_t util_pool_stats(void)
+{
+  return &pool_stats;
+}
+
+#else
+
+// prefixed to every block so free/realloc know where it goes, sized to keep the data aligned
+typedef struct pool_head_struct
+{
+  struct pool_head_struct *next;
+  size_t cls; // POOL_CLASSES when large
+} *pool_head_t;
+
+static POOL_TLS pool_head_t pool_lists[POOL_CLASSES];
+static POOL_TLS uint32_t pool_counts[POOL_CLASSES];
+static POOL_TLS struct util_pool_stats_struct pool_stats;
+
+static size_t pool_class(size_t size)
+{
+  size_t cls = 0;
+  while(cls < POOL_CLASSES && ((size_t)POOL_MIN << cls) < size) cls++;
+  return cls;
+}
+
+void *util_pool_malloc(size_t size)
+{
+  pool_head_t head;
+  size_t cls = pool_class(size);
+
+  pool_stats.allocs++;
+  if(cls < POOL_CLASSES && (head = pool_lists[cls]))
+  {
+    pool_lists[cls] = head->next;
+    pool_counts[cls]--;
+    pool_stats.cached--;
+    pool_stats.hits++;
+  }else{
+    pool_stats.misses++;
+    if(cls < POOL_CLASSES) size = (size_t)POOL_MIN << cls;
+    else pool_stats.large++;
+    if(!(head = malloc(sizeof (struct pool_head_struct) + size))) return LOG_WARN("OOM");
+  }
+
+  head->next = NULL;
+  head->cls = cls;
+  return head+1;
+}
+
+void *util_pool_realloc(void *ptr, size_t size)
+{
+  pool_head_t head;
+  void *ret;
+  if(!ptr) return util_pool_malloc(size);
+
+  head = (pool_head_t)ptr - 1;
+
+  // large blocks stay large
+  if(head->cls == POOL_CLASSES)
+  {
+    if(!(head = realloc(head, sizeof (struct pool_head_struct) + size))) return LOG_WARN("OOM");
+    return head+1;
+  }
+
+  // still fits the class
+  if(size <= ((size_t)POOL_MIN << head->cls)) return ptr;
+
+  if(!(ret = util_pool_malloc(size))) return NULL;
+  memcpy(ret, ptr, (size_t)POOL_MIN << head->cls);
+  util_pool_free(ptr);
+  return ret;
+}
+
+void util_pool_free(void *ptr)
+{
+  pool_head_t head;
+  if(!ptr) return;
+
+  head = (pool_head_t)ptr - 1;
+  pool_stats.frees++;
+  if(head->cls == POOL_CLASSES || pool_counts[head->cls] >= POOL_CACHE)
+  {
+    free(head);
+    return;
+  }
+
+  head->next = pool_lists[head->cls];
+  pool_lists[head->cls] = head;
+  pool_counts[head->cls]++;
+  pool_stats.cached++;
+}
+
+void util_pool_flush(void)
+{
+  pool_head_t head;
+  size_t cls;
+
+  for(cls = 0; cls < POOL_CLASSES; cls++)
+  {
+    while((head = pool_lists[cls]))
+    {
+      pool_lists[cls] = head->next;
+      free(head);
+    }
+    pool_counts[cls] = 0;
+  }
+  pool_stats.cached = 0;
+}
+
+util_pool_stats_t util_pool_stats(void)
+{
+  return &pool_stats;
+}
+
+#endif
@@ -9,7 +9,7 @@ char *util_hex(uint8_t *in, size_t len, char *out)
     uint32_t j;
     char *c = out;
     static char *hex = "0123456789abcdef";
-    static char *buf = NULL;
+    static UTIL_TLS char *buf = NULL; // per thread, never freed
     if(!in || !len) return NULL;
 
     // utility mode only! use/return an internal buffer
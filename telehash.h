@@ -0,0 +1,4077 @@
+#ifndef lob_h
+#define lob_h
+
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct lob_struct
+{
+  // these are public but managed by accessors
+  uint8_t *raw;
+  uint8_t *body;
+  size_t body_len;
+  uint8_t *head;
+  size_t head_len;
+  
+  // these are all for external use only
+  uint32_t id;
+  void *arg;
+
+  // these are internal/private
+  struct lob_struct *chain;
+  char *cache; // edited copy of the json head
+  struct lob_index_struct *index; // top level key offsets in the head, built on first lookup
+  size_t headroom, tailroom; // unused space allocated before/after raw
+
+  // used only by the list utils
+  struct lob_struct *next, *prev;
+
+} *lob_t;
+
+// these all allocate/free memory
+lob_t lob_new();
+lob_t lob_copy(lob_t p);
+lob_t lob_free(lob_t p); // returns NULL for convenience
+
+// creates a new parent packet chained to the given child one, so freeing the new packet also free's it
+lob_t lob_chain(lob_t child);
+// manually chain together two packets, returns parent, frees any existing child, creates parent if none
+lob_t lob_link(lob_t parent, lob_t child);
+// return a linked child if any
+lob_t lob_linked(lob_t parent);
+// returns child, unlinked
+lob_t lob_unlink(lob_t parent);
+
+// initialize head/body from raw, parses json
+lob_t lob_parse(const uint8_t *raw, size_t len);
+
+// same as lob_parse but takes ownership of raw instead of copying it (from util_pool_malloc, free'd on failure too)
+lob_t lob_adopt(uint8_t *raw, size_t len);
+
+// make sure there's at least this much space before/after raw so it can be framed in place w/o a realloc
+lob_t lob_reserve(lob_t p, size_t headroom, size_t tailroom);
+
+// turns p in place into a packet w/ no json and a body of [head bytes][original raw][tail bytes], caller fills head/tail
+lob_t lob_wrap(lob_t p, size_t head, size_t tail);
+
+// return full encoded packet
+uint8_t *lob_raw(lob_t p);
+size_t lob_len(lob_t p);
+
+// return null-terminated json header only
+char *lob_json(lob_t p);
+
+// creates temporarily cached string on lob (used by lob_json), free'd w/ lob or next cache call
+char *lob_cache(lob_t p, size_t len);
+
+// set/store these in the current packet
+uint8_t *lob_head(lob_t p, uint8_t *head, size_t len);
+uint8_t *lob_body(lob_t p, uint8_t *body, size_t len);
+lob_t lob_append(lob_t p, uint8_t *chunk, size_t len);
+lob_t lob_append_str(lob_t p, char *chunk);
+
+// core accessors
+size_t lob_head_len(lob_t p);
+uint8_t *lob_head_get(lob_t p);
+size_t lob_body_len(lob_t p);
+uint8_t *lob_body_get(lob_t p);
+
+// convenient json setters/getters, always return given lob so they're chainable
+lob_t lob_set_raw(lob_t p, char *key, size_t klen, char *val, size_t vlen); // raw
+lob_t lob_set(lob_t p, char *key, char *val); // escapes value
+lob_t lob_set_len(lob_t p, char *key, size_t klen, char *val, size_t vlen); // same as lob_set
+lob_t lob_set_int(lob_t p, char *key, int val);
+lob_t lob_set_uint(lob_t p, char *key, unsigned int val);
+lob_t lob_set_float(lob_t p, char *key, float val, uint8_t places);
+lob_t lob_set_printf(lob_t p, char *key, const char *format, ...);
+lob_t lob_set_base32(lob_t p, char *key, uint8_t *val, size_t vlen);
+
+// builds a json head in place w/o any duplicate key checks, the head isn't valid json until lob_finish
+lob_t lob_begin(lob_t p); // starts a new head or reopens an existing object
+lob_t lob_add_raw(lob_t p, char *key, size_t klen, char *val, size_t vlen); // raw
+lob_t lob_add(lob_t p, char *key, char *val); // escapes value
+lob_t lob_add_uint(lob_t p, char *key, unsigned int val);
+lob_t lob_add_base32(lob_t p, char *key, uint8_t *val, size_t vlen);
+lob_t lob_finish(lob_t p);
+
+// copies keys from json into p
+lob_t lob_set_json(lob_t p, lob_t json);
+
+// count of keys
+unsigned int lob_keys(lob_t p);
+
+// alpha-sorts the json keys
+lob_t lob_sort(lob_t p);
+
+// 0 to match, !0 if different, compares only top-level json and body
+int lob_cmp(lob_t a, lob_t b);
+
+// the return uint8_t* is invalidated with any _set* operation!
+char *lob_get(lob_t p, char *key);
+int lob_get_int(lob_t p, char *key);
+unsigned int lob_get_uint(lob_t p, char *key);
+float lob_get_float(lob_t p, char *key);
+
+char *lob_get_index(lob_t p, uint32_t i); // returns ["0","1","2","3"] or {"0":"1","2":"3"}
+
+// just shorthand for util_cmp to match a key/value
+int lob_get_cmp(lob_t p, char *key, char *val);
+
+// get the raw value, must use get_len
+char *lob_get_raw(lob_t p, char *key);
+size_t lob_get_len(lob_t p, char *key);
+
+// returns new packets based on values
+lob_t lob_get_json(lob_t p, char *key); // creates new packet from key:object value
+lob_t lob_get_array(lob_t p, char *key); // list of packet->next from key:[object,object]
+lob_t lob_get_base32(lob_t p, char *key); // decoded binary is the return body
+
+// TODO, this would be handy, js syntax to get a json value
+// char *lob_eval(lob_t p, "foo.bar[0]['zzz']");
+
+// manage a basic double-linked list of packets using ->next and ->prev
+lob_t lob_pop(lob_t list); // returns last item, item->next is the new list
+lob_t lob_push(lob_t list, lob_t append); // appends new item, returns new list
+lob_t lob_shift(lob_t list); // returns first item, item->next is the new list
+lob_t lob_unshift(lob_t list, lob_t prepend); // adds item, returns new list
+lob_t lob_splice(lob_t list, lob_t extract); // removes item from list, returns new list
+lob_t lob_insert(lob_t list, lob_t after, lob_t p); // inserts item in list after other item, returns new list
+lob_t lob_freeall(lob_t list); // frees all
+lob_t lob_match(lob_t list, char *key, char *value); // find the first packet in the list w/ the matching key/value
+lob_t lob_next(lob_t list);
+lob_t lob_array(lob_t list); // return json array of the list
+
+#endif
+#include <stddef.h>
+
+#ifndef xht_h
+#define xht_h
+
+// simple string->void* hashtable, very static and bare minimal, but efficient
+
+typedef struct xht_struct *xht_t;
+
+// must pass a prime#
+xht_t xht_new(unsigned int prime);
+
+// caller responsible for key storage, no copies made (don't free it b4 xht_free()!)
+// set val to NULL to clear an entry (key is released), memory is reused but never free'd (# of keys only grows to peak usage)
+void xht_set(xht_t h, const char *key, void *val);
+
+// ooh! unlike set where key/val is in caller's mem, here they are copied into xht_t and free'd when val is 0 or xht_free()
+void xht_store(xht_t h, const char *key, void *val, size_t vlen);
+
+// returns value of val if found, or NULL
+void *xht_get(xht_t h, const char *key);
+
+// free the hashtable and all entries
+void xht_free(xht_t h);
+
+// pass a function that is called for every key that has a value set
+typedef void (*xht_walker)(xht_t h, const char *key, void *val, void *arg);
+void xht_walk(xht_t h, xht_walker w, void *arg);
+
+// iterator through all the keys (NULL to start), use get for values
+char *xht_iter(xht_t h, char *key);
+
+#endif
+
+#ifndef e3x_cipher_h
+#define e3x_cipher_h
+
+
+// these are unique to each cipher set implementation
+#define local_t void*
+#define remote_t void*
+#define ephemeral_t void*
+
+// one signature in a batch for remote_validate_batch, err is set to what remote_validate would return
+typedef struct e3x_validate_struct
+{
+  remote_t remote;
+  lob_t args, sig;
+  uint8_t *data;
+  size_t len;
+  uint8_t err;
+} *e3x_validate_t;
+
+// this is the overall holder for each cipher set, function pointers to cs specific implementations
+typedef struct e3x_cipher_struct
+{
+  // these are common functions each one needs to support
+  uint8_t *(*rand)(uint8_t *bytes, size_t len); // write len random bytes, returns bytes as well for convenience
+  uint8_t *(*hash)(uint8_t *in, size_t len, uint8_t *out32); // sha256's the in, out32 must be [32] from caller
+  uint8_t *(*err)(void); // last known crypto error string, if any
+
+  // create a new keypair, save encoded to csid in each
+  uint8_t (*generate)(lob_t keys, lob_t secrets);
+
+  // our local identity
+  local_t (*local_new)(lob_t keys, lob_t secrets);
+  void (*local_free)(local_t local);
+  lob_t (*local_decrypt)(local_t local, lob_t outer);
+  lob_t (*local_sign)(local_t local, lob_t args, uint8_t *data, size_t len);
+  
+  // a remote endpoint identity
+  remote_t (*remote_new)(lob_t key, uint8_t *token);
+  void (*remote_free)(remote_t remote);
+  remote_t (*remote_dup)(remote_t remote); // optional, an independent copy for use on another thread
+  uint8_t (*remote_verify)(remote_t remote, local_t local, lob_t outer);
+  lob_t (*remote_encrypt)(remote_t remote, local_t local, lob_t inner);
+  uint8_t (*remote_validate)(remote_t remote, lob_t args, lob_t sig, uint8_t *data, size_t len);
+  uint32_t (*remote_validate_batch)(e3x_validate_t *items, uint32_t count); // optional, sets each err and returns how many were valid
+  
+  // an active session to a remote for channel packets
+  ephemeral_t (*ephemeral_new)(remote_t remote, lob_t outer);
+  void (*ephemeral_free)(ephemeral_t ephemeral);
+  lob_t (*ephemeral_encrypt)(ephemeral_t ephemeral, lob_t inner);
+  lob_t (*ephemeral_decrypt)(ephemeral_t ephemeral, lob_t outer);
+  lob_t (*ephemeral_wrap)(ephemeral_t ephemeral, lob_t inner); // optional, encrypts inner in place and returns it as the outer
+
+  uint8_t id, csid;
+  char hex[3], *alg;
+} *e3x_cipher_t;
+
+
+// room to reserve around channel packets so ephemeral_wrap can frame them w/o a copy
+#define E3X_HEADROOM (2+16+4)
+#define E3X_TAILROOM 4
+
+// all possible cipher sets, as index into cipher_sets global
+#define CS_1a 0
+#define CS_1c 1
+#define CS_2a 2
+#define CS_3a 3
+#define CS_MAX 4
+
+extern e3x_cipher_t e3x_cipher_sets[]; // all created
+extern e3x_cipher_t e3x_cipher_default; // just one of them for the rand/hash utils
+
+// calls all e3x_cipher_init_*'s to fill in e3x_cipher_sets[]
+uint8_t e3x_cipher_init(lob_t options);
+
+// return by id or hex
+e3x_cipher_t e3x_cipher_set(uint8_t csid, char *hex);
+
+// init functions for each
+e3x_cipher_t cs1a_init(lob_t options);
+e3x_cipher_t cs1c_init(lob_t options);
+e3x_cipher_t cs2a_init(lob_t options);
+e3x_cipher_t cs3a_init(lob_t options);
+
+#endif
+#ifndef e3x_self_h
+#define e3x_self_h
+
+
+typedef struct e3x_self_struct
+{
+  lob_t keys[CS_MAX];
+  local_t locals[CS_MAX];
+} *e3x_self_t;
+
+// load id secrets/keys to create a new local endpoint
+e3x_self_t e3x_self_new(lob_t secrets, lob_t keys);
+void e3x_self_free(e3x_self_t self); // any exchanges must have been free'd first
+
+// try to decrypt any message sent to us, returns the inner
+lob_t e3x_self_decrypt(e3x_self_t self, lob_t message);
+
+// generate a signature for the data
+lob_t e3x_self_sign(e3x_self_t self, lob_t args, uint8_t *data, size_t len);
+
+#endif
+#ifndef e3x_exchange_h
+#define e3x_exchange_h
+
+#include <stdint.h>
+
+// apps should only use accessor functions for values in this struct
+typedef struct e3x_exchange_struct
+{
+  e3x_cipher_t cs; // convenience
+  e3x_self_t self;
+  remote_t remote;
+  ephemeral_t ephem;
+  uint32_t in, out;
+  uint32_t cid, last;
+  uint8_t token[16], eid[16];
+  uint8_t csid, order;
+  char hex[3];
+} *e3x_exchange_t;
+
+// make a new exchange
+// packet must contain the raw key in the body
+e3x_exchange_t e3x_exchange_new(e3x_self_t self, uint8_t csid, lob_t key);
+void e3x_exchange_free(e3x_exchange_t x);
+
+// these are stateless async encryption and verification
+lob_t e3x_exchange_message(e3x_exchange_t x, lob_t inner);
+uint8_t e3x_exchange_verify(e3x_exchange_t x, lob_t outer);
+uint8_t e3x_exchange_validate(e3x_exchange_t x, lob_t args, lob_t sig, uint8_t *data, size_t len);
+
+// many validates at once, each w/ the key from xs[i] (xs and its entries optional) and args/sig/data/len filled in
+// sets each item's remote and err (0 is valid), returns how many were valid
+uint32_t e3x_exchange_validate_batch(e3x_exchange_t *xs, e3x_validate_t items, uint32_t count);
+
+// return the current incoming at value, optional arg to update it
+uint32_t e3x_exchange_in(e3x_exchange_t x, uint32_t at);
+
+// will return the current outgoing at value, optional arg to update it
+uint32_t e3x_exchange_out(e3x_exchange_t x, uint32_t at);
+
+// synchronize to incoming ephemeral key and set out at = in at, returns x if success, NULL if not
+e3x_exchange_t e3x_exchange_sync(e3x_exchange_t x, lob_t outer);
+
+// an independent copy (w/o any ephemeral) that another thread can verify/sync a handshake on, NULL if the cipher set can't
+e3x_exchange_t e3x_exchange_dup(e3x_exchange_t x);
+
+// does what e3x_exchange_sync() would w/ the ephemeral a dup created for this same handshake, NULL if that dup doesn't apply to x
+e3x_exchange_t e3x_exchange_adopt(e3x_exchange_t x, e3x_exchange_t dup, lob_t outer);
+
+// drops ephemeral state, out=0
+e3x_exchange_t e3x_exchange_down(e3x_exchange_t x);
+
+// generates handshake w/ current e3x_exchange_out value and ephemeral key
+lob_t e3x_exchange_handshake(e3x_exchange_t x, lob_t inner);
+
+// simple synchronous encrypt/decrypt conversion of any packet for channels
+lob_t e3x_exchange_receive(e3x_exchange_t x, lob_t outer); // goes to channel, validates cid
+lob_t e3x_exchange_send(e3x_exchange_t x, lob_t inner); // comes from channel 
+lob_t e3x_exchange_wrap(e3x_exchange_t x, lob_t inner); // same as send but consumes inner, in place when possible
+
+// validate the next incoming channel id from the packet, or return the next avail outgoing channel id
+uint32_t e3x_exchange_cid(e3x_exchange_t x, lob_t incoming);
+
+// get the 16-byte token value to this exchange
+uint8_t *e3x_exchange_token(e3x_exchange_t x);
+
+#endif
+#ifndef hashname_h
+#define hashname_h
+
+
+// overall type
+typedef struct hashname_struct
+{
+  uint8_t bin[32];
+} *hashname_t;
+
+// only things that actually malloc/free
+hashname_t hashname_dup(hashname_t hn);
+hashname_t hashname_free(hashname_t hn);
+
+// everything else returns a pointer to a per-thread static for temporary use
+hashname_t hashname_vchar(const char *str); // from a string
+hashname_t hashname_vbin(const uint8_t *bin);
+hashname_t hashname_vkeys(lob_t keys);
+hashname_t hashname_vkey(lob_t key, uint8_t id); // key is body, intermediates in json
+
+// accessors
+uint8_t *hashname_bin(hashname_t hn); // 32 bytes
+char *hashname_char(hashname_t hn); // 52 byte base32 string w/ \0 (TEMPORARY)
+
+// utilities related to hashnames
+int hashname_cmp(hashname_t a, hashname_t b);  // memcmp shortcut
+uint8_t hashname_id(lob_t a, lob_t b); // best matching id (single byte)
+lob_t hashname_im(lob_t keys, uint8_t id); // intermediate hashes in the json, optional id to set that as body
+
+// working with short hashnames (5 bin bytes, 8 char bytes)
+char *hashname_short(hashname_t hn); // 8 byte base32 string w/ \0 (TEMPORARY)
+int hashname_scmp(hashname_t a, hashname_t b);  // short only comparison
+hashname_t hashname_schar(const char *str); // 8 char string, temp hn
+hashname_t hashname_sbin(const uint8_t *bin); // 5 bytes, temp hn
+hashname_t hashname_isshort(hashname_t hn); // NULL unless is short
+
+#endif
+#ifndef mesh_h
+#define mesh_h
+
+typedef struct mesh_struct *mesh_t;
+typedef struct link_struct *link_t;
+typedef struct chan_struct *chan_t;
+
+#ifndef MESH_BUFFER
+#define MESH_BUFFER (16 * 1024 * 1024) // default cap on bytes all channels on all links buffer
+#endif
+
+
+
+
+struct mesh_struct
+{
+  hashname_t id;
+  lob_t keys, paths;
+  e3x_self_t self;
+  void *on; // internal list of triggers
+  // shared network info
+  uint16_t port_local, port_public;
+  char *ipv4_local, *ipv4_public;
+  link_t links;
+  // lookup indexes into links, keyed by routing token, full and short hashname
+  xht_t index_token, index_id, index_short;
+  uint32_t index_prime, linked;
+  util_admit_t admit; // handshake admission control, see mesh_admission()
+  uint32_t buffered, buffer_max, refused; // channel buffers on all links, see mesh_buffer()
+  uint8_t clocked; // reliable channels run on mesh_clock() instead of mesh_process()'s now
+  uint32_t clock; // the latest mesh_clock() (or mesh_process() w/o those), see link_now()
+  // min-heaps of the links w/ something due, by link_due() and by link_clock_due(), space for every link
+  link_t *timers, *clocks;
+  uint32_t timers_count, clocks_count, heaps_size;
+};
+
+mesh_t mesh_new(void);
+mesh_t mesh_free(mesh_t mesh);
+
+// must be called to initialize to a hashname from keys/secrets, return !0 if failed
+uint8_t mesh_load(mesh_t mesh, lob_t secrets, lob_t keys);
+
+// creates and loads a new random hashname, returns secrets if it needs to be saved/reused
+lob_t mesh_generate(mesh_t mesh);
+
+// simple accessors
+hashname_t mesh_id(mesh_t mesh);
+lob_t mesh_keys(mesh_t mesh);
+
+// generate json of mesh keys and current paths
+lob_t mesh_json(mesh_t mesh);
+
+// generate json for all links, returns lob list
+lob_t mesh_links(mesh_t mesh);
+
+// creates a link from the json format of {"hashname":"...","keys":{},"paths":[]}
+link_t mesh_add(mesh_t mesh, lob_t json);
+
+// return only if this hashname (full or short) is currently linked (in any state)
+link_t mesh_linked(mesh_t mesh, char *hn, size_t len);
+link_t mesh_linkid(mesh_t mesh, hashname_t id); // TODO, clean this up
+
+// internal, keeps the link lookup indexes current (used by link_new/link_load/link_free)
+mesh_t mesh_index(mesh_t mesh, link_t link);
+mesh_t mesh_unindex(mesh_t mesh, link_t link);
+
+// internal, keeps the heaps of links by when they're due current (used by link.c whenever that may have changed)
+mesh_t mesh_link_room(mesh_t mesh, uint32_t links); // heap space for this many links
+mesh_t mesh_link_timer(mesh_t mesh, link_t link);
+mesh_t mesh_link_drop(mesh_t mesh, link_t link);
+
+// remove this link, will event it down and clean up during next process()
+mesh_t mesh_unlink(link_t link);
+
+// processes incoming packet, it will take ownership of packet, returns link delivered to if success
+link_t mesh_receive(mesh_t mesh, lob_t packet);
+
+// same, from is the transport's address for the sender, when *reply is set it must be sent back to that address
+link_t mesh_receive_from(mesh_t mesh, lob_t packet, uint8_t *from, size_t len, lob_t *reply);
+
+// rate limit handshakes before any public key work is spent on them, options are those of util_admit_new() (NULL turns it off)
+// w/ "cookie":true a sender w/o a cookie is challenged (a *reply) and must resend its handshake echoing it, links do that automatically
+mesh_t mesh_admission(mesh_t mesh, lob_t options);
+
+// cap the bytes all channels on all links can buffer (0 for MESH_BUFFER), past it packets from either side are refused
+mesh_t mesh_buffer(mesh_t mesh, uint32_t max);
+
+// the admission step of mesh_receive_from() alone, returns a bare handshake that's admitted (NULL if not) and any other packet unchanged
+lob_t mesh_admit(mesh_t mesh, lob_t packet, uint8_t *from, size_t len, lob_t *reply);
+
+// process any unencrypted handshake packet
+link_t mesh_receive_handshake(mesh_t mesh, lob_t handshake);
+
+// the rest of mesh_receive() for a handshake decrypted elsewhere (e3x_self_decrypt), inner must have the outer linked
+// prepared is an optional dup of the sender link's exchange already verified/synced to it, takes ownership of both
+link_t mesh_receive_prepared(mesh_t mesh, lob_t inner, e3x_exchange_t prepared);
+
+// process any channel timeouts based on the current/given time
+mesh_t mesh_process(mesh_t mesh, uint32_t now);
+
+// earliest link_due() of all links, 0 if nothing is waiting on a timeout
+uint32_t mesh_due(mesh_t mesh);
+
+// a finer clock (ms) for reliable channels' resends, rtt and pacing, once it's given mesh_process() only drives the channel timeouts
+// (call it often, sends are timed by its latest now, and from the start since it can't mix w/ the now before it)
+mesh_t mesh_clock(mesh_t mesh, uint32_t now);
+
+// earliest resend or paced send due on that clock, 0 if none
+uint32_t mesh_clock_due(mesh_t mesh);
+
+// callback when the mesh is free'd
+void mesh_on_free(mesh_t mesh, char *id, void (*free)(mesh_t mesh));
+
+// callback when a path needs to be turned into a pipe
+void mesh_on_path(mesh_t mesh, char *id, link_t (*path)(link_t link, lob_t path));
+link_t mesh_path(mesh_t mesh, link_t link, lob_t path);
+
+// callback when an unknown hashname is discovered
+void mesh_on_discover(mesh_t mesh, char *id, link_t (*discover)(mesh_t mesh, lob_t discovered));
+void mesh_discover(mesh_t mesh, lob_t discovered);
+
+// callback when a link changes state created/up/down
+void mesh_on_link(mesh_t mesh, char *id, void (*link)(link_t link));
+void mesh_link(mesh_t mesh, link_t link);
+
+// callback when a new incoming channel is requested
+void mesh_on_open(mesh_t mesh, char *id, lob_t (*open)(link_t link, lob_t open));
+lob_t mesh_open(mesh_t mesh, link_t link, lob_t open);
+
+
+#endif
+#ifndef util_cc_h
+#define util_cc_h
+
+#include <stdint.h>
+
+// congestion control for everything a link sends reliably, shared by all of its channels
+// the window grows CUBIC-style but counted in round trips (by bytes acked) so it doesn't care what units now is in,
+// and sends are paced to spread a window across the smoothed rtt
+#define UTIL_CC_MSS 1200 // nominal packet size the window moves by
+#define UTIL_CC_INIT 10 // initial window, in packets
+#define UTIL_CC_MIN 2 // smallest window after a loss, in packets
+#define UTIL_CC_MAX (64 * 1024 * 1024) // bytes
+
+typedef struct util_cc_struct
+{
+  uint32_t cwnd, ssthresh, flight; // bytes
+  uint32_t wmax; // window before the last reduction
+  uint32_t epoch, k; // round trips since that reduction and until back at wmax, both in 16ths
+  uint32_t round; // bytes acked towards the next round trip
+  uint32_t srtt, rttvar; // 8x and 4x, like tcp
+  uint32_t now, recover; // latest clock, no more reductions until it's past recover
+  uint32_t tokens, filled; // pacing bucket, and when it was last filled
+  uint32_t sent, lost, timeouts, samples; // counts
+} *util_cc_t;
+
+void util_cc_init(util_cc_t cc);
+
+// the latest now, refills the pacing bucket
+void util_cc_clock(util_cc_t cc, uint32_t now);
+
+// bytes that can be sent right now, limited by the window and the pacing
+uint32_t util_cc_room(util_cc_t cc);
+
+// a packet of this many bytes was sent
+void util_cc_sent(util_cc_t cc, uint32_t bytes);
+
+// these bytes were acked, grows the window (call util_cc_gone too for what was still in flight)
+void util_cc_acked(util_cc_t cc, uint32_t bytes);
+
+// these bytes aren't in flight anymore (acked, lost, or their channel is gone)
+void util_cc_gone(util_cc_t cc, uint32_t bytes);
+
+// a round trip was measured (from a packet only sent once)
+void util_cc_rtt(util_cc_t cc, uint32_t rtt);
+
+// a packet was reported missing, the window shrinks at most once per round trip
+void util_cc_loss(util_cc_t cc);
+
+// nothing was acked in time, back to a minimal window
+void util_cc_timeout(util_cc_t cc);
+
+// how long to wait for an ack before resending, 0 until there's a measured rtt
+uint32_t util_cc_rto(util_cc_t cc);
+
+// adds the estimates to a json object being built (lob_begin'd)
+lob_t util_cc_json(util_cc_t cc, lob_t json);
+
+#endif
+#ifndef link_h
+#define link_h
+#include <stdint.h>
+
+
+#ifndef LINK_BUFFER
+#define LINK_BUFFER (4 * 1024 * 1024) // default cap on bytes all of a link's channels buffer
+#endif
+
+struct link_struct
+{
+  // public link data
+  hashname_t id;
+  e3x_exchange_t x;
+  mesh_t mesh;
+  lob_t key;
+
+  // channels open-addressed by id, and min-heaps of them by next timeout and by next resend (on the cc clock)
+  chan_t *chans, *timers, *resends;
+  uint32_t chans_size, chans_count, timers_count, resends_count;
+
+  // what reliable channels send is paced and windowed together, taking turns
+  struct util_cc_struct cc;
+  chan_t ready, ready_last; // channels w/ something to send, in turn order
+  uint32_t ready_count;
+  uint32_t tpace; // held back by pacing as of then, 0 if not
+  uint32_t paced; // sends pacing held back
+  uint8_t flushing;
+
+  // when it's due on the mesh's heaps (as of the last mesh_link_timer), and position+1 in them, 0 if not in it
+  uint32_t tdue, cdue, tindex, cindex;
+
+  // everything the channels have buffered, in or out
+  uint32_t buffered, buffer_max, refused; // bytes, cap, packets refused for being over it (or the mesh's)
+
+  // transport plumbing
+  void *send_arg;
+  link_t (*send_cb)(link_t link, lob_t packet, void *arg);
+  
+  // these are for internal link management only
+  link_t next;
+  uint8_t csid;
+  char hashname[53], hshort[9], token[17]; // mesh index keys
+  char cookie[32]; // base32, our handshakes echo it when the other side asked for one
+};
+
+// these all create or return existing one from the mesh
+link_t link_get(mesh_t mesh, hashname_t id);
+link_t link_get_keys(mesh_t mesh, lob_t keys); // adds in the right key
+link_t link_get_key(mesh_t mesh, lob_t key, uint8_t csid); // adds in from the body
+
+// simple accessors
+hashname_t link_id(link_t link);
+lob_t link_key(link_t link);
+
+// get link info json
+lob_t link_json(link_t link);
+
+// removes from mesh
+void link_free(link_t link);
+
+// load in the key to existing link
+link_t link_load(link_t link, uint8_t csid, lob_t key);
+
+// add a delivery pipe to this link
+link_t link_pipe(link_t link, link_t (*send)(link_t link, lob_t packet, void *arg), void *arg);
+
+// cap the bytes all of this link's channels can buffer (0 for LINK_BUFFER), past it packets from either side are refused
+link_t link_buffer(link_t link, uint32_t max);
+
+// process a decrypted channel packet
+link_t link_receive(link_t link, lob_t inner);
+
+// process an incoming handshake
+link_t link_receive_handshake(link_t link, lob_t handshake);
+
+// same, w/ a dup of link->x that already verified and synced to it on another thread (see e3x_exchange_dup), caller still owns prepared
+link_t link_receive_prepared(link_t link, lob_t handshake, e3x_exchange_t prepared);
+
+// try to deliver this encrypted packet
+link_t link_send(link_t link, lob_t outer);
+
+// encrypt and send this packet
+link_t link_direct(link_t link, lob_t inner);
+
+// return current handshake (caller free's)
+lob_t link_handshake(link_t link);
+
+// send current handshake(s) 
+link_t link_sync(link_t link);
+
+// force generate new encrypted handshake(s) and sync
+link_t link_resync(link_t link);
+
+// is the other endpoint connected and the link available, NULL if not
+link_t link_up(link_t link);
+
+// force link down, ends channels and generates events
+link_t link_down(link_t link);
+
+// create/track a new channel for this open
+chan_t link_chan(link_t link, lob_t open);
+
+// get an existing channel by id, NULL if none
+chan_t link_chan_get(link_t link, uint32_t id);
+
+// internal, used by chan.c to stop tracking a channel and to re-sort it when its timeout/state changes
+link_t link_chan_drop(link_t link, chan_t c);
+link_t link_chan_timer(link_t link, chan_t c);
+
+// internal, send what reliable channels have waiting as the congestion window and pacing allow, each queued by chan.c for a turn
+link_t link_chan_ready(link_t link, chan_t c);
+link_t link_flush(link_t link);
+
+// process any channel timeouts based on the current/given time, and w/o a mesh_clock() the resends and pacing too
+link_t link_process(link_t link, uint32_t now);
+
+// the clock reliable channels are timed by (see mesh_clock), processes the resends and paced sends due
+link_t link_clock(link_t link, uint32_t now);
+uint32_t link_clock_due(link_t link); // when the next of those is, 0 if none
+uint32_t link_now(link_t link); // that clock now, caught up to the mesh's
+
+// when the next channel is due to be processed (pass a later time to link_process), 0 if none
+uint32_t link_due(link_t link);
+
+#endif
+#ifndef chan_h
+#define chan_h
+#include <stdint.h>
+
+enum chan_states { CHAN_ENDED, CHAN_OPENING, CHAN_OPEN };
+
+// reliable channel defaults
+#ifndef CHAN_WINDOW
+#define CHAN_WINDOW 65536 // bytes in flight, held out of order, and advertised for the other side to send
+#endif
+#ifndef CHAN_RESEND
+#define CHAN_RESEND 2 // unacked packets are sent again after this long (in the link's clock units), doubling each time
+#endif
+#ifndef CHAN_RESEND_MS
+#define CHAN_RESEND_MS 200 // the same on a mesh_clock(), which is in ms
+#endif
+#define CHAN_RETRIES 8 // resends w/o the ack moving before the channel errors
+#define CHAN_MISS 32 // most gaps listed in one ack
+
+// standalone channel packet management, buffering and ordering
+// internal only structure, always use accessors
+struct chan_struct
+{
+  link_t link; // so channels can be first-class
+  uint32_t id; // wire id (not unique)
+  char *type;
+  lob_t in;
+  uint32_t buffered, queued; // bytes in in/reorder and in out, also counted against the link's and mesh's caps
+
+  // timer stuff
+  uint32_t tsent, trecv; // last send, recv at
+  uint32_t timeout; // when to error w/ a timeout, on mesh_process()'s clock
+  uint32_t tindex, rindex; // position+1 in the link's timeout and resend heaps, 0 if not in it
+  
+  // direct handler
+  void *arg;
+  void (*handle)(chan_t c, void *arg);
+  void (*writable)(chan_t c, void *arg); // room to send again, see chan_writable()
+
+  // reliable delivery, only when window is set
+  uint32_t window; // bytes, bounds both what's in flight and what's held out of order
+  uint32_t seq; // last one queued
+  uint32_t sent; // highest seq sent so far
+  uint32_t sample, tsample; // seq being timed for the rtt, and when it was sent
+  uint32_t ack; // highest received in order
+  uint32_t acked, peer; // the other side's highest ack and receive window as of it
+  uint32_t adv; // receive window we last told the other side
+  uint32_t missed; // highest already resent because an ack said it was missing
+  uint32_t tresend; // when the oldest in flight is due to be sent again, 0 if none
+  lob_t out; // unacked in seq order, each ->id is when it was last sent (0 if waiting to be)
+  lob_t unsent; // the first in out never sent, nothing after it has been either
+  uint32_t flight, resends; // bytes of out in flight, and how many before unsent are waiting to be sent again
+  chan_t ready; // next in the link's list of channels taking turns sending
+  uint8_t listed; // is in that list
+  lob_t reorder; // received past a gap, in seq order
+  uint8_t retries; // resend timeouts since the ack last moved
+  uint8_t acking; // something was received that hasn't been acked yet
+  uint8_t flushing; // acks can arrive while we're sending
+  uint8_t blocked; // was short on room to send, the writable callback is owed
+
+  enum chan_states state;
+};
+
+// caller must manage lists of channels per e3x_exchange based on cid
+chan_t chan_new(lob_t open); // open must be chan_receive or chan_send next yet
+chan_t chan_free(chan_t c);
+
+// sets the absolute time (on mesh_process()'s clock) this channel errors w/ a timeout, returns the current one (0 for none)
+// it isn't pushed back by traffic, set it again to keep a busy channel going
+uint32_t chan_timeout(chan_t c, uint32_t at);
+
+// make this a reliable channel, everything sent is sequenced and resent until acked, received is put back in order
+// window is in bytes (0 for CHAN_WINDOW), call before sending anything, an incoming open w/ a "seq" does this already
+chan_t chan_reliable(chan_t c, uint32_t window);
+
+// bytes buffered in the inbox, and for reliable channels unacked and out of order
+uint32_t chan_size(chan_t c);
+
+// bytes a reliable channel can chan_send before there's more than a window waiting on acks (or the link's/mesh's buffer caps are hit)
+// it's only a credit, past it sends are still queued until a cap refuses them, UINT32_MAX for unreliable channels since nothing is kept
+// when it's down to half a window or less the writable callback fires once there's more than that again (checked as the channel is processed)
+uint32_t chan_writable(chan_t c);
+chan_t chan_on_writable(chan_t c, void (*writable)(chan_t c, void *arg)); // called w/ the chan_handle() arg
+
+// incoming packets
+chan_t chan_receive(chan_t c, lob_t inner); // process into receiving queue
+chan_t chan_sync(chan_t c, uint8_t sync); // false to force start timeouts (after any new handshake), true to cancel and resend last packet (after any e3x_exchange_sync)
+lob_t chan_receiving(chan_t c); // get next avail packet in order, null if nothing
+
+// outgoing packets
+lob_t chan_oob(chan_t c); // id/ack/miss only headers base packet
+lob_t chan_packet(chan_t c);  // creates a sequenced packet w/ all necessary headers, just a convenience
+chan_t chan_send(chan_t c, lob_t inner); // encrypts and sends packet out link, reliable ones are sequenced and may wait on the window
+chan_t chan_err(chan_t c, char *err); // generates local-only error packet for next chan_process()
+
+// must be called after every send or receive, processes resends/timeouts, fires handlers
+chan_t chan_process(chan_t c, uint32_t now);
+
+// internal, used by link_flush: sends the next waiting packet if it fits the channel's window and the room given, returns its size or 0
+uint32_t chan_transmit(chan_t c, uint32_t room);
+
+// internal, true when it has a packet its own window lets go (only the link's room could be holding it)
+uint8_t chan_ready(chan_t c);
+
+// set up internal handler for all incoming packets on this channel
+chan_t chan_handle(chan_t c, void (*handle)(chan_t c, void *arg), void *arg);
+
+// convenience functions, accessors
+uint32_t chan_id(chan_t c); // c->id
+enum chan_states chan_state(chan_t c);
+
+
+
+#endif
+#ifndef util_chunks_h
+#define util_chunks_h
+
+#include <stdint.h>
+
+// for list of incoming chunks
+typedef struct util_chunk_struct
+{
+  struct util_chunk_struct *prev;
+  uint8_t size;
+  uint8_t data[];
+} *util_chunk_t;
+
+typedef struct util_chunks_struct
+{
+
+  util_chunk_t reading; // stacked linked list of incoming chunks
+
+  lob_t writing;
+  size_t writeat; // offset into lob_raw()
+  uint16_t waitat; // gets to 256, offset into current chunk
+  uint8_t waiting; // current writing chunk size;
+  uint8_t readat; // always less than a max chunk, offset into reading
+
+  uint8_t cap;
+  uint8_t blocked:1, blocking:1, ack:1, err:1; // bool flags
+} *util_chunks_t;
+
+
+// size of each chunk, 0 == MAX (256)
+util_chunks_t util_chunks_new(uint8_t size);
+
+util_chunks_t util_chunks_free(util_chunks_t chunks);
+
+// turn this packet into chunks and append, free's out
+util_chunks_t util_chunks_send(util_chunks_t chunks, lob_t out);
+
+// get any packets that have been reassembled from incoming chunks
+lob_t util_chunks_receive(util_chunks_t chunks);
+
+// bytes waiting to be sent
+uint32_t util_chunks_writing(util_chunks_t chunks);
+
+
+////// these are for a stream-based transport
+
+// how many bytes are there ready to write
+uint32_t util_chunks_len(util_chunks_t chunks);
+
+// return the next block of data to be written to the stream transport, max len is util_chunks_len()
+uint8_t *util_chunks_write(util_chunks_t chunks);
+
+// advance the write this far, don't mix with util_chunks_out() usage
+util_chunks_t util_chunks_written(util_chunks_t chunks, size_t len);
+
+// queues incoming stream based data
+util_chunks_t util_chunks_read(util_chunks_t chunks, uint8_t *block, size_t len);
+
+////// these are for frame-based transport
+
+// size of the next chunk, -1 when none, max is chunks size-1
+int16_t util_chunks_size(util_chunks_t chunks);
+
+// return the next chunk of data, use util_chunks_next to advance
+uint8_t *util_chunks_frame(util_chunks_t chunks);
+
+// peek into what the next chunk size will be, to see terminator ones
+int16_t util_chunks_peek(util_chunks_t chunks);
+
+// process incoming chunk
+util_chunks_t util_chunks_chunk(util_chunks_t chunks, uint8_t *chunk, int16_t size);
+
+// advance the write past the current chunk
+util_chunks_t util_chunks_next(util_chunks_t chunks);
+
+
+#endif
+#ifndef util_frames_h
+#define util_frames_h
+
+#include <stdint.h>
+
+// for list of incoming frames
+typedef struct util_frame_struct
+{
+  struct util_frame_struct *prev;
+  uint32_t hash;
+  uint8_t data[];
+} *util_frame_t;
+
+typedef struct util_frames_struct
+{
+
+  lob_t inbox; // received packets waiting to be processed
+  lob_t outbox; // current packet being sent out
+
+  util_frame_t cache; // stacked linked list of incoming frames in progress
+
+  uint32_t inbase; // last confirmed inbox hash
+  uint32_t outbase; // last confirmed outbox hash
+
+  uint8_t in; // number of incoming frames received/waiting
+  uint8_t out; //  number of outgoing frames of outbox sent since outbase
+
+  uint8_t size; // frame size
+  uint8_t flush:1; // bool to signal a flush is needed
+  uint8_t err:1; // unrecoverable failure
+
+} *util_frames_t;
+
+
+// size of each frame, min 16 max 128, multiple of 4
+util_frames_t util_frames_new(uint8_t size);
+
+util_frames_t util_frames_free(util_frames_t frames);
+
+// turn this packet into frames and append, free's out
+util_frames_t util_frames_send(util_frames_t frames, lob_t out);
+
+// get any packets that have been reassembled from incoming frames
+lob_t util_frames_receive(util_frames_t frames);
+
+// total bytes in the inbox/outbox
+size_t util_frames_inlen(util_frames_t frames);
+size_t util_frames_outlen(util_frames_t frames);
+
+// meta space is (size - 14) and only filled when receiving a meta frame
+util_frames_t util_frames_inbox(util_frames_t frames, uint8_t *data, uint8_t *meta); // data=NULL is ready check
+
+// fills data with the next frame, if no payload available always fills w/ meta frame, safe to re-run (idempotent)
+util_frames_t util_frames_outbox(util_frames_t frames, uint8_t *data, uint8_t *meta); // data=NULL is ready-check
+
+// this must be called immediately (no inbox interleaved) after last outbox is actually sent to advance payload or clear flush request, returns if more to send
+util_frames_t util_frames_sent(util_frames_t frames);
+
+// is just a check to see if there's data waiting to be sent
+util_frames_t util_frames_waiting(util_frames_t frames);
+
+// is there an expectation of an incoming frame
+util_frames_t util_frames_await(util_frames_t frames);
+
+// are we waiting to send/receive a frame (both waiting && await)
+util_frames_t util_frames_busy(util_frames_t frames);
+
+// is a frame pending to be sent immediately
+util_frames_t util_frames_pending(util_frames_t frames);
+
+
+
+// check error state and clearing it
+util_frames_t util_frames_ok(util_frames_t frames);
+util_frames_t util_frames_clear(util_frames_t frames);
+
+#endif
+/**
+ * \file aes.h
+ *
+ * \brief AES block cipher
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+#ifndef MBEDTLS_AES_H
+#define MBEDTLS_AES_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MBEDTLS_AES_ENCRYPT     1
+#define MBEDTLS_AES_DECRYPT     0
+
+#define MBEDTLS_ERR_AES_INVALID_KEY_LENGTH                -0x0020  /**< Invalid key length. */
+#define MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH              -0x0022  /**< Invalid data input length. */
+
+#define MBEDTLS_AES_ROM_TABLES
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// local wrapper
+void aes_128_ctr(unsigned char *key, size_t length, unsigned char nonce_counter[16], const unsigned char *input, unsigned char *output);
+
+// an expanded key, for anything that uses the same key for many aes_128_ctr_key() calls
+typedef struct aes_128_key_struct
+{
+  uint32_t rk[44]; // round keys, the same bytes for the table and AES-NI paths
+} *aes_128_key_t;
+
+void aes_128_setkey(aes_128_key_t key, const unsigned char raw[16]);
+void aes_128_ctr_key(aes_128_key_t key, size_t length, unsigned char nonce_counter[16], const unsigned char *input, unsigned char *output);
+
+// x86 AES-NI is used whenever the cpu has it, this turns it off (0) or back on, returns if it's in use
+uint8_t aes_128_hw(uint8_t enable);
+
+/**
+ * \brief          AES context structure
+ *
+ * \note           buf is able to hold 32 extra bytes, which can be used:
+ *                 - for alignment purposes if VIA padlock is used, and/or
+ *                 - to simplify key expansion in the 256-bit case by
+ *                 generating an extra round key
+ */
+typedef struct
+{
+    int nr;                     /*!<  number of rounds  */
+    uint32_t *rk;               /*!<  AES round keys    */
+    uint32_t buf[68];           /*!<  unaligned data    */
+}
+mbedtls_aes_context;
+
+/**
+ * \brief          Initialize AES context
+ *
+ * \param ctx      AES context to be initialized
+ */
+void mbedtls_aes_init( mbedtls_aes_context *ctx );
+
+/**
+ * \brief          Clear AES context
+ *
+ * \param ctx      AES context to be cleared
+ */
+void mbedtls_aes_free( mbedtls_aes_context *ctx );
+
+/**
+ * \brief          AES key schedule (encryption)
+ *
+ * \param ctx      AES context to be initialized
+ * \param key      encryption key
+ * \param keybits  must be 128, 192 or 256
+ *
+ * \return         0 if successful, or MBEDTLS_ERR_AES_INVALID_KEY_LENGTH
+ */
+int mbedtls_aes_setkey_enc( mbedtls_aes_context *ctx, const unsigned char *key,
+                    unsigned int keybits );
+
+/**
+ * \brief          AES key schedule (decryption)
+ *
+ * \param ctx      AES context to be initialized
+ * \param key      decryption key
+ * \param keybits  must be 128, 192 or 256
+ *
+ * \return         0 if successful, or MBEDTLS_ERR_AES_INVALID_KEY_LENGTH
+ */
+int mbedtls_aes_setkey_dec( mbedtls_aes_context *ctx, const unsigned char *key,
+                    unsigned int keybits );
+
+/**
+ * \brief          AES-ECB block encryption/decryption
+ *
+ * \param ctx      AES context
+ * \param mode     MBEDTLS_AES_ENCRYPT or MBEDTLS_AES_DECRYPT
+ * \param input    16-byte input block
+ * \param output   16-byte output block
+ *
+ * \return         0 if successful
+ */
+int mbedtls_aes_crypt_ecb( mbedtls_aes_context *ctx,
+                    int mode,
+                    const unsigned char input[16],
+                    unsigned char output[16] );
+
+
+/**
+ * \brief               AES-CTR buffer encryption/decryption
+ *
+ * Warning: You have to keep the maximum use of your counter in mind!
+ *
+ * Note: Due to the nature of CTR you should use the same key schedule for
+ * both encryption and decryption. So a context initialized with
+ * mbedtls_aes_setkey_enc() for both MBEDTLS_AES_ENCRYPT and MBEDTLS_AES_DECRYPT.
+ *
+ * \param ctx           AES context
+ * \param length        The length of the data
+ * \param nc_off        The offset in the current stream_block (for resuming
+ *                      within current cipher stream). The offset pointer to
+ *                      should be 0 at the start of a stream.
+ * \param nonce_counter The 128-bit nonce and counter.
+ * \param stream_block  The saved stream-block for resuming. Is overwritten
+ *                      by the function.
+ * \param input         The input data stream
+ * \param output        The output data stream
+ *
+ * \return         0 if successful
+ */
+int mbedtls_aes_crypt_ctr( mbedtls_aes_context *ctx,
+                       size_t length,
+                       size_t *nc_off,
+                       unsigned char nonce_counter[16],
+                       unsigned char stream_block[16],
+                       const unsigned char *input,
+                       unsigned char *output );
+
+/**
+ * \brief           Internal AES block encryption function
+ *                  (Only exposed to allow overriding it,
+ *                  see MBEDTLS_AES_ENCRYPT_ALT)
+ *
+ * \param ctx       AES context
+ * \param input     Plaintext block
+ * \param output    Output (ciphertext) block
+ */
+void mbedtls_aes_encrypt( mbedtls_aes_context *ctx,
+                          const unsigned char input[16],
+                          unsigned char output[16] );
+
+/**
+ * \brief           Internal AES block decryption function
+ *                  (Only exposed to allow overriding it,
+ *                  see MBEDTLS_AES_DECRYPT_ALT)
+ *
+ * \param ctx       AES context
+ * \param input     Ciphertext block
+ * \param output    Output (plaintext) block
+ */
+void mbedtls_aes_decrypt( mbedtls_aes_context *ctx,
+                          const unsigned char input[16],
+                          unsigned char output[16] );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* aes.h */
+// Base32 implementation
+//
+// Copyright 2010 Google Inc.
+// Author: Markus Gutschke
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Encode and decode from base32 encoding using the following alphabet:
+//   ABCDEFGHIJKLMNOPQRSTUVWXYZ234567
+// This alphabet is documented in RFC 4668/3548
+//
+// We allow white-space and hyphens, but all other characters are considered
+// invalid.
+//
+// All functions return the number of output bytes or -1 on error. If the
+// output buffer is too small, the result will silently be truncated.
+
+#ifndef _BASE32_H_
+#define _BASE32_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+size_t base32_decode(const char *encoded, size_t length, uint8_t *result, size_t bufSize);
+size_t base32_encode(const uint8_t *data, size_t length, char *result, size_t bufSize);
+
+// number of characters required, including null terminator
+size_t base32_encode_length(size_t rawLength);
+
+// number of bytes, rounded down (truncates extra bits)
+size_t base32_decode_floor(size_t base32Length);
+
+#endif /* _BASE32_H_ */
+#ifndef b64_h
+#define b64_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// min buffer size for encoding/decoding
+#define base64_encode_length(x) (8 * (((x) + 2) / 6)) + 3
+#define base64_decode_length(x) ((((x) + 2) * 6) / 8)
+
+// encode str of len into out (must be at least base64_encode_length(len) big), return actual encoded len
+size_t base64_encoder(const uint8_t *str, size_t len, char *out);
+
+// decode str of len into out (must be base64_decode_length(len) bit), return actual decoded len
+size_t base64_decoder(const char *str, size_t len, uint8_t *out);
+
+#endif
+
+#ifndef _CHACHA20_H_
+#define _CHACHA20_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// a convert-in-place utility
+uint8_t *chacha20(uint8_t *key, uint8_t *nonce, uint8_t *bytes, uint32_t len);
+
+// limit the vector paths for testing/benchmarking: 2 allows AVX2 (the default), 1 only SSE2, 0 is all scalar
+// returns the level actually in use on this cpu
+uint8_t chacha20_hw(uint8_t level);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* !_CHACHA20_H_ */
+#ifndef chan_h
+#define chan_h
+#include <stdint.h>
+
+enum chan_states { CHAN_ENDED, CHAN_OPENING, CHAN_OPEN };
+
+// reliable channel defaults
+#ifndef CHAN_WINDOW
+#define CHAN_WINDOW 65536 // bytes in flight, held out of order, and advertised for the other side to send
+#endif
+#ifndef CHAN_RESEND
+#define CHAN_RESEND 2 // unacked packets are sent again after this long (in the link's clock units), doubling each time
+#endif
+#ifndef CHAN_RESEND_MS
+#define CHAN_RESEND_MS 200 // the same on a mesh_clock(), which is in ms
+#endif
+#define CHAN_RETRIES 8 // resends w/o the ack moving before the channel errors
+#define CHAN_MISS 32 // most gaps listed in one ack
+
+// standalone channel packet management, buffering and ordering
+// internal only structure, always use accessors
+struct chan_struct
+{
+  link_t link; // so channels can be first-class
+  uint32_t id; // wire id (not unique)
+  char *type;
+  lob_t in;
+  uint32_t buffered, queued; // bytes in in/reorder and in out, also counted against the link's and mesh's caps
+
+  // timer stuff
+  uint32_t tsent, trecv; // last send, recv at
+  uint32_t timeout; // when to error w/ a timeout, on mesh_process()'s clock
+  uint32_t tindex, rindex; // position+1 in the link's timeout and resend heaps, 0 if not in it
+  
+  // direct handler
+  void *arg;
+  void (*handle)(chan_t c, void *arg);
+  void (*writable)(chan_t c, void *arg); // room to send again, see chan_writable()
+
+  // reliable delivery, only when window is set
+  uint32_t window; // bytes, bounds both what's in flight and what's held out of order
+  uint32_t seq; // last one queued
+  uint32_t sent; // highest seq sent so far
+  uint32_t sample, tsample; // seq being timed for the rtt, and when it was sent
+  uint32_t ack; // highest received in order
+  uint32_t acked, peer; // the other side's highest ack and receive window as of it
+  uint32_t adv; // receive window we last told the other side
+  uint32_t missed; // highest already resent because an ack said it was missing
+  uint32_t tresend; // when the oldest in flight is due to be sent again, 0 if none
+  lob_t out; // unacked in seq order, each ->id is when it was last sent (0 if waiting to be)
+  lob_t unsent; // the first in out never sent, nothing after it has been either
+  uint32_t flight, resends; // bytes of out in flight, and how many before unsent are waiting to be sent again
+  chan_t ready; // next in the link's list of channels taking turns sending
+  uint8_t listed; // is in that list
+  lob_t reorder; // received past a gap, in seq order
+  uint8_t retries; // resend timeouts since the ack last moved
+  uint8_t acking; // something was received that hasn't been acked yet
+  uint8_t flushing; // acks can arrive while we're sending
+  uint8_t blocked; // was short on room to send, the writable callback is owed
+
+  enum chan_states state;
+};
+
+// caller must manage lists of channels per e3x_exchange based on cid
+chan_t chan_new(lob_t open); // open must be chan_receive or chan_send next yet
+chan_t chan_free(chan_t c);
+
+// sets the absolute time (on mesh_process()'s clock) this channel errors w/ a timeout, returns the current one (0 for none)
+// it isn't pushed back by traffic, set it again to keep a busy channel going
+uint32_t chan_timeout(chan_t c, uint32_t at);
+
+// make this a reliable channel, everything sent is sequenced and resent until acked, received is put back in order
+// window is in bytes (0 for CHAN_WINDOW), call before sending anything, an incoming open w/ a "seq" does this already
+chan_t chan_reliable(chan_t c, uint32_t window);
+
+// bytes buffered in the inbox, and for reliable channels unacked and out of order
+uint32_t chan_size(chan_t c);
+
+// bytes a reliable channel can chan_send before there's more than a window waiting on acks (or the link's/mesh's buffer caps are hit)
+// it's only a credit, past it sends are still queued until a cap refuses them, UINT32_MAX for unreliable channels since nothing is kept
+// when it's down to half a window or less the writable callback fires once there's more than that again (checked as the channel is processed)
+uint32_t chan_writable(chan_t c);
+chan_t chan_on_writable(chan_t c, void (*writable)(chan_t c, void *arg)); // called w/ the chan_handle() arg
+
+// incoming packets
+chan_t chan_receive(chan_t c, lob_t inner); // process into receiving queue
+chan_t chan_sync(chan_t c, uint8_t sync); // false to force start timeouts (after any new handshake), true to cancel and resend last packet (after any e3x_exchange_sync)
+lob_t chan_receiving(chan_t c); // get next avail packet in order, null if nothing
+
+// outgoing packets
+lob_t chan_oob(chan_t c); // id/ack/miss only headers base packet
+lob_t chan_packet(chan_t c);  // creates a sequenced packet w/ all necessary headers, just a convenience
+chan_t chan_send(chan_t c, lob_t inner); // encrypts and sends packet out link, reliable ones are sequenced and may wait on the window
+chan_t chan_err(chan_t c, char *err); // generates local-only error packet for next chan_process()
+
+// must be called after every send or receive, processes resends/timeouts, fires handlers
+chan_t chan_process(chan_t c, uint32_t now);
+
+// internal, used by link_flush: sends the next waiting packet if it fits the channel's window and the room given, returns its size or 0
+uint32_t chan_transmit(chan_t c, uint32_t room);
+
+// internal, true when it has a packet its own window lets go (only the link's room could be holding it)
+uint8_t chan_ready(chan_t c);
+
+// set up internal handler for all incoming packets on this channel
+chan_t chan_handle(chan_t c, void (*handle)(chan_t c, void *arg), void *arg);
+
+// convenience functions, accessors
+uint32_t chan_id(chan_t c); // c->id
+enum chan_states chan_state(chan_t c);
+
+
+
+#endif
+#ifndef e3x_h
+#define e3x_h
+
+#define E3X_VERSION_MAJOR 0
+#define E3X_VERSION_MINOR 5
+#define E3X_VERSION_PATCH 1
+#define E3X_VERSION ((E3X_VERSION_MAJOR) * 10000 + (E3X_VERSION_MINOR) * 100 + (E3X_VERSION_PATCH))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// ##### e3x - end-to-end encrypted exchange #####
+//
+// * intended to be wrapped/embedded in other codebases
+// * includes some minimal crypto, but is primarily a wrapper around other crypto libraries
+// * tries to minimize the integration points to send and receive encrypted packets over any transport
+// * everything contains a '3' to minimize any naming conflicts when used with other codebases
+//
+
+
+// top-level library functions
+
+// process-wide boot one-time initialization, !0 is error and lob_get(options,"err");
+uint8_t e3x_init(lob_t options);
+
+// return last known error string from anywhere, intended only for debugging/logging
+uint8_t *e3x_err(void);
+
+// generate a new local identity, secrets returned in the lob json and keys in the linked lob json
+lob_t e3x_generate(void);
+
+// random bytes, from a supported cipher set
+uint8_t *e3x_rand(uint8_t *bytes, size_t len);
+
+// set a random byte provider function
+void e3x_random(uint8_t (*frand)(void));
+
+// sha256 hashing, from one of the cipher sets
+uint8_t *e3x_hash(uint8_t *in, size_t len, uint8_t *out32);
+
+
+// local endpoint state management
+
+// a single exchange (a session w/ local endpoint and remote endpoint)
+
+
+
+//##############
+/* binding notes
+
+* app must have an index of the hashnames-to-exchange and tokens-to-exchange
+* for each exchange, keep a list of active network transport sessions and potential transport paths
+* also keep a list of active channels per exchange to track state
+* one transport session may be delivering to multiple exchanges (not a 1:1 mapping)
+* unreliable transport sessions must trigger a new handshake for any exchange when they need to be re-validated
+* all transport sessions must signal when they are closed, which generates a new handshake to any other sessions
+* always use the most recently validated-active transport session to deliver to for sending
+
+*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+#ifndef e3x_cipher_h
+#define e3x_cipher_h
+
+
+// these are unique to each cipher set implementation
+#define local_t void*
+#define remote_t void*
+#define ephemeral_t void*
+
+// one signature in a batch for remote_validate_batch, err is set to what remote_validate would return
+typedef struct e3x_validate_struct
+{
+  remote_t remote;
+  lob_t args, sig;
+  uint8_t *data;
+  size_t len;
+  uint8_t err;
+} *e3x_validate_t;
+
+// this is the overall holder for each cipher set, function pointers to cs specific implementations
+typedef struct e3x_cipher_struct
+{
+  // these are common functions each one needs to support
+  uint8_t *(*rand)(uint8_t *bytes, size_t len); // write len random bytes, returns bytes as well for convenience
+  uint8_t *(*hash)(uint8_t *in, size_t len, uint8_t *out32); // sha256's the in, out32 must be [32] from caller
+  uint8_t *(*err)(void); // last known crypto error string, if any
+
+  // create a new keypair, save encoded to csid in each
+  uint8_t (*generate)(lob_t keys, lob_t secrets);
+
+  // our local identity
+  local_t (*local_new)(lob_t keys, lob_t secrets);
+  void (*local_free)(local_t local);
+  lob_t (*local_decrypt)(local_t local, lob_t outer);
+  lob_t (*local_sign)(local_t local, lob_t args, uint8_t *data, size_t len);
+  
+  // a remote endpoint identity
+  remote_t (*remote_new)(lob_t key, uint8_t *token);
+  void (*remote_free)(remote_t remote);
+  remote_t (*remote_dup)(remote_t remote); // optional, an independent copy for use on another thread
+  uint8_t (*remote_verify)(remote_t remote, local_t local, lob_t outer);
+  lob_t (*remote_encrypt)(remote_t remote, local_t local, lob_t inner);
+  uint8_t (*remote_validate)(remote_t remote, lob_t args, lob_t sig, uint8_t *data, size_t len);
+  uint32_t (*remote_validate_batch)(e3x_validate_t *items, uint32_t count); // optional, sets each err and returns how many were valid
+  
+  // an active session to a remote for channel packets
+  ephemeral_t (*ephemeral_new)(remote_t remote, lob_t outer);
+  void (*ephemeral_free)(ephemeral_t ephemeral);
+  lob_t (*ephemeral_encrypt)(ephemeral_t ephemeral, lob_t inner);
+  lob_t (*ephemeral_decrypt)(ephemeral_t ephemeral, lob_t outer);
+  lob_t (*ephemeral_wrap)(ephemeral_t ephemeral, lob_t inner); // optional, encrypts inner in place and returns it as the outer
+
+  uint8_t id, csid;
+  char hex[3], *alg;
+} *e3x_cipher_t;
+
+
+// room to reserve around channel packets so ephemeral_wrap can frame them w/o a copy
+#define E3X_HEADROOM (2+16+4)
+#define E3X_TAILROOM 4
+
+// all possible cipher sets, as index into cipher_sets global
+#define CS_1a 0
+#define CS_1c 1
+#define CS_2a 2
+#define CS_3a 3
+#define CS_MAX 4
+
+extern e3x_cipher_t e3x_cipher_sets[]; // all created
+extern e3x_cipher_t e3x_cipher_default; // just one of them for the rand/hash utils
+
+// calls all e3x_cipher_init_*'s to fill in e3x_cipher_sets[]
+uint8_t e3x_cipher_init(lob_t options);
+
+// return by id or hex
+e3x_cipher_t e3x_cipher_set(uint8_t csid, char *hex);
+
+// init functions for each
+e3x_cipher_t cs1a_init(lob_t options);
+e3x_cipher_t cs1c_init(lob_t options);
+e3x_cipher_t cs2a_init(lob_t options);
+e3x_cipher_t cs3a_init(lob_t options);
+
+#endif
+#ifndef e3x_exchange_h
+#define e3x_exchange_h
+
+#include <stdint.h>
+
+// apps should only use accessor functions for values in this struct
+typedef struct e3x_exchange_struct
+{
+  e3x_cipher_t cs; // convenience
+  e3x_self_t self;
+  remote_t remote;
+  ephemeral_t ephem;
+  uint32_t in, out;
+  uint32_t cid, last;
+  uint8_t token[16], eid[16];
+  uint8_t csid, order;
+  char hex[3];
+} *e3x_exchange_t;
+
+// make a new exchange
+// packet must contain the raw key in the body
+e3x_exchange_t e3x_exchange_new(e3x_self_t self, uint8_t csid, lob_t key);
+void e3x_exchange_free(e3x_exchange_t x);
+
+// these are stateless async encryption and verification
+lob_t e3x_exchange_message(e3x_exchange_t x, lob_t inner);
+uint8_t e3x_exchange_verify(e3x_exchange_t x, lob_t outer);
+uint8_t e3x_exchange_validate(e3x_exchange_t x, lob_t args, lob_t sig, uint8_t *data, size_t len);
+
+// many validates at once, each w/ the key from xs[i] (xs and its entries optional) and args/sig/data/len filled in
+// sets each item's remote and err (0 is valid), returns how many were valid
+uint32_t e3x_exchange_validate_batch(e3x_exchange_t *xs, e3x_validate_t items, uint32_t count);
+
+// return the current incoming at value, optional arg to update it
+uint32_t e3x_exchange_in(e3x_exchange_t x, uint32_t at);
+
+// will return the current outgoing at value, optional arg to update it
+uint32_t e3x_exchange_out(e3x_exchange_t x, uint32_t at);
+
+// synchronize to incoming ephemeral key and set out at = in at, returns x if success, NULL if not
+e3x_exchange_t e3x_exchange_sync(e3x_exchange_t x, lob_t outer);
+
+// an independent copy (w/o any ephemeral) that another thread can verify/sync a handshake on, NULL if the cipher set can't
+e3x_exchange_t e3x_exchange_dup(e3x_exchange_t x);
+
+// does what e3x_exchange_sync() would w/ the ephemeral a dup created for this same handshake, NULL if that dup doesn't apply to x
+e3x_exchange_t e3x_exchange_adopt(e3x_exchange_t x, e3x_exchange_t dup, lob_t outer);
+
+// drops ephemeral state, out=0
+e3x_exchange_t e3x_exchange_down(e3x_exchange_t x);
+
+// generates handshake w/ current e3x_exchange_out value and ephemeral key
+lob_t e3x_exchange_handshake(e3x_exchange_t x, lob_t inner);
+
+// simple synchronous encrypt/decrypt conversion of any packet for channels
+lob_t e3x_exchange_receive(e3x_exchange_t x, lob_t outer); // goes to channel, validates cid
+lob_t e3x_exchange_send(e3x_exchange_t x, lob_t inner); // comes from channel 
+lob_t e3x_exchange_wrap(e3x_exchange_t x, lob_t inner); // same as send but consumes inner, in place when possible
+
+// validate the next incoming channel id from the packet, or return the next avail outgoing channel id
+uint32_t e3x_exchange_cid(e3x_exchange_t x, lob_t incoming);
+
+// get the 16-byte token value to this exchange
+uint8_t *e3x_exchange_token(e3x_exchange_t x);
+
+#endif
+#ifndef e3x_self_h
+#define e3x_self_h
+
+
+typedef struct e3x_self_struct
+{
+  lob_t keys[CS_MAX];
+  local_t locals[CS_MAX];
+} *e3x_self_t;
+
+// load id secrets/keys to create a new local endpoint
+e3x_self_t e3x_self_new(lob_t secrets, lob_t keys);
+void e3x_self_free(e3x_self_t self); // any exchanges must have been free'd first
+
+// try to decrypt any message sent to us, returns the inner
+lob_t e3x_self_decrypt(e3x_self_t self, lob_t message);
+
+// generate a signature for the data
+lob_t e3x_self_sign(e3x_self_t self, lob_t args, uint8_t *data, size_t len);
+
+#endif
+#ifndef ext_h
+#define ext_h
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+
+
+#endif
+#ifndef ext_block_h
+#define ext_block_h
+
+
+// add block channel support
+mesh_t ext_block(mesh_t mesh);
+
+// get the next incoming block, if any, packet->arg is the link it came from
+lob_t ext_block_receive(mesh_t mesh);
+
+// creates/reuses a single default block channel on the link
+link_t ext_block_send(link_t link, lob_t block);
+
+// TODO, handle multiple block channels per link, and custom packets on open
+
+#endif
+#ifndef ext_chat_h
+#define ext_chat_h
+
+/*
+
+typedef struct chat_struct 
+{
+  char ep[32+1], id[32+1+64+1], idhash[9];
+  hashname_t origin;
+  switch_t s;
+  chan_t hub;
+  char rhash[9];
+  uint8_t local, seed[4];
+  uint16_t seq;
+  lob_t roster;
+  xht_t conn, log;
+  lob_t msgs;
+  char *join, *sent, *after;
+} *chat_t;
+
+chat_t ext_chat(chan_t c);
+
+chat_t chat_get(switch_t s, char *id);
+chat_t chat_free(chat_t chat);
+
+// get the next incoming message (type state/message), caller must free
+lob_t chat_pop(chat_t chat);
+
+lob_t chat_message(chat_t chat);
+chat_t chat_join(chat_t chat, lob_t join);
+chat_t chat_send(chat_t chat, lob_t msg);
+chat_t chat_add(chat_t chat, char *hn, char *val);
+
+// get a participant or walk the list, returns the current state packet (immutable), online:true/false
+lob_t chat_participant(chat_t chat, char *hn);
+lob_t chat_iparticipant(chat_t chat, int index);
+
+*/
+#endif
+#ifndef ext_connect_h
+#define ext_connect_h
+
+
+//void ext_connect(chan_t c);
+
+#endif
+#ifndef ext_path_h
+#define ext_path_h
+
+
+// send a path ping and get callback event
+link_t path_ping(link_t link, void (*pong)(link_t link, lob_t status, void *arg), void *arg);
+
+lob_t path_on_open(link_t link, lob_t open);
+
+#endif
+#ifndef ext_peer_h
+#define ext_peer_h
+
+
+// enables peer/connect handling for this mesh
+mesh_t peer_enable(mesh_t mesh);
+
+// become a router
+mesh_t peer_route(mesh_t mesh);
+
+// set this link as the default router for any peer
+link_t peer_router(link_t router);
+
+// try to connect this peer via this router (sends an ad-hoc peer request)
+link_t peer_connect(link_t peer, link_t router);
+
+
+#endif
+
+#ifndef ext_sock_h
+#define ext_sock_h
+/*
+
+#define SOCKC_NEW 0
+#define SOCKC_OPEN 1
+#define SOCKC_CLOSED 2
+
+typedef struct sockc_struct 
+{
+  uint8_t state;
+  uint32_t readable, writing;
+  uint8_t *readbuf, *writebuf, *zwrite;
+  lob_t opts;
+  chan_t c;
+  int fd; // convenience for app usage, initialized to -1
+} *sockc_t;
+
+// process channel for new incoming sock channel, any returned sockc must have a read or close function called
+// state is SOCKC_OPEN or SOCKC_NEW (until sockc_accept())
+// it's set to SOCKC_CLOSED after all the data is read on an ended channel or sockc_close() is called
+sockc_t ext_sock(chan_t c);
+
+// changes state from SOCKC_NEW to SOCKC_OPEN
+void sockc_accept(sockc_t sc);
+
+// create a sock channel to this hn, optional opts (ip, port), sets state=SOCKC_OPEN
+sockc_t sockc_connect(switch_t s, char *hn, lob_t opts);
+
+// tries to flush and end, cleans up, sets SOCKC_CLOSED
+sockc_t sockc_close(sockc_t sock);
+
+// must be called to free up sc resources (internally calls sockc_close to be sure)
+sockc_t sockc_free(sockc_t sc);
+
+// -1 on err, returns bytes read into buf up to len, sets SOCKC_CLOSED when channel ended
+int sockc_read(sockc_t sock, uint8_t *buf, int len);
+
+// -1 on err, returns len and will always buffer up to len 
+int sockc_write(sockc_t sock, uint8_t *buf, int len);
+
+// general flush outgoing buffer into a packet
+void sockc_flush(chan_t c);
+
+// advances readbuf by this len, for use when doing zero-copy reading directly from ->readbuf
+// sets SOCKC_CLOSED when channel ended
+void sockc_zread(sockc_t sc, int len);
+
+// creates zero-copy buffer space of requested len at sc->zwrite or returns 0
+int sockc_zwrite(sockc_t sc, int len);
+
+// must use after writing anything to ->zwrite, adds len to outgoing buffer and resets sc->zwrite, returns len
+int sockc_zwritten(sockc_t sc, int len);
+
+// serial-style single character interface
+int sockc_available(sockc_t sc);
+uint8_t sockc_sread(sockc_t sc);
+uint8_t sockc_swrite(sockc_t sc, uint8_t byte);
+*/
+#endif
+#ifndef ext_thtp_h
+#define ext_thtp_h
+
+/*
+
+void ext_thtp(chan_t c);
+
+// optionally initialize thtp w/ an index, happens automatically too
+void thtp_init(switch_t s, xht_t index);
+void thtp_free(switch_t s);
+
+// sends requests matching this glob ("/path" matches "/path/foo") to this note, most specific wins
+void thtp_glob(switch_t s, char *glob, lob_t note);
+
+// sends requests matching this exact path to this note
+void thtp_path(switch_t s, char *path, lob_t note);
+
+// generate an outgoing request, send the response attached to the note
+chan_t thtp_req(switch_t s, lob_t note);
+*/
+#endif
+#ifndef hashname_h
+#define hashname_h
+
+
+// overall type
+typedef struct hashname_struct
+{
+  uint8_t bin[32];
+} *hashname_t;
+
+// only things that actually malloc/free
+hashname_t hashname_dup(hashname_t hn);
+hashname_t hashname_free(hashname_t hn);
+
+// everything else returns a pointer to a per-thread static for temporary use
+hashname_t hashname_vchar(const char *str); // from a string
+hashname_t hashname_vbin(const uint8_t *bin);
+hashname_t hashname_vkeys(lob_t keys);
+hashname_t hashname_vkey(lob_t key, uint8_t id); // key is body, intermediates in json
+
+// accessors
+uint8_t *hashname_bin(hashname_t hn); // 32 bytes
+char *hashname_char(hashname_t hn); // 52 byte base32 string w/ \0 (TEMPORARY)
+
+// utilities related to hashnames
+int hashname_cmp(hashname_t a, hashname_t b);  // memcmp shortcut
+uint8_t hashname_id(lob_t a, lob_t b); // best matching id (single byte)
+lob_t hashname_im(lob_t keys, uint8_t id); // intermediate hashes in the json, optional id to set that as body
+
+// working with short hashnames (5 bin bytes, 8 char bytes)
+char *hashname_short(hashname_t hn); // 8 byte base32 string w/ \0 (TEMPORARY)
+int hashname_scmp(hashname_t a, hashname_t b);  // short only comparison
+hashname_t hashname_schar(const char *str); // 8 char string, temp hn
+hashname_t hashname_sbin(const uint8_t *bin); // 5 bytes, temp hn
+hashname_t hashname_isshort(hashname_t hn); // NULL unless is short
+
+#endif
+
+// key = string to match or null
+// klen = key length (or 0), or if null key then len is the array offset value
+// json = json object or array
+// jlen = length of json
+// vlen = where to store return value length
+// returns pointer to value and sets len to value length, or 0 if not found or any error
+char *js0n(char *key, size_t klen, char *json, size_t jlen, size_t *vlen);
+#ifndef jwt_h
+#define jwt_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// utils to parse and generate JWTs to/from LOBs
+
+// one JWT is two LOB packets, jwt_claims() returns second one
+//  token->head is the JWT header JSON
+//  token->body is a raw LOB for the claims
+//  claims->head is the JWT claims JSON
+//  claims->body is the JWT signature
+
+lob_t jwt_decode(char *encoded, size_t len); // base64 into lobs
+char *jwt_encode(lob_t token); // returns new malloc'd base64 string, caller owns
+
+lob_t jwt_parse(uint8_t *raw, size_t len); // from raw lobs
+uint8_t *jwt_raw(lob_t token); // lob-encoded raw bytes of whole thing
+uint32_t jwt_len(lob_t token); // length of raw bytes
+
+lob_t jwt_claims(lob_t token); // just returns the claims from the token
+lob_t jwt_verify(lob_t token, e3x_exchange_t x); // checks signature, optional x for pk algs
+uint32_t jwt_verify_batch(lob_t *tokens, e3x_exchange_t *xs, uint32_t count, uint8_t *ok); // many at once, how many check out, optional ok[i] set to 1/0
+uint32_t jwt_verify_threads(lob_t *tokens, e3x_exchange_t *xs, uint32_t count, uint8_t *ok, uint32_t threads); // same, w/ the batches spread over up to this many threads (POSIX, else just one)
+lob_t jwt_sign(lob_t token, e3x_self_t self); // attaches signature to the claims, optional self for pk algs
+
+// checks if this alg is supported
+char *jwt_alg(char *alg);
+
+#endif
+#ifndef link_h
+#define link_h
+#include <stdint.h>
+
+
+#ifndef LINK_BUFFER
+#define LINK_BUFFER (4 * 1024 * 1024) // default cap on bytes all of a link's channels buffer
+#endif
+
+struct link_struct
+{
+  // public link data
+  hashname_t id;
+  e3x_exchange_t x;
+  mesh_t mesh;
+  lob_t key;
+
+  // channels open-addressed by id, and min-heaps of them by next timeout and by next resend (on the cc clock)
+  chan_t *chans, *timers, *resends;
+  uint32_t chans_size, chans_count, timers_count, resends_count;
+
+  // what reliable channels send is paced and windowed together, taking turns
+  struct util_cc_struct cc;
+  chan_t ready, ready_last; // channels w/ something to send, in turn order
+  uint32_t ready_count;
+  uint32_t tpace; // held back by pacing as of then, 0 if not
+  uint32_t paced; // sends pacing held back
+  uint8_t flushing;
+
+  // when it's due on the mesh's heaps (as of the last mesh_link_timer), and position+1 in them, 0 if not in it
+  uint32_t tdue, cdue, tindex, cindex;
+
+  // everything the channels have buffered, in or out
+  uint32_t buffered, buffer_max, refused; // bytes, cap, packets refused for being over it (or the mesh's)
+
+  // transport plumbing
+  void *send_arg;
+  link_t (*send_cb)(link_t link, lob_t packet, void *arg);
+  
+  // these are for internal link management only
+  link_t next;
+  uint8_t csid;
+  char hashname[53], hshort[9], token[17]; // mesh index keys
+  char cookie[32]; // base32, our handshakes echo it when the other side asked for one
+};
+
+// these all create or return existing one from the mesh
+link_t link_get(mesh_t mesh, hashname_t id);
+link_t link_get_keys(mesh_t mesh, lob_t keys); // adds in the right key
+link_t link_get_key(mesh_t mesh, lob_t key, uint8_t csid); // adds in from the body
+
+// simple accessors
+hashname_t link_id(link_t link);
+lob_t link_key(link_t link);
+
+// get link info json
+lob_t link_json(link_t link);
+
+// removes from mesh
+void link_free(link_t link);
+
+// load in the key to existing link
+link_t link_load(link_t link, uint8_t csid, lob_t key);
+
+// add a delivery pipe to this link
+link_t link_pipe(link_t link, link_t (*send)(link_t link, lob_t packet, void *arg), void *arg);
+
+// cap the bytes all of this link's channels can buffer (0 for LINK_BUFFER), past it packets from either side are refused
+link_t link_buffer(link_t link, uint32_t max);
+
+// process a decrypted channel packet
+link_t link_receive(link_t link, lob_t inner);
+
+// process an incoming handshake
+link_t link_receive_handshake(link_t link, lob_t handshake);
+
+// same, w/ a dup of link->x that already verified and synced to it on another thread (see e3x_exchange_dup), caller still owns prepared
+link_t link_receive_prepared(link_t link, lob_t handshake, e3x_exchange_t prepared);
+
+// try to deliver this encrypted packet
+link_t link_send(link_t link, lob_t outer);
+
+// encrypt and send this packet
+link_t link_direct(link_t link, lob_t inner);
+
+// return current handshake (caller free's)
+lob_t link_handshake(link_t link);
+
+// send current handshake(s) 
+link_t link_sync(link_t link);
+
+// force generate new encrypted handshake(s) and sync
+link_t link_resync(link_t link);
+
+// is the other endpoint connected and the link available, NULL if not
+link_t link_up(link_t link);
+
+// force link down, ends channels and generates events
+link_t link_down(link_t link);
+
+// create/track a new channel for this open
+chan_t link_chan(link_t link, lob_t open);
+
+// get an existing channel by id, NULL if none
+chan_t link_chan_get(link_t link, uint32_t id);
+
+// internal, used by chan.c to stop tracking a channel and to re-sort it when its timeout/state changes
+link_t link_chan_drop(link_t link, chan_t c);
+link_t link_chan_timer(link_t link, chan_t c);
+
+// internal, send what reliable channels have waiting as the congestion window and pacing allow, each queued by chan.c for a turn
+link_t link_chan_ready(link_t link, chan_t c);
+link_t link_flush(link_t link);
+
+// process any channel timeouts based on the current/given time, and w/o a mesh_clock() the resends and pacing too
+link_t link_process(link_t link, uint32_t now);
+
+// the clock reliable channels are timed by (see mesh_clock), processes the resends and paced sends due
+link_t link_clock(link_t link, uint32_t now);
+uint32_t link_clock_due(link_t link); // when the next of those is, 0 if none
+uint32_t link_now(link_t link); // that clock now, caught up to the mesh's
+
+// when the next channel is due to be processed (pass a later time to link_process), 0 if none
+uint32_t link_due(link_t link);
+
+#endif
+#ifndef lob_h
+#define lob_h
+
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct lob_struct
+{
+  // these are public but managed by accessors
+  uint8_t *raw;
+  uint8_t *body;
+  size_t body_len;
+  uint8_t *head;
+  size_t head_len;
+  
+  // these are all for external use only
+  uint32_t id;
+  void *arg;
+
+  // these are internal/private
+  struct lob_struct *chain;
+  char *cache; // edited copy of the json head
+  struct lob_index_struct *index; // top level key offsets in the head, built on first lookup
+  size_t headroom, tailroom; // unused space allocated before/after raw
+
+  // used only by the list utils
+  struct lob_struct *next, *prev;
+
+} *lob_t;
+
+// these all allocate/free memory
+lob_t lob_new();
+lob_t lob_copy(lob_t p);
+lob_t lob_free(lob_t p); // returns NULL for convenience
+
+// creates a new parent packet chained to the given child one, so freeing the new packet also free's it
+lob_t lob_chain(lob_t child);
+// manually chain together two packets, returns parent, frees any existing child, creates parent if none
+lob_t lob_link(lob_t parent, lob_t child);
+// return a linked child if any
+lob_t lob_linked(lob_t parent);
+// returns child, unlinked
+lob_t lob_unlink(lob_t parent);
+
+// initialize head/body from raw, parses json
+lob_t lob_parse(const uint8_t *raw, size_t len);
+
+// same as lob_parse but takes ownership of raw instead of copying it (from util_pool_malloc, free'd on failure too)
+lob_t lob_adopt(uint8_t *raw, size_t len);
+
+// make sure there's at least this much space before/after raw so it can be framed in place w/o a realloc
+lob_t lob_reserve(lob_t p, size_t headroom, size_t tailroom);
+
+// turns p in place into a packet w/ no json and a body of [head bytes][original raw][tail bytes], caller fills head/tail
+lob_t lob_wrap(lob_t p, size_t head, size_t tail);
+
+// return full encoded packet
+uint8_t *lob_raw(lob_t p);
+size_t lob_len(lob_t p);
+
+// return null-terminated json header only
+char *lob_json(lob_t p);
+
+// creates temporarily cached string on lob (used by lob_json), free'd w/ lob or next cache call
+char *lob_cache(lob_t p, size_t len);
+
+// set/store these in the current packet
+uint8_t *lob_head(lob_t p, uint8_t *head, size_t len);
+uint8_t *lob_body(lob_t p, uint8_t *body, size_t len);
+lob_t lob_append(lob_t p, uint8_t *chunk, size_t len);
+lob_t lob_append_str(lob_t p, char *chunk);
+
+// core accessors
+size_t lob_head_len(lob_t p);
+uint8_t *lob_head_get(lob_t p);
+size_t lob_body_len(lob_t p);
+uint8_t *lob_body_get(lob_t p);
+
+// convenient json setters/getters, always return given lob so they're chainable
+lob_t lob_set_raw(lob_t p, char *key, size_t klen, char *val, size_t vlen); // raw
+lob_t lob_set(lob_t p, char *key, char *val); // escapes value
+lob_t lob_set_len(lob_t p, char *key, size_t klen, char *val, size_t vlen); // same as lob_set
+lob_t lob_set_int(lob_t p, char *key, int val);
+lob_t lob_set_uint(lob_t p, char *key, unsigned int val);
+lob_t lob_set_float(lob_t p, char *key, float val, uint8_t places);
+lob_t lob_set_printf(lob_t p, char *key, const char *format, ...);
+lob_t lob_set_base32(lob_t p, char *key, uint8_t *val, size_t vlen);
+
+// builds a json head in place w/o any duplicate key checks, the head isn't valid json until lob_finish
+lob_t lob_begin(lob_t p); // starts a new head or reopens an existing object
+lob_t lob_add_raw(lob_t p, char *key, size_t klen, char *val, size_t vlen); // raw
+lob_t lob_add(lob_t p, char *key, char *val); // escapes value
+lob_t lob_add_uint(lob_t p, char *key, unsigned int val);
+lob_t lob_add_base32(lob_t p, char *key, uint8_t *val, size_t vlen);
+lob_t lob_finish(lob_t p);
+
+// copies keys from json into p
+lob_t lob_set_json(lob_t p, lob_t json);
+
+// count of keys
+unsigned int lob_keys(lob_t p);
+
+// alpha-sorts the json keys
+lob_t lob_sort(lob_t p);
+
+// 0 to match, !0 if different, compares only top-level json and body
+int lob_cmp(lob_t a, lob_t b);
+
+// the return uint8_t* is invalidated with any _set* operation!
+char *lob_get(lob_t p, char *key);
+int lob_get_int(lob_t p, char *key);
+unsigned int lob_get_uint(lob_t p, char *key);
+float lob_get_float(lob_t p, char *key);
+
+char *lob_get_index(lob_t p, uint32_t i); // returns ["0","1","2","3"] or {"0":"1","2":"3"}
+
+// just shorthand for util_cmp to match a key/value
+int lob_get_cmp(lob_t p, char *key, char *val);
+
+// get the raw value, must use get_len
+char *lob_get_raw(lob_t p, char *key);
+size_t lob_get_len(lob_t p, char *key);
+
+// returns new packets based on values
+lob_t lob_get_json(lob_t p, char *key); // creates new packet from key:object value
+lob_t lob_get_array(lob_t p, char *key); // list of packet->next from key:[object,object]
+lob_t lob_get_base32(lob_t p, char *key); // decoded binary is the return body
+
+// TODO, this would be handy, js syntax to get a json value
+// char *lob_eval(lob_t p, "foo.bar[0]['zzz']");
+
+// manage a basic double-linked list of packets using ->next and ->prev
+lob_t lob_pop(lob_t list); // returns last item, item->next is the new list
+lob_t lob_push(lob_t list, lob_t append); // appends new item, returns new list
+lob_t lob_shift(lob_t list); // returns first item, item->next is the new list
+lob_t lob_unshift(lob_t list, lob_t prepend); // adds item, returns new list
+lob_t lob_splice(lob_t list, lob_t extract); // removes item from list, returns new list
+lob_t lob_insert(lob_t list, lob_t after, lob_t p); // inserts item in list after other item, returns new list
+lob_t lob_freeall(lob_t list); // frees all
+lob_t lob_match(lob_t list, char *key, char *value); // find the first packet in the list w/ the matching key/value
+lob_t lob_next(lob_t list);
+lob_t lob_array(lob_t list); // return json array of the list
+
+#endif
+#ifndef mesh_h
+#define mesh_h
+
+typedef struct mesh_struct *mesh_t;
+typedef struct link_struct *link_t;
+typedef struct chan_struct *chan_t;
+
+#ifndef MESH_BUFFER
+#define MESH_BUFFER (16 * 1024 * 1024) // default cap on bytes all channels on all links buffer
+#endif
+
+
+
+
+struct mesh_struct
+{
+  hashname_t id;
+  lob_t keys, paths;
+  e3x_self_t self;
+  void *on; // internal list of triggers
+  // shared network info
+  uint16_t port_local, port_public;
+  char *ipv4_local, *ipv4_public;
+  link_t links;
+  // lookup indexes into links, keyed by routing token, full and short hashname
+  xht_t index_token, index_id, index_short;
+  uint32_t index_prime, linked;
+  util_admit_t admit; // handshake admission control, see mesh_admission()
+  uint32_t buffered, buffer_max, refused; // channel buffers on all links, see mesh_buffer()
+  uint8_t clocked; // reliable channels run on mesh_clock() instead of mesh_process()'s now
+  uint32_t clock; // the latest mesh_clock() (or mesh_process() w/o those), see link_now()
+  // min-heaps of the links w/ something due, by link_due() and by link_clock_due(), space for every link
+  link_t *timers, *clocks;
+  uint32_t timers_count, clocks_count, heaps_size;
+};
+
+mesh_t mesh_new(void);
+mesh_t mesh_free(mesh_t mesh);
+
+// must be called to initialize to a hashname from keys/secrets, return !0 if failed
+uint8_t mesh_load(mesh_t mesh, lob_t secrets, lob_t keys);
+
+// creates and loads a new random hashname, returns secrets if it needs to be saved/reused
+lob_t mesh_generate(mesh_t mesh);
+
+// simple accessors
+hashname_t mesh_id(mesh_t mesh);
+lob_t mesh_keys(mesh_t mesh);
+
+// generate json of mesh keys and current paths
+lob_t mesh_json(mesh_t mesh);
+
+// generate json for all links, returns lob list
+lob_t mesh_links(mesh_t mesh);
+
+// creates a link from the json format of {"hashname":"...","keys":{},"paths":[]}
+link_t mesh_add(mesh_t mesh, lob_t json);
+
+// return only if this hashname (full or short) is currently linked (in any state)
+link_t mesh_linked(mesh_t mesh, char *hn, size_t len);
+link_t mesh_linkid(mesh_t mesh, hashname_t id); // TODO, clean this up
+
+// internal, keeps the link lookup indexes current (used by link_new/link_load/link_free)
+mesh_t mesh_index(mesh_t mesh, link_t link);
+mesh_t mesh_unindex(mesh_t mesh, link_t link);
+
+// internal, keeps the heaps of links by when they're due current (used by link.c whenever that may have changed)
+mesh_t mesh_link_room(mesh_t mesh, uint32_t links); // heap space for this many links
+mesh_t mesh_link_timer(mesh_t mesh, link_t link);
+mesh_t mesh_link_drop(mesh_t mesh, link_t link);
+
+// remove this link, will event it down and clean up during next process()
+mesh_t mesh_unlink(link_t link);
+
+// processes incoming packet, it will take ownership of packet, returns link delivered to if success
+link_t mesh_receive(mesh_t mesh, lob_t packet);
+
+// same, from is the transport's address for the sender, when *reply is set it must be sent back to that address
+link_t mesh_receive_from(mesh_t mesh, lob_t packet, uint8_t *from, size_t len, lob_t *reply);
+
+// rate limit handshakes before any public key work is spent on them, options are those of util_admit_new() (NULL turns it off)
+// w/ "cookie":true a sender w/o a cookie is challenged (a *reply) and must resend its handshake echoing it, links do that automatically
+mesh_t mesh_admission(mesh_t mesh, lob_t options);
+
+// cap the bytes all channels on all links can buffer (0 for MESH_BUFFER), past it packets from either side are refused
+mesh_t mesh_buffer(mesh_t mesh, uint32_t max);
+
+// the admission step of mesh_receive_from() alone, returns a bare handshake that's admitted (NULL if not) and any other packet unchanged
+lob_t mesh_admit(mesh_t mesh, lob_t packet, uint8_t *from, size_t len, lob_t *reply);
+
+// process any unencrypted handshake packet
+link_t mesh_receive_handshake(mesh_t mesh, lob_t handshake);
+
+// the rest of mesh_receive() for a handshake decrypted elsewhere (e3x_self_decrypt), inner must have the outer linked
+// prepared is an optional dup of the sender link's exchange already verified/synced to it, takes ownership of both
+link_t mesh_receive_prepared(mesh_t mesh, lob_t inner, e3x_exchange_t prepared);
+
+// process any channel timeouts based on the current/given time
+mesh_t mesh_process(mesh_t mesh, uint32_t now);
+
+// earliest link_due() of all links, 0 if nothing is waiting on a timeout
+uint32_t mesh_due(mesh_t mesh);
+
+// a finer clock (ms) for reliable channels' resends, rtt and pacing, once it's given mesh_process() only drives the channel timeouts
+// (call it often, sends are timed by its latest now, and from the start since it can't mix w/ the now before it)
+mesh_t mesh_clock(mesh_t mesh, uint32_t now);
+
+// earliest resend or paced send due on that clock, 0 if none
+uint32_t mesh_clock_due(mesh_t mesh);
+
+// callback when the mesh is free'd
+void mesh_on_free(mesh_t mesh, char *id, void (*free)(mesh_t mesh));
+
+// callback when a path needs to be turned into a pipe
+void mesh_on_path(mesh_t mesh, char *id, link_t (*path)(link_t link, lob_t path));
+link_t mesh_path(mesh_t mesh, link_t link, lob_t path);
+
+// callback when an unknown hashname is discovered
+void mesh_on_discover(mesh_t mesh, char *id, link_t (*discover)(mesh_t mesh, lob_t discovered));
+void mesh_discover(mesh_t mesh, lob_t discovered);
+
+// callback when a link changes state created/up/down
+void mesh_on_link(mesh_t mesh, char *id, void (*link)(link_t link));
+void mesh_link(mesh_t mesh, link_t link);
+
+// callback when a new incoming channel is requested
+void mesh_on_open(mesh_t mesh, char *id, lob_t (*open)(link_t link, lob_t open));
+lob_t mesh_open(mesh_t mesh, link_t link, lob_t open);
+
+
+#endif
+// local wrappers/additions
+#include <stdint.h>
+
+// murmurhash3 32bit
+uint32_t murmur4(const uint8_t *data, uint32_t len);
+
+// hex must be 8+\0
+char *murmur8(const uint8_t *data, uint32_t len, char *hex);
+
+// more convenient, caller must ensure 4-byte sizing
+uint8_t *murmur(const uint8_t *data, uint32_t len, uint8_t *hash);
+
+
+/*-----------------------------------------------------------------------------
+ * MurmurHash3 was written by Austin Appleby, and is placed in the public
+ * domain.
+ *
+ * This implementation was written by Shane Day, and is also public domain.
+ *
+ * This is a portable ANSI C implementation of MurmurHash3_x86_32 (Murmur3A)
+ * with support for progressive processing.
+ */
+
+
+/* ------------------------------------------------------------------------- */
+/* Prototypes */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void PMurHash32_Process(uint32_t *ph1, uint32_t *pcarry, const void *key, int len);
+uint32_t PMurHash32_Result(uint32_t h1, uint32_t carry, uint32_t total_length);
+uint32_t PMurHash32(uint32_t seed, const void *key, int len);
+
+void PMurHash32_test(const void *key, int len, uint32_t seed, void *out);
+
+#ifdef __cplusplus
+}
+#endif
+#ifndef net_handshake_h
+#define net_handshake_h
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__)))
+
+#include <stdint.h>
+
+// worker threads for the public key work of incoming handshakes, so a burst of them doesn't stall channel packets
+// a handshake is decrypted on a worker, then if it's from a known link it's verified/synced on a copy of that link's exchange
+// on another pass through a worker, and only the cheap bookkeeping is left for the mesh's own thread
+typedef struct net_handshakes_struct *net_handshakes_t;
+
+// queued to completion latency, bucket i counts those under 2^i microseconds (the last one everything slower)
+#define NET_HANDSHAKES_BUCKETS 24
+
+typedef struct net_handshakes_stats_struct
+{
+  uint32_t queued, completed; // completed includes failed
+  uint32_t dropped; // pipeline was full
+  uint32_t failed; // didn't decrypt or verify
+  uint32_t pending; // in the pipeline right now
+  uint32_t latency[NET_HANDSHAKES_BUCKETS];
+} *net_handshakes_stats_t;
+
+// options are "threads" (default 1) and "depth", the most handshakes in the pipeline at once (default 256)
+net_handshakes_t net_handshakes_new(mesh_t mesh, lob_t options);
+
+// any still pending are done w/ a NULL link
+net_handshakes_t net_handshakes_free(net_handshakes_t hs);
+
+// take a received handshake (1 byte head), done is called from net_handshakes_process() w/ the sender's link or NULL if it failed
+// when the pipeline is full it's dropped (freed) and this returns NULL w/o calling done, peers resend
+net_handshakes_t net_handshakes_queue(net_handshakes_t hs, lob_t outer, void (*done)(link_t link, void *arg), void *arg);
+
+// readable when there are results for net_handshakes_process()
+int net_handshakes_fd(net_handshakes_t hs);
+
+// finish any results, must be called on the mesh's thread, returns how many were done
+uint32_t net_handshakes_process(net_handshakes_t hs);
+
+net_handshakes_stats_t net_handshakes_stats(net_handshakes_t hs);
+
+#endif // POSIX
+
+#endif // net_handshake_h
+#ifndef net_loop_h
+#define net_loop_h
+
+#if defined(__linux__)
+
+#include <stdint.h>
+
+// epoll driven event loop for a mesh and its sockets, replaces polling net_udp4_process() on a socket timeout
+// sockets are switched to non-blocking and edge-triggered, channel timeouts run from a timerfd when they come due
+// the mesh gets a ms mesh_clock() for its reliable channels' resends and pacing, mesh_process() stays in seconds
+typedef struct net_loop_struct *net_loop_t;
+
+// options are "resend":ms, how often peers still waiting to confirm frames get resent to (default 20)
+net_loop_t net_loop_new(mesh_t mesh, lob_t options);
+net_loop_t net_loop_free(net_loop_t loop);
+
+// drive this udp4 transport from the loop
+net_loop_t net_loop_udp4(net_loop_t loop, net_udp4_t udp4);
+
+// any other socket, handler is called w/ the epoll events whenever it's ready (must read/write until EAGAIN)
+net_loop_t net_loop_fd(net_loop_t loop, int fd, void (*handler)(net_loop_t loop, int fd, uint32_t events, void *arg), void *arg);
+net_loop_t net_loop_fd_drop(net_loop_t loop, int fd);
+
+// wait up to ms (-1 forever) for any activity and handle it, returns NULL on error or after net_loop_stop()
+net_loop_t net_loop_run(net_loop_t loop, int ms);
+
+// makes the current/next net_loop_run() return NULL, safe from any handler
+net_loop_t net_loop_stop(net_loop_t loop);
+
+#endif // __linux__
+
+#endif // net_loop_h
+#ifndef net_loopback_h
+#define net_loopback_h
+
+
+typedef struct net_loopback_struct
+{
+  mesh_t a, b;
+  uint32_t loss, seed; // percent of packets dropped, picked w/ a fixed seed so runs repeat
+  uint32_t sent, dropped;
+} *net_loopback_t;
+
+// connect two mesh instances with each other for packet delivery
+net_loopback_t net_loopback_new(mesh_t a, mesh_t b);
+void net_loopback_free(net_loopback_t pair);
+
+// drop this percent of packets either way (0 for none), for testing reliable channels
+net_loopback_t net_loopback_loss(net_loopback_t pair, uint32_t percent);
+
+#endif
+#ifndef net_serial_h
+#define net_serial_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+// overall server
+typedef struct net_serial_struct
+{
+  mesh_t mesh;
+  xht_t pipes;
+} *net_serial_t;
+
+// create a new serial hub
+net_serial_t net_serial_new(mesh_t mesh, lob_t options);
+void net_serial_free(net_serial_t net);
+
+// add a named serial pipe and I/O callbacks for it
+net_serial_t net_serial_add(net_serial_t net, const char *name, int (*read)(void), int (*write)(uint8_t *buf, size_t len), uint8_t buffer);
+
+// manually send a packet down a named pipe (discovery, etc)
+net_serial_t net_serial_send(net_serial_t net, const char *name, lob_t packet);
+
+// check all pipes for data
+net_serial_t net_serial_loop(net_serial_t net);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+#ifndef net_shard_h
+#define net_shard_h
+
+#if defined(__linux__)
+
+#include <stdint.h>
+
+// one hashname served by N threads, each w/ its own mesh, udp4 socket (SO_REUSEPORT on a shared port) and event loop
+// the kernel spreads peer addresses across the sockets, each link lives only in the thread that got its handshake
+// channel packets arriving at any other thread (a peer that roamed to a new address) are queued to the owner by routing token
+typedef struct net_shards_struct *net_shards_t;
+
+// options are "threads" (default one per cpu), "port" (default any) and anything for each udp4 transport
+// "mtu" defaults to 1472 so that any thread can answer an address w/o sharing frame state
+net_shards_t net_shards_new(lob_t secrets, lob_t keys, lob_t options);
+
+// stops and joins all the threads first if started
+net_shards_t net_shards_free(net_shards_t shards);
+
+// each thread's mesh, for adding handlers before starting (same hashname in all of them)
+uint32_t net_shards_count(net_shards_t shards);
+mesh_t net_shards_mesh(net_shards_t shards, uint32_t index);
+
+// runs every thread, the meshes must not be touched from outside again until freed
+net_shards_t net_shards_start(net_shards_t shards);
+
+uint16_t net_shards_port(net_shards_t shards);
+
+// totals across all threads, packets received and those queued to another thread
+uint32_t net_shards_received(net_shards_t shards);
+uint32_t net_shards_forwarded(net_shards_t shards);
+
+#endif // __linux__
+
+#endif // net_shard_h
+#ifndef net_sim_h
+#define net_sim_h
+
+
+// a simulated network between meshes on a virtual clock, the same seed and calls always play out the same
+typedef struct net_sim_struct *net_sim_t;
+typedef struct net_sim_pair_struct *net_sim_pair_t;
+
+// the conditions one way between a pair (times in clock units), and what happened to the packets sent
+typedef struct net_sim_path_struct
+{
+  uint32_t latency, jitter; // each packet takes latency plus up to jitter more
+  uint32_t bandwidth; // bytes per unit, 0 for unlimited
+  uint32_t queue; // bytes that can be waiting on the bandwidth, the rest are dropped (0 for no limit)
+  uint32_t loss, reorder, duplicate; // percent of packets dropped, held back past the ones after them, delivered twice
+  uint64_t busy; // when what's queued is done sending, in 1024ths of a unit
+  uint32_t last; // latest arrival so far, packets stay in order unless reordered
+  uint32_t sent, delivered, lost, overflowed, reordered, duplicated;
+  uint64_t bytes;
+} *net_sim_path_t;
+
+struct net_sim_pair_struct
+{
+  net_sim_t sim;
+  mesh_t a, b;
+  struct net_sim_path_struct ab, ba;
+  net_sim_pair_t next;
+};
+
+net_sim_t net_sim_new(uint32_t seed);
+// free every mesh in it first, their links still pipe through the pairs until then
+void net_sim_free(net_sim_t sim);
+
+// connect (and link) two meshes through the sim, both ways get the same conditions from options
+// {"latency":0,"jitter":0,"bandwidth":0,"queue":0,"loss":0,"reorder":0,"duplicate":0}
+net_sim_pair_t net_sim_pair(net_sim_t sim, mesh_t a, mesh_t b, lob_t options);
+
+// the path packets take from this mesh to the other one, to read or change directly
+net_sim_path_t net_sim_path(net_sim_pair_t pair, mesh_t from);
+
+// the current virtual time
+uint32_t net_sim_now(net_sim_t sim);
+
+// move the clock to the next thing due (a delivery or any mesh_due()) but not past until,
+// delivers everything due by then and runs mesh_process() on every mesh, returns the new time
+// (an until that's not past now does nothing)
+uint32_t net_sim_step(net_sim_t sim, uint32_t until);
+
+// steps until the clock gets to until
+net_sim_t net_sim_run(net_sim_t sim, uint32_t until);
+
+#endif
+#ifndef net_tcp4_h
+#define net_tcp4_h
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__)))
+
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+// overall server
+typedef struct net_tcp4_struct
+{
+  int server;
+  int port;
+  mesh_t mesh;
+  xht_t pipes;
+  lob_t path;
+} *net_tcp4_t;
+
+// create a new listening tcp server
+net_tcp4_t net_tcp4_new(mesh_t mesh, lob_t options);
+void net_tcp4_free(net_tcp4_t net);
+
+// check all sockets for work (just for testing, use libuv or such for production instead)
+net_tcp4_t net_tcp4_loop(net_tcp4_t net);
+
+#endif
+
+#endif
+#ifndef net_udp4_h
+#define net_udp4_h
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__)))
+
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+// overall server
+typedef struct net_udp4_struct *net_udp4_t;
+
+// create a new listening udp server, options are:
+//   "port"
+//   "batch":false to use one syscall per frame instead of recvmmsg/sendmmsg
+//   "mtu":1472 sends packets up to that size as single datagrams instead of 128 byte frames, both sides must set it
+//   "pipes":N keeps at most N peer addresses, evicting the least recently heard from
+//   "idle":S evicts any peer address not heard from in S seconds
+//   "reuseport":true lets several transports (one per thread) bind the same port
+net_udp4_t net_udp4_new(mesh_t mesh, lob_t options);
+net_udp4_t net_udp4_free(net_udp4_t net);
+
+// send/receive any waiting frames, delivers packets into mesh, also resends to every peer still waiting to confirm
+net_udp4_t net_udp4_process(net_udp4_t net);
+
+// same but without the resends, only handles received frames and new packets to send (for event driven use)
+net_udp4_t net_udp4_receive(net_udp4_t net);
+
+// returns net when new packets are queued and need a receive/process, or sent ones are awaiting confirmation and need a process
+net_udp4_t net_udp4_pending(net_udp4_t net);
+net_udp4_t net_udp4_awaiting(net_udp4_t net);
+
+// return server socket handle / port
+int net_udp4_socket(net_udp4_t net);
+uint16_t net_udp4_port(net_udp4_t net);
+
+// received packets go to this instead of mesh_receive(), it returns the sender's link if any (to send replies via this address)
+net_udp4_t net_udp4_receiver(net_udp4_t net, link_t (*receive)(net_udp4_t net, lob_t packet, struct sockaddr_in *from, void *arg), void *arg);
+
+// process a packet as if it was received from this address (skips any receiver), replies go back out this transport
+net_udp4_t net_udp4_deliver(net_udp4_t net, lob_t packet, struct sockaddr_in *from);
+
+// the address bytes given to mesh_receive_from()/mesh_admit() for a sender (6, the ip and port)
+uint8_t *net_udp4_address(struct sockaddr_in *sa, uint8_t *address);
+
+// queue a packet to this address, for a receiver to send a reply w/o a link (like mesh_receive_from()'s)
+net_udp4_t net_udp4_reply(net_udp4_t net, lob_t packet, struct sockaddr_in *to);
+
+// received handshakes are queued to these workers (not w/ a receiver), and finished in net_udp4_receive/process
+// the workers must be freed before this transport, NULL detaches them
+net_udp4_t net_udp4_handshakes(net_udp4_t net, net_handshakes_t hs);
+
+// number of peer addresses currently tracked
+uint32_t net_udp4_pipes(net_udp4_t net);
+
+// send a packet directly
+net_udp4_t net_udp4_direct(net_udp4_t net, lob_t packet, char *ip, uint16_t port);
+
+#endif // POSIX
+
+#endif // net_udp4_h
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  // use old api
+/**
+ * \brief          Output = SHA-256( input buffer )
+ *
+ * \param input    buffer holding the  data
+ * \param ilen     length of the input data
+ * \param output   SHA-224/256 checksum result
+ * \param is224    0 = use SHA256, 1 = use SHA224
+ */
+void sha256( const unsigned char *input, size_t ilen,
+           unsigned char output[32], int is224 );
+
+/**
+ * \brief          Output = HMAC-SHA-256( hmac key, input buffer )
+ *
+ * \param key      HMAC secret key
+ * \param keylen   length of the HMAC key
+ * \param input    buffer holding the  data
+ * \param ilen     length of the input data
+ * \param output   HMAC-SHA-224/256 result
+ * \param is224    0 = use SHA256, 1 = use SHA224
+ */
+void sha256_hmac( const unsigned char *key, size_t keylen,
+                  const unsigned char *input, size_t ilen,
+                  unsigned char output[32], int is224 );
+
+void hmac_256(const unsigned char *key, size_t keylen,
+                  const unsigned char *input, size_t ilen,
+                  unsigned char output[32]);
+
+// a key w/ its inner and outer pad blocks already hashed, for MAC'ing many messages under the same one
+typedef struct hmac_256_struct
+{
+  uint32_t istate[8], ostate[8];
+} *hmac_256_t;
+
+void hmac_256_key(hmac_256_t hmac, const unsigned char *key, size_t keylen);
+void hmac_256_keyed(hmac_256_t hmac, const unsigned char *input, size_t ilen, unsigned char output[32]);
+
+// the x86 SHA extensions are used whenever the cpu has them, this turns them off (0) or back on, returns if they're in use
+unsigned char sha256_hw(unsigned char enable);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* sha256.h */
+#ifndef socketio_h
+#define socketio_h
+
+// utilities to parse and generate minimal socket.io / engine.io packets
+
+#include <stdint.h>
+
+// https://github.com/Automattic/engine.io-protocol
+#define SOCKETIO_ETYPE_OPEN 0
+#define SOCKETIO_ETYPE_CLOSE 1
+#define SOCKETIO_ETYPE_PING 2
+#define SOCKETIO_ETYPE_PONG 3
+#define SOCKETIO_ETYPE_MESSAGE 4
+#define SOCKETIO_ETYPE_UPGRADE 5
+#define SOCKETIO_ETYPE_NOOP 6
+
+// https://github.com/Automattic/socket.io-protocol
+#define SOCKETIO_PTYPE_CONNECT 0
+#define SOCKETIO_PTYPE_DISCONNECT 1
+#define SOCKETIO_PTYPE_EVENT 2
+#define SOCKETIO_PTYPE_ACK 3
+#define SOCKETIO_PTYPE_ERROR 4
+#define SOCKETIO_PTYPE_BINARY_EVENT 5
+#define SOCKETIO_PTYPE_BINARY_ACK 6
+
+
+lob_t socketio_decode(lob_t data);
+
+lob_t socketio_encode(uint8_t etype, uint8_t ptype, lob_t payload);
+
+#endif
+#ifndef telehash_h
+#define telehash_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+#ifndef tmesh_h
+#define tmesh_h
+
+#include <stdbool.h>
+
+/*
+
+tempo_t is a synchronized comm thread
+every tempo has a medium id that identifies the transceiver details
+all tempos belong to a mote->community for grouping
+two types of tempos: signals and streams
+motes have one constant signal tempo and on-demand stream tempos
+signal tempo
+  - use shared secrets across the community
+  - can be lost signal, derived secret and no neighbors
+  - signal tempo should use limited medium to ease syncing
+  - include neighbor info and stream requests
+  - either side initiates stream tempo
+  - 6*10-block format, +4 mmh
+    - neighbors (+rssi)
+    - stream req (+repeat)
+    - signals (+hops)
+stream tempo
+  - use one-time secrets
+  - initiated from signals
+  - frames only
+  - flush meta space for app use
+  - inside channel sent link signal sync
+
+mediums
+  - limit # of channels
+  - set rx tolerance
+  - indicate power/lna for rssi comparisons
+  - tm->tempo(tempo), sets window min/max, can change secret
+
+stream tempos are lost until first rx
+lost streams are reset each signal
+lost signal hash is 8+50+4 w/ hash of just 50, rx can detect difference
+!signal->lost after first good rx
+must be commanded to change tx signal->lost, scheduled along w/ medium change
+
+stream hold/lost/idle states
+  * hold means don't schedule
+  * idle means don't signal, dont schedule TX but do schedule RX (if !hold)
+  * lost means signal (if !idle), hold = request, !hold || mote->signal->lost = accept
+    - TX/RX signal accept is stream resync event
+  - idle is cleared on any new send data, set after any TX/RX if !ready && !await
+  - mote_gone() called by the driver based on missed RX, sets lost if !idle, hold if idle
+
+TODO, move flags to explicit vs implicit:
+  * do_schedule and !do_schedule
+    - skip TX if !ready && !awaiting
+    - set true on any new data
+  * do_signal and !do_signal
+    - do_schedule = true if mote->signal->lost
+    - request if !do_schedule, else accept
+  * mote_gone() called by the driver based on missed RX
+    - sets do_schedule = false
+    - sets do_signal = true if ready||awaiting
+
+beacon > lost
+  * tm->beacon alongside tm->signal
+  * beacon is a stream, always starts w/ meta frame
+    * meta contains sender nickname to ignore once linked (just for now, future is random id)
+  * when no motes, beacon uses fast medium, if any other mote it goes slow
+  * signal is off or slow when beaconing
+  * only beacon open rx seeks
+  * when mote looses signal it drops entirely, beacon goes fast
+    * if stream request is not accepted in X signals, also drop
+  * streams just go idle (not lost), low priori rx skip tx
+  * after beacon stream exchanges handshake
+    * start our signal to include in stream
+    * create mote
+    * move beacon to mote as stream
+    * reset beacon after link is up
+    * create their signal once received in stream meta
+  * when routed packet is requested on a stream
+    * cache from who on outgoing stream
+    * include orig sender's full blocks in stream meta
+    * faster way to establish signal to neighbor than waiting for slow beacon
+
+... more notes
+  * beacon (signal) advertises its shared stream
+  * shared stream uses beacon id in secret to be unique
+  * all tempo keys roll community name + other stuff + password
+
+SECURITY TODOs
+  * generate a temp hashname on boot, use that to do all beacon and shared stream handling
+
+NEXT
+  * use ad-hoc beacons for faster signal stream request/accept
+
+*/
+
+typedef struct tmesh_struct *tmesh_t; // joined community motes/signals
+typedef struct mote_struct *mote_t; // local link info, signal and list of stream tempos
+typedef struct tempo_struct *tempo_t; // single tempo, is a signal or stream
+typedef struct knock_struct *knock_t; // single txrx action
+
+// overall tmesh manager
+struct tmesh_struct
+{
+  mesh_t mesh;
+  uint32_t at; // last known
+  
+  // community deets
+  char *community;
+  char *password; // optional
+  mote_t motes;
+  tempo_t signal; // outgoing signal, unique to us
+  tempo_t stream; // have an always-running shared stream, keyed from beacon for handshakes, RX for alerts
+  tempo_t beacon; // only one of these, advertises our shared stream
+  uint32_t route; // available for app-level routing logic
+
+  // driver interface
+  tempo_t (*sort)(tmesh_t tm, tempo_t a, tempo_t b);
+  tmesh_t (*schedule)(tmesh_t tm); // called whenever a new knock is ready to be scheduled
+  tmesh_t (*advance)(tmesh_t tm, tempo_t tempo, uint8_t seed[8]); // advances tempo to next window
+  tmesh_t (*medium)(tmesh_t tm, tempo_t tempo, uint8_t seed[8], uint32_t medium); // driver can initialize/update a tempo's medium
+  tmesh_t (*accept)(tmesh_t tm, hashname_t id, uint32_t route); // driver handles new neighbors, returns tm to continue or NULL to ignore
+  tmesh_t (*free)(tmesh_t tm, tempo_t tempo); // driver can free any associated tempo resources
+  knock_t knock;
+  
+  uint8_t seen[5]; // recently seen short hn from a beacon
+};
+
+// join a new tmesh community, pass optional
+tmesh_t tmesh_new(mesh_t mesh, char *name, char *pass);
+tmesh_t tmesh_free(tmesh_t tm);
+
+// process knock that has been completed by a driver
+// returns a tempo when successful rx in case there's new packets available
+tempo_t tmesh_knocked(tmesh_t tm);
+
+// at based on current cycle count since start or last rebase
+tmesh_t tmesh_schedule(tmesh_t tm, uint32_t at);
+
+// call before a schedule to rebase (subtract) given cycles off all at's (to prevent overflow)
+tmesh_t tmesh_rebase(tmesh_t tm, uint32_t at);
+
+// returns mote for this link, creating one if a stream is provided
+mote_t tmesh_mote(tmesh_t tm, link_t link);
+
+// drops and free's this mote (link just goes to down state if no other paths)
+tmesh_t tmesh_demote(tmesh_t tm, mote_t mote);
+
+// returns mote for this id if one exists
+mote_t tmesh_moted(tmesh_t tm, hashname_t id);
+
+// update/signal our current route value
+tmesh_t tmesh_route(tmesh_t tm, uint32_t route);
+
+// tempo state
+struct tempo_struct
+{
+  tmesh_t tm; // mostly convenience
+  mote_t mote; // parent mote (except for our outgoing signal) 
+  void *driver; // for driver use, set during tm->tempo()
+  util_frames_t frames; // r/w frame buffers for streams
+  uint32_t qos_remote, qos_local; // last qos from/about this tempo
+  uint32_t medium; // id
+  uint32_t at; // cycles until next knock in current window
+  uint32_t seq; // window increment part of nonce
+  uint16_t c_tx, c_rx; // current counts
+  uint16_t c_bad; // dropped bad frames
+  int16_t last, best, worst; // rssi
+  uint8_t secret[32];
+  uint8_t c_miss, c_skip, c_idle; // how many of the last rx windows were missed (expected), skipped (scheduling), or idle
+  uint8_t chan; // channel of next knock
+  uint8_t priority; // next knock priority
+  // a byte of state flags for each tempo type
+  union
+  {
+    struct
+    {
+      uint8_t is_signal:1;
+      uint8_t unused1:1;
+      uint8_t qos_ping:1;
+      uint8_t qos_pong:1;
+      uint8_t seen:1; // beacon only
+      uint8_t adhoc:1;
+    };
+    struct
+    {
+      uint8_t unused2:1;
+      uint8_t is_stream:1;
+      uint8_t requesting:1;
+      uint8_t accepting:1;
+      uint8_t direction:1; // 1==TX, 0==RX
+    };
+  } state;
+};
+
+// a single convenient knock request ready to go
+struct knock_struct
+{
+  tempo_t tempo;
+  uint32_t adhoc; // request driver to do an adhoc tx(immediate) or rx(seek until)
+  uint32_t started, stopped; // actual times
+  int16_t rssi, snr; // set by driver only after rx
+  uint8_t frame[64];
+  uint8_t nonce[8]; // convenience
+  // boolean flags for state tracking, etc
+  uint8_t is_active:1; // is actively transceiving
+  uint8_t is_tx:1; // current window direction (copied from tempo for convenience)
+  uint8_t do_err:1; // driver sets if failed
+  uint8_t do_gone:1; // driver sets to fail the signal/stream
+};
+
+// mote state tracking
+struct mote_struct
+{
+  mote_t next; // for lists
+  mote_t via; // router mote
+  tmesh_t tm;
+  link_t link;
+  tempo_t signal; // tracks their signal
+  tempo_t stream; // is a private stream, optionally can track their shared stream (TODO)
+  uint32_t route; // most recent route block from them
+};
+
+// return current mote appid
+uint32_t mote_appid(mote_t mote);
+
+// find a stream to send it to for this mote
+mote_t mote_send(mote_t mote, lob_t packet);
+
+// send this packet to this id via this router
+mote_t mote_route(mote_t router, hashname_t to, lob_t packet);
+
+
+#endif
+/* Copyright 2014, Kenneth MacKay. Licensed under the BSD 2-clause license. */
+
+#ifndef _UECC_H_
+#define _UECC_H_
+
+#include <stdint.h>
+
+/* Platform selection options.
+If uECC_PLATFORM is not defined, the code will try to guess it based on compiler macros.
+Possible values for uECC_PLATFORM are defined below: */
+#define uECC_arch_other 0
+#define uECC_x86        1
+#define uECC_x86_64     2
+#define uECC_arm        3
+#define uECC_arm_thumb  4
+#define uECC_arm_thumb2 5
+#define uECC_arm64      6
+#define uECC_avr        7
+
+/* If desired, you can define uECC_WORD_SIZE as appropriate for your platform (1, 4, or 8 bytes).
+If uECC_WORD_SIZE is not explicitly defined then it will be automatically set based on your
+platform. */
+
+/* Optimization level; trade speed for code size.
+   Larger values produce code that is faster but larger.
+   Currently supported values are 0 - 3; 0 is unusably slow for most applications. */
+#ifndef uECC_OPTIMIZATION_LEVEL
+    #define uECC_OPTIMIZATION_LEVEL 2
+#endif
+
+/* uECC_SQUARE_FUNC - If enabled (defined as nonzero), this will cause a specific function to be
+used for (scalar) squaring instead of the generic multiplication function. This can make things
+faster somewhat faster, but increases the code size. */
+#ifndef uECC_SQUARE_FUNC
+    #define uECC_SQUARE_FUNC 0
+#endif
+
+/* uECC_VLI_NATIVE_LITTLE_ENDIAN - If enabled (defined as nonzero), this will switch to native
+little-endian format for *all* arrays passed in and out of the public API. This includes public 
+and private keys, shared secrets, signatures and message hashes. 
+Using this switch reduces the amount of call stack memory used by uECC, since less intermediate
+translations are required. 
+Note that this will *only* work on native little-endian processors and it will treat the uint8_t
+arrays passed into the public API as word arrays, therefore requiring the provided byte arrays 
+to be word aligned on architectures that do not support unaligned accesses. */
+#ifndef uECC_VLI_NATIVE_LITTLE_ENDIAN
+    #define uECC_VLI_NATIVE_LITTLE_ENDIAN 0
+#endif
+
+/* Curve support selection. Set to 0 to remove that curve. */
+#ifndef uECC_SUPPORTS_secp160r1
+    #define uECC_SUPPORTS_secp160r1 1
+#endif
+#ifndef uECC_SUPPORTS_secp192r1
+    #define uECC_SUPPORTS_secp192r1 0
+#endif
+#ifndef uECC_SUPPORTS_secp224r1
+    #define uECC_SUPPORTS_secp224r1 0
+#endif
+#ifndef uECC_SUPPORTS_secp256r1
+    #define uECC_SUPPORTS_secp256r1 1
+#endif
+#ifndef uECC_SUPPORTS_secp256k1
+    #define uECC_SUPPORTS_secp256k1 1
+#endif
+
+/* Specifies whether compressed point format is supported.
+   Set to 0 to disable point compression/decompression functions. */
+#ifndef uECC_SUPPORT_COMPRESSED_POINT
+    #define uECC_SUPPORT_COMPRESSED_POINT 1
+#endif
+
+/* uECC_FIXED_BASE - If enabled (defined as nonzero), uECC_precompute() can build a table of
+multiples of a curve's generator point, after which key generation and signing on that curve
+use a constant-time fixed-window lookup into it instead of the generic ladder. A table takes
+8 public keys worth of memory per 4 bits of curve order (32KB for secp256r1), and room is
+reserved for uECC_FIXED_BASE_CURVES of them. */
+#ifndef uECC_FIXED_BASE
+    #define uECC_FIXED_BASE 0
+#endif
+#ifndef uECC_FIXED_BASE_CURVES
+    #define uECC_FIXED_BASE_CURVES 2
+#endif
+
+/* uECC_BATCH_SIZE - How many signatures uECC_verify_batch() works on at once. Each one takes
+about 10 public keys worth of stack, and the inversions mod p are shared across all of them. */
+#ifndef uECC_BATCH_SIZE
+    #define uECC_BATCH_SIZE 8
+#endif
+
+struct uECC_Curve_t;
+typedef const struct uECC_Curve_t * uECC_Curve;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if uECC_SUPPORTS_secp160r1
+uECC_Curve uECC_secp160r1(void);
+#endif
+#if uECC_SUPPORTS_secp192r1
+uECC_Curve uECC_secp192r1(void);
+#endif
+#if uECC_SUPPORTS_secp224r1
+uECC_Curve uECC_secp224r1(void);
+#endif
+#if uECC_SUPPORTS_secp256r1
+uECC_Curve uECC_secp256r1(void);
+#endif
+#if uECC_SUPPORTS_secp256k1
+uECC_Curve uECC_secp256k1(void);
+#endif
+
+/* uECC_RNG_Function type
+The RNG function should fill 'size' random bytes into 'dest'. It should return 1 if
+'dest' was filled with random data, or 0 if the random data could not be generated.
+The filled-in values should be either truly random, or from a cryptographically-secure PRNG.
+
+A correctly functioning RNG function must be set (using uECC_set_rng()) before calling
+uECC_make_key() or uECC_sign().
+
+Setting a correctly functioning RNG function improves the resistance to side-channel attacks
+for uECC_shared_secret() and uECC_sign_deterministic().
+
+A correct RNG function is set by default when building for Windows, Linux, or OS X.
+If you are building on another POSIX-compliant system that supports /dev/random or /dev/urandom,
+you can define uECC_POSIX to use the predefined RNG. For embedded platforms there is no predefined
+RNG function; you must provide your own.
+*/
+typedef int (*uECC_RNG_Function)(uint8_t *dest, unsigned size);
+
+/* uECC_set_rng() function.
+Set the function that will be used to generate random bytes. The RNG function should
+return 1 if the random data was generated, or 0 if the random data could not be generated.
+
+On platforms where there is no predefined RNG function (eg embedded platforms), this must
+be called before uECC_make_key() or uECC_sign() are used.
+
+Inputs:
+    rng_function - The function that will be used to generate random bytes.
+*/
+void uECC_set_rng(uECC_RNG_Function rng_function);
+
+/* uECC_get_rng() function.
+
+Returns the function that will be used to generate random bytes.
+*/
+uECC_RNG_Function uECC_get_rng(void);
+
+/* uECC_curve_private_key_size() function.
+
+Returns the size of a private key for the curve in bytes.
+*/
+int uECC_curve_private_key_size(uECC_Curve curve);
+
+/* uECC_curve_public_key_size() function.
+
+Returns the size of a public key for the curve in bytes.
+*/
+int uECC_curve_public_key_size(uECC_Curve curve);
+
+/* uECC_make_key() function.
+Create a public/private key pair.
+
+Outputs:
+    public_key  - Will be filled in with the public key. Must be at least 2 * the curve size
+                  (in bytes) long. For example, if the curve is secp256r1, public_key must be 64
+                  bytes long.
+    private_key - Will be filled in with the private key. Must be as long as the curve order; this
+                  is typically the same as the curve size, except for secp160r1. For example, if the
+                  curve is secp256r1, private_key must be 32 bytes long.
+
+                  For secp160r1, private_key must be 21 bytes long! Note that the first byte will
+                  almost always be 0 (there is about a 1 in 2^80 chance of it being non-zero).
+
+Returns 1 if the key pair was generated successfully, 0 if an error occurred.
+*/
+int uECC_make_key(uint8_t *public_key, uint8_t *private_key, uECC_Curve curve);
+
+/* uECC_shared_secret() function.
+Compute a shared secret given your secret key and someone else's public key.
+Note: It is recommended that you hash the result of uECC_shared_secret() before using it for
+symmetric encryption or HMAC.
+
+Inputs:
+    public_key  - The public key of the remote party.
+    private_key - Your private key.
+
+Outputs:
+    secret - Will be filled in with the shared secret value. Must be the same size as the
+             curve size; for example, if the curve is secp256r1, secret must be 32 bytes long.
+
+Returns 1 if the shared secret was generated successfully, 0 if an error occurred.
+*/
+int uECC_shared_secret(const uint8_t *public_key,
+                       const uint8_t *private_key,
+                       uint8_t *secret,
+                       uECC_Curve curve);
+
+#if uECC_SUPPORT_COMPRESSED_POINT
+/* uECC_compress() function.
+Compress a public key.
+
+Inputs:
+    public_key - The public key to compress.
+
+Outputs:
+    compressed - Will be filled in with the compressed public key. Must be at least
+                 (curve size + 1) bytes long; for example, if the curve is secp256r1,
+                 compressed must be 33 bytes long.
+*/
+void uECC_compress(const uint8_t *public_key, uint8_t *compressed, uECC_Curve curve);
+
+/* uECC_decompress() function.
+Decompress a compressed public key.
+
+Inputs:
+    compressed - The compressed public key.
+
+Outputs:
+    public_key - Will be filled in with the decompressed public key.
+*/
+void uECC_decompress(const uint8_t *compressed, uint8_t *public_key, uECC_Curve curve);
+#endif /* uECC_SUPPORT_COMPRESSED_POINT */
+
+/* uECC_valid_public_key() function.
+Check to see if a public key is valid.
+
+Note that you are not required to check for a valid public key before using any other uECC
+functions. However, you may wish to avoid spending CPU time computing a shared secret or
+verifying a signature using an invalid public key.
+
+Inputs:
+    public_key - The public key to check.
+
+Returns 1 if the public key is valid, 0 if it is invalid.
+*/
+int uECC_valid_public_key(const uint8_t *public_key, uECC_Curve curve);
+
+/* uECC_compute_public_key() function.
+Compute the corresponding public key for a private key.
+
+Inputs:
+    private_key - The private key to compute the public key for
+
+Outputs:
+    public_key - Will be filled in with the corresponding public key
+
+Returns 1 if the key was computed successfully, 0 if an error occurred.
+*/
+int uECC_compute_public_key(const uint8_t *private_key, uint8_t *public_key, uECC_Curve curve);
+
+/* uECC_precompute() function.
+Build the fixed-base table for a curve (see uECC_FIXED_BASE) so that uECC_make_key(),
+uECC_compute_public_key() and uECC_sign() on it are faster. It is not thread safe, call it
+once at startup before using the curve.
+
+Returns 1 if the table is ready, 0 if uECC_FIXED_BASE is disabled or all the tables are in use.
+*/
+int uECC_precompute(uECC_Curve curve);
+
+/* uECC_sign() function.
+Generate an ECDSA signature for a given hash value.
+
+Usage: Compute a hash of the data you wish to sign (SHA-2 is recommended) and pass it in to
+this function along with your private key.
+
+Inputs:
+    private_key  - Your private key.
+    message_hash - The hash of the message to sign.
+    hash_size    - The size of message_hash in bytes.
+
+Outputs:
+    signature - Will be filled in with the signature value. Must be at least 2 * curve size long.
+                For example, if the curve is secp256r1, signature must be 64 bytes long.
+
+Returns 1 if the signature generated successfully, 0 if an error occurred.
+*/
+int uECC_sign(const uint8_t *private_key,
+              const uint8_t *message_hash,
+              unsigned hash_size,
+              uint8_t *signature,
+              uECC_Curve curve);
+
+/* uECC_HashContext structure.
+This is used to pass in an arbitrary hash function to uECC_sign_deterministic().
+The structure will be used for multiple hash computations; each time a new hash
+is computed, init_hash() will be called, followed by one or more calls to
+update_hash(), and finally a call to finish_hash() to produce the resulting hash.
+
+The intention is that you will create a structure that includes uECC_HashContext
+followed by any hash-specific data. For example:
+
+typedef struct SHA256_HashContext {
+    uECC_HashContext uECC;
+    SHA256_CTX ctx;
+} SHA256_HashContext;
+
+void init_SHA256(uECC_HashContext *base) {
+    SHA256_HashContext *context = (SHA256_HashContext *)base;
+    SHA256_Init(&context->ctx);
+}
+
+void update_SHA256(uECC_HashContext *base,
+                   const uint8_t *message,
+                   unsigned message_size) {
+    SHA256_HashContext *context = (SHA256_HashContext *)base;
+    SHA256_Update(&context->ctx, message, message_size);
+}
+
+void finish_SHA256(uECC_HashContext *base, uint8_t *hash_result) {
+    SHA256_HashContext *context = (SHA256_HashContext *)base;
+    SHA256_Final(hash_result, &context->ctx);
+}
+
+... when signing ...
+{
+    uint8_t tmp[32 + 32 + 64];
+    SHA256_HashContext ctx = {{&init_SHA256, &update_SHA256, &finish_SHA256, 64, 32, tmp}};
+    uECC_sign_deterministic(key, message_hash, &ctx.uECC, signature);
+}
+*/
+typedef struct uECC_HashContext {
+    void (*init_hash)(const struct uECC_HashContext *context);
+    void (*update_hash)(const struct uECC_HashContext *context,
+                        const uint8_t *message,
+                        unsigned message_size);
+    void (*finish_hash)(const struct uECC_HashContext *context, uint8_t *hash_result);
+    unsigned block_size; /* Hash function block size in bytes, eg 64 for SHA-256. */
+    unsigned result_size; /* Hash function result size in bytes, eg 32 for SHA-256. */
+    uint8_t *tmp; /* Must point to a buffer of at least (2 * result_size + block_size) bytes. */
+} uECC_HashContext;
+
+/* uECC_sign_deterministic() function.
+Generate an ECDSA signature for a given hash value, using a deterministic algorithm
+(see RFC 6979). You do not need to set the RNG using uECC_set_rng() before calling
+this function; however, if the RNG is defined it will improve resistance to side-channel
+attacks.
+
+Usage: Compute a hash of the data you wish to sign (SHA-2 is recommended) and pass it to
+this function along with your private key and a hash context. Note that the message_hash
+does not need to be computed with the same hash function used by hash_context.
+
+Inputs:
+    private_key  - Your private key.
+    message_hash - The hash of the message to sign.
+    hash_size    - The size of message_hash in bytes.
+    hash_context - A hash context to use.
+
+Outputs:
+    signature - Will be filled in with the signature value.
+
+Returns 1 if the signature generated successfully, 0 if an error occurred.
+*/
+int uECC_sign_deterministic(const uint8_t *private_key,
+                            const uint8_t *message_hash,
+                            unsigned hash_size,
+                            const uECC_HashContext *hash_context,
+                            uint8_t *signature,
+                            uECC_Curve curve);
+
+/* uECC_verify() function.
+Verify an ECDSA signature.
+
+Usage: Compute the hash of the signed data using the same hash as the signer and
+pass it to this function along with the signer's public key and the signature values (r and s).
+
+Inputs:
+    public_key   - The signer's public key.
+    message_hash - The hash of the signed data.
+    hash_size    - The size of message_hash in bytes.
+    signature    - The signature value.
+
+Returns 1 if the signature is valid, 0 if it is invalid.
+*/
+int uECC_verify(const uint8_t *public_key,
+                const uint8_t *message_hash,
+                unsigned hash_size,
+                const uint8_t *signature,
+                uECC_Curve curve);
+
+/* uECC_verify_batch() function.
+Verify a number of ECDSA signatures on the same curve, each the same as uECC_verify() would.
+ECDSA signatures can't be combined into one check (only r, the x coordinate of each signer's
+point, is known), so they are verified separately but the two inversions mod p each one
+needs are done together, two inversions per uECC_BATCH_SIZE signatures instead.
+
+Inputs:
+    public_keys    - The signer's public key for each signature.
+    message_hashes - The hash of the signed data for each signature.
+    hash_size      - The size of every message hash in bytes.
+    signatures     - The signature values.
+    count          - How many signatures there are.
+
+Outputs:
+    results - Set to 1 for each valid signature, 0 for each invalid one.
+
+Returns the number of valid signatures.
+*/
+int uECC_verify_batch(const uint8_t * const *public_keys,
+                      const uint8_t * const *message_hashes,
+                      unsigned hash_size,
+                      const uint8_t * const *signatures,
+                      unsigned count,
+                      uint8_t *results,
+                      uECC_Curve curve);
+
+#ifdef __cplusplus
+} /* end of extern "C" */
+#endif
+
+#endif /* _UECC_H_ */
+/* Copyright 2015, Kenneth MacKay. Licensed under the BSD 2-clause license. */
+
+#ifndef _UECC_TYPES_H_
+#define _UECC_TYPES_H_
+
+#ifndef uECC_PLATFORM
+    #if __AVR__
+        #define uECC_PLATFORM uECC_avr
+    #elif defined(__thumb2__) || defined(_M_ARMT) /* I think MSVC only supports Thumb-2 targets */
+        #define uECC_PLATFORM uECC_arm_thumb2
+    #elif defined(__thumb__)
+        #define uECC_PLATFORM uECC_arm_thumb
+    #elif defined(__arm__) || defined(_M_ARM)
+        #define uECC_PLATFORM uECC_arm
+    #elif defined(__aarch64__)
+        #define uECC_PLATFORM uECC_arm64
+    #elif defined(__i386__) || defined(_M_IX86) || defined(_X86_) || defined(__I86__)
+        #define uECC_PLATFORM uECC_x86
+    #elif defined(__amd64__) || defined(_M_X64)
+        #define uECC_PLATFORM uECC_x86_64
+    #else
+        #define uECC_PLATFORM uECC_arch_other
+    #endif
+#endif
+
+#ifndef uECC_WORD_SIZE
+    #if uECC_PLATFORM == uECC_avr
+        #define uECC_WORD_SIZE 1
+    #elif (uECC_PLATFORM == uECC_x86_64 || uECC_PLATFORM == uECC_arm64)
+        #define uECC_WORD_SIZE 8
+    #else
+        #define uECC_WORD_SIZE 4
+    #endif
+#endif
+
+#if (uECC_WORD_SIZE != 1) && (uECC_WORD_SIZE != 4) && (uECC_WORD_SIZE != 8)
+    #error "Unsupported value for uECC_WORD_SIZE"
+#endif
+
+#if ((uECC_PLATFORM == uECC_avr) && (uECC_WORD_SIZE != 1))
+    #pragma message ("uECC_WORD_SIZE must be 1 for AVR")
+    #undef uECC_WORD_SIZE
+    #define uECC_WORD_SIZE 1
+#endif
+
+#if ((uECC_PLATFORM == uECC_arm || uECC_PLATFORM == uECC_arm_thumb || \
+        uECC_PLATFORM ==  uECC_arm_thumb2) && \
+     (uECC_WORD_SIZE != 4))
+    #pragma message ("uECC_WORD_SIZE must be 4 for ARM")
+    #undef uECC_WORD_SIZE
+    #define uECC_WORD_SIZE 4
+#endif
+
+#if defined(__SIZEOF_INT128__) || ((__clang_major__ * 100 + __clang_minor__) >= 302)
+    #define SUPPORTS_INT128 1
+#else
+    #define SUPPORTS_INT128 0
+#endif
+
+typedef int8_t wordcount_t;
+typedef int16_t bitcount_t;
+typedef int8_t cmpresult_t;
+
+#if (uECC_WORD_SIZE == 1)
+
+typedef uint8_t uECC_word_t;
+typedef uint16_t uECC_dword_t;
+
+#define HIGH_BIT_SET 0x80
+#define uECC_WORD_BITS 8
+#define uECC_WORD_BITS_SHIFT 3
+#define uECC_WORD_BITS_MASK 0x07
+
+#elif (uECC_WORD_SIZE == 4)
+
+typedef uint32_t uECC_word_t;
+typedef uint64_t uECC_dword_t;
+
+#define HIGH_BIT_SET 0x80000000
+#define uECC_WORD_BITS 32
+#define uECC_WORD_BITS_SHIFT 5
+#define uECC_WORD_BITS_MASK 0x01F
+
+#elif (uECC_WORD_SIZE == 8)
+
+typedef uint64_t uECC_word_t;
+#if SUPPORTS_INT128
+typedef unsigned __int128 uECC_dword_t;
+#endif
+
+#define HIGH_BIT_SET 0x8000000000000000ull
+#define uECC_WORD_BITS 64
+#define uECC_WORD_BITS_SHIFT 6
+#define uECC_WORD_BITS_MASK 0x03F
+
+#endif /* uECC_WORD_SIZE */
+
+#endif /* _UECC_TYPES_H_ */
+/* Copyright 2015, Kenneth MacKay. Licensed under the BSD 2-clause license. */
+
+#ifndef _UECC_VLI_H_
+#define _UECC_VLI_H_
+
+
+/* Functions for raw large-integer manipulation. These are only available
+   if uECC.c is compiled with uECC_ENABLE_VLI_API defined to 1. */
+#ifndef uECC_ENABLE_VLI_API
+    #define uECC_ENABLE_VLI_API 0
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if uECC_ENABLE_VLI_API
+
+void uECC_vli_clear(uECC_word_t *vli, wordcount_t num_words);
+
+/* Constant-time comparison to zero - secure way to compare long integers */
+/* Returns 1 if vli == 0, 0 otherwise. */
+uECC_word_t uECC_vli_isZero(const uECC_word_t *vli, wordcount_t num_words);
+
+/* Returns nonzero if bit 'bit' of vli is set. */
+uECC_word_t uECC_vli_testBit(const uECC_word_t *vli, bitcount_t bit);
+
+/* Counts the number of bits required to represent vli. */
+bitcount_t uECC_vli_numBits(const uECC_word_t *vli, const wordcount_t max_words);
+
+/* Sets dest = src. */
+void uECC_vli_set(uECC_word_t *dest, const uECC_word_t *src, wordcount_t num_words);
+
+/* Constant-time comparison function - secure way to compare long integers */
+/* Returns one if left == right, zero otherwise */
+uECC_word_t uECC_vli_equal(const uECC_word_t *left,
+                           const uECC_word_t *right,
+                           wordcount_t num_words);
+
+/* Constant-time comparison function - secure way to compare long integers */
+/* Returns sign of left - right, in constant time. */
+cmpresult_t uECC_vli_cmp(const uECC_word_t *left, const uECC_word_t *right, wordcount_t num_words);
+
+/* Computes vli = vli >> 1. */
+void uECC_vli_rshift1(uECC_word_t *vli, wordcount_t num_words);
+
+/* Computes result = left + right, returning carry. Can modify in place. */
+uECC_word_t uECC_vli_add(uECC_word_t *result,
+                         const uECC_word_t *left,
+                         const uECC_word_t *right,
+                         wordcount_t num_words);
+
+/* Computes result = left - right, returning borrow. Can modify in place. */
+uECC_word_t uECC_vli_sub(uECC_word_t *result,
+                         const uECC_word_t *left,
+                         const uECC_word_t *right,
+                         wordcount_t num_words);
+
+/* Computes result = left * right. Result must be 2 * num_words long. */
+void uECC_vli_mult(uECC_word_t *result,
+                   const uECC_word_t *left,
+                   const uECC_word_t *right,
+                   wordcount_t num_words);
+
+/* Computes result = left^2. Result must be 2 * num_words long. */
+void uECC_vli_square(uECC_word_t *result, const uECC_word_t *left, wordcount_t num_words);
+
+/* Computes result = (left + right) % mod.
+   Assumes that left < mod and right < mod, and that result does not overlap mod. */
+void uECC_vli_modAdd(uECC_word_t *result,
+                     const uECC_word_t *left,
+                     const uECC_word_t *right,
+                     const uECC_word_t *mod,
+                     wordcount_t num_words);
+
+/* Computes result = (left - right) % mod.
+   Assumes that left < mod and right < mod, and that result does not overlap mod. */
+void uECC_vli_modSub(uECC_word_t *result,
+                     const uECC_word_t *left,
+                     const uECC_word_t *right,
+                     const uECC_word_t *mod,
+                     wordcount_t num_words);
+
+/* Computes result = product % mod, where product is 2N words long.
+   Currently only designed to work for mod == curve->p or curve_n. */
+void uECC_vli_mmod(uECC_word_t *result,
+                   uECC_word_t *product,
+                   const uECC_word_t *mod,
+                   wordcount_t num_words);
+
+/* Calculates result = product (mod curve->p), where product is up to
+   2 * curve->num_words long. */
+void uECC_vli_mmod_fast(uECC_word_t *result, uECC_word_t *product, uECC_Curve curve);
+
+/* Computes result = (left * right) % mod.
+   Currently only designed to work for mod == curve->p or curve_n. */
+void uECC_vli_modMult(uECC_word_t *result,
+                      const uECC_word_t *left,
+                      const uECC_word_t *right,
+                      const uECC_word_t *mod,
+                      wordcount_t num_words);
+
+/* Computes result = (left * right) % curve->p. */
+void uECC_vli_modMult_fast(uECC_word_t *result,
+                           const uECC_word_t *left,
+                           const uECC_word_t *right,
+                           uECC_Curve curve);
+
+/* Computes result = left^2 % mod.
+   Currently only designed to work for mod == curve->p or curve_n. */
+void uECC_vli_modSquare(uECC_word_t *result,
+                        const uECC_word_t *left,
+                        const uECC_word_t *mod,
+                        wordcount_t num_words);
+
+/* Computes result = left^2 % curve->p. */
+void uECC_vli_modSquare_fast(uECC_word_t *result, const uECC_word_t *left, uECC_Curve curve);
+
+/* Computes result = (1 / input) % mod.*/
+void uECC_vli_modInv(uECC_word_t *result,
+                     const uECC_word_t *input,
+                     const uECC_word_t *mod,
+                     wordcount_t num_words);
+
+#if uECC_SUPPORT_COMPRESSED_POINT
+/* Calculates a = sqrt(a) (mod curve->p) */
+void uECC_vli_mod_sqrt(uECC_word_t *a, uECC_Curve curve);
+#endif
+
+/* Converts an integer in uECC native format to big-endian bytes. */
+void uECC_vli_nativeToBytes(uint8_t *bytes, int num_bytes, const uECC_word_t *native);
+/* Converts big-endian bytes to an integer in uECC native format. */
+void uECC_vli_bytesToNative(uECC_word_t *native, const uint8_t *bytes, int num_bytes);
+
+unsigned uECC_curve_num_words(uECC_Curve curve);
+unsigned uECC_curve_num_bytes(uECC_Curve curve);
+unsigned uECC_curve_num_bits(uECC_Curve curve);
+unsigned uECC_curve_num_n_words(uECC_Curve curve);
+unsigned uECC_curve_num_n_bytes(uECC_Curve curve);
+unsigned uECC_curve_num_n_bits(uECC_Curve curve);
+
+const uECC_word_t *uECC_curve_p(uECC_Curve curve);
+const uECC_word_t *uECC_curve_n(uECC_Curve curve);
+const uECC_word_t *uECC_curve_G(uECC_Curve curve);
+const uECC_word_t *uECC_curve_b(uECC_Curve curve);
+
+int uECC_valid_point(const uECC_word_t *point, uECC_Curve curve);
+
+/* Multiplies a point by a scalar. Points are represented by the X coordinate followed by
+   the Y coordinate in the same array, both coordinates are curve->num_words long. Note
+   that scalar must be curve->num_n_words long (NOT curve->num_words). */
+void uECC_point_mult(uECC_word_t *result,
+                     const uECC_word_t *point,
+                     const uECC_word_t *scalar,
+                     uECC_Curve curve);
+
+/* Generates a random integer in the range 0 < random < top.
+   Both random and top have num_words words. */
+int uECC_generate_random_int(uECC_word_t *random,
+                             const uECC_word_t *top,
+                             wordcount_t num_words);
+
+#endif /* uECC_ENABLE_VLI_API */
+
+#ifdef __cplusplus
+} /* end of extern "C" */
+#endif
+
+#endif /* _UECC_VLI_H_ */
+#ifndef util_h
+#define util_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// make sure out is 2*len + 1
+char *util_hex(uint8_t *in, size_t len, char *out);
+// out must be len/2
+uint8_t *util_unhex(char *in, size_t len, uint8_t *out);
+// hex string validator, NULL is invalid, else returns str
+char *util_ishex(char *str, uint32_t len);
+
+// safer string comparison (0 == same)
+int util_cmp(char *a, char *b);
+
+// portable sort
+void util_sort(void *base, unsigned int nel, unsigned int width, int (*comp)(void *, const void *, const void *), void *arg);
+
+// portable reallocf
+void *util_reallocf(void *ptr, size_t size);
+
+// get a "now" timestamp to do millisecond timers
+uint64_t util_at(void); // only pass at into _since()
+uint32_t util_since(uint64_t at); // get ms since the at
+
+// Use a constant time comparison function to avoid timing attacks
+int util_ct_memcmp(const void* s1, const void* s2, size_t n);
+
+// embedded may not have strdup but it's a kinda handy shortcut
+char *util_strdup(const char *str);
+#ifndef strdup
+#define strdup util_strdup
+#endif
+
+#endif
+#ifndef util_admit_h
+#define util_admit_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// admission control for expensive work (handshakes) from many sources, sources are any transport address bytes
+// each source gets a token bucket, all of them share a budget, and optionally must echo a stateless cookie first
+typedef struct util_admit_struct *util_admit_t;
+
+typedef struct util_admit_stats_struct
+{
+  uint32_t admitted;
+  uint32_t limited; // that source was over its rate
+  uint32_t over_budget; // all sources together were over the budget
+  uint32_t challenged; // cookies handed out
+  uint32_t bad_cookies; // wrong or expired ones echoed back
+} *util_admit_stats_t;
+
+#define UTIL_ADMIT_COOKIE 16
+#define UTIL_ADMIT_WINDOW 30 // seconds, a cookie is good for the rest of its window and the next one
+
+// options are "rate" per source per second (default 4), "burst" per source (default 8),
+// "budget" all sources per second (default 0, unlimited), "cookie":true to require cookies, "sources" table size (default 1024)
+// secret keys the cookies and source hashing, it should be random
+util_admit_t util_admit_new(lob_t options, uint8_t *secret, size_t len);
+util_admit_t util_admit_free(util_admit_t admit);
+
+// take a token from this source's bucket and the budget, NULL (and counted) if either is empty, now is in ms
+// w/o any from (len 0) there's no source bucket, only the budget applies
+util_admit_t util_admit_take(util_admit_t admit, uint8_t *from, size_t len, uint64_t now);
+
+// returns admit if cookies are required
+util_admit_t util_admit_cookies(util_admit_t admit);
+
+// fill in this source's current cookie (UTIL_ADMIT_COOKIE bytes), counts it as a challenge, NULL if over the budget
+uint8_t *util_admit_cookie(util_admit_t admit, uint8_t *from, size_t len, uint64_t now, uint8_t *cookie);
+
+// admit if this is a current cookie for this source, NULL (and counted) if not
+util_admit_t util_admit_verify(util_admit_t admit, uint8_t *from, size_t len, uint64_t now, uint8_t *cookie);
+
+util_admit_stats_t util_admit_stats(util_admit_t admit);
+
+#endif
+#ifndef util_cc_h
+#define util_cc_h
+
+#include <stdint.h>
+
+// congestion control for everything a link sends reliably, shared by all of its channels
+// the window grows CUBIC-style but counted in round trips (by bytes acked) so it doesn't care what units now is in,
+// and sends are paced to spread a window across the smoothed rtt
+#define UTIL_CC_MSS 1200 // nominal packet size the window moves by
+#define UTIL_CC_INIT 10 // initial window, in packets
+#define UTIL_CC_MIN 2 // smallest window after a loss, in packets
+#define UTIL_CC_MAX (64 * 1024 * 1024) // bytes
+
+typedef struct util_cc_struct
+{
+  uint32_t cwnd, ssthresh, flight; // bytes
+  uint32_t wmax; // window before the last reduction
+  uint32_t epoch, k; // round trips since that reduction and until back at wmax, both in 16ths
+  uint32_t round; // bytes acked towards the next round trip
+  uint32_t srtt, rttvar; // 8x and 4x, like tcp
+  uint32_t now, recover; // latest clock, no more reductions until it's past recover
+  uint32_t tokens, filled; // pacing bucket, and when it was last filled
+  uint32_t sent, lost, timeouts, samples; // counts
+} *util_cc_t;
+
+void util_cc_init(util_cc_t cc);
+
+// the latest now, refills the pacing bucket
+void util_cc_clock(util_cc_t cc, uint32_t now);
+
+// bytes that can be sent right now, limited by the window and the pacing
+uint32_t util_cc_room(util_cc_t cc);
+
+// a packet of this many bytes was sent
+void util_cc_sent(util_cc_t cc, uint32_t bytes);
+
+// these bytes were acked, grows the window (call util_cc_gone too for what was still in flight)
+void util_cc_acked(util_cc_t cc, uint32_t bytes);
+
+// these bytes aren't in flight anymore (acked, lost, or their channel is gone)
+void util_cc_gone(util_cc_t cc, uint32_t bytes);
+
+// a round trip was measured (from a packet only sent once)
+void util_cc_rtt(util_cc_t cc, uint32_t rtt);
+
+// a packet was reported missing, the window shrinks at most once per round trip
+void util_cc_loss(util_cc_t cc);
+
+// nothing was acked in time, back to a minimal window
+void util_cc_timeout(util_cc_t cc);
+
+// how long to wait for an ack before resending, 0 until there's a measured rtt
+uint32_t util_cc_rto(util_cc_t cc);
+
+// adds the estimates to a json object being built (lob_begin'd)
+lob_t util_cc_json(util_cc_t cc, lob_t json);
+
+#endif
+#ifndef util_chunks_h
+#define util_chunks_h
+
+#include <stdint.h>
+
+// for list of incoming chunks
+typedef struct util_chunk_struct
+{
+  struct util_chunk_struct *prev;
+  uint8_t size;
+  uint8_t data[];
+} *util_chunk_t;
+
+typedef struct util_chunks_struct
+{
+
+  util_chunk_t reading; // stacked linked list of incoming chunks
+
+  lob_t writing;
+  size_t writeat; // offset into lob_raw()
+  uint16_t waitat; // gets to 256, offset into current chunk
+  uint8_t waiting; // current writing chunk size;
+  uint8_t readat; // always less than a max chunk, offset into reading
+
+  uint8_t cap;
+  uint8_t blocked:1, blocking:1, ack:1, err:1; // bool flags
+} *util_chunks_t;
+
+
+// size of each chunk, 0 == MAX (256)
+util_chunks_t util_chunks_new(uint8_t size);
+
+util_chunks_t util_chunks_free(util_chunks_t chunks);
+
+// turn this packet into chunks and append, free's out
+util_chunks_t util_chunks_send(util_chunks_t chunks, lob_t out);
+
+// get any packets that have been reassembled from incoming chunks
+lob_t util_chunks_receive(util_chunks_t chunks);
+
+// bytes waiting to be sent
+uint32_t util_chunks_writing(util_chunks_t chunks);
+
+
+////// these are for a stream-based transport
+
+// how many bytes are there ready to write
+uint32_t util_chunks_len(util_chunks_t chunks);
+
+// return the next block of data to be written to the stream transport, max len is util_chunks_len()
+uint8_t *util_chunks_write(util_chunks_t chunks);
+
+// advance the write this far, don't mix with util_chunks_out() usage
+util_chunks_t util_chunks_written(util_chunks_t chunks, size_t len);
+
+// queues incoming stream based data
+util_chunks_t util_chunks_read(util_chunks_t chunks, uint8_t *block, size_t len);
+
+////// these are for frame-based transport
+
+// size of the next chunk, -1 when none, max is chunks size-1
+int16_t util_chunks_size(util_chunks_t chunks);
+
+// return the next chunk of data, use util_chunks_next to advance
+uint8_t *util_chunks_frame(util_chunks_t chunks);
+
+// peek into what the next chunk size will be, to see terminator ones
+int16_t util_chunks_peek(util_chunks_t chunks);
+
+// process incoming chunk
+util_chunks_t util_chunks_chunk(util_chunks_t chunks, uint8_t *chunk, int16_t size);
+
+// advance the write past the current chunk
+util_chunks_t util_chunks_next(util_chunks_t chunks);
+
+
+#endif
+#ifndef util_frames_h
+#define util_frames_h
+
+#include <stdint.h>
+
+// for list of incoming frames
+typedef struct util_frame_struct
+{
+  struct util_frame_struct *prev;
+  uint32_t hash;
+  uint8_t data[];
+} *util_frame_t;
+
+typedef struct util_frames_struct
+{
+
+  lob_t inbox; // received packets waiting to be processed
+  lob_t outbox; // current packet being sent out
+
+  util_frame_t cache; // stacked linked list of incoming frames in progress
+
+  uint32_t inbase; // last confirmed inbox hash
+  uint32_t outbase; // last confirmed outbox hash
+
+  uint8_t in; // number of incoming frames received/waiting
+  uint8_t out; //  number of outgoing frames of outbox sent since outbase
+
+  uint8_t size; // frame size
+  uint8_t flush:1; // bool to signal a flush is needed
+  uint8_t err:1; // unrecoverable failure
+
+} *util_frames_t;
+
+
+// size of each frame, min 16 max 128, multiple of 4
+util_frames_t util_frames_new(uint8_t size);
+
+util_frames_t util_frames_free(util_frames_t frames);
+
+// turn this packet into frames and append, free's out
+util_frames_t util_frames_send(util_frames_t frames, lob_t out);
+
+// get any packets that have been reassembled from incoming frames
+lob_t util_frames_receive(util_frames_t frames);
+
+// total bytes in the inbox/outbox
+size_t util_frames_inlen(util_frames_t frames);
+size_t util_frames_outlen(util_frames_t frames);
+
+// meta space is (size - 14) and only filled when receiving a meta frame
+util_frames_t util_frames_inbox(util_frames_t frames, uint8_t *data, uint8_t *meta); // data=NULL is ready check
+
+// fills data with the next frame, if no payload available always fills w/ meta frame, safe to re-run (idempotent)
+util_frames_t util_frames_outbox(util_frames_t frames, uint8_t *data, uint8_t *meta); // data=NULL is ready-check
+
+// this must be called immediately (no inbox interleaved) after last outbox is actually sent to advance payload or clear flush request, returns if more to send
+util_frames_t util_frames_sent(util_frames_t frames);
+
+// is just a check to see if there's data waiting to be sent
+util_frames_t util_frames_waiting(util_frames_t frames);
+
+// is there an expectation of an incoming frame
+util_frames_t util_frames_await(util_frames_t frames);
+
+// are we waiting to send/receive a frame (both waiting && await)
+util_frames_t util_frames_busy(util_frames_t frames);
+
+// is a frame pending to be sent immediately
+util_frames_t util_frames_pending(util_frames_t frames);
+
+
+
+// check error state and clearing it
+util_frames_t util_frames_ok(util_frames_t frames);
+util_frames_t util_frames_clear(util_frames_t frames);
+
+#endif
+#ifndef util_pool_h
+#define util_pool_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// size-classed block pools w/ per-thread freelists for the hot packet objects (lob, chan, frames, chunks)
+// anything from util_pool_malloc/realloc must only go back through util_pool_realloc/free
+// build w/ -DNOPOOL to pass everything straight through to the system allocator
+
+typedef struct util_pool_stats_struct
+{
+  uint64_t allocs, frees; // all requests
+  uint64_t hits, misses; // allocs served from a freelist or not
+  uint64_t large; // allocs bigger than any size class, always the system allocator
+  uint32_t cached; // blocks currently sitting on freelists
+} *util_pool_stats_t;
+
+void *util_pool_malloc(size_t size);
+void *util_pool_realloc(void *ptr, size_t size);
+void util_pool_free(void *ptr);
+
+// returns the calling thread's freelist blocks to the system allocator
+void util_pool_flush(void);
+
+// the calling thread's counters
+util_pool_stats_t util_pool_stats(void);
+
+#endif
+#ifndef util_sys_h
+#define util_sys_h
+
+typedef uint32_t at_t;
+
+// the TEMPORARY results some functions return live in per-thread storage so they're safe from any thread
+// platforms w/o thread-local storage can define this empty (single threaded only then)
+#ifndef UTIL_TLS
+#define UTIL_TLS __thread
+#endif
+
+// returns a number that increments in seconds for comparison (epoch or just since boot)
+at_t util_sys_seconds();
+
+// number of milliseconds since given epoch seconds value
+unsigned long long util_sys_ms(long epoch);
+
+unsigned short util_sys_short(unsigned short x);
+unsigned long util_sys_long(unsigned long x);
+
+// use the platform's best RNG
+void util_sys_random_init(void);
+long util_sys_random(void);
+
+// -1 toggles debug, 0 disable, 1 enable
+void util_sys_logging(int enabled);
+
+// returns NULL for convenient return logging
+void *util_sys_log(uint8_t level, const char *file, int line, const char *function, const char * format, ...);
+
+// use syslog levels https://en.wikipedia.org/wiki/Syslog#Severity_level
+#define LOG_LEVEL(level, fmt, ...) util_sys_log(level, __FILE__, __LINE__, __func__, fmt, ## __VA_ARGS__)
+
+// default LOG is DEBUG level and compile-time optional
+#ifdef NOLOG
+#define LOG(...) NULL
+#else
+#define LOG(fmt, ...) util_sys_log(7, __FILE__, __LINE__, __func__, fmt, ## __VA_ARGS__)
+#endif
+
+// most things just need these
+#define LOG_DEBUG LOG
+#define LOG_INFO(fmt, ...) util_sys_log(6, __FILE__, __LINE__, __func__, fmt, ## __VA_ARGS__)
+#define LOG_WARN(fmt, ...) util_sys_log(4, __FILE__, __LINE__, __func__, fmt, ## __VA_ARGS__)
+#define LOG_ERROR(fmt, ...) util_sys_log(3, __FILE__, __LINE__, __func__, fmt, ## __VA_ARGS__)
+#define LOG_CRAZY(fmt, ...) util_sys_log(8, __FILE__, __LINE__, __func__, fmt, ## __VA_ARGS__)
+
+#endif
+#ifndef util_unix_h
+#define util_unix_h
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__)))
+
+
+// load a json file into packet
+lob_t util_fjson(char *file);
+
+// load an array of hashnames from a file and add them as links
+mesh_t util_links(mesh_t mesh, char *file);
+
+// simple sockets simpler
+int util_sock_timeout(int sock, uint32_t ms); // blocking timeout
+
+#endif
+
+#endif
+#ifndef util_uri_h
+#define util_uri_h
+
+#include <stdint.h>
+
+// utils to get link info in/out of a uri
+
+// parser
+lob_t util_uri_parse(char *string);
+
+// get keys from query
+lob_t util_uri_keys(lob_t uri);
+
+// get paths from host and query
+lob_t util_uri_paths(lob_t uri); // chain
+
+// validate any fragment from this peer
+uint8_t util_uri_check(lob_t uri, uint8_t *peer);
+
+// generators
+lob_t util_uri_add_keys(lob_t uri, lob_t keys);
+lob_t util_uri_add_path(lob_t uri, lob_t path);
+lob_t util_uri_add_check(lob_t uri, uint8_t *peer, uint8_t *data, size_t len);
+lob_t util_uri_add_data(lob_t uri, uint8_t *data, size_t len);
+
+// serialize out from lob format to "uri" key and return it
+char *util_uri_format(lob_t uri);
+
+#endif
+#ifndef version_h
+#define version_h
+
+#define TELEHASH_VERSION_MAJOR 3
+#define TELEHASH_VERSION_MINOR 2
+#define TELEHASH_VERSION_PATCH 0
+#define TELEHASH_VERSION ((TELEHASH_VERSION_MAJOR) * 10000 + (TELEHASH_VERSION_MINOR) * 100 + (TELEHASH_VERSION_PATCH))
+
+#endif
+#include <stddef.h>
+
+#ifndef xht_h
+#define xht_h
+
+// simple string->void* hashtable, very static and bare minimal, but efficient
+
+typedef struct xht_struct *xht_t;
+
+// must pass a prime#
+xht_t xht_new(unsigned int prime);
+
+// caller responsible for key storage, no copies made (don't free it b4 xht_free()!)
+// set val to NULL to clear an entry (key is released), memory is reused but never free'd (# of keys only grows to peak usage)
+void xht_set(xht_t h, const char *key, void *val);
+
+// ooh! unlike set where key/val is in caller's mem, here they are copied into xht_t and free'd when val is 0 or xht_free()
+void xht_store(xht_t h, const char *key, void *val, size_t vlen);
+
+// returns value of val if found, or NULL
+void *xht_get(xht_t h, const char *key);
+
+// free the hashtable and all entries
+void xht_free(xht_t h);
+
+// pass a function that is called for every key that has a value set
+typedef void (*xht_walker)(xht_t h, const char *key, void *val, void *arg);
+void xht_walk(xht_t h, xht_walker w, void *arg);
+
+// iterator through all the keys (NULL to start), use get for values
+char *xht_iter(xht_t h, char *key);
+
+#endif
+
@@ -0,0 +1,104 @@
+#ifndef _bench_h_
+#define _bench_h_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "util_pool.h"
+
+/* a small harness for the benches: a warmup picks how many calls make a batch, then batches are timed
+ * for ns/op and its percentiles, and heap allocations are counted for allocs/op (and util_pool ones for pool/op).
+ * link w/ -Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc for the counting, which is atomic so worker threads count too */
+
+#ifndef BENCH_SAMPLES
+#define BENCH_SAMPLES 100 // timed batches per benchmark, the percentiles are across these
+#endif
+#ifndef BENCH_BATCH_NS
+#define BENCH_BATCH_NS 2000000 // how long a batch should take
+#endif
+#ifndef BENCH_WARMUP_NS
+#define BENCH_WARMUP_NS 20000000 // calls before timing starts, to size the batches and warm caches
+#endif
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+static uint64_t bench_allocs = 0;
+void *__wrap_malloc(size_t size) { __atomic_add_fetch(&bench_allocs,1,__ATOMIC_RELAXED); return __real_malloc(size); }
+void *__wrap_calloc(size_t nmemb, size_t size) { __atomic_add_fetch(&bench_allocs,1,__ATOMIC_RELAXED); return __real_calloc(nmemb,size); }
+void *__wrap_realloc(void *ptr, size_t size) { __atomic_add_fetch(&bench_allocs,1,__ATOMIC_RELAXED); return __real_realloc(ptr,size); }
+
+static uint64_t bench_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int bench_cmp(const void *a, const void *b)
+{
+  double x = *(const double*)a, y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+static FILE *bench_json = NULL;
+static uint32_t bench_count = 0;
+
+// results always go to stdout, and as JSON to the file named by the first arg (or "-" for stdout only JSON)
+static void bench_open(int argc, char **argv)
+{
+  if(argc > 1 && strcmp(argv[1],"-") == 0) bench_json = stdout;
+  else if(argc > 1 && !(bench_json = fopen(argv[1],"w"))) fprintf(stderr,"can't write %s\n",argv[1]);
+  if(bench_json) fprintf(bench_json,"{\"benchmarks\":[");
+}
+
+// ops is how many of the thing being measured each call does (packets, bytes, ...), per op figures are divided by it
+static void bench_run(char *suite, char *name, uint32_t ops, void (*fn)(void *arg), void *arg)
+{
+  double samples[BENCH_SAMPLES], mean;
+  uint64_t start, total, allocs, pool, calls;
+  uint32_t i, n, batch;
+
+  if(!ops) ops = 1;
+  for(calls = 0, start = bench_ns();bench_ns() - start < BENCH_WARMUP_NS;calls++) fn(arg);
+  batch = (uint32_t)((calls * BENCH_BATCH_NS) / BENCH_WARMUP_NS);
+  if(!batch) batch = 1;
+
+  allocs = bench_allocs;
+  pool = util_pool_stats()->allocs;
+  for(total = i = 0;i < BENCH_SAMPLES;i++)
+  {
+    start = bench_ns();
+    for(n=0;n<batch;n++) fn(arg);
+    start = bench_ns() - start;
+    total += start;
+    samples[i] = (double)start / ((uint64_t)batch * ops);
+  }
+  calls = (uint64_t)BENCH_SAMPLES * batch * ops;
+  mean = (double)total / calls;
+  pool = util_pool_stats()->allocs - pool;
+  allocs = bench_allocs - allocs;
+  qsort(samples, BENCH_SAMPLES, sizeof(double), bench_cmp);
+#define BENCH_P(p) samples[((BENCH_SAMPLES - 1) * (p)) / 100]
+
+  if(bench_json != stdout) printf("%-8s %-14s %11.1f ns/op  p50 %10.1f  p90 %10.1f  p99 %10.1f  %5.2f allocs/op %5.2f pool/op %11.0f ops/s\n",
+    suite, name, mean, BENCH_P(50), BENCH_P(90), BENCH_P(99), (double)allocs / calls, (double)pool / calls, mean ? 1e9 / mean : 0);
+  if(bench_json) fprintf(bench_json,"%s\n{\"suite\":\"%s\",\"name\":\"%s\",\"ops\":%llu,\"ns\":%.1f,\"p50\":%.1f,\"p90\":%.1f,\"p99\":%.1f,\"allocs\":%.2f,\"pool\":%.2f,\"per_sec\":%.0f}",
+    bench_count ? "," : "", suite, name, (unsigned long long)calls, mean, BENCH_P(50), BENCH_P(90), BENCH_P(99),
+    (double)allocs / calls, (double)pool / calls, mean ? 1e9 / mean : 0);
+#undef BENCH_P
+  bench_count++;
+}
+
+static int bench_close(void)
+{
+  if(!bench_json) return 0;
+  fprintf(bench_json,"\n]}\n");
+  if(bench_json != stdout) fclose(bench_json);
+  bench_json = NULL;
+  return 0;
+}
+
+#endif
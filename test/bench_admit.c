@@ -0,0 +1,123 @@
+#include <time.h>
+#include "telehash.h"
+#include "net_loopback.h"
+#include "unit_test.h"
+
+#define CLIENTS 16
+#define ROUNDS 50
+#define FLOOD 4 // handshakes arriving just ahead of each ping
+
+static uint64_t now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static uint32_t pongs = 0;
+static lob_t pong_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","pong")) return open;
+  pongs++;
+  lob_free(open);
+  return NULL;
+}
+
+static lob_t ping_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","ping")) return open;
+  link_direct(link, lob_set(lob_new(),"type","pong"));
+  lob_free(open);
+  return NULL;
+}
+
+static int cmp(void *arg, const void *a, const void *b)
+{
+  return (*(uint32_t*)a > *(uint32_t*)b) - (*(uint32_t*)a < *(uint32_t*)b);
+}
+
+// a ping over loopback behind a flood of handshakes from spoofed addresses (any cookie challenges go nowhere)
+static void bench(char *label, lob_t options, lob_t secrets, lob_t *handshakes)
+{
+  uint32_t i, j, rounds, us[ROUNDS];
+  uint64_t start, total;
+  util_admit_stats_t stats;
+  lob_t reply;
+
+  mesh_t meshS = mesh_new();
+  fail_unless(!mesh_load(meshS, secrets, lob_linked(secrets)));
+  mesh_on_discover(meshS,"auto",mesh_add);
+  mesh_on_open(meshS,"ping",ping_on_open);
+  mesh_t meshC = mesh_new();
+  lob_free(mesh_generate(meshC));
+  mesh_on_open(meshC,"pong",pong_on_open);
+  net_loopback_t pair = net_loopback_new(meshS, meshC);
+  fail_unless(pair);
+  link_t link = link_get(meshC, meshS->id);
+  fail_unless(link_resync(link) && link_up(link));
+
+  // after the link is up, so it isn't challenged itself
+  fail_unless(mesh_admission(meshS, options));
+
+  total = now_us();
+  for(rounds=j=0;rounds<ROUNDS;rounds++)
+  {
+    start = now_us();
+    for(i=0;i<FLOOD;i++,j++)
+    {
+      mesh_receive_from(meshS, lob_copy(handshakes[j % CLIENTS]), (uint8_t*)&j, sizeof(j), &reply);
+      lob_free(reply);
+    }
+    i = pongs;
+    link_direct(link, lob_set(lob_new(),"type","ping"));
+    fail_unless(pongs == i + 1);
+    us[rounds] = (uint32_t)(now_us() - start);
+  }
+  total = now_us() - total;
+
+  util_sort(us, rounds, sizeof(uint32_t), cmp, NULL);
+  printf("%-26s %5.0f rounds/sec, ping behind the flood p50 %6uus p99 %6uus max %6uus\n",label,(double)rounds * 1e6 / (double)total,us[rounds/2],us[rounds*99/100],us[rounds-1]);
+  if((stats = util_admit_stats(meshS->admit))) printf("%26s %u admitted %u limited %u over budget %u challenged\n","",stats->admitted,stats->limited,stats->over_budget,stats->challenged);
+
+  net_loopback_free(pair);
+  mesh_free(meshS);
+  mesh_free(meshC);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t i;
+  lob_t handshakes[CLIENTS], options;
+
+  fail_unless(!e3x_init(NULL));
+  util_sys_logging(0);
+
+  lob_t secrets = e3x_generate();
+  fail_unless(secrets);
+
+  // the flood, handshakes made once up front
+  for(i=0;i<CLIENTS;i++)
+  {
+    mesh_t mesh = mesh_new();
+    lob_free(mesh_generate(mesh));
+    link_t link = link_get_keys(mesh, lob_linked(secrets));
+    fail_unless(link);
+    handshakes[i] = link_handshake(link);
+    fail_unless(handshakes[i]);
+    mesh_free(mesh);
+  }
+
+  printf("%u handshakes per ping, each from a new address\n",FLOOD);
+  bench("no admission control", NULL, secrets, handshakes);
+  options = lob_set_uint(lob_new(),"budget",20);
+  bench("budget 20/sec", options, secrets, handshakes);
+  lob_free(options);
+  options = lob_set_raw(lob_new(),"cookie",0,"true",4);
+  bench("cookies", options, secrets, handshakes);
+  lob_free(options);
+
+  for(i=0;i<CLIENTS;i++) lob_free(handshakes[i]);
+  lob_free(secrets);
+
+  return 0;
+}
@@ -0,0 +1,57 @@
+#include "telehash.h"
+#include "bench.h"
+
+#define MAX 65536
+
+// aes_128_ctr per byte, expanding the key every call (how it was) or once
+typedef struct aes_struct
+{
+  struct aes_128_key_struct expanded;
+  uint8_t key[16], iv[16];
+  size_t len;
+} *aes_t;
+
+static uint8_t buf[MAX];
+
+static void setkey_fn(void *arg)
+{
+  aes_t aes = (aes_t)arg;
+  aes_128_ctr(aes->key,aes->len,aes->iv,buf,buf);
+}
+
+static void expanded_fn(void *arg)
+{
+  aes_t aes = (aes_t)arg;
+  aes_128_ctr_key(&(aes->expanded),aes->len,aes->iv,buf,buf);
+}
+
+int main(int argc, char **argv)
+{
+  size_t sizes[] = {64, 1400, MAX};
+  struct aes_struct aes;
+  char name[32];
+  uint32_t i;
+  uint8_t hw;
+
+  bench_open(argc, argv);
+  memset(aes.key,42,sizeof(aes.key));
+  memset(aes.iv,0,sizeof(aes.iv));
+  aes_128_setkey(&(aes.expanded),aes.key);
+
+  hw = aes_128_hw(1);
+  for(i=0;i<sizeof(sizes)/sizeof(sizes[0]);i++)
+  {
+    aes.len = sizes[i];
+    aes_128_hw(0);
+    snprintf(name,sizeof(name),"setkey_%lu",(unsigned long)sizes[i]);
+    bench_run("aes", name, sizes[i], setkey_fn, &aes);
+    snprintf(name,sizeof(name),"tables_%lu",(unsigned long)sizes[i]);
+    bench_run("aes", name, sizes[i], expanded_fn, &aes);
+    if(!hw || !aes_128_hw(1)) continue;
+    snprintf(name,sizeof(name),"aesni_%lu",(unsigned long)sizes[i]);
+    bench_run("aes", name, sizes[i], expanded_fn, &aes);
+  }
+  aes_128_hw(1);
+
+  return bench_close();
+}
@@ -0,0 +1,39 @@
+#include "telehash.h"
+#include "bench.h"
+
+#define MAX 65536
+
+// chacha20 per byte at each level the cpu has
+static uint8_t key[32], nonce[8], buf[MAX];
+
+static void chacha_fn(void *arg)
+{
+  chacha20(key,nonce,buf,*(uint32_t*)arg);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t sizes[] = {64, 72, 192, 1400, MAX}; // a knock frame, a tempo seed, ...
+  char *names[] = {"scalar","sse2","avx2"};
+  char name[32];
+  uint32_t i;
+  uint8_t level, top;
+
+  bench_open(argc, argv);
+  memset(key,42,sizeof(key));
+  memset(nonce,0,sizeof(nonce));
+
+  top = chacha20_hw(2);
+  for(i=0;i<sizeof(sizes)/sizeof(sizes[0]);i++)
+  {
+    for(level=0;level<=top;level++)
+    {
+      chacha20_hw(level);
+      snprintf(name,sizeof(name),"%s_%u",names[level],sizes[i]);
+      bench_run("chacha", name, sizes[i], chacha_fn, &sizes[i]);
+    }
+  }
+  chacha20_hw(2);
+
+  return bench_close();
+}
@@ -0,0 +1,109 @@
+#include <time.h>
+#include "telehash.h"
+#include "net_loopback.h"
+#include "unit_test.h"
+
+#define PACKETS 2000
+#define PAYLOAD 1000
+#define PER_TICK 50 // the app sends this many each tick, the window holds back the rest
+
+static uint64_t now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static int cmp(void *arg, const void *a, const void *b)
+{
+  return (*(uint32_t*)a > *(uint32_t*)b) - (*(uint32_t*)a < *(uint32_t*)b);
+}
+
+// ticks each packet took from chan_send to the receiving handler
+static uint32_t tick, received, misordered, ticks[PACKETS];
+static void bulk_handler(chan_t chan, void *arg)
+{
+  lob_t packet;
+  while((packet = chan_receiving(chan)))
+  {
+    if(lob_get(packet,"n"))
+    {
+      if(lob_get_uint(packet,"n") != received) misordered++;
+      ticks[received++] = tick - lob_get_uint(packet,"t");
+    }
+    lob_free(packet);
+  }
+}
+
+static lob_t bulk_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","bulk")) return open;
+  chan_t chan = link_chan(link, open);
+  chan_handle(chan,bulk_handler,NULL);
+  chan_receive(chan,open);
+  chan_process(chan,0);
+  return NULL;
+}
+
+static void bench(uint32_t loss)
+{
+  uint8_t payload[PAYLOAD];
+  uint32_t sent;
+  uint64_t start;
+  lob_t packet;
+
+  mesh_t meshA = mesh_new();
+  lob_free(mesh_generate(meshA));
+  mesh_on_open(meshA,"bulk",bulk_on_open);
+  mesh_t meshB = mesh_new();
+  lob_free(mesh_generate(meshB));
+  net_loopback_t pair = net_loopback_new(meshA,meshB);
+  link_t link = link_get(meshB, meshA->id);
+  fail_unless(link_resync(link) && link_up(link));
+  net_loopback_loss(pair, loss);
+  pair->sent = 0;
+  e3x_rand(payload,PAYLOAD);
+
+  received = misordered = 0;
+  packet = lob_set(lob_new(),"type","bulk");
+  chan_t chan = link_chan(link, packet);
+  chan_reliable(chan, 0);
+  chan_send(chan, packet);
+
+  start = now_us();
+  for(sent=0,tick=1;received < PACKETS && tick < 100000;tick++)
+  {
+    for(;sent < PACKETS && sent < tick * PER_TICK;sent++)
+    {
+      packet = chan_packet(chan);
+      lob_set_uint(packet,"n",sent);
+      lob_set_uint(packet,"t",tick);
+      lob_body(packet,payload,PAYLOAD);
+      chan_send(chan, packet);
+    }
+    mesh_process(meshA, tick);
+    mesh_process(meshB, tick);
+  }
+  start = now_us() - start;
+  fail_unless(received == PACKETS && !misordered);
+
+  util_sort(ticks, received, sizeof(uint32_t), cmp, NULL);
+  printf("%3u%% loss %7.1f MB/s %5u ticks %5.2f sent/packet latency p50 %3u p99 %3u max %3u ticks\n",loss,(double)PACKETS * PAYLOAD / (double)start,tick,(double)pair->sent / PACKETS,ticks[received/2],ticks[received*99/100],ticks[received-1]);
+
+  net_loopback_free(pair);
+  mesh_free(meshA);
+  mesh_free(meshB);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t losses[] = {0, 1, 5, 10, 20}, i;
+
+  fail_unless(!e3x_init(NULL));
+  util_sys_logging(0);
+
+  printf("%u reliable packets of %u bytes, %u sent per tick, resend after %u ticks\n",PACKETS,PAYLOAD,PER_TICK,CHAN_RESEND);
+  for(i=0;i<sizeof(losses)/sizeof(losses[0]);i++) bench(losses[i]);
+
+  return 0;
+}
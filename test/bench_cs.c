@@ -0,0 +1,96 @@
+#include "telehash.h"
+#include "unit_test.h"
+#include "bench.h"
+
+// handshakes for each cipher set, sent and received on an established pair and for a brand new exchange
+typedef struct cs_struct
+{
+  uint8_t csid;
+  char *hex;
+  lob_t idB, hs;
+  e3x_self_t selfA, selfB;
+  e3x_exchange_t xAB, xBA;
+} *cs_t;
+
+static uint32_t bad = 0;
+
+static e3x_exchange_t exchange(e3x_self_t self, lob_t id, uint8_t csid, char *hex)
+{
+  lob_t key = lob_get_base32(lob_linked(id),hex);
+  e3x_exchange_t x = e3x_exchange_new(self, csid, key);
+  lob_free(key);
+  if(x) e3x_exchange_out(x,1);
+  return x;
+}
+
+static void send_fn(void *arg)
+{
+  lob_free(e3x_exchange_handshake(((cs_t)arg)->xAB, NULL));
+}
+
+static void receive_fn(void *arg)
+{
+  cs_t cs = (cs_t)arg;
+  lob_t inner = e3x_self_decrypt(cs->selfB, cs->hs);
+  if(!inner || e3x_exchange_verify(cs->xBA, cs->hs) || !e3x_exchange_sync(cs->xBA, cs->hs)) bad++;
+  lob_free(inner);
+}
+
+static void fresh_fn(void *arg)
+{
+  cs_t cs = (cs_t)arg;
+  e3x_exchange_t x = exchange(cs->selfA, cs->idB, cs->csid, cs->hex);
+  lob_t hs = e3x_exchange_handshake(x, NULL);
+  if(!hs) bad++;
+  lob_free(hs);
+  e3x_exchange_free(x);
+}
+
+static void bench(uint8_t csid, char *hex, lob_t idA, lob_t idB)
+{
+  struct cs_struct cs;
+  char suite[8];
+
+  snprintf(suite,sizeof(suite),"cs%s",hex);
+  cs.csid = csid;
+  cs.hex = hex;
+  cs.idB = idB;
+  cs.selfA = e3x_self_new(idA,NULL);
+  cs.selfB = e3x_self_new(idB,NULL);
+  fail_unless(cs.selfA && cs.selfB);
+  cs.xAB = exchange(cs.selfA, idB, csid, hex);
+  cs.xBA = exchange(cs.selfB, idA, csid, hex);
+  fail_unless(cs.xAB && cs.xBA);
+
+  bench_run(suite, "send", 1, send_fn, &cs);
+  cs.hs = e3x_exchange_handshake(cs.xAB, NULL);
+  fail_unless(cs.hs);
+  bench_run(suite, "receive", 1, receive_fn, &cs);
+  lob_free(cs.hs);
+  bench_run(suite, "new_exchange", 1, fresh_fn, &cs);
+  fail_unless(!bad);
+
+  e3x_exchange_free(cs.xAB);
+  e3x_exchange_free(cs.xBA);
+  e3x_self_free(cs.selfA);
+  e3x_self_free(cs.selfB);
+}
+
+int main(int argc, char **argv)
+{
+  fail_unless(!e3x_init(NULL));
+  util_sys_logging(0);
+  bench_open(argc, argv);
+
+  lob_t idA = e3x_generate();
+  lob_t idB = e3x_generate();
+  fail_unless(idA && idB);
+
+  bench(0x1a, "1a", idA, idB);
+  bench(0x1c, "1c", idA, idB);
+
+  lob_free(idA);
+  lob_free(idB);
+
+  return bench_close();
+}
@@ -0,0 +1,179 @@
+#include <time.h>
+#include <unistd.h>
+#include "telehash.h"
+#include "net_udp4.h"
+#include "net_handshake.h"
+#include "unit_test.h"
+
+#define CLIENTS 32
+#define ROUNDS 50
+#define FLOOD 2 // handshakes arriving just ahead of each ping
+
+static uint64_t now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static uint32_t pongs = 0;
+static lob_t pong_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","pong")) return open;
+  pongs++;
+  lob_free(open);
+  return NULL;
+}
+
+static lob_t ping_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","ping")) return open;
+  link_direct(link, lob_set(lob_new(),"type","pong"));
+  lob_free(open);
+  return NULL;
+}
+
+// smallest bucket holding at least this share of the samples
+static uint32_t percentile(uint32_t *buckets, uint32_t total, double share)
+{
+  uint32_t i, sum = 0;
+  for(i=0;i<NET_HANDSHAKES_BUCKETS;i++)
+  {
+    sum += buckets[i];
+    if(sum >= total * share) break;
+  }
+  return 1U << i;
+}
+
+static void print(char *label, uint32_t *buckets, uint32_t total)
+{
+  printf("  %-10s %4u samples, p50 <%7uus p90 <%7uus p99 <%7uus\n",label,total,percentile(buckets,total,0.5),percentile(buckets,total,0.9),percentile(buckets,total,0.99));
+}
+
+// ping through the server while other clients keep handshaking with it, threads 0 is all on the mesh's own thread
+static void bench(uint32_t threads, lob_t secrets, lob_t *handshakes, int *socks, lob_t mtu)
+{
+  uint32_t i, j, rounds, bucket, rtt[NET_HANDSHAKES_BUCKETS];
+  uint64_t start, us;
+  struct sockaddr_in sa;
+  net_handshakes_t hs = NULL;
+  net_handshakes_stats_t stats;
+
+  mesh_t meshS = mesh_new();
+  fail_unless(!mesh_load(meshS, secrets, lob_linked(secrets)));
+  mesh_on_discover(meshS,"auto",mesh_add);
+  mesh_on_open(meshS,"ping",ping_on_open);
+  net_udp4_t netS = net_udp4_new(meshS, mtu);
+  fail_unless(netS);
+  if(threads)
+  {
+    lob_t options = lob_set_uint(lob_new(),"threads",threads);
+    hs = net_handshakes_new(meshS, options);
+    lob_free(options);
+    fail_unless(hs);
+    net_udp4_handshakes(netS, hs);
+  }
+
+  mesh_t meshC = mesh_new();
+  lob_free(mesh_generate(meshC));
+  mesh_on_open(meshC,"pong",pong_on_open);
+  net_udp4_t netC = net_udp4_new(meshC, mtu);
+  link_t link = link_get_keys(meshC, meshS->keys);
+  fail_unless(link);
+  net_udp4_direct(netC,link_handshake(link),"127.0.0.1",net_udp4_port(netS));
+  for(i=10000;i && !(link_up(link) && link_up(mesh_linkid(meshS, meshC->id)));i--)
+  {
+    net_udp4_process(netS);
+    net_udp4_process(netC);
+  }
+  fail_unless(i);
+
+  memset(&sa,0,sizeof(sa));
+  sa.sin_family = AF_INET;
+  inet_aton("127.0.0.1", &(sa.sin_addr));
+  sa.sin_port = htons(net_udp4_port(netS));
+
+  memset(rtt,0,sizeof(rtt));
+  start = now_us();
+  for(rounds=j=0;rounds<ROUNDS;rounds++)
+  {
+    for(i=0;i<FLOOD;i++,j++) sendto(socks[j % CLIENTS], lob_raw(handshakes[j % CLIENTS]), lob_len(handshakes[j % CLIENTS]), 0, (struct sockaddr *)&sa, sizeof(sa));
+    us = now_us();
+    i = pongs;
+    link_direct(link, lob_set(lob_new(),"type","ping"));
+    while(pongs == i && now_us() - us < 1000000)
+    {
+      net_udp4_process(netS);
+      net_udp4_process(netC);
+    }
+    if(pongs == i) break; // lost
+    us = now_us() - us;
+    for(bucket=0;bucket < NET_HANDSHAKES_BUCKETS-1 && us >= (1ULL << bucket);bucket++);
+    rtt[bucket]++;
+  }
+
+  // let the pool catch up so all of its handshakes are counted
+  for(i=1000;hs && i && net_handshakes_stats(hs)->pending;i--)
+  {
+    usleep(100);
+    net_udp4_process(netS);
+  }
+  us = now_us() - start;
+
+  if(hs) printf("%u worker threads, %.0f rounds/sec\n",threads,(double)rounds * 1e6 / (double)us);
+  else printf("synchronous, %.0f rounds/sec\n",(double)rounds * 1e6 / (double)us);
+  print("ping rtt", rtt, rounds);
+  if((stats = net_handshakes_stats(hs)))
+  {
+    print("handshake", stats->latency, stats->completed);
+    printf("  %u queued %u dropped %u failed\n",stats->queued,stats->dropped,stats->failed);
+  }
+
+  net_handshakes_free(hs);
+  mesh_free(meshS);
+  mesh_free(meshC);
+  net_udp4_free(netS);
+  net_udp4_free(netC);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t i;
+  int socks[CLIENTS];
+  lob_t handshakes[CLIENTS];
+
+  fail_unless(!e3x_init(NULL));
+  util_sys_logging(0);
+
+  lob_t secrets = e3x_generate();
+  fail_unless(secrets);
+
+  // the flood, one client per socket and its handshake made once up front
+  for(i=0;i<CLIENTS;i++)
+  {
+    mesh_t mesh = mesh_new();
+    lob_free(mesh_generate(mesh));
+    link_t link = link_get_keys(mesh, lob_linked(secrets));
+    fail_unless(link);
+    handshakes[i] = link_handshake(link);
+    fail_unless(handshakes[i]);
+    mesh_free(mesh);
+    fail_unless((socks[i] = socket(AF_INET, SOCK_DGRAM, 0)) >= 0);
+  }
+
+  // whole packets as datagrams, so the flood can be sent raw
+  lob_t mtu = lob_set_uint(lob_new(),"mtu",1472);
+  printf("%ld cpus, %u handshakes per ping\n",sysconf(_SC_NPROCESSORS_ONLN),FLOOD);
+  bench(0, secrets, handshakes, socks, mtu);
+  for(i=1;i<=4;i*=2) bench(i, secrets, handshakes, socks, mtu);
+  lob_free(mtu);
+
+  for(i=0;i<CLIENTS;i++)
+  {
+    lob_free(handshakes[i]);
+    close(socks[i]);
+  }
+  lob_free(secrets);
+
+  return 0;
+}
@@ -0,0 +1,92 @@
+#include "telehash.h"
+#include "jwt.h"
+#include "unit_test.h"
+#include "bench.h"
+
+#define TOKENS 64
+#define SIGNERS 4
+
+// tokens verified one at a time and as a batch, signed by a few different keys
+static lob_t tokens[TOKENS];
+static e3x_exchange_t xs[TOKENS];
+static uint32_t bad = 0;
+
+static void single_fn(void *arg)
+{
+  uint32_t i;
+  for(i=0;i<TOKENS;i++) if(!jwt_verify(tokens[i],xs[i])) bad++;
+}
+
+static void batch_fn(void *arg)
+{
+  if(jwt_verify_batch(tokens,xs,TOKENS,NULL) != TOKENS) bad++;
+}
+
+static void threads_fn(void *arg)
+{
+  if(jwt_verify_threads(tokens,xs,TOKENS,NULL,*(uint32_t*)arg) != TOKENS) bad++;
+}
+
+static void bench(char *alg, uint8_t csid, char *hex, e3x_self_t self)
+{
+  lob_t ids[SIGNERS], key;
+  e3x_self_t selves[SIGNERS];
+  uint32_t i, threads[] = {2,4};
+  char name[32];
+
+  for(i=0;i<SIGNERS;i++)
+  {
+    ids[i] = e3x_generate();
+    if(!(selves[i] = e3x_self_new(ids[i],NULL))) bad++;
+  }
+  fail_unless(!bad);
+  for(i=0;i<TOKENS;i++)
+  {
+    tokens[i] = lob_set(lob_set(lob_new(),"alg",alg),"typ","JWT");
+    lob_link(tokens[i],lob_set_int(lob_new(),"sub",i));
+    if(!jwt_sign(tokens[i],selves[i % SIGNERS])) bad++;
+    key = lob_get_base32(lob_linked(ids[i % SIGNERS]),hex);
+    if(!(xs[i] = e3x_exchange_new(self, csid, key))) bad++;
+    lob_free(key);
+  }
+  fail_unless(!bad);
+
+  bench_run(alg, "verify", TOKENS, single_fn, NULL);
+  bench_run(alg, "verify_batch", TOKENS, batch_fn, NULL);
+  for(i=0;i<sizeof(threads)/sizeof(threads[0]);i++)
+  {
+    snprintf(name, sizeof(name), "threads%u", threads[i]);
+    bench_run(alg, name, TOKENS, threads_fn, &threads[i]);
+  }
+  fail_unless(!bad);
+
+  for(i=0;i<TOKENS;i++)
+  {
+    lob_free(tokens[i]);
+    e3x_exchange_free(xs[i]);
+  }
+  for(i=0;i<SIGNERS;i++)
+  {
+    e3x_self_free(selves[i]);
+    lob_free(ids[i]);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  fail_unless(!e3x_init(NULL));
+  util_sys_logging(0);
+  bench_open(argc, argv);
+
+  lob_t id = e3x_generate();
+  e3x_self_t self = e3x_self_new(id,NULL);
+  fail_unless(self);
+
+  bench("ES160", 0x1a, "1a", self);
+  bench("ES256", 0x1c, "1c", self);
+
+  e3x_self_free(self);
+  lob_free(id);
+
+  return bench_close();
+}
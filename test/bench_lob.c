@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <time.h>
+#include "telehash.h"
+
+#define ITERATIONS 500000
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// the lookups a received channel packet gets from link_receive, chan_receive and a reliable handler
+static char *lookups[] = {"c","c","type","end","err","seq","ack","miss",NULL};
+
+// per-packet cost of header lookups, a js0n scan each (before) vs the lob's key index (after), and of building heads
+int main(int argc, char **argv)
+{
+  uint32_t i, k, found;
+  uint64_t start;
+  size_t len;
+  lob_t packet;
+  uint8_t body[100];
+
+  util_sys_logging(0);
+  memset(body,42,100);
+  packet = lob_new();
+  lob_set_uint(packet,"c",1234);
+  lob_set(packet,"type","stream");
+  lob_set_uint(packet,"seq",4321);
+  lob_set_uint(packet,"ack",4300);
+  lob_set_raw(packet,"miss",0,"[4301,4302,4310]",0);
+  lob_body(packet,body,100);
+  lob_t wire = lob_copy(packet);
+  lob_free(packet);
+
+  found = 0;
+  start = now_ns();
+  for(i=0;i<ITERATIONS;i++)
+  {
+    packet = lob_parse(lob_raw(wire),lob_len(wire));
+    for(k=0;lookups[k];k++) if(js0n(lookups[k],0,(char*)packet->head,packet->head_len,&len)) found++;
+    lob_free(packet);
+  }
+  printf("js0n per lookup: %5lu ns/packet (%u found)\n",(unsigned long)((now_ns() - start) / ITERATIONS),found);
+
+  found = 0;
+  start = now_ns();
+  for(i=0;i<ITERATIONS;i++)
+  {
+    packet = lob_parse(lob_raw(wire),lob_len(wire));
+    for(k=0;lookups[k];k++) if(lob_get_raw(packet,lookups[k])) found++;
+    lob_free(packet);
+  }
+  printf("lob key index:   %5lu ns/packet (%u found)\n",(unsigned long)((now_ns() - start) / ITERATIONS),found);
+
+  lob_free(wire);
+
+  // building a handshake-sized head, replacing setters vs the in place builder
+  util_pool_stats_t stats = util_pool_stats();
+  uint64_t allocs = stats->allocs;
+  start = now_ns();
+  for(i=0;i<ITERATIONS;i++)
+  {
+    packet = lob_new();
+    lob_set(packet,"type","link");
+    lob_set_uint(packet,"at",1234567890);
+    lob_set(packet,"id","abcdefghijklmnop");
+    lob_set(packet,"csid","1a");
+    lob_set(packet,"hashname","uvabrvfqacyvgcu8kbrrmk9apjbvgvn2wjechqr3vf9c1zm9hv7g");
+    lob_set_raw(packet,"1a",2,"true",4);
+    lob_free(packet);
+  }
+  printf("lob_set x6:      %5lu ns/head, %.1f allocs\n",(unsigned long)((now_ns() - start) / ITERATIONS),(double)(stats->allocs - allocs)/ITERATIONS);
+
+  allocs = stats->allocs;
+  start = now_ns();
+  for(i=0;i<ITERATIONS;i++)
+  {
+    packet = lob_begin(lob_new());
+    lob_add(packet,"type","link");
+    lob_add_uint(packet,"at",1234567890);
+    lob_add(packet,"id","abcdefghijklmnop");
+    lob_add(packet,"csid","1a");
+    lob_add(packet,"hashname","uvabrvfqacyvgcu8kbrrmk9apjbvgvn2wjechqr3vf9c1zm9hv7g");
+    lob_add_raw(packet,"1a",2,"true",4);
+    lob_finish(packet);
+    lob_free(packet);
+  }
+  printf("lob_add x6:      %5lu ns/head, %.1f allocs\n",(unsigned long)((now_ns() - start) / ITERATIONS),(double)(stats->allocs - allocs)/ITERATIONS);
+
+  return 0;
+}
@@ -0,0 +1,107 @@
+#include <time.h>
+#include "telehash.h"
+#include "unit_test.h"
+
+#define ITERATIONS 200000
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void drain(chan_t c, void *arg)
+{
+  lob_t packet;
+  while((packet = chan_receiving(c))) lob_free(packet);
+}
+
+// per-packet cost of link and channel lookups as the number of them grows, should stay flat
+int main(int argc, char **argv)
+{
+  uint32_t sizes[] = {10, 100, 1000, 10000, 100000, 0};
+  uint32_t s, i, n;
+  uint8_t bin[32];
+  uint64_t start, get_ns, id_ns, rx_ns;
+  link_t *links;
+  lob_t packet;
+
+  fail_unless(!e3x_init(NULL));
+  util_sys_logging(0);
+
+  for(s=0;(n = sizes[s]);s++)
+  {
+    mesh_t mesh = mesh_new();
+    lob_free(mesh_generate(mesh));
+    links = malloc(n * sizeof(link_t));
+
+    // links w/ a stub exchange, just enough to have a routing token
+    for(i=0;i<n;i++)
+    {
+      e3x_rand(bin,32);
+      links[i] = link_get(mesh, hashname_vbin(bin));
+      links[i]->x = malloc(sizeof (struct e3x_exchange_struct));
+      memset(links[i]->x,0,sizeof (struct e3x_exchange_struct));
+      links[i]->x->cs = e3x_cipher_set(0x1a,NULL);
+      e3x_rand(links[i]->x->token,16);
+      mesh_index(mesh, links[i]);
+    }
+
+    start = now_ns();
+    for(i=0;i<ITERATIONS;i++) if(link_get(mesh, links[(i*7919) % n]->id) != links[(i*7919) % n]) break;
+    get_ns = (now_ns() - start) / ITERATIONS;
+    fail_unless(i == ITERATIONS);
+
+    start = now_ns();
+    for(i=0;i<ITERATIONS;i++) if(mesh_linkid(mesh, links[(i*7919) % n]->id) != links[(i*7919) % n]) break;
+    id_ns = (now_ns() - start) / ITERATIONS;
+    fail_unless(i == ITERATIONS);
+
+    // channel packets, fail right after the token lookup since there's no ephemeral
+    start = now_ns();
+    for(i=0;i<ITERATIONS;i++)
+    {
+      packet = lob_new();
+      lob_body(packet,NULL,32);
+      memcpy(packet->body,links[(i*7919) % n]->x->token,16);
+      mesh_receive(mesh, packet);
+    }
+    rx_ns = (now_ns() - start) / ITERATIONS;
+
+    printf("%6u links: link_get %4lu ns, mesh_linkid %4lu ns, mesh_receive %4lu ns/packet\n",n,(unsigned long)get_ns,(unsigned long)id_ns,(unsigned long)rx_ns);
+
+    mesh_free(mesh);
+    free(links);
+  }
+
+  // channel packets on one link
+  for(s=0;(n = sizes[s]) && n <= 10000;s++)
+  {
+    mesh_t mesh = mesh_new();
+    lob_free(mesh_generate(mesh));
+    e3x_rand(bin,32);
+    link_t link = link_get(mesh, hashname_vbin(bin));
+    for(i=0;i<n;i++)
+    {
+      packet = lob_set(lob_new(),"type","bench");
+      lob_set_uint(packet,"c",(i*2)+1);
+      chan_handle(link_chan(link, packet), drain, NULL);
+      lob_free(packet);
+    }
+
+    start = now_ns();
+    for(i=0;i<ITERATIONS;i++)
+    {
+      packet = lob_new();
+      lob_set_uint(packet,"c",(((i*7919) % n)*2)+1);
+      link_receive(link, packet);
+    }
+    rx_ns = (now_ns() - start) / ITERATIONS;
+    printf("%6u chans: link_receive %4lu ns/packet\n",n,(unsigned long)rx_ns);
+
+    mesh_free(mesh);
+  }
+
+  return 0;
+}
@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <time.h>
+#include "telehash.h"
+
+#define ITERATIONS 1000000
+#define BATCH 64
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// pooled vs system allocator for the packet-sized blocks we churn, in batches like a burst of frames
+int main(int argc, char **argv)
+{
+  size_t sizes[] = {24, 132, 300, 1500, 0};
+  void *ptrs[BATCH];
+  uint32_t s, i, j;
+  uint64_t start, sys_ns, pool_ns;
+  util_pool_stats_t stats = util_pool_stats();
+
+  util_sys_logging(0);
+
+  for(s=0;sizes[s];s++)
+  {
+    start = now_ns();
+    for(i=0;i<ITERATIONS/BATCH;i++)
+    {
+      for(j=0;j<BATCH;j++) ptrs[j] = malloc(sizes[s]);
+      for(j=0;j<BATCH;j++) free(ptrs[j]);
+    }
+    sys_ns = now_ns() - start;
+
+    start = now_ns();
+    for(i=0;i<ITERATIONS/BATCH;i++)
+    {
+      for(j=0;j<BATCH;j++) ptrs[j] = util_pool_malloc(sizes[s]);
+      for(j=0;j<BATCH;j++) util_pool_free(ptrs[j]);
+    }
+    pool_ns = now_ns() - start;
+
+    printf("%5lu bytes: malloc/free %5.1f ns, util_pool %5.1f ns\n",(unsigned long)sizes[s],(double)sys_ns/ITERATIONS,(double)pool_ns/ITERATIONS);
+  }
+
+  // whole packets
+  start = now_ns();
+  for(i=0;i<ITERATIONS/BATCH;i++)
+  {
+    lob_t list = NULL;
+    for(j=0;j<BATCH;j++)
+    {
+      lob_t p = lob_new();
+      lob_set_uint(p,"c",j+1);
+      lob_body(p,NULL,100);
+      list = lob_push(list,p);
+    }
+    lob_freeall(list);
+  }
+  printf("lob_new/lob_free w/ head and body %5.1f ns/packet\n",(double)(now_ns() - start)/ITERATIONS);
+  printf("pool stats: %lu allocs, %lu hits, %lu misses, %lu large, %u cached\n",(unsigned long)stats->allocs,(unsigned long)stats->hits,(unsigned long)stats->misses,(unsigned long)stats->large,stats->cached);
+
+  return 0;
+}
@@ -0,0 +1,108 @@
+#include <time.h>
+#include "telehash.h"
+#include "net_loopback.h"
+#include "unit_test.h"
+
+#define ITERATIONS 200000
+#define PAYLOAD 100
+
+// linked w/ -Wl,--wrap so every heap allocation can be counted
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+static uint32_t allocs = 0;
+void *__wrap_malloc(size_t size) { allocs++; return __real_malloc(size); }
+void *__wrap_calloc(size_t nmemb, size_t size) { allocs++; return __real_calloc(nmemb,size); }
+void *__wrap_realloc(void *ptr, size_t size) { allocs++; return __real_realloc(ptr,size); }
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// stands in for udp4_send, which only queues the packet onto the pipe's frames
+static lob_t queued = NULL;
+static link_t sink(link_t link, lob_t packet, void *arg)
+{
+  if(packet) queued = lob_push(queued,packet);
+  return link;
+}
+
+// allocations and time per channel packet from chan_send() to the network pipe
+int main(int argc, char **argv)
+{
+  uint32_t i, build, send;
+  uint64_t start, ns;
+  uint8_t payload[PAYLOAD];
+  lob_t packet, outer;
+
+  lob_t opt = lob_set(lob_new(),"force","1a");
+  fail_unless(!e3x_init(opt));
+  lob_free(opt);
+  util_sys_logging(0);
+
+  mesh_t meshA = mesh_new();
+  lob_free(mesh_generate(meshA));
+  mesh_t meshB = mesh_new();
+  lob_free(mesh_generate(meshB));
+  net_loopback_t pair = net_loopback_new(meshA,meshB);
+  link_t link = link_get(meshA, meshB->id);
+  fail_unless(link_resync(link));
+  fail_unless(link_up(link));
+  link_pipe(link, sink, NULL);
+  lob_freeall(queued);
+  queued = NULL;
+
+  packet = lob_set(lob_new(),"type","bench");
+  chan_t chan = link_chan(link, packet);
+  lob_free(packet);
+  fail_unless(chan);
+  e3x_rand(payload,PAYLOAD);
+
+  // previous path, encrypt into a new outer and free the inner
+  build = send = 0;
+  start = now_ns();
+  for(i=0;i<ITERATIONS;i++)
+  {
+    allocs = 0;
+    packet = lob_new();
+    lob_set_uint(packet,"c",chan->id);
+    lob_body(packet,payload,PAYLOAD);
+    build += allocs;
+    allocs = 0;
+    outer = e3x_exchange_send(link->x, packet);
+    lob_free(packet);
+    link_send(link, outer);
+    send += allocs;
+    if(i % 1000 == 0) queued = lob_freeall(queued);
+  }
+  ns = (now_ns() - start) / ITERATIONS;
+  queued = lob_freeall(queued);
+  printf("copy: %.2f allocs building, %.2f allocs sending, %4lu ns/packet\n",(float)build/ITERATIONS,(float)send/ITERATIONS,(unsigned long)ns);
+
+  // chan_packet reserves room and chan_send encrypts in place
+  build = send = 0;
+  start = now_ns();
+  for(i=0;i<ITERATIONS;i++)
+  {
+    allocs = 0;
+    packet = chan_packet(chan);
+    lob_body(packet,payload,PAYLOAD);
+    build += allocs;
+    allocs = 0;
+    chan_send(chan, packet);
+    send += allocs;
+    if(i % 1000 == 0) queued = lob_freeall(queued);
+  }
+  ns = (now_ns() - start) / ITERATIONS;
+  queued = lob_freeall(queued);
+  printf("wrap: %.2f allocs building, %.2f allocs sending, %4lu ns/packet\n",(float)build/ITERATIONS,(float)send/ITERATIONS,(unsigned long)ns);
+  fail_unless(send <= ITERATIONS);
+
+  net_loopback_free(pair);
+  mesh_free(meshA);
+  mesh_free(meshB);
+  return 0;
+}
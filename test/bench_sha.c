@@ -0,0 +1,58 @@
+#include "telehash.h"
+#include "bench.h"
+
+// a MAC of a len byte packet, w/ a fresh 20 byte key (enckey+iv, like every channel packet) or one already keyed
+typedef struct sha_struct
+{
+  struct hmac_256_struct ctx;
+  uint8_t key[20], out[32];
+  size_t len;
+} *sha_t;
+
+static uint8_t buf[1500];
+
+static void hmac_fn(void *arg)
+{
+  sha_t sha = (sha_t)arg;
+  hmac_256(sha->key,sizeof(sha->key),buf,sha->len,sha->out);
+  buf[0] = sha->out[0];
+}
+
+static void keyed_fn(void *arg)
+{
+  sha_t sha = (sha_t)arg;
+  hmac_256_keyed(&(sha->ctx),buf,sha->len,sha->out);
+  buf[0] = sha->out[0];
+}
+
+int main(int argc, char **argv)
+{
+  size_t sizes[] = {64, 1400};
+  struct sha_struct sha;
+  char name[32];
+  uint32_t i;
+  uint8_t hw;
+
+  bench_open(argc, argv);
+  memset(sha.key,42,sizeof(sha.key));
+  hmac_256_key(&(sha.ctx),sha.key,sizeof(sha.key));
+
+  hw = sha256_hw(1);
+  for(i=0;i<sizeof(sizes)/sizeof(sizes[0]);i++)
+  {
+    sha.len = sizes[i];
+    sha256_hw(0);
+    snprintf(name,sizeof(name),"hmac_%lu",(unsigned long)sizes[i]);
+    bench_run("sha", name, 1, hmac_fn, &sha);
+    snprintf(name,sizeof(name),"keyed_%lu",(unsigned long)sizes[i]);
+    bench_run("sha", name, 1, keyed_fn, &sha);
+    if(!hw || !sha256_hw(1)) continue;
+    snprintf(name,sizeof(name),"hmac_ni_%lu",(unsigned long)sizes[i]);
+    bench_run("sha", name, 1, hmac_fn, &sha);
+    snprintf(name,sizeof(name),"keyed_ni_%lu",(unsigned long)sizes[i]);
+    bench_run("sha", name, 1, keyed_fn, &sha);
+  }
+  sha256_hw(1);
+
+  return bench_close();
+}
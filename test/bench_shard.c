@@ -0,0 +1,91 @@
+#include <time.h>
+#include <unistd.h>
+#include "telehash.h"
+#include "net_shard.h"
+#include "unit_test.h"
+
+#define CLIENTS 64
+#define HANDSHAKES 256
+#define WINDOW 64
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// replay the same handshakes from many addresses, the kernel spreads them across the threads
+static void bench(uint32_t threads, lob_t secrets, lob_t *handshakes, int *socks)
+{
+  uint32_t i, sent, received;
+  uint64_t start, ns;
+  struct sockaddr_in sa;
+
+  lob_t options = lob_set_uint(lob_new(),"threads",threads);
+  net_shards_t shards = net_shards_new(secrets, lob_linked(secrets), options);
+  lob_free(options);
+  fail_unless(shards);
+  for(i=0;i<threads;i++) mesh_on_discover(net_shards_mesh(shards, i),"auto",mesh_add);
+  fail_unless(net_shards_start(shards));
+
+  memset(&sa,0,sizeof(sa));
+  sa.sin_family = AF_INET;
+  inet_aton("127.0.0.1", &(sa.sin_addr));
+  sa.sin_port = htons(net_shards_port(shards));
+
+  // keep a window outstanding, anything dropped just ends the run at the deadline
+  start = now_ns();
+  for(sent=received=0;received < HANDSHAKES && now_ns() - start < 10000000000ULL;)
+  {
+    for(;sent < HANDSHAKES && sent - received < WINDOW;sent++)
+    {
+      i = sent % CLIENTS;
+      sendto(socks[i], lob_raw(handshakes[i]), lob_len(handshakes[i]), 0, (struct sockaddr *)&sa, sizeof(sa));
+    }
+    usleep(100);
+    received = net_shards_received(shards);
+  }
+  ns = now_ns() - start;
+
+  printf("%2u threads: %6.0f handshakes/sec, %4u forwarded\n",threads,(double)received * 1e9 / (double)ns,net_shards_forwarded(shards));
+  net_shards_free(shards);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t i;
+  int socks[CLIENTS];
+  lob_t handshakes[CLIENTS];
+
+  fail_unless(!e3x_init(NULL));
+  util_sys_logging(0);
+
+  lob_t secrets = e3x_generate();
+  fail_unless(secrets);
+
+  // one client per socket, its handshake made once up front
+  for(i=0;i<CLIENTS;i++)
+  {
+    mesh_t mesh = mesh_new();
+    lob_free(mesh_generate(mesh));
+    link_t link = link_get_keys(mesh, lob_linked(secrets));
+    fail_unless(link);
+    handshakes[i] = link_handshake(link);
+    fail_unless(handshakes[i]);
+    mesh_free(mesh);
+    fail_unless((socks[i] = socket(AF_INET, SOCK_DGRAM, 0)) >= 0);
+  }
+
+  printf("%ld cpus\n",sysconf(_SC_NPROCESSORS_ONLN));
+  for(i=1;i<=16;i*=2) bench(i, secrets, handshakes, socks);
+
+  for(i=0;i<CLIENTS;i++)
+  {
+    lob_free(handshakes[i]);
+    close(socks[i]);
+  }
+  lob_free(secrets);
+
+  return 0;
+}
@@ -0,0 +1,151 @@
+#include <time.h>
+#include "telehash.h"
+#include "net_sim.h"
+#include "unit_test.h"
+
+#define PACKETS 2000
+#define PAYLOAD 1000
+#define PEERS 50
+#define TICK 10 // ms each sim clock unit stands for, w/o a mesh_clock() the resend floor is CHAN_RESEND of these units
+
+static uint64_t now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static uint32_t received, misordered;
+static void bulk_handler(chan_t chan, void *arg)
+{
+  lob_t packet;
+  while((packet = chan_receiving(chan)))
+  {
+    if(lob_get(packet,"n") && lob_get_uint(packet,"n") != received++) misordered++;
+    lob_free(packet);
+  }
+}
+
+static lob_t bulk_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","bulk")) return open;
+  chan_t chan = link_chan(link, open);
+  chan_handle(chan,bulk_handler,NULL);
+  chan_receive(chan,open);
+  chan_process(chan,0);
+  return NULL;
+}
+
+// a reliable bulk transfer over a pair, the app sends as fast as it's given credit
+static void bulk(char *name, char *json)
+{
+  uint8_t payload[PAYLOAD];
+  uint32_t sent, until = (10 * 60 * 1000) / TICK;
+  uint64_t start;
+  lob_t options = lob_new(), packet;
+
+  memset(payload,42,PAYLOAD);
+  lob_head(options,(uint8_t*)json,strlen(json));
+  received = misordered = 0;
+  net_sim_t sim = net_sim_new(1);
+  mesh_t meshA = mesh_new();
+  lob_free(mesh_generate(meshA));
+  mesh_on_open(meshA,"bulk",bulk_on_open);
+  mesh_t meshB = mesh_new();
+  lob_free(mesh_generate(meshB));
+  net_sim_pair_t pair = net_sim_pair(sim,meshA,meshB,options);
+  link_t link = link_get(meshB, meshA->id);
+  link_resync(link);
+
+  start = now_us();
+  while(!link_up(link) && net_sim_now(sim) < until) net_sim_step(sim, until);
+  uint32_t up = net_sim_now(sim) * TICK;
+
+  packet = lob_set(lob_new(),"type","bulk");
+  chan_t chan = link_chan(link, packet);
+  chan_reliable(chan, 0);
+  chan_send(chan, packet);
+  for(sent=0;received < PACKETS && net_sim_now(sim) < until;net_sim_step(sim, until))
+  {
+    for(;sent < PACKETS && chan_writable(chan) >= PAYLOAD;sent++)
+    {
+      packet = chan_packet(chan);
+      lob_set_uint(packet,"n",sent);
+      lob_body(packet,payload,PAYLOAD);
+      chan_send(chan, packet);
+    }
+  }
+  uint64_t wall = now_us() - start;
+  uint32_t took = (net_sim_now(sim) * TICK) - up;
+  net_sim_path_t path = net_sim_path(pair, meshB);
+
+  printf("%-10s %s\n",name,json);
+  printf("  %u/%u in order (%u misordered), handshake %ums, transfer %ums, %.1f KB/s simulated\n",
+    received, PACKETS, misordered, up, took, took ? (double)received * PAYLOAD / took : 0);
+  printf("  %.2f sends/packet, %u lost %u overflowed %u reordered %u duplicated, %.1fms wall (%.0f sim ms/wall ms)\n",
+    (double)path->sent / PACKETS, path->lost, path->overflowed, path->reordered, path->duplicated,
+    wall / 1000.0, wall ? (double)net_sim_now(sim) * TICK * 1000 / wall : 0);
+
+  mesh_free(meshA);
+  mesh_free(meshB);
+  net_sim_free(sim);
+  lob_free(options);
+}
+
+// many meshes all linking to one at once over lossy paths
+static void storm(char *json)
+{
+  mesh_t peers[PEERS];
+  link_t links[PEERS];
+  net_sim_pair_t pairs[PEERS];
+  uint32_t i, up, next, handshakes = 0, until = (60 * 1000) / TICK;
+  uint64_t start;
+  lob_t options = lob_new();
+
+  lob_head(options,(uint8_t*)json,strlen(json));
+  net_sim_t sim = net_sim_new(1);
+  mesh_t hub = mesh_new();
+  lob_free(mesh_generate(hub));
+  for(i=0;i<PEERS;i++)
+  {
+    peers[i] = mesh_new();
+    lob_free(mesh_generate(peers[i]));
+    pairs[i] = net_sim_pair(sim,hub,peers[i],options);
+    links[i] = link_get(peers[i], hub->id);
+    link_resync(links[i]);
+  }
+
+  start = now_us();
+  // links don't resend handshakes on their own, each peer tries again every second until it's up
+  for(up=0,next=1000/TICK;up < PEERS && net_sim_now(sim) < until;net_sim_step(sim, (next < until) ? next : until))
+  {
+    for(up=i=0;i<PEERS;i++) if(link_up(links[i])) up++;
+    if(net_sim_now(sim) < next) continue;
+    for(i=0;i<PEERS;i++) if(!link_up(links[i])) link_resync(links[i]);
+    next += 1000/TICK;
+  }
+  for(i=0;i<PEERS;i++) handshakes += net_sim_path(pairs[i], peers[i])->sent + net_sim_path(pairs[i], hub)->sent;
+  uint64_t wall = now_us() - start;
+
+  printf("storm      %s\n",json);
+  printf("  %u/%u peers up by %ums, %u handshakes sent, %.1fms wall\n", up, PEERS, net_sim_now(sim) * TICK, handshakes, wall / 1000.0);
+
+  for(i=0;i<PEERS;i++) mesh_free(peers[i]);
+  mesh_free(hub);
+  net_sim_free(sim);
+  lob_free(options);
+}
+
+int main(int argc, char **argv)
+{
+  fail_unless(!e3x_init(NULL));
+
+  // in ticks and bytes/tick, 10000 is 8Mbit
+  bulk("lan", "{\"latency\":0,\"bandwidth\":125000}");
+  bulk("wan", "{\"latency\":4,\"jitter\":1,\"bandwidth\":25000,\"queue\":64000}");
+  bulk("wifi", "{\"latency\":1,\"jitter\":2,\"bandwidth\":10000,\"loss\":3,\"reorder\":5,\"duplicate\":2}");
+  bulk("satellite", "{\"latency\":30,\"jitter\":2,\"bandwidth\":5000,\"queue\":32000,\"loss\":1}");
+  storm("{\"latency\":2,\"jitter\":1,\"loss\":10}");
+
+  return 0;
+}
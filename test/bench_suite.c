@@ -0,0 +1,299 @@
+#include "telehash.h"
+#include "net_loopback.h"
+#include "unit_test.h"
+#include "bench.h"
+
+#define PAYLOAD 1000
+
+// everything on the per-packet path in one run, "./bin/bench_suite out.json" also writes the results for comparing runs
+static uint8_t payload[PAYLOAD];
+static uint32_t bad = 0;
+
+// lob: a channel packet's head and body, parsed, read and built
+static lob_t wire;
+static char *lookups[] = {"c","type","seq","ack","miss","end","err","c",NULL};
+
+static void lob_parse_fn(void *arg)
+{
+  lob_free(lob_parse(lob_raw(wire),lob_len(wire)));
+}
+
+static void lob_set_fn(void *arg)
+{
+  lob_t packet = lob_new();
+  lob_set_uint(packet,"c",1234);
+  lob_set(packet,"type","stream");
+  lob_set_uint(packet,"seq",4321);
+  lob_set_uint(packet,"ack",4300);
+  lob_free(packet);
+}
+
+static void lob_get_fn(void *arg)
+{
+  uint32_t k;
+  for(k=0;lookups[k];k++) if(!lob_get_raw((lob_t)arg,lookups[k]) && k < 5) bad++;
+}
+
+static void js0n_fn(void *arg)
+{
+  size_t len;
+  if(!js0n("miss",0,(char*)wire->head,wire->head_len,&len)) bad++;
+}
+
+// base32 and murmur on hashname sized input
+static uint8_t bin[32];
+static char b32[64];
+static void base32_encode_fn(void *arg)
+{
+  base32_encode(bin,32,b32,sizeof(b32));
+}
+
+static void base32_decode_fn(void *arg)
+{
+  uint8_t out[32];
+  if(base32_decode(b32,52,out,sizeof(out)) != 32) bad++;
+}
+
+static void murmur_fn(void *arg)
+{
+  if(!murmur4(payload,PAYLOAD)) bad++;
+}
+
+// a cipher set: handshakes out and in, and channel packets encrypted and decrypted on a synced pair
+typedef struct cs_struct
+{
+  e3x_self_t selfA, selfB;
+  e3x_exchange_t xAB, xBA;
+  lob_t hs, inner, outer, sealed;
+} *cs_t;
+
+static void cs_handshake_fn(void *arg)
+{
+  lob_free(e3x_exchange_handshake(((cs_t)arg)->xAB, NULL));
+}
+
+static void cs_handshake_in_fn(void *arg)
+{
+  cs_t cs = (cs_t)arg;
+  lob_t inner = e3x_self_decrypt(cs->selfB, cs->hs);
+  if(!inner || e3x_exchange_verify(cs->xBA, cs->hs) || !e3x_exchange_sync(cs->xBA, cs->hs)) bad++;
+  lob_free(inner);
+}
+
+static void cs_encrypt_fn(void *arg)
+{
+  cs_t cs = (cs_t)arg;
+  lob_free(e3x_exchange_send(cs->xAB, cs->inner));
+}
+
+static void cs_decrypt_fn(void *arg)
+{
+  cs_t cs = (cs_t)arg;
+  // decrypted in place, each starts over from the ciphertext
+  memcpy(cs->outer->body, cs->sealed->body, cs->sealed->body_len);
+  lob_t inner = e3x_exchange_receive(cs->xBA, cs->outer);
+  if(!inner) bad++;
+  lob_free(inner);
+}
+
+static e3x_exchange_t cs_exchange(e3x_self_t self, lob_t id, uint8_t csid, char *hex)
+{
+  lob_t key = lob_get_base32(lob_linked(id),hex);
+  e3x_exchange_t x = e3x_exchange_new(self, csid, key);
+  lob_free(key);
+  if(x) e3x_exchange_out(x,1);
+  return x;
+}
+
+static void cs_suite(uint8_t csid, char *hex, lob_t idA, lob_t idB)
+{
+  struct cs_struct cs;
+  char suite[8];
+  lob_t hs;
+
+  if(!e3x_cipher_set(csid,NULL)) return;
+  snprintf(suite,sizeof(suite),"cs%s",hex);
+  cs.selfA = e3x_self_new(idA,NULL);
+  cs.selfB = e3x_self_new(idB,NULL);
+  fail_unless(cs.selfA && cs.selfB);
+  cs.xAB = cs_exchange(cs.selfA, idB, csid, hex);
+  cs.xBA = cs_exchange(cs.selfB, idA, csid, hex);
+  fail_unless(cs.xAB && cs.xBA);
+
+  cs.hs = e3x_exchange_handshake(cs.xAB, NULL);
+  fail_unless(cs.hs);
+  bench_run(suite, "handshake", 1, cs_handshake_fn, &cs);
+  bench_run(suite, "handshake_in", 1, cs_handshake_in_fn, &cs);
+
+  // synced both ways (after the syncs above) for the channel keys
+  hs = e3x_exchange_handshake(cs.xBA, NULL);
+  fail_unless(hs && e3x_exchange_sync(cs.xAB, hs));
+  lob_free(hs);
+  cs.inner = lob_set_uint(lob_new(),"c",e3x_exchange_cid(cs.xAB, NULL));
+  lob_body(cs.inner,payload,PAYLOAD);
+  cs.outer = e3x_exchange_send(cs.xAB, cs.inner);
+  fail_unless(cs.outer && (cs.sealed = lob_copy(cs.outer)));
+  bench_run(suite, "encrypt_1k", 1, cs_encrypt_fn, &cs);
+  bench_run(suite, "decrypt_1k", 1, cs_decrypt_fn, &cs);
+
+  lob_free(cs.hs);
+  lob_free(cs.inner);
+  lob_free(cs.outer);
+  lob_free(cs.sealed);
+  e3x_exchange_free(cs.xAB);
+  e3x_exchange_free(cs.xBA);
+  e3x_self_free(cs.selfA);
+  e3x_self_free(cs.selfB);
+}
+
+// a packet across a frames and a chunks stream pair
+static util_frames_t fa, fb;
+static util_chunks_t ca, cb;
+static void frames_fn(void *arg)
+{
+  uint8_t frame[64];
+  lob_t msg;
+
+  util_frames_send(fa, lob_copy((lob_t)arg));
+  while(util_frames_busy(fa) && util_frames_outbox(fa,frame,NULL))
+  {
+    util_frames_sent(fa);
+    if(!util_frames_inbox(fb,frame,NULL)) bad++;
+    if(util_frames_outbox(fb,frame,NULL))
+    {
+      util_frames_sent(fb);
+      if(!util_frames_inbox(fa,frame,NULL)) bad++;
+    }
+  }
+  if(!(msg = util_frames_receive(fb)) || msg->body_len != PAYLOAD) bad++;
+  lob_free(msg);
+}
+
+static void chunks_fn(void *arg)
+{
+  uint32_t len;
+  lob_t msg;
+
+  util_chunks_send(ca, lob_copy((lob_t)arg));
+  while((len = util_chunks_len(ca)))
+  {
+    util_chunks_read(cb,util_chunks_write(ca),len);
+    util_chunks_written(ca,len);
+  }
+  if(!(msg = util_chunks_receive(cb)) || msg->body_len != PAYLOAD) bad++;
+  lob_free(msg);
+}
+
+// channel packets from one mesh to another over net_loopback, per packet is packets/sec
+static chan_t loop_chan;
+static uint32_t loop_received = 0;
+static void loop_handler(chan_t chan, void *arg)
+{
+  lob_t packet;
+  while((packet = chan_receiving(chan)))
+  {
+    loop_received++;
+    lob_free(packet);
+  }
+}
+
+static lob_t loop_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","bench")) return open;
+  chan_t chan = link_chan(link, open);
+  chan_handle(chan,loop_handler,NULL);
+  chan_receive(chan,open);
+  chan_process(chan,0);
+  return NULL;
+}
+
+static void loopback_fn(void *arg)
+{
+  lob_t packet = chan_packet(loop_chan);
+  lob_body(packet,payload,PAYLOAD);
+  if(!chan_send(loop_chan, packet)) bad++;
+}
+
+int main(int argc, char **argv)
+{
+  lob_t packet, idA, idB;
+  uint32_t sent;
+
+  fail_unless(!e3x_init(NULL));
+  util_sys_logging(0);
+  e3x_rand(payload,PAYLOAD);
+  bench_open(argc, argv);
+
+  packet = lob_new();
+  lob_set_uint(packet,"c",1234);
+  lob_set(packet,"type","stream");
+  lob_set_uint(packet,"seq",4321);
+  lob_set_uint(packet,"ack",4300);
+  lob_set_raw(packet,"miss",0,"[1,2,10]",0);
+  lob_body(packet,payload,100);
+  wire = lob_copy(packet);
+  lob_free(packet);
+  packet = lob_parse(lob_raw(wire),lob_len(wire));
+  bench_run("lob", "parse", 1, lob_parse_fn, NULL);
+  bench_run("lob", "set_x4", 1, lob_set_fn, NULL);
+  bench_run("lob", "get", 8, lob_get_fn, packet);
+  bench_run("js0n", "lookup", 1, js0n_fn, NULL);
+  lob_free(packet);
+
+  e3x_rand(bin,32);
+  base32_encode(bin,32,b32,sizeof(b32));
+  bench_run("base32", "encode_32", 1, base32_encode_fn, NULL);
+  bench_run("base32", "decode_32", 1, base32_decode_fn, NULL);
+  bench_run("murmur", "murmur4_1k", 1, murmur_fn, NULL);
+
+  idA = e3x_generate();
+  idB = e3x_generate();
+  fail_unless(idA && idB);
+  cs_suite(0x1a, "1a", idA, idB);
+  cs_suite(0x1c, "1c", idA, idB);
+  cs_suite(0x2a, "2a", idA, idB);
+  cs_suite(0x3a, "3a", idA, idB);
+  lob_free(idA);
+  lob_free(idB);
+
+  packet = lob_new();
+  lob_body(packet,payload,PAYLOAD);
+  fa = util_frames_new(64);
+  fb = util_frames_new(64);
+  fa->flush = 1;
+  frames_fn(packet);
+  bench_run("util", "frames_1k", 1, frames_fn, packet);
+  util_frames_free(fa);
+  util_frames_free(fb);
+  ca = util_chunks_new(0);
+  ca->blocking = 0;
+  cb = util_chunks_new(0);
+  bench_run("util", "chunks_1k", 1, chunks_fn, packet);
+  util_chunks_free(ca);
+  util_chunks_free(cb);
+  lob_free(packet);
+
+  mesh_t meshA = mesh_new();
+  lob_free(mesh_generate(meshA));
+  mesh_on_open(meshA,"bench",loop_on_open);
+  mesh_t meshB = mesh_new();
+  lob_free(mesh_generate(meshB));
+  net_loopback_t pair = net_loopback_new(meshA,meshB);
+  link_t link = link_get(meshB, meshA->id);
+  fail_unless(link_resync(link) && link_up(link));
+  packet = lob_set(lob_new(),"type","bench");
+  loop_chan = link_chan(link, packet);
+  fail_unless(chan_send(loop_chan, packet));
+  sent = loop_received;
+  bench_run("mesh", "loopback_1k", 1, loopback_fn, NULL);
+  fail_unless(loop_received > sent);
+  net_loopback_free(pair);
+  mesh_free(meshA);
+  mesh_free(meshB);
+
+  lob_free(wire);
+  bench_close();
+  fail_unless(!bad);
+
+  return 0;
+}
@@ -0,0 +1,157 @@
+#define _GNU_SOURCE
+#include <time.h>
+#include <sys/socket.h>
+#include "telehash.h"
+#include "net_udp4.h"
+#include "net_loop.h"
+#include "unit_test.h"
+
+#define PACKETS 200
+#define PAYLOAD 1000
+#define WINDOW 32
+
+// linked w/ -Wl,--wrap so every socket call and the datagrams it moved can be counted
+static uint32_t calls = 0, frames = 0;
+ssize_t __real_recvfrom(int fd, void *buf, size_t len, int flags, struct sockaddr *sa, socklen_t *salen);
+ssize_t __real_sendto(int fd, const void *buf, size_t len, int flags, const struct sockaddr *sa, socklen_t salen);
+ssize_t __wrap_recvfrom(int fd, void *buf, size_t len, int flags, struct sockaddr *sa, socklen_t *salen)
+{
+  ssize_t ret = __real_recvfrom(fd,buf,len,flags,sa,salen);
+  calls++;
+  if(ret > 0) frames++;
+  return ret;
+}
+ssize_t __wrap_sendto(int fd, const void *buf, size_t len, int flags, const struct sockaddr *sa, socklen_t salen)
+{
+  ssize_t ret = __real_sendto(fd,buf,len,flags,sa,salen);
+  calls++;
+  if(ret > 0) frames++;
+  return ret;
+}
+#ifdef MSG_WAITFORONE
+int __real_recvmmsg(int fd, struct mmsghdr *msgs, unsigned int vlen, int flags, struct timespec *timeout);
+int __real_sendmmsg(int fd, struct mmsghdr *msgs, unsigned int vlen, int flags);
+int __wrap_recvmmsg(int fd, struct mmsghdr *msgs, unsigned int vlen, int flags, struct timespec *timeout)
+{
+  int ret = __real_recvmmsg(fd,msgs,vlen,flags,timeout);
+  calls++;
+  if(ret > 0) frames += (uint32_t)ret;
+  return ret;
+}
+int __wrap_sendmmsg(int fd, struct mmsghdr *msgs, unsigned int vlen, int flags)
+{
+  int ret = __real_sendmmsg(fd,msgs,vlen,flags);
+  calls++;
+  if(ret > 0) frames += (uint32_t)ret;
+  return ret;
+}
+#endif
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t received = 0;
+static lob_t bench_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","bench")) return open;
+  received++;
+  lob_free(open);
+  return NULL;
+}
+
+// one pair of meshes talking over real loopback sockets
+static void bench(char *name, lob_t options, uint8_t evented)
+{
+  uint32_t i, sent;
+  uint64_t start, ns;
+  uint8_t payload[PAYLOAD];
+
+  mesh_t meshA = mesh_new();
+  lob_free(mesh_generate(meshA));
+  mesh_t meshB = mesh_new();
+  lob_free(mesh_generate(meshB));
+  mesh_on_open(meshB, "bench", bench_on_open);
+
+  net_udp4_t netA = net_udp4_new(meshA, options);
+  net_udp4_t netB = net_udp4_new(meshB, options);
+  fail_unless(netA && netB);
+  net_loop_t loopA = net_loop_new(meshA, NULL);
+  net_loop_t loopB = net_loop_new(meshB, NULL);
+  if(evented)
+  {
+    net_loop_udp4(loopA, netA);
+    net_loop_udp4(loopB, netB);
+  }
+
+  link_t linkAB = link_get_keys(meshA, meshB->keys);
+  link_t linkBA = link_get_keys(meshB, meshA->keys);
+  fail_unless(linkAB && linkBA);
+  net_udp4_direct(netA,link_handshake(linkAB),"127.0.0.1",net_udp4_port(netB));
+  for(i=64;i && !(link_up(linkAB) && link_up(linkBA));i--)
+  {
+    net_udp4_process(netA);
+    net_udp4_process(netB);
+  }
+  fail_unless(i);
+
+  // keep a window of packets outstanding so whole datagrams don't overrun the socket buffer
+  e3x_rand(payload,PAYLOAD);
+  received = calls = frames = 0;
+  start = now_ns();
+  for(sent=0,i=PACKETS*8;i && received < PACKETS;i--)
+  {
+    for(;sent < PACKETS && sent - received < WINDOW;sent++)
+    {
+      lob_t packet = lob_set(lob_new(),"type","bench");
+      lob_body(packet,payload,PAYLOAD);
+      link_direct(linkAB, packet);
+    }
+    // one thread alternating, so the loops don't wait on each other
+    if(evented)
+    {
+      net_loop_run(loopA, 0);
+      net_loop_run(loopB, 0);
+      continue;
+    }
+    net_udp4_process(netA);
+    net_udp4_process(netB);
+  }
+  ns = now_ns() - start;
+  fail_unless(received == PACKETS);
+
+  printf("%s: %6.0f packets/sec, %7.0f datagrams/sec, %5.2f syscalls/packet, %5.2f datagrams/syscall\n",name,(double)PACKETS * 1e9 / (double)ns,(double)frames * 1e9 / (double)ns,(float)calls/PACKETS,(float)frames/calls);
+
+  // links drop their pipes as they're freed, so the meshes go first
+  net_loop_free(loopA);
+  net_loop_free(loopB);
+  mesh_free(meshA);
+  mesh_free(meshB);
+  net_udp4_free(netA);
+  net_udp4_free(netB);
+}
+
+int main(int argc, char **argv)
+{
+  lob_t options;
+
+  fail_unless(!e3x_init(NULL));
+  util_sys_logging(0);
+
+  options = lob_set_raw(lob_new(),"batch",0,"false",5);
+  bench("single",options,0);
+  lob_free(options);
+
+  bench("batch ",NULL,0);
+  bench("ev    ",NULL,1);
+
+  options = lob_set_uint(lob_new(),"mtu",1472);
+  bench("mtu   ",options,0);
+  bench("mtu+ev",options,1);
+  lob_free(options);
+
+  return 0;
+}
@@ -0,0 +1,58 @@
+#include "uECC.h"
+#include "unit_test.h"
+#include "bench.h"
+
+// everything that multiplies points
+static uint8_t priv[32], pub[64], hash[32], sig[64], shared[32];
+static uint32_t bad = 0;
+
+static void keys_fn(void *arg)
+{
+  if(!uECC_make_key(pub, priv, (uECC_Curve)arg)) bad++;
+}
+
+static void sign_fn(void *arg)
+{
+  if(!uECC_sign(priv, hash, sizeof(hash), sig, (uECC_Curve)arg)) bad++;
+}
+
+static void ecdh_fn(void *arg)
+{
+  if(!uECC_shared_secret(pub, priv, shared, (uECC_Curve)arg)) bad++;
+}
+
+static void verify_fn(void *arg)
+{
+  if(!uECC_verify(pub, hash, sizeof(hash), sig, (uECC_Curve)arg)) bad++;
+}
+
+static void bench(char *suite, uECC_Curve curve)
+{
+  fail_unless(uECC_make_key(pub, priv, curve));
+  memset(hash,42,sizeof(hash));
+
+  bench_run(suite, "make_key", 1, keys_fn, (void*)curve);
+  bench_run(suite, "sign", 1, sign_fn, (void*)curve);
+  bench_run(suite, "ecdh", 1, ecdh_fn, (void*)curve);
+  fail_unless(uECC_sign(priv, hash, sizeof(hash), sig, curve));
+  bench_run(suite, "verify", 1, verify_fn, (void*)curve);
+  fail_unless(!bad);
+}
+
+int main(int argc, char **argv)
+{
+  bench_open(argc, argv);
+  bench("p160", uECC_secp160r1());
+  bench("p256", uECC_secp256r1());
+
+  // again w/ the generator tables
+  if(!uECC_precompute(uECC_secp160r1()) || !uECC_precompute(uECC_secp256r1()))
+  {
+    printf("built without uECC_FIXED_BASE\n");
+    return bench_close();
+  }
+  bench("p160tbl", uECC_secp160r1());
+  bench("p256tbl", uECC_secp256r1());
+
+  return bench_close();
+}
@@ -45,6 +45,56 @@ int main(int argc, char **argv)
   lob_set_int(outgoing,"test",42);
   fail_unless(!chan_send(chan,outgoing)); // dropped, no link
 
+  // an open w/ a seq is reliable, packets come out in order once
+  open = lob_set_int(lob_set(lob_set_int(lob_new(),"c",3),"type","test"),"seq",1);
+  chan = chan_new(open);
+  fail_unless(chan);
+  fail_unless(chan->window == CHAN_WINDOW);
+  fail_unless(chan_receive(chan,open));
+  incoming = lob_set_int(lob_set_int(lob_new(),"c",3),"seq",3);
+  fail_unless(chan_receive(chan,incoming));
+  incoming = lob_set_int(lob_set_int(lob_new(),"c",3),"seq",5);
+  fail_unless(chan_receive(chan,incoming));
+  fail_unless(chan_receive(chan,lob_copy(incoming))); // dup
+  lob_t ack = chan_oob(chan);
+  fail_unless(lob_get_int(ack,"ack") == 1);
+  fail_unless(util_cmp(lob_get(ack,"miss"),"[1,3]") == 0);
+  fail_unless(lob_get_int(ack,"held") == 4); // 3 and 5
+  fail_unless(lob_get_uint(ack,"win") == CHAN_WINDOW - chan_size(chan));
+  lob_free(ack);
+  fail_unless(lob_get_int(chan_receiving(chan),"seq") == 1);
+  fail_unless(chan_receiving(chan) == NULL);
+  incoming = lob_set_int(lob_set_int(lob_new(),"c",3),"seq",2);
+  fail_unless(chan_receive(chan,incoming));
+  incoming = lob_set_int(lob_set_int(lob_new(),"c",3),"seq",4);
+  fail_unless(chan_receive(chan,incoming));
+  fail_unless(lob_get_int(chan_receiving(chan),"seq") == 2);
+  fail_unless(lob_get_int(chan_receiving(chan),"seq") == 3);
+  fail_unless(lob_get_int(chan_receiving(chan),"seq") == 4);
+  fail_unless(lob_get_int(chan_receiving(chan),"seq") == 5);
+  fail_unless(chan_receiving(chan) == NULL);
+  fail_unless(chan_size(chan) == 0);
+  ack = chan_oob(chan);
+  fail_unless(lob_get_int(ack,"ack") == 5);
+  fail_unless(!lob_get(ack,"miss"));
+  fail_unless(!lob_get(ack,"held"));
+  fail_unless(lob_get_uint(ack,"win") == CHAN_WINDOW);
+  lob_free(ack);
+
+  // and the reorder buffer is bounded
+  chan->window = 250;
+  uint32_t seq;
+  for(seq=9;seq>=7;seq--)
+  {
+    lob_t big = lob_set_int(lob_set_int(lob_new(),"c",3),"seq",(int)seq);
+    lob_body(big,NULL,90);
+    fail_unless(chan_receive(chan,big));
+  }
+  fail_unless(lob_get_uint(chan->reorder,"seq") == 8);
+  fail_unless(lob_get_uint(chan->reorder->next,"seq") == 9);
+  fail_unless(!chan->reorder->next->next);
+  chan_free(chan);
+
   return 0;
 }
 
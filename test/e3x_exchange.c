@@ -80,7 +80,6 @@ int main(int argc, char **argv)
   lob_free(inBA);
   lob_free(hsBA);
   lob_free(keyA);
-  lob_free(keyB);
   
   // send/receive channel packet
   lob_t chanAB = lob_new();
@@ -95,6 +94,42 @@ int main(int argc, char **argv)
   lob_free(cinAB);
   lob_free(coutAB);
 
+  // a restarted A's handshake verified/synced on a dup of B's side, then adopted
+  e3x_exchange_t xAB2 = e3x_exchange_new(selfA, csid, keyB);
+  fail_unless(xAB2);
+  fail_unless(e3x_exchange_out(xAB2,5));
+  lob_t hsAB2 = e3x_exchange_handshake(xAB2, NULL);
+  fail_unless(hsAB2);
+  e3x_exchange_t dupBA = e3x_exchange_dup(xBA);
+  fail_unless(dupBA);
+  fail_unless(dupBA->remote != xBA->remote);
+  fail_unless(!e3x_exchange_adopt(xBA,dupBA,hsAB2)); // not synced yet
+  fail_unless(e3x_exchange_verify(dupBA,hsAB2) == 0);
+  fail_unless(e3x_exchange_sync(dupBA,hsAB2));
+  fail_unless(e3x_exchange_adopt(xBA,dupBA,hsAB2));
+  fail_unless(!dupBA->ephem); // taken
+  fail_unless(e3x_exchange_adopt(xBA,dupBA,hsAB2)); // already has it
+  e3x_exchange_free(dupBA);
+  lob_free(hsAB2);
+  lob_t hsBA2 = e3x_exchange_handshake(xBA, NULL);
+  fail_unless(e3x_exchange_verify(xAB2,hsBA2) == 0);
+  fail_unless(e3x_exchange_sync(xAB2,hsBA2));
+  lob_free(hsBA2);
+  lob_free(keyB);
+
+  // channels are between the new pair now
+  lob_free(chanAB);
+  chanAB = lob_set_int(lob_new(),"c",e3x_exchange_cid(xAB2, NULL));
+  coutAB = e3x_exchange_send(xAB2,chanAB);
+  fail_unless(coutAB);
+  cinAB = e3x_exchange_receive(xBA,coutAB);
+  fail_unless(cinAB);
+  fail_unless(lob_get_int(cinAB,"c") == lob_get_int(chanAB,"c"));
+  lob_free(cinAB);
+  lob_free(coutAB);
+  lob_free(chanAB);
+  e3x_exchange_free(xAB2);
+
   e3x_exchange_free(xAB);
   e3x_exchange_free(xBA);
   e3x_self_free(selfA);
@@ -0,0 +1,134 @@
+#include "telehash.h"
+#include "unit_test.h"
+
+int main(int argc, char **argv)
+{
+  uint8_t secret[32], cookie[UTIL_ADMIT_COOKIE], cookie2[UTIL_ADMIT_COOKIE];
+  uint8_t a[6] = {127,0,0,1,0x10,0x01}, b[6] = {127,0,0,2,0x10,0x01};
+  uint64_t now = 1000000;
+  uint32_t i;
+
+  memset(secret,42,sizeof(secret));
+  fail_unless(!util_admit_new(NULL, NULL, 0));
+
+  // 2/sec per source, burst of 3
+  lob_t options = lob_set_uint(lob_set_uint(lob_new(),"rate",2),"burst",3);
+  util_admit_t admit = util_admit_new(options, secret, sizeof(secret));
+  lob_free(options);
+  fail_unless(admit);
+  util_admit_stats_t stats = util_admit_stats(admit);
+  fail_unless(stats);
+  fail_unless(!util_admit_cookies(admit));
+
+  for(i=0;i<3;i++) fail_unless(util_admit_take(admit, a, sizeof(a), now));
+  fail_unless(!util_admit_take(admit, a, sizeof(a), now));
+  fail_unless(stats->admitted == 3 && stats->limited == 1);
+
+  // others have their own bucket
+  fail_unless(util_admit_take(admit, b, sizeof(b), now));
+
+  // refills at the rate, never past the burst
+  fail_unless(!util_admit_take(admit, a, sizeof(a), now + 400));
+  fail_unless(util_admit_take(admit, a, sizeof(a), now + 500));
+  now += 60000;
+  for(i=0;i<3;i++) fail_unless(util_admit_take(admit, a, sizeof(a), now));
+  fail_unless(!util_admit_take(admit, a, sizeof(a), now));
+
+  // w/o an address there's no source to limit, they don't all share one bucket
+  for(i=0;i<10;i++) fail_unless(util_admit_take(admit, NULL, 0, now));
+
+  // cookies are per source and last into the next window
+  fail_unless(util_admit_cookie(admit, a, sizeof(a), now, cookie));
+  fail_unless(stats->challenged == 1);
+  fail_unless(util_admit_verify(admit, a, sizeof(a), now, cookie));
+  fail_unless(!util_admit_verify(admit, b, sizeof(b), now, cookie));
+  fail_unless(util_admit_verify(admit, a, sizeof(a), now + UTIL_ADMIT_WINDOW * 1000, cookie));
+  fail_unless(!util_admit_verify(admit, a, sizeof(a), now + UTIL_ADMIT_WINDOW * 2000, cookie));
+  fail_unless(stats->bad_cookies == 2);
+  util_admit_free(admit);
+
+  // a different secret makes different cookies
+  secret[0] = 0;
+  options = lob_set_raw(lob_set_uint(lob_new(),"budget",2),"cookie",0,"true",4);
+  admit = util_admit_new(options, secret, sizeof(secret));
+  lob_free(options);
+  fail_unless(admit);
+  fail_unless(util_admit_cookies(admit));
+  fail_unless(util_admit_cookie(admit, a, sizeof(a), now, cookie2));
+  fail_unless(memcmp(cookie, cookie2, sizeof(cookie)) != 0);
+
+  // the budget is shared by every source, and the challenge above came out of it too
+  stats = util_admit_stats(admit);
+  fail_unless(util_admit_take(admit, a, sizeof(a), now));
+  fail_unless(!util_admit_take(admit, b, sizeof(b), now));
+  fail_unless(stats->over_budget == 1 && stats->limited == 0);
+  fail_unless(!util_admit_cookie(admit, b, sizeof(b), now, cookie2));
+  fail_unless(stats->over_budget == 2 && stats->challenged == 1);
+  fail_unless(util_admit_take(admit, b, sizeof(b), now + 500));
+  fail_unless(util_admit_cookie(admit, b, sizeof(b), now + 1000, cookie2));
+  util_admit_free(admit);
+
+  // a mesh challenges a handshake, then admits it echoing the cookie
+  mesh_t meshA = mesh_new();
+  lob_free(mesh_generate(meshA));
+  mesh_t meshB = mesh_new();
+  lob_free(mesh_generate(meshB));
+  mesh_on_discover(meshB,"auto",mesh_add);
+  options = lob_set_raw(lob_new(),"cookie",0,"true",4);
+  fail_unless(mesh_admission(meshB, options));
+  lob_free(options);
+  link_t link = link_get_keys(meshA, meshB->keys);
+  fail_unless(link);
+
+  lob_t reply = NULL;
+  fail_unless(!mesh_receive_from(meshB, link_handshake(link), a, sizeof(a), &reply));
+  fail_unless(reply);
+  fail_unless(lob_get_cmp(reply,"type","cookie") == 0);
+  fail_unless(!mesh_linkid(meshB, meshA->id));
+  fail_unless(mesh_receive_from(meshA, reply, b, sizeof(b), NULL) == link); // to pipe it
+  fail_unless(link->cookie[0]);
+
+  // from anywhere else it's no good, that address gets its own challenge
+  lob_t handshake = link_handshake(link);
+  fail_unless(handshake && handshake->head_len > 1);
+  fail_unless(!mesh_receive_from(meshB, lob_copy(handshake), b, sizeof(b), &reply));
+  fail_unless(reply && lob_get_cmp(reply,"type","cookie") == 0);
+  fail_unless(lob_get_cmp(reply,"cookie",link->cookie) != 0);
+  reply = lob_free(reply);
+  fail_unless(util_admit_stats(meshB->admit)->bad_cookies == 1);
+  fail_unless(util_admit_stats(meshB->admit)->challenged == 2);
+  mesh_receive_from(meshB, handshake, a, sizeof(a), &reply);
+  fail_unless(!reply);
+  fail_unless(mesh_linkid(meshB, meshA->id));
+  fail_unless(util_admit_stats(meshB->admit)->admitted == 1);
+
+  // nothing is sent back to a handshake smaller than the challenge
+  lob_t tiny = lob_new();
+  lob_head(tiny,(uint8_t*)"\x1a",1);
+  lob_body(tiny,NULL,16);
+  fail_unless(!mesh_receive_from(meshB, tiny, b, sizeof(b), &reply));
+  fail_unless(!reply);
+  fail_unless(util_admit_stats(meshB->admit)->challenged == 2);
+
+  // once the cookie goes stale (new keys here, or old windows) the next handshake gets a fresh one and then works again
+  options = lob_set_raw(lob_new(),"cookie",0,"true",4);
+  fail_unless(mesh_admission(meshB, options));
+  lob_free(options);
+  char stale[sizeof(link->cookie)];
+  strcpy(stale, link->cookie);
+  fail_unless(!mesh_receive_from(meshB, link_handshake(link), a, sizeof(a), &reply));
+  fail_unless(reply && lob_get_cmp(reply,"type","cookie") == 0);
+  fail_unless(util_admit_stats(meshB->admit)->bad_cookies == 1);
+  fail_unless(mesh_receive_from(meshA, reply, b, sizeof(b), NULL) == link);
+  fail_unless(strcmp(stale, link->cookie) != 0);
+  fail_unless(!mesh_receive_from(meshB, link_handshake(link), a, sizeof(a), &reply) || !reply);
+  fail_unless(!reply);
+  fail_unless(util_admit_stats(meshB->admit)->admitted == 1);
+
+  fail_unless(mesh_admission(meshB, NULL));
+  fail_unless(!meshB->admit);
+  mesh_free(meshA);
+  mesh_free(meshB);
+
+  return 0;
+}
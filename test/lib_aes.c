@@ -0,0 +1,59 @@
+#include "aes128.h"
+#include "util.h"
+#include "unit_test.h"
+
+#define BIG 1000
+
+// SP 800-38A F.5.1, CTR-AES128.Encrypt, and the same again at every length w/ the other path
+static void check(void)
+{
+  uint8_t key[16], iv[16], iv2[16], plain[64], cipher[64], out[64], in[BIG], big[BIG], big2[BIG];
+  struct aes_128_key_struct expanded;
+  uint32_t i, bad = 0;
+  uint8_t hw;
+
+  util_unhex("2b7e151628aed2a6abf7158809cf4f3c", 32, key);
+  util_unhex("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+             "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710", 128, plain);
+  util_unhex("874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff"
+             "5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee", 128, cipher);
+
+  // the counter carries across bytes from ...feff
+  util_unhex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff", 32, iv);
+  aes_128_ctr(key, 64, iv, plain, out);
+  fail_unless(memcmp(out, cipher, 64) == 0);
+  util_unhex("f0f1f2f3f4f5f6f7f8f9fafbfcfdff03", 32, iv2);
+  fail_unless(memcmp(iv, iv2, 16) == 0);
+
+  // expanded once, in place
+  aes_128_setkey(&expanded, key);
+  util_unhex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff", 32, iv);
+  memcpy(out, cipher, 64);
+  aes_128_ctr_key(&expanded, 64, iv, out, out);
+  fail_unless(memcmp(out, plain, 64) == 0);
+
+  // every length, including a counter that wraps all the way around
+  for(i=0;i<BIG;i++) in[i] = (uint8_t)(i * 7);
+  for(i=0;i<=BIG;i+=(i < 200) ? 1 : 97)
+  {
+    memset(iv, 0xff, 16);
+    iv[0] = (uint8_t)i;
+    memcpy(iv2, iv, 16);
+    hw = aes_128_hw(1);
+    aes_128_ctr_key(&expanded, i, iv, in, big);
+    aes_128_hw(0);
+    aes_128_ctr_key(&expanded, i, iv2, in, big2);
+    if(memcmp(big, big2, i) != 0 || memcmp(iv, iv2, 16) != 0) bad++;
+  }
+  fail_unless(!bad);
+  aes_128_hw(1);
+  LOG("AES-NI %s",hw ? "in use" : "not available");
+}
+
+int main(int argc, char **argv)
+{
+  check();
+  aes_128_hw(0);
+  check(); // the table path for the vectors too
+  return 0;
+}
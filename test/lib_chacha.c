@@ -2,9 +2,48 @@
 #include "util.h"
 #include "unit_test.h"
 
+// RFC 7539 vectors have a 32 bit counter and 96 bit nonce, here it's DJB's 64/64 so they're the ones
+// whose first nonce word is zero, using the last 8 nonce bytes and skipping counter blocks of zeros
+static void rfc(uint8_t *key, char *nonce, uint32_t counter, uint8_t *data, uint32_t len, char *expect)
+{
+  uint8_t n[8], buf[256];
+  char hex[513];
+  memset(buf,0,counter*64);
+  memcpy(buf+(counter*64),data,len);
+  util_unhex(nonce,16,n);
+  fail_unless(chacha20(key,n,buf,(counter*64)+len));
+  fail_unless(util_cmp(util_hex(buf+(counter*64),len,hex),expect) == 0);
+}
+
+static uint8_t zeros[64];
+
+static void vectors(void)
+{
+  uint8_t key[32];
+  char *sunscreen = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+
+  // A.1 block function
+  memset(key,0,32);
+  rfc(key,"0000000000000000",0,zeros,64,"76b8e0ada0f13d90405d6ae55386bd28bdd219b8a08ded1aa836efcc8b770dc7da41597c5157488d7724e03fb8d84a376a43b8f41518a11cc387b669b2ee6586");
+  rfc(key,"0000000000000000",1,zeros,64,"9f07e7be5551387a98ba977c732d080dcb0f29a048e3656912c6533e32ee7aed29b721769ce64e43d57133b074d839d531ed1f28510afb45ace10a1f4b794d6f");
+  rfc(key,"0000000000000002",0,zeros,64,"c2c64d378cd536374ae204b9ef933fcd1a8b2288b3dfa49672ab765b54ee27c78a970e0e955c14f3a88e741b97c286f75f8fc299e8148362fa198a39531bed6d");
+  key[31] = 1;
+  rfc(key,"0000000000000000",1,zeros,64,"3aeb5224ecf849929b9d828db1ced4dd832025e8018b8160b82284f3c949aa5a8eca00bbb4a73bdad192b5c42f73f2fd4e273644c8b36125a64addeb006c13a0");
+  memset(key,0,32);
+  key[1] = 0xff;
+  rfc(key,"0000000000000000",2,zeros,64,"72d54dfbf12ec44b362692df94137f328fea8da73990265ec1bbbea1ae9af0ca13b25aa26cb4a648cb9b9d1be65b2c0924a66c54d545ec1b7374f4872e99f096");
+
+  // 2.4.2 encryption
+  util_unhex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f",64,key);
+  rfc(key,"0000004a00000000",1,(uint8_t*)sunscreen,strlen(sunscreen),"6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afccfd9fae0bf91b65c5524733ab8f593dabcd62b3571639d624e65152ab8f530c359f0861d807ca0dbf500d6a6156a38e088a22b65e52bc514d16ccf806818ce91ab77937365af90bbf74a35be6b40b8eedf2785e42874d");
+}
+
 int main(int argc, char **argv)
 {
   uint8_t key[32], nonce[8], test[9];
+  static uint8_t a[2048], b[2048];
+  uint32_t i, len, bad;
+  uint8_t level;
   char hex[65];
 
   memset(key,0,32);
@@ -25,7 +64,32 @@ int main(int argc, char **argv)
   fail_unless(chacha20(key,nonce,test,9));
   fail_unless(util_cmp(util_hex(test,9,hex),"ffffffffffffffffff") == 0);
 
+  // every path this cpu has
+  for(level=0;level<=2;level++)
+  {
+    if(chacha20_hw(level) != level) continue;
+    vectors();
+  }
+
+  // and they all agree with scalar at every length around the block/batch edges
+  for(i=0;i<sizeof(a);i++) a[i] = (uint8_t)(i * 7);
+  memset(key,3,32);
+  for(bad=0,len=1;len<=sizeof(a);len += (len < 600) ? 1 : 61)
+  {
+    memcpy(b,a,len);
+    chacha20_hw(0);
+    chacha20(key,nonce,b,len);
+    for(level=1;level<=2;level++)
+    {
+      if(chacha20_hw(level) != level) continue;
+      chacha20(key,nonce,b,len); // back again
+      if(memcmp(a,b,len) != 0) bad++;
+      chacha20_hw(0);
+      chacha20(key,nonce,b,len);
+    }
+  }
+  fail_unless(bad == 0);
+  chacha20_hw(2);
 
   return 0;
 }
-
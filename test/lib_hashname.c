@@ -1,6 +1,21 @@
+#include <pthread.h>
 #include "telehash.h"
 #include "unit_test.h"
 
+// each thread round-trips its own hashname through the temporary buffers
+static char hns[4][53];
+static void *hn_thread(void *arg)
+{
+  char *str = arg;
+  int i;
+  for(i=0;i<10000;i++)
+  {
+    hashname_t hn = hashname_vchar(str);
+    if(!hn || strcmp(hashname_char(hn),str) != 0 || strncmp(hashname_short(hn),str,8) != 0) return NULL;
+  }
+  return arg;
+}
+
 int main(int argc, char **argv)
 {
   hashname_t hn;
@@ -43,6 +58,23 @@ int main(int argc, char **argv)
   fail_unless(hashname_isshort(hn));
   fail_unless(util_cmp(hashname_short(hn),"uvabrvfq") == 0);
 
+  // temporary results are per thread
+  pthread_t threads[4];
+  void *ret;
+  int i;
+  uint8_t bin[32];
+  for(i=0;i<4;i++)
+  {
+    e3x_rand(bin,32);
+    strcpy(hns[i],hashname_char(hashname_vbin(bin)));
+  }
+  for(i=0;i<4;i++) fail_unless(pthread_create(&threads[i], NULL, hn_thread, hns[i]) == 0);
+  for(i=0;i<4;i++)
+  {
+    fail_unless(pthread_join(threads[i], &ret) == 0);
+    fail_unless(ret == hns[i]);
+  }
+
   return 0;
 }
 
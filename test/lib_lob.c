@@ -34,6 +34,14 @@ int main(int argc, char **argv)
   lob_set(packet,"key","value");
   fail_unless(lob_keys(packet) == 2);
 
+  // formatted, short and longer than the stack buffer
+  lob_t printed = lob_new();
+  fail_unless(lob_set_printf(printed,"n","%d:%s",42,"x\"y"));
+  fail_unless(util_cmp(lob_get(printed,"n"),"42:x\"y") == 0);
+  fail_unless(lob_set_printf(printed,"long","%0200d",7));
+  fail_unless(strlen(lob_get(printed,"long")) == 200);
+  lob_free(printed);
+
   // test sorting
   lob_set(packet,"zz","value");
   lob_set(packet,"a","value");
@@ -102,6 +110,133 @@ int main(int argc, char **argv)
   fail_unless(lob_get_int(ft,"bar0") == 42);
   LOG("floats %s",lob_json(ft));
 
+  // room around raw survives edits and is used by wrap w/o moving the inner bytes
+  lob_t room = lob_reserve(lob_new(),22,4);
+  fail_unless(room && room->headroom == 22 && room->tailroom == 4);
+  lob_set(room,"type","test");
+  lob_body(room,(uint8_t*)"body",4);
+  fail_unless(room->headroom == 22);
+  fail_unless(lob_get_cmp(room,"type","test") == 0);
+  fail_unless(lob_reserve(room,22,4) == room && room->tailroom == 4);
+  size_t rlen = lob_len(room);
+  uint8_t *rraw = lob_raw(room);
+  lob_t rcopy = lob_copy(room);
+  fail_unless(lob_wrap(room,20,4) == room);
+  fail_unless(room->head_len == 0 && room->body_len == 20+rlen+4);
+  fail_unless(room->body+20 == rraw);
+  fail_unless(memcmp(room->body+20,lob_raw(rcopy),rlen) == 0);
+  lob_free(rcopy);
+  lob_free(room);
+
+  // wrap w/o any room still works
+  lob_t bare = lob_set(lob_new(),"a","b");
+  size_t blen = lob_len(bare);
+  fail_unless(lob_wrap(bare,20,4));
+  fail_unless(bare->body_len == 20+blen+4);
+  lob_t unwrapped = lob_parse(bare->body+20,bare->body_len-24);
+  fail_unless(lob_get_cmp(unwrapped,"a","b") == 0);
+  lob_free(unwrapped);
+  lob_free(bare);
+
+  // adopt takes the buffer as-is
+  uint8_t *abuf = util_pool_malloc(2+13+3);
+  memcpy(abuf,"\0\x0d{\"foo\":42.42}abc",2+13+3);
+  lob_t adopted = lob_adopt(abuf,2+13+3);
+  fail_unless(adopted && lob_raw(adopted) == abuf);
+  fail_unless(lob_get_float(adopted,"foo") == f);
+  fail_unless(adopted->body_len == 3 && memcmp(adopted->body,"abc",3) == 0);
+  lob_set(adopted,"bar","baz");
+  fail_unless(lob_get_cmp(adopted,"bar","baz") == 0);
+  lob_free(adopted);
+  abuf = util_pool_malloc(4);
+  memcpy(abuf,"\0\x09{}",4);
+  fail_unless(!lob_adopt(abuf,4));
+
+  // indexed lookups match js0n's
+  char *heads[] = {
+    "{\"c\":5,\"type\":\"stream\",\"end\":true}",
+    "{ \"a\" : \"x\\\"y\" , \"b\":{\"a\":[1,\"]\"]}, \"c\":-1.5e3 }",
+    "{\"dup\":1,\"dup\":2,\"\":\"empty\",\"s\":\"\"}",
+    "{\"open\":1,",
+    "[\"c\",\"a\"]",
+    "{}",
+    NULL};
+  char *keys[] = {"c","type","end","a","b","dup","","s","open","x",NULL};
+  size_t h, k, jlen, ilen;
+  char *jval;
+  for(h=0;heads[h];h++)
+  {
+    lob_t ip = lob_new();
+    lob_head(ip,(uint8_t*)heads[h],strlen(heads[h]));
+    for(k=0;keys[k];k++)
+    {
+      jlen = 0;
+      jval = js0n(keys[k],0,(char*)ip->head,ip->head_len,&jlen);
+      ilen = lob_get_len(ip,keys[k]);
+      if(!jval) fail_unless(!lob_get_raw(ip,keys[k]) && !ilen);
+      else fail_unless(lob_get_raw(ip,keys[k]) == ((*(jval-1) == '"') ? jval-1 : jval) && ilen == ((*(jval-1) == '"') ? jlen+2 : jlen));
+    }
+    lob_free(ip);
+  }
+
+  // index follows head changes and handles more keys than it holds
+  lob_t ip = lob_set_uint(lob_new(),"c",1);
+  fail_unless(lob_get_uint(ip,"c") == 1);
+  lob_set_uint(ip,"c",22);
+  fail_unless(lob_get_uint(ip,"c") == 22);
+  char kbuf[8];
+  for(k=0;k<40;k++)
+  {
+    sprintf(kbuf,"k%u",(unsigned)k);
+    lob_set_uint(ip,kbuf,(unsigned)k);
+  }
+  for(k=0;k<40;k++)
+  {
+    sprintf(kbuf,"k%u",(unsigned)k);
+    fail_unless(lob_get_uint(ip,kbuf) == k);
+  }
+  fail_unless(lob_get_uint(ip,"c") == 22);
+  fail_unless(!lob_get(ip,"k40"));
+  lob_free(ip);
+
+  // in place edits keep the body intact
+  lob_t ed = lob_new();
+  lob_body(ed,(uint8_t*)"body",4);
+  lob_set(ed,"a","one");
+  lob_set(ed,"b","two");
+  lob_set(ed,"a","a \"longer\" one");
+  lob_set_int(ed,"b",2);
+  fail_unless(util_cmp(lob_json(ed),"{\"a\":\"a \\\"longer\\\" one\",\"b\":2}") == 0);
+  lob_set_uint(ed,"a",1);
+  fail_unless(util_cmp(lob_json(ed),"{\"a\":1,\"b\":2}") == 0);
+  fail_unless(ed->body_len == 4 && memcmp(ed->body,"body",4) == 0);
+  lob_t edc = lob_parse(lob_raw(ed),lob_len(ed));
+  fail_unless(edc && lob_get_int(edc,"b") == 2);
+  lob_free(edc);
+  lob_free(ed);
+
+  // builder
+  lob_t bu = lob_new();
+  lob_body(bu,(uint8_t*)"body",4);
+  fail_unless(lob_begin(bu) == bu);
+  lob_add(bu,"s","q\"uote");
+  lob_add_uint(bu,"n",42);
+  lob_add_raw(bu,"o",0,"{\"x\":true}",0);
+  lob_add_base32(bu,"b",(uint8_t*)"hi",2);
+  fail_unless(lob_finish(bu) == bu);
+  fail_unless(util_cmp(lob_json(bu),"{\"s\":\"q\\\"uote\",\"n\":42,\"o\":{\"x\":true},\"b\":\"nbuq\"}") == 0);
+  fail_unless(bu->body_len == 4 && memcmp(bu->body,"body",4) == 0);
+  fail_unless(!lob_add(bu,"late","x"));
+  // reopen to append
+  fail_unless(lob_begin(bu));
+  lob_add_uint(bu,"m",1);
+  lob_finish(bu);
+  fail_unless(lob_get_uint(bu,"n") == 42 && lob_get_uint(bu,"m") == 1);
+  lob_free(bu);
+  bu = lob_finish(lob_begin(lob_new()));
+  fail_unless(util_cmp(lob_json(bu),"{}") == 0);
+  lob_free(bu);
+
   return 0;
 }
 
@@ -0,0 +1,51 @@
+#include "telehash.h"
+#include "unit_test.h"
+
+int main(int argc, char **argv)
+{
+  util_pool_stats_t stats = util_pool_stats();
+  fail_unless(stats);
+
+  uint8_t *a = util_pool_malloc(10);
+  fail_unless(a);
+  memset(a,42,10);
+  uint64_t misses = stats->misses;
+  util_pool_free(a);
+
+  // same size class comes back from the freelist
+  uint8_t *b = util_pool_malloc(20);
+  fail_unless(b);
+#ifndef NOPOOL
+  fail_unless(b == a);
+  fail_unless(stats->misses == misses);
+  fail_unless(stats->hits > 0);
+
+  // grows in place within the class, moves w/ the data beyond it
+  fail_unless(util_pool_realloc(b,32) == b);
+#endif
+  memset(b,7,20);
+  b = util_pool_realloc(b,1000);
+  fail_unless(b);
+  fail_unless(b[0] == 7 && b[19] == 7);
+
+  // large blocks bypass the classes
+  uint8_t *c = util_pool_malloc(100000);
+  fail_unless(c);
+  c[99999] = 1;
+  c = util_pool_realloc(c,200000);
+  fail_unless(c && c[99999] == 1);
+  util_pool_free(c);
+  util_pool_free(b);
+  fail_unless(stats->frees >= 2);
+
+  // packet objects round-trip through it
+  lob_t p = lob_set(lob_new(),"type","pool");
+  lob_body(p,NULL,3000);
+  fail_unless(lob_get_cmp(p,"type","pool") == 0);
+  lob_free(p);
+
+  util_pool_flush();
+  fail_unless(stats->cached == 0);
+
+  return 0;
+}
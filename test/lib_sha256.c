@@ -0,0 +1,74 @@
+#include "util.h"
+#include "sha256.h"
+#include "unit_test.h"
+
+#define BIG 300
+
+static char *hash(const char *data, size_t len, char *hex)
+{
+  uint8_t out[32];
+  sha256((const unsigned char*)data, len, out, 0);
+  return util_hex(out, 32, hex);
+}
+
+static char *hmac(uint8_t *key, size_t keylen, const char *data, char *hex)
+{
+  uint8_t out[32], out2[32];
+  struct hmac_256_struct keyed;
+  hmac_256(key, keylen, (const unsigned char*)data, strlen(data), out);
+  hmac_256_key(&keyed, key, keylen);
+  hmac_256_keyed(&keyed, (const unsigned char*)data, strlen(data), out2);
+  if(memcmp(out, out2, 32) != 0) return "mismatch";
+  hmac_256_keyed(&keyed, (const unsigned char*)data, strlen(data), out2); // reusable
+  if(memcmp(out, out2, 32) != 0) return "mismatch";
+  return util_hex(out, 32, hex);
+}
+
+// FIPS 180-2 and RFC 4231 vectors
+static void check(void)
+{
+  char hex[65], *million;
+  uint8_t key[131];
+
+  fail_unless(util_cmp(hash("", 0, hex), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855") == 0);
+  fail_unless(util_cmp(hash("abc", 3, hex), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad") == 0);
+  fail_unless(util_cmp(hash("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 56, hex), "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1") == 0);
+  million = malloc(1000000);
+  memset(million, 'a', 1000000);
+  fail_unless(util_cmp(hash(million, 1000000, hex), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0") == 0);
+  free(million);
+
+  memset(key, 0x0b, 20);
+  fail_unless(util_cmp(hmac(key, 20, "Hi There", hex), "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7") == 0);
+  fail_unless(util_cmp(hmac((uint8_t*)"Jefe", 4, "what do ya want for nothing?", hex), "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843") == 0);
+  memset(key, 0xaa, 131);
+  fail_unless(util_cmp(hmac(key, 131, "Test Using Larger Than Block-Size Key - Hash Key First", hex), "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54") == 0);
+}
+
+int main(int argc, char **argv)
+{
+  uint8_t data[BIG], out[32], out2[32];
+  uint32_t i, bad = 0;
+  uint8_t hw;
+
+  hw = sha256_hw(1);
+  LOG("SHA extensions %s",hw ? "in use" : "not available");
+  check();
+  sha256_hw(0);
+  check();
+
+  // both ways agree at every length
+  for(i=0;i<BIG;i++) data[i] = (uint8_t)(i * 13);
+  for(i=0;i<=BIG;i++)
+  {
+    sha256_hw(1);
+    sha256(data, i, out, 0);
+    sha256_hw(0);
+    sha256(data, i, out2, 0);
+    if(memcmp(out, out2, 32) != 0) bad++;
+  }
+  fail_unless(!bad);
+  sha256_hw(1);
+
+  return 0;
+}
@@ -0,0 +1,154 @@
+#include "uECC.h"
+#include "util.h"
+#include "sha256.h"
+#include "unit_test.h"
+
+#define KEYS 32
+
+typedef struct curve_struct
+{
+  uECC_Curve (*curve)(void);
+  char *last[3]; // n-1, and n-3 and n-4 (the ladder can't do n-1 or n-2)
+} *curve_t;
+
+// keys made w/ the ladder must come out the same from the fixed-base table, and still sign/verify
+static void check(curve_t c)
+{
+  uECC_Curve curve = c->curve();
+  int priv_len = uECC_curve_private_key_size(curve), pub_len = uECC_curve_public_key_size(curve);
+  uint8_t priv[KEYS][32], pub[KEYS][64], pub2[64], hash[32], sig[64];
+  uint32_t i;
+
+  memset(priv,0,sizeof(priv));
+  for(i=0;i<KEYS-4;i++) fail_unless(uECC_make_key(pub[i], priv[i], curve));
+  // the smallest (the ladder can't do 1) and largest of both parities
+  priv[i][priv_len-1] = 2;
+  fail_unless(uECC_compute_public_key(priv[i], pub[i], curve));
+  i++;
+  priv[i][priv_len-1] = 3;
+  fail_unless(uECC_compute_public_key(priv[i], pub[i], curve));
+  i++;
+  util_unhex(c->last[1], priv_len*2, priv[i]);
+  fail_unless(uECC_compute_public_key(priv[i], pub[i], curve));
+  i++;
+  util_unhex(c->last[2], priv_len*2, priv[i]);
+  fail_unless(uECC_compute_public_key(priv[i], pub[i], curve));
+
+  fail_unless(uECC_precompute(curve));
+  fail_unless(uECC_precompute(curve)); // again is a no-op
+
+  for(i=0;i<KEYS;i++)
+  {
+    fail_unless(uECC_compute_public_key(priv[i], pub2, curve));
+    fail_unless(memcmp(pub[i], pub2, pub_len) == 0);
+  }
+
+  // the table has no trouble w/ 1 and n-1, G and -G
+  memset(priv[0],0,sizeof(priv[0]));
+  priv[0][priv_len-1] = 1;
+  fail_unless(uECC_compute_public_key(priv[0], pub[0], curve));
+  util_unhex(c->last[0], priv_len*2, priv[1]);
+  fail_unless(uECC_compute_public_key(priv[1], pub[1], curve));
+  fail_unless(uECC_valid_public_key(pub[0], curve) && uECC_valid_public_key(pub[1], curve));
+  fail_unless(memcmp(pub[0], pub[1], pub_len/2) == 0 && memcmp(pub[0], pub[1], pub_len) != 0);
+
+  memset(hash,42,sizeof(hash));
+  fail_unless(uECC_make_key(pub[0], priv[0], curve));
+  fail_unless(uECC_valid_public_key(pub[0], curve));
+  fail_unless(uECC_sign(priv[0], hash, sizeof(hash), sig, curve));
+  fail_unless(uECC_verify(pub[0], hash, sizeof(hash), sig, curve));
+}
+
+// a batch (more than one chunk) must give the same answer as verifying each one, good or bad
+static void batch(uECC_Curve curve)
+{
+  int priv_len = uECC_curve_private_key_size(curve), pub_len = uECC_curve_public_key_size(curve), bytes = pub_len/2; // r and s are each as long as a coordinate
+  uint8_t priv[KEYS][32], pub[KEYS][64], hash[KEYS][32], sig[KEYS][64], ok[KEYS];
+  const uint8_t *pubs[KEYS], *hashes[KEYS], *sigs[KEYS];
+  uint32_t i, valid = 0;
+
+  for(i=0;i<KEYS;i++)
+  {
+    // every few share a key
+    if(i % 4)
+    {
+      memcpy(pub[i], pub[i-1], pub_len);
+      memcpy(priv[i], priv[i-1], priv_len);
+    }else{
+      fail_unless(uECC_make_key(pub[i], priv[i], curve));
+    }
+    memset(hash[i], (int)i, sizeof(hash[i]));
+    fail_unless(uECC_sign(priv[i], hash[i], sizeof(hash[i]), sig[i], curve));
+    pubs[i] = pub[i];
+    hashes[i] = hash[i];
+    sigs[i] = sig[i];
+  }
+
+  sig[1][bytes-1] ^= 1; // r
+  sig[6][bytes*2-1] ^= 1; // s
+  hash[9][0] ^= 1;
+  memset(sig[12], 0, bytes); // r = 0
+  memset(sig[17]+bytes, 0xff, bytes); // s > n
+  pubs[21] = pub[0]; // someone else's key
+  sigs[30] = sig[31]; // someone else's sig
+
+  fail_unless(uECC_verify_batch(pubs, hashes, 32, sigs, 0, ok, curve) == 0);
+  for(i=0;i<KEYS;i++) valid += (uint32_t)uECC_verify(pubs[i], hashes[i], 32, sigs[i], curve);
+  fail_unless(valid == KEYS - 7);
+  fail_unless(uECC_verify_batch(pubs, hashes, 32, sigs, KEYS, ok, curve) == (int)valid);
+  for(i=0;i<KEYS;i++) fail_unless(ok[i] == uECC_verify(pubs[i], hashes[i], 32, sigs[i], curve));
+
+  // a lone one, a single bad one
+  fail_unless(uECC_verify_batch(pubs, hashes, 32, sigs, 1, ok, curve) == 1 && ok[0] == 1);
+  fail_unless(uECC_verify_batch(pubs+1, hashes+1, 32, sigs+1, 1, ok, curve) == 0 && ok[0] == 0);
+}
+
+// known answers for secp256r1, whichever field arithmetic backend is built
+static void vectors(void)
+{
+  uECC_Curve curve = uECC_secp256r1();
+  uint8_t priv[32], pub[64], pub2[64], shared[32], secret[32], hash[32], sig[64];
+
+  // NIST CAVS ECDH, the first P-256 vector
+  util_unhex("7d7dc5f71eb29ddaf80d6214632eeae03d9058af1fb6d22ed80badb62bc1a534", 64, priv);
+  util_unhex("ead218590119e8876b29146ff89ca61770c4edbbf97d38ce385ed281d8a6b230"
+             "28af61281fd35e2fa7002523acc85a429cb06ee6648325389f59edfce1405141", 128, pub);
+  fail_unless(uECC_compute_public_key(priv, pub2, curve));
+  fail_unless(memcmp(pub, pub2, 64) == 0);
+  util_unhex("700c48f77f56584c5cc632ca65640db91b6bacce3a4df6b42ce7cc838833d287"
+             "db71e509e3fd9b060ddb20ba5c51dcc5948d46fbf640dfe0441782cab85fa4ac", 128, pub);
+  util_unhex("46fc62106420ff012e54a434fbdd2d25ccc5852060561e68040dd7778997bd7b", 64, secret);
+  fail_unless(uECC_shared_secret(pub, priv, shared, curve));
+  fail_unless(memcmp(shared, secret, 32) == 0);
+
+  // RFC 6979 A.2.5, P-256 w/ SHA-256 of "sample"
+  util_unhex("c9afa9d845ba75166b5c215767b1d6934e50c3db36e89b127b8a622b120f6721", 64, priv);
+  util_unhex("60fed4ba255a9d31c961eb74c6356d68c049b8923b61fa6ce669622e60f29fb6"
+             "7903fe1008b8bc99a41ae9e95628bc64f2f1b20c2d7e9f5177a3c294d4462299", 128, pub);
+  fail_unless(uECC_compute_public_key(priv, pub2, curve));
+  fail_unless(memcmp(pub, pub2, 64) == 0);
+  util_unhex("efd48b2aacb6a8fd1140dd9cd45e81d69d2c877b56aaf991c34d0ea84eaf3716"
+             "f7cb1c942d657c41d436c7a1b6e29f65f3e900dbb9aff4064dc4ab2f843acda8", 128, sig);
+  sha256((uint8_t*)"sample", 6, hash, 0);
+  fail_unless(uECC_verify(pub, hash, 32, sig, curve));
+  sig[63] ^= 1;
+  fail_unless(!uECC_verify(pub, hash, 32, sig, curve));
+}
+
+int main(int argc, char **argv)
+{
+  struct curve_struct secp160r1 = {uECC_secp160r1, {"0100000000000000000001f4c8f927aed3ca752256", "0100000000000000000001f4c8f927aed3ca752254", "0100000000000000000001f4c8f927aed3ca752253"}};
+  struct curve_struct secp256r1 = {uECC_secp256r1, {"ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632550", "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc63254e", "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc63254d"}};
+
+  vectors();
+  batch(uECC_secp160r1());
+  batch(uECC_secp256r1());
+  check(&secp160r1);
+  check(&secp256r1);
+
+  // no room left for another table, it just uses the ladder
+  fail_unless(!uECC_precompute(uECC_secp256k1()));
+
+  vectors(); // again w/ the tables
+  return 0;
+}
@@ -34,13 +34,85 @@ int main(int argc, char **argv)
   fail_unless(link->csid > 0x01);
   fail_unless(link->x);
   lob_free(idB);
+
+  // indexed lookups
+  fail_unless(link_get(mesh,link->id) == link);
+  fail_unless(mesh_linkid(mesh,link->id) == link);
+  fail_unless(mesh_linked(mesh,hashname_char(link->id),0) == link);
+  fail_unless(mesh_linked(mesh,hashname_short(link->id),0) == link);
+  fail_unless(mesh_linked(mesh,hashname_char(link->id),12) == link);
+  fail_unless(strlen(link->token) == 16);
+
+  // enough to grow the indexes a few times
+  int i;
+  uint8_t bin[32];
+  hashname_t many[500];
+  for(i=0;i<500;i++)
+  {
+    e3x_rand(bin,32);
+    many[i] = hashname_dup(hashname_vbin(bin));
+    fail_unless(link_get(mesh,many[i]));
+  }
+  fail_unless(mesh->linked == 501);
+  for(i=0;i<500;i++) fail_unless(mesh_linkid(mesh,many[i]) == link_get(mesh,many[i]));
+  link_free(link_get(mesh,many[0]));
+  fail_unless(!mesh_linkid(mesh,many[0]));
+  fail_unless(!mesh_linked(mesh,hashname_char(many[0]),0));
+  fail_unless(mesh->linked == 500);
+  for(i=0;i<500;i++) hashname_free(many[i]);
+
+  // past the biggest index size new links still get indexed (pretend there's that many)
+  mesh->index_prime = 786433;
+  mesh->linked += 2 * 786433;
+  e3x_rand(bin,32);
+  hashname_t big = hashname_dup(hashname_vbin(bin));
+  link_t blink = link_get(mesh,big);
+  fail_unless(blink);
+  fail_unless(mesh_linkid(mesh,big) == blink);
+  fail_unless(link_get(mesh,big) == blink);
+  fail_unless(mesh_linked(mesh,hashname_short(big),0) == blink);
+  mesh->linked -= 2 * 786433;
+  link_free(blink);
+  hashname_free(big);
   
   lob_t open = lob_new();
   lob_set(open,"type","test");
   lob_set_int(open,"c",e3x_exchange_cid(link->x, NULL));
   chan_t chan = link_chan(link, open);
   fail_unless(chan);
+  fail_unless(!link_chan(link, open)); // id in use
   lob_free(open);
+  fail_unless(link_chan_get(link, chan_id(chan)) == chan);
+
+  // lots of channels, with timeouts to check only due ones get processed
+  chan_t chans[200];
+  for(i=0;i<200;i++)
+  {
+    open = lob_set(lob_new(),"type","test");
+    fail_unless((chans[i] = link_chan(link, open)));
+    lob_free(open);
+    chan_timeout(chans[i], 1000 + (200 - i));
+  }
+  fail_unless(link->chans_count == 201);
+  fail_unless(link->timers_count == 200);
+  fail_unless(mesh->timers_count == 1 && mesh_due(mesh) == 1001); // of all the links only this one has anything due
+  for(i=0;i<200;i++) fail_unless(link_chan_get(link, chan_id(chans[i])) == chans[i]);
+  for(i=0;i<200;i+=2) chan_free(chans[i]);
+  fail_unless(link->chans_count == 101);
+  fail_unless(link->timers_count == 100);
+  for(i=1;i<200;i+=2) fail_unless(link_chan_get(link, chan_id(chans[i])) == chans[i]);
+  fail_unless(link_process(link, 1000));
+  fail_unless(link->timers_count == 100);
+  fail_unless(mesh_process(mesh, 1100));
+  fail_unless(link->timers_count == 50);
+  fail_unless(mesh_due(mesh) == 1101);
+  fail_unless(chan_timeout(chans[199],0) == 0); // fired
+  fail_unless(lob_get(chan_receiving(chans[199]),"err"));
+  fail_unless(chan_timeout(chans[1],0) == 1199);
+  for(i=1;i<200;i+=2) chan_free(chans[i]);
+  fail_unless(link->chans_count == 1);
+  fail_unless(!link->timers_count);
+  fail_unless(!mesh_due(mesh) && !mesh->timers_count);
 
   mesh_on_path(mesh, "test", net_test);
   link = mesh_path(mesh,link,lob_set(lob_new(),"type","test"));
@@ -36,6 +36,29 @@ lob_t bulk_on_open(link_t link, lob_t open)
   return NULL;
 }
 
+// reliable channel packets must arrive in order, once
+uint32_t expected = 0, misordered = 0;
+void reliable_handler(chan_t chan, void *arg)
+{
+  lob_t packet;
+
+  while((packet = chan_receiving(chan)))
+  {
+    if(lob_get(packet,"n") && lob_get_uint(packet,"n") != expected++) misordered++;
+    lob_free(packet);
+  }
+}
+
+lob_t reliable_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","reliable")) return open;
+  chan_t chan = link_chan(link, open);
+  fail_unless(chan && chan->window);
+  chan_handle(chan,reliable_handler,NULL);
+  chan_receive(chan,open);
+  chan_process(chan,0);
+  return NULL;
+}
 
 int main(int argc, char **argv)
 {
@@ -85,6 +108,32 @@ int main(int argc, char **argv)
   
   LOG("bulked %d",bulked);
   fail_unless(bulked == i+1);
+
+  // a reliable channel over a link dropping a fifth of everything
+  mesh_on_open(meshA, "reliable", reliable_on_open);
+  fail_unless(net_loopback_loss(pair, 20));
+  lob_t open = lob_set(lob_new(),"type","reliable");
+  chan_t rel = link_chan(linkBA, open);
+  fail_unless(chan_reliable(rel, 4096));
+  fail_unless(chan_send(rel, open));
+  for(i=0;i<200;i++)
+  {
+    lob_t packet = chan_packet(rel);
+    lob_set_uint(packet,"n",i);
+    lob_body(packet,NULL,200);
+    fail_unless(chan_send(rel, packet));
+  }
+  uint32_t now;
+  for(now=1;now < 10000 && expected < 200;now++)
+  {
+    mesh_process(meshA, now);
+    mesh_process(meshB, now);
+  }
+  LOG("reliable %u in order by %u, %u of %u dropped",expected,now,pair->dropped,pair->sent);
+  fail_unless(expected == 200);
+  fail_unless(misordered == 0);
+  fail_unless(pair->dropped > 0);
+  fail_unless(chan_size(rel) < 1000); // only the last acks still in flight
   
   mesh_free(meshA);
   mesh_free(meshB);
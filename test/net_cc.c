@@ -0,0 +1,223 @@
+#include "telehash.h"
+#include "unit_test.h"
+
+// a bottleneck between two meshes: a drop-tail queue drained at RATE packets a tick, then DELAY ticks on the wire
+#define RATE 8
+#define DELAY 5
+#define LIMIT 24
+
+#define CHANS 4
+#define PACKETS 300
+#define PAYLOAD 500
+#define PER_TICK 4 // each channel's app sends this many a tick, together more than the bottleneck takes
+
+typedef struct hop_struct
+{
+  mesh_t from, to;
+  lob_t queue, wire;
+  uint32_t queued, dropped;
+} *hop_t;
+
+static struct hop_struct ab, ba;
+static uint32_t tick;
+
+static link_t hop_send(link_t link, lob_t packet, void *arg)
+{
+  hop_t hop = (link->mesh == ab.from) ? &ab : &ba;
+  if(hop->queued >= LIMIT)
+  {
+    hop->dropped++;
+    lob_free(packet);
+    return link;
+  }
+  hop->queue = lob_push(hop->queue, packet);
+  hop->queued++;
+  return link;
+}
+
+static void hop_tick(hop_t hop)
+{
+  lob_t packet, reply;
+  uint32_t i;
+
+  for(i=0;i<RATE && hop->queue;i++)
+  {
+    packet = lob_shift(hop->queue);
+    hop->queue = packet->next;
+    hop->queued--;
+    packet->id = tick + DELAY;
+    hop->wire = lob_push(hop->wire, packet);
+  }
+
+  // anything delivered may send more, on either hop
+  while((packet = hop->wire) && packet->id <= tick)
+  {
+    packet = lob_shift(hop->wire);
+    hop->wire = packet->next;
+    packet->next = NULL;
+    reply = NULL;
+    mesh_receive_from(hop->to, packet, (uint8_t*)&(hop->from), sizeof(mesh_t), &reply);
+    if(reply) lob_free(reply);
+  }
+}
+
+// each channel's packets must arrive in order, once
+static uint32_t received[CHANS], misordered;
+static void flow_handler(chan_t chan, void *arg)
+{
+  uint32_t *count = (uint32_t*)arg;
+  lob_t packet;
+  while((packet = chan_receiving(chan)))
+  {
+    if(lob_get(packet,"n") && lob_get_uint(packet,"n") != (*count)++) misordered++;
+    lob_free(packet);
+  }
+}
+
+static lob_t flow_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","flow")) return open;
+  chan_t chan = link_chan(link, open);
+  fail_unless(chan && chan->window);
+  chan_handle(chan,flow_handler,&received[lob_get_uint(open,"i")]);
+  chan_receive(chan,open);
+  chan_process(chan,0);
+  return NULL;
+}
+
+// the running counts must match what's actually in out
+static void flight_check(chan_t chan)
+{
+  uint32_t flight = 0, resends = 0, unsent = 0;
+  lob_t cur;
+  for(cur = chan->out;cur;cur = cur->next)
+  {
+    if(cur == chan->unsent) unsent = 1;
+    if(cur->id) flight += lob_len(cur);
+    else if(!unsent) resends++;
+    fail_unless(!unsent || !cur->id);
+  }
+  fail_unless(flight == chan->flight);
+  fail_unless(resends == chan->resends);
+  fail_unless(unsent == (chan->unsent != NULL));
+}
+
+int main(int argc, char **argv)
+{
+  uint8_t payload[PAYLOAD];
+  uint32_t i, sent, done, first, at[CHANS];
+  double sum, squares;
+  chan_t chans[CHANS];
+  lob_t packet, json;
+
+  fail_unless(!e3x_init(NULL));
+  e3x_rand(payload,PAYLOAD);
+
+  // one reduction per round trip, and the clock wrapping doesn't stop them
+  struct util_cc_struct cc;
+  util_cc_init(&cc);
+  util_cc_clock(&cc, UINT32_MAX - 10);
+  util_cc_rtt(&cc, 20);
+  util_cc_loss(&cc);
+  i = cc.cwnd;
+  util_cc_loss(&cc);
+  fail_unless(cc.cwnd == i);
+  util_cc_clock(&cc, 20); // past the wrap and the round trip
+  util_cc_loss(&cc);
+  fail_unless(cc.cwnd < i);
+
+  mesh_t meshA = mesh_new();
+  lob_free(mesh_generate(meshA));
+  mesh_on_open(meshA,"flow",flow_on_open);
+  mesh_t meshB = mesh_new();
+  lob_free(mesh_generate(meshB));
+  ab.from = ba.to = meshA;
+  ab.to = ba.from = meshB;
+  link_t linkAB = link_get_keys(meshA, meshB->keys);
+  link_t linkBA = link_get_keys(meshB, meshA->keys);
+  fail_unless(linkAB && linkBA);
+  link_pipe(linkAB, hop_send, NULL);
+  link_pipe(linkBA, hop_send, NULL);
+
+  // handshake across the bottleneck
+  fail_unless(link_resync(linkBA));
+  for(tick=1;tick < 100 && !link_up(linkBA);tick++)
+  {
+    hop_tick(&ab);
+    hop_tick(&ba);
+  }
+  fail_unless(link_up(linkBA) && link_up(linkAB));
+
+  // every channel from B to A over the one link
+  for(i=0;i<CHANS;i++)
+  {
+    packet = lob_set_uint(lob_set(lob_new(),"type","flow"),"i",i);
+    chans[i] = link_chan(linkBA, packet);
+    fail_unless(chan_reliable(chans[i], 0));
+    fail_unless(chan_send(chans[i], packet));
+  }
+
+  memset(at,0,sizeof(at));
+  for(sent=done=first=0;done < CHANS && tick < 20000;tick++)
+  {
+    for(;sent < PACKETS && sent < tick * PER_TICK;sent++) for(i=0;i<CHANS;i++)
+    {
+      packet = chan_packet(chans[i]);
+      lob_set_uint(packet,"n",sent);
+      lob_body(packet,payload,PAYLOAD);
+      fail_unless(chan_send(chans[i], packet));
+    }
+    hop_tick(&ab);
+    hop_tick(&ba);
+    mesh_process(meshA, tick);
+    mesh_process(meshB, tick);
+    for(i=0;i<CHANS;i++) flight_check(chans[i]);
+    fail_unless(linkBA->ready_count <= CHANS);
+
+    // how far every channel got when the first one finished
+    for(done=i=0;i<CHANS;i++) if(received[i] == PACKETS) done++;
+    if(done && !first++) memcpy(at,received,sizeof(at));
+  }
+
+  json = link_json(linkBA);
+  LOG("done by %u, %u dropped at the bottleneck, %s",tick,ba.dropped,lob_json(json));
+  fail_unless(done == CHANS);
+  fail_unless(misordered == 0);
+  fail_unless(ba.dropped > 0); // it did fill the queue
+  fail_unless(lob_get_uint(json,"rtt") >= DELAY);
+  fail_unless(lob_get_uint(json,"cwnd") > 0);
+  fail_unless(lob_get_uint(json,"lost") > 0);
+
+  // nothing's left waiting for a turn once everything's acked
+  for(done=0;!done && tick < 20000;tick++)
+  {
+    hop_tick(&ab);
+    hop_tick(&ba);
+    mesh_process(meshA, tick);
+    mesh_process(meshB, tick);
+    for(done=1,i=0;i<CHANS;i++) if(chans[i]->out) done = 0;
+  }
+  for(i=0;i<CHANS;i++) fail_unless(!chans[i]->flight && !chans[i]->listed);
+  fail_unless(!linkBA->ready && !linkBA->ready_count);
+
+  // nobody gets starved, jain's index of what each had when the first was done
+  for(sum=squares=0,i=0;i<CHANS;i++)
+  {
+    LOG("chan %u had %u",i,at[i]);
+    sum += at[i];
+    squares += (double)at[i] * at[i];
+  }
+  fail_unless(squares > 0);
+  LOG("fairness %f",(sum * sum) / (CHANS * squares));
+  fail_unless((sum * sum) / (CHANS * squares) > 0.9);
+  lob_free(json);
+
+  mesh_free(meshA);
+  mesh_free(meshB);
+  lob_freeall(ab.queue);
+  lob_freeall(ab.wire);
+  lob_freeall(ba.queue);
+  lob_freeall(ba.wire);
+
+  return 0;
+}
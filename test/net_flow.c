@@ -0,0 +1,149 @@
+#include "telehash.h"
+#include "net_loopback.h"
+#include "unit_test.h"
+
+#define PACKETS 40
+#define PAYLOAD 500
+
+// a slow consumer, packets sit in its inbox until the test reads them
+chan_t slow = NULL;
+lob_t slow_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","flow")) return open;
+  slow = link_chan(link, open);
+  fail_unless(chan_reliable(slow, 2048));
+  chan_receive(slow,open);
+  chan_process(slow,0);
+  return NULL;
+}
+
+uint32_t received = 0, misordered = 0;
+void consume(void)
+{
+  lob_t packet;
+  while((packet = chan_receiving(slow)))
+  {
+    if(lob_get(packet,"n") && lob_get_uint(packet,"n") != received++) misordered++;
+    lob_free(packet);
+  }
+}
+
+uint32_t writables = 0;
+void on_writable(chan_t chan, void *arg)
+{
+  writables++;
+}
+
+int main(int argc, char **argv)
+{
+  uint8_t payload[PAYLOAD];
+  uint32_t i, now = 1;
+
+  fail_unless(!e3x_init(NULL));
+  e3x_rand(payload,PAYLOAD);
+
+  mesh_t meshA = mesh_new();
+  lob_free(mesh_generate(meshA));
+  mesh_on_open(meshA,"flow",slow_on_open);
+  mesh_t meshB = mesh_new();
+  lob_free(mesh_generate(meshB));
+  net_loopback_t pair = net_loopback_new(meshA,meshB);
+  fail_unless(pair);
+  link_t link = link_get(meshB, meshA->id);
+  fail_unless(link_resync(link) && link_up(link));
+
+  lob_t open = lob_set(lob_new(),"type","flow");
+  chan_t chan = link_chan(link, open);
+  fail_unless(chan_reliable(chan, 4096));
+  fail_unless(chan_on_writable(chan, on_writable));
+  fail_unless(chan_send(chan, open));
+  fail_unless(slow);
+
+  // the app sends while it has credit, it runs out at about a window
+  for(i=0;i<PACKETS && chan_writable(chan);i++)
+  {
+    lob_t packet = chan_packet(chan);
+    lob_set_uint(packet,"n",i);
+    lob_body(packet,payload,PAYLOAD);
+    fail_unless(chan_send(chan, packet));
+  }
+  fail_unless(i > 4 && i < PACKETS);
+  fail_unless(chan_writable(chan) == 0);
+
+  // the receiver never holds more than its window (and the one filling a gap)
+  for(;now < 20;now++)
+  {
+    mesh_process(meshA, now);
+    mesh_process(meshB, now);
+  }
+  fail_unless(chan_size(slow) <= 2048);
+  fail_unless(chan->peer < PAYLOAD);
+  fail_unless(chan->out); // still waiting on room
+  fail_unless(!writables);
+
+  // reading opens the window back up, that gets everything moving again and the app told there's room
+  for(;now < 200 && received < i;now++)
+  {
+    consume();
+    mesh_process(meshA, now);
+    mesh_process(meshB, now);
+  }
+  fail_unless(received == i);
+  fail_unless(writables == 1);
+  fail_unless(chan_writable(chan) > 2048);
+
+  // the window update can be lost, a probe from the sender finds it open anyway
+  for(;i<PACKETS;i++)
+  {
+    lob_t packet = chan_packet(chan);
+    lob_set_uint(packet,"n",i);
+    lob_body(packet,payload,PAYLOAD);
+    fail_unless(chan_send(chan, packet));
+  }
+  fail_unless(chan->out && chan->peer < PAYLOAD);
+  fail_unless(net_loopback_loss(pair, 100));
+  consume();
+  fail_unless(net_loopback_loss(pair, 0));
+  for(;now < 1000 && chan->out;now++)
+  {
+    consume();
+    mesh_process(meshA, now);
+    mesh_process(meshB, now);
+  }
+  fail_unless(!chan->out);
+  fail_unless(received == PACKETS && !misordered);
+
+  // everything's read and acked, nothing counted against the caps
+  mesh_process(meshB, now);
+  fail_unless(!chan_size(chan) && !chan_size(slow));
+  fail_unless(!link->buffered && !meshB->buffered && !meshA->buffered);
+
+  // and past the caps sends are refused, and counted (nothing's acked to free any up)
+  fail_unless(net_loopback_loss(pair, 100));
+  fail_unless(link_buffer(link, 1500));
+  lob_t packet = chan_packet(chan);
+  lob_body(packet,payload,PAYLOAD);
+  fail_unless(chan_send(chan, lob_copy(packet)));
+  fail_unless(chan_send(chan, lob_copy(packet)));
+  fail_unless(!chan_send(chan, lob_copy(packet)));
+  fail_unless(link->refused == 1 && meshB->refused == 1);
+  fail_unless(link->buffered == meshB->buffered && link->buffered <= 1500);
+  lob_t json = link_json(link);
+  fail_unless(lob_get_uint(json,"refused") == 1);
+  lob_free(json);
+  fail_unless(link_buffer(link, 0) && link->buffer_max == LINK_BUFFER);
+  fail_unless(mesh_buffer(meshB, 1000));
+  fail_unless(!chan_send(chan, packet));
+  fail_unless(meshB->refused == 2 && link->refused == 2);
+  fail_unless(mesh_buffer(meshB, 0) && meshB->buffer_max == MESH_BUFFER);
+
+  // freeing a channel gives back what it had
+  chan_free(chan);
+  fail_unless(!link->buffered && !meshB->buffered);
+
+  net_loopback_free(pair);
+  mesh_free(meshA);
+  mesh_free(meshB);
+
+  return 0;
+}
@@ -0,0 +1,174 @@
+#include <unistd.h>
+#include "net_udp4.h"
+#include "net_handshake.h"
+#include "util_sys.h"
+#include "unit_test.h"
+
+int pongs = 0;
+lob_t pong_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","pong")) return open;
+  pongs++;
+  lob_free(open);
+  return NULL;
+}
+
+lob_t ping_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","ping")) return open;
+  link_direct(link, lob_set(lob_new(),"type","pong"));
+  lob_free(open);
+  return NULL;
+}
+
+int dones = 0, links = 0;
+void done(link_t link, void *arg)
+{
+  dones++;
+  if(link) links++;
+}
+
+// run both sides until they're linked and a ping comes back
+static int ping(net_udp4_t netA, net_udp4_t netB, link_t link, mesh_t to)
+{
+  int i, before = pongs;
+  for(i=1000;i && !(link_up(link) && link_up(mesh_linkid(to, link->mesh->id)));i--)
+  {
+    net_udp4_process(netA);
+    net_udp4_process(netB);
+    usleep(100);
+  }
+  if(!i) return 0;
+  link_direct(link, lob_set(lob_new(),"type","ping"));
+  for(i=1000;i && pongs == before;i--)
+  {
+    net_udp4_process(netA);
+    net_udp4_process(netB);
+  }
+  return pongs == before + 1;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t i, total;
+  net_handshakes_stats_t stats;
+
+  fail_unless(!e3x_init(NULL));
+  fail_unless(!net_handshakes_new(NULL, NULL));
+
+  // a server whose handshakes all go through two workers
+  mesh_t meshS = mesh_new();
+  lob_t secretsS = mesh_generate(meshS);
+  fail_unless(secretsS);
+  mesh_on_discover(meshS,"auto",mesh_add);
+  mesh_on_open(meshS,"ping",ping_on_open);
+  net_udp4_t netS = net_udp4_new(meshS, NULL);
+  fail_unless(netS);
+  lob_t options = lob_set_uint(lob_new(),"threads",2);
+  net_handshakes_t hs = net_handshakes_new(meshS, options);
+  lob_free(options);
+  fail_unless(hs);
+  fail_unless(net_handshakes_fd(hs) >= 0);
+  fail_unless(net_udp4_handshakes(netS, hs));
+
+  // an unknown client only has its handshake decrypted by a worker
+  mesh_t meshC = mesh_new();
+  lob_t secretsC = mesh_generate(meshC);
+  fail_unless(secretsC);
+  mesh_on_open(meshC,"pong",pong_on_open);
+  net_udp4_t netC = net_udp4_new(meshC, NULL);
+  fail_unless(netC);
+  link_t linkCS = link_get_keys(meshC, meshS->keys);
+  fail_unless(linkCS);
+  net_udp4_direct(netC,link_handshake(linkCS),"127.0.0.1",net_udp4_port(netS));
+  fail_unless(ping(netC, netS, linkCS, meshS));
+  link_t linkSC = mesh_linkid(meshS, meshC->id);
+  fail_unless(linkSC && link_up(linkSC));
+
+  stats = net_handshakes_stats(hs);
+  fail_unless(stats);
+  fail_unless(stats->queued >= 1);
+  fail_unless(stats->completed == stats->queued);
+  fail_unless(stats->pending == 0);
+  fail_unless(stats->failed == 0);
+  fail_unless(stats->dropped == 0);
+  for(total=i=0;i<NET_HANDSHAKES_BUCKETS;i++) total += stats->latency[i];
+  fail_unless(total == stats->completed);
+
+  // the client restarts w/ a new ephemeral, the server's link is verified and synced to it on a worker
+  mesh_t meshC2 = mesh_new();
+  fail_unless(!mesh_load(meshC2, secretsC, lob_linked(secretsC)));
+  mesh_on_open(meshC2,"pong",pong_on_open);
+  net_udp4_t netC2 = net_udp4_new(meshC2, NULL);
+  fail_unless(netC2);
+  link_t linkC2S = link_get_keys(meshC2, meshS->keys);
+  fail_unless(linkC2S);
+  total = stats->completed;
+  net_udp4_direct(netC2,link_handshake(linkC2S),"127.0.0.1",net_udp4_port(netS));
+  fail_unless(ping(netC2, netS, linkC2S, meshS));
+  fail_unless(mesh_linkid(meshS, meshC->id) == linkSC);
+  fail_unless(stats->completed > total);
+  fail_unless(stats->failed == 0);
+
+  // w/ admission control a new client first has to echo a cookie back
+  options = lob_set_raw(lob_new(),"cookie",0,"true",4);
+  fail_unless(mesh_admission(meshS, options));
+  lob_free(options);
+  mesh_t meshD = mesh_new();
+  lob_free(mesh_generate(meshD));
+  mesh_on_open(meshD,"pong",pong_on_open);
+  net_udp4_t netD = net_udp4_new(meshD, NULL);
+  fail_unless(netD);
+  link_t linkDS = link_get_keys(meshD, meshS->keys);
+  fail_unless(linkDS);
+  net_udp4_direct(netD,link_handshake(linkDS),"127.0.0.1",net_udp4_port(netS));
+  fail_unless(ping(netD, netS, linkDS, meshS));
+  fail_unless(linkDS->cookie[0]);
+  fail_unless(util_admit_stats(meshS->admit)->challenged >= 1);
+  fail_unless(util_admit_stats(meshS->admit)->admitted >= 1);
+  fail_unless(util_admit_stats(meshS->admit)->bad_cookies == 0);
+  mesh_admission(meshS, NULL);
+
+  // garbage fails on the worker
+  total = stats->completed;
+  lob_t bad = lob_new();
+  lob_head(bad, (uint8_t*)"\x1a", 1);
+  lob_body(bad, NULL, 80);
+  fail_unless(net_handshakes_queue(hs, bad, done, NULL));
+  for(i=1000;i && stats->completed == total;i--)
+  {
+    usleep(100);
+    net_handshakes_process(hs);
+  }
+  fail_unless(stats->failed == 1);
+  fail_unless(dones == 1 && links == 0);
+
+  // a full pipeline drops, and anything left when freed is done w/o a link
+  options = lob_set_uint(lob_new(),"depth",1);
+  net_handshakes_t hs1 = net_handshakes_new(meshS, options);
+  lob_free(options);
+  fail_unless(hs1);
+  fail_unless(net_handshakes_queue(hs1, link_handshake(linkC2S), done, NULL));
+  fail_unless(!net_handshakes_queue(hs1, link_handshake(linkC2S), done, NULL));
+  fail_unless(net_handshakes_stats(hs1)->dropped == 1);
+  fail_unless(net_handshakes_stats(hs1)->pending == 1);
+  net_handshakes_free(hs1);
+  fail_unless(dones == 2);
+
+  fail_unless(!net_handshakes_queue(NULL, NULL, NULL, NULL));
+  fail_unless(!net_handshakes_process(NULL));
+
+  net_handshakes_free(hs);
+  mesh_free(meshS);
+  mesh_free(meshC);
+  mesh_free(meshC2);
+  mesh_free(meshD);
+  net_udp4_free(netS);
+  net_udp4_free(netC);
+  net_udp4_free(netC2);
+  net_udp4_free(netD);
+  lob_free(secretsS);
+  lob_free(secretsC);
+
+  return 0;
+}
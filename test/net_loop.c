@@ -0,0 +1,202 @@
+#include <unistd.h>
+#include "net_loop.h"
+#include "util_sys.h"
+#include "unit_test.h"
+
+int bigs = 0;
+lob_t big_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","big")) return open;
+  bigs++;
+  lob_free(open);
+  return NULL;
+}
+
+int reads = 0;
+void reader(net_loop_t loop, int fd, uint32_t events, void *arg)
+{
+  char buf[8];
+  while(read(fd, buf, sizeof(buf)) > 0) reads++;
+}
+
+int acked = 0;
+void acked_handler(chan_t chan, void *arg)
+{
+  lob_t packet;
+  while((packet = chan_receiving(chan)))
+  {
+    acked++;
+    lob_free(packet);
+  }
+}
+
+lob_t acked_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","acked")) return open;
+  chan_t chan = link_chan(link, open);
+  chan_handle(chan,acked_handler,NULL);
+  chan_receive(chan,open);
+  chan_process(chan,0);
+  return NULL;
+}
+
+int errs = 0;
+void timeout_handler(chan_t chan, void *arg)
+{
+  lob_t packet;
+  while((packet = chan_receiving(chan)))
+  {
+    if(lob_get(packet,"err")) errs++;
+    lob_free(packet);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int i;
+
+  mesh_t meshA = mesh_new();
+  fail_unless(meshA);
+  lob_free(mesh_generate(meshA));
+  mesh_t meshB = mesh_new();
+  fail_unless(meshB);
+  lob_free(mesh_generate(meshB));
+  mesh_on_open(meshB, "big", big_on_open);
+
+  net_udp4_t netA = net_udp4_new(meshA, NULL);
+  fail_unless(netA);
+  net_udp4_t netB = net_udp4_new(meshB, NULL);
+  fail_unless(netB);
+
+  net_loop_t loopA = net_loop_new(meshA, NULL);
+  fail_unless(loopA);
+  fail_unless(net_loop_udp4(loopA, netA));
+  net_loop_t loopB = net_loop_new(meshB, NULL);
+  fail_unless(loopB);
+  fail_unless(net_loop_udp4(loopB, netB));
+
+  link_t linkAB = link_get_keys(meshA, meshB->keys);
+  link_t linkBA = link_get_keys(meshB, meshA->keys);
+  fail_unless(linkAB);
+  fail_unless(linkBA);
+
+  // handshake queued between runs goes out on the next one
+  net_udp4_direct(netA,link_handshake(linkAB),"127.0.0.1",net_udp4_port(netB));
+  for(i=100;i && !(link_up(linkAB) && link_up(linkBA));i--)
+  {
+    fail_unless(net_loop_run(loopA, 5));
+    fail_unless(net_loop_run(loopB, 5));
+  }
+  fail_unless(i);
+
+  // several framed packets in a row, all driven by socket events and the resend timer
+  for(i=0;i<10;i++)
+  {
+    lob_t big = lob_set(lob_new(),"type","big");
+    lob_body(big,NULL,500);
+    fail_unless(link_direct(linkAB,big));
+  }
+  for(i=500;i && bigs < 10;i--)
+  {
+    fail_unless(net_loop_run(loopA, 5));
+    fail_unless(net_loop_run(loopB, 5));
+  }
+  fail_unless(bigs == 10);
+
+  // settles once the last one is confirmed, then idle runs just time out
+  for(i=100;i && (net_udp4_awaiting(netA) || net_udp4_pending(netB));i--)
+  {
+    fail_unless(net_loop_run(loopA, 5));
+    fail_unless(net_loop_run(loopB, 5));
+  }
+  fail_unless(i);
+  fail_unless(!net_udp4_pending(netA) && !net_udp4_awaiting(netA));
+  fail_unless(net_loop_run(loopA, 1));
+
+  // other sockets get their handler
+  int fds[2];
+  fail_unless(pipe(fds) == 0);
+  fail_unless(net_loop_fd(loopA, fds[0], reader, NULL));
+  fail_unless(write(fds[1], "x", 1) == 1);
+  fail_unless(net_loop_run(loopA, 100));
+  fail_unless(reads == 1);
+  fail_unless(net_loop_fd_drop(loopA, fds[0]));
+  fail_unless(!net_loop_fd_drop(loopA, fds[0]));
+  close(fds[0]);
+  close(fds[1]);
+
+  // channel timeouts fire from the timer w/o any socket activity
+  lob_t open = lob_set(lob_new(),"type","wait");
+  chan_t chan = link_chan(linkAB, open);
+  fail_unless(chan);
+  chan_handle(chan, timeout_handler, NULL);
+  chan_timeout(chan, util_sys_seconds());
+  fail_unless(mesh_due(meshA) == util_sys_seconds() || mesh_due(meshA) == util_sys_seconds() - 1);
+  for(i=30;i && !errs;i--) fail_unless(net_loop_run(loopA, 100));
+  fail_unless(errs == 1);
+  lob_free(open);
+
+  fail_unless(net_loop_stop(loopA));
+  fail_unless(!net_loop_run(loopA, 0));
+
+  // reliable channels are timed on the loop's ms clock, not the seconds channel timeouts use
+  mesh_t meshC = mesh_new();
+  lob_free(mesh_generate(meshC));
+  mesh_t meshD = mesh_new();
+  lob_free(mesh_generate(meshD));
+  mesh_on_open(meshD, "acked", acked_on_open);
+  lob_t options = lob_set_uint(lob_new(),"mtu",1472);
+  net_udp4_t netC = net_udp4_new(meshC, options);
+  net_udp4_t netD = net_udp4_new(meshD, options);
+  lob_free(options);
+  fail_unless(netC && netD);
+  net_loop_t loopC = net_loop_new(meshC, NULL);
+  net_loop_t loopD = net_loop_new(meshD, NULL);
+  fail_unless(net_loop_udp4(loopC, netC) && net_loop_udp4(loopD, netD));
+  fail_unless(meshC->clocked && meshD->clocked);
+  link_t linkCD = link_get_keys(meshC, meshD->keys);
+  link_t linkDC = link_get_keys(meshD, meshC->keys);
+  net_udp4_direct(netC,link_handshake(linkCD),"127.0.0.1",net_udp4_port(netD));
+  for(i=100;i && !(link_up(linkCD) && link_up(linkDC));i--)
+  {
+    fail_unless(net_loop_run(loopC, 5));
+    fail_unless(net_loop_run(loopD, 5));
+  }
+  fail_unless(i);
+
+  open = lob_set(lob_new(),"type","acked");
+  chan = link_chan(linkCD, open);
+  fail_unless(chan_reliable(chan, 0));
+  fail_unless(chan_send(chan, open));
+  for(i=0;i<100;i++)
+  {
+    lob_t packet = chan_packet(chan);
+    lob_body(packet,NULL,1000);
+    fail_unless(chan_send(chan, packet));
+  }
+  for(i=500;i && (acked < 101 || chan->out);i--)
+  {
+    fail_unless(net_loop_run(loopC, 5));
+    fail_unless(net_loop_run(loopD, 5));
+  }
+  fail_unless(i);
+  fail_unless(linkCD->cc.samples);
+  fail_unless(linkCD->cc.now >= 1000 && linkCD->cc.now < 1000 + 60000); // ms since the loop started
+  fail_unless(util_cc_rto(&linkCD->cc) < CHAN_RESEND_MS);
+
+  net_loop_free(loopC);
+  net_loop_free(loopD);
+  mesh_free(meshC);
+  mesh_free(meshD);
+  net_udp4_free(netC);
+  net_udp4_free(netD);
+
+  net_loop_free(loopA);
+  net_loop_free(loopB);
+  mesh_free(meshA);
+  mesh_free(meshB);
+  net_udp4_free(netA);
+  net_udp4_free(netB);
+
+  return 0;
+}
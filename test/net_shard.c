@@ -0,0 +1,143 @@
+#include "net_shard.h"
+#include "util_sys.h"
+#include "unit_test.h"
+
+#define CLIENTS 8
+
+// bumped from every shard thread
+static uint32_t pings = 0;
+lob_t ping_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","ping")) return open;
+  __atomic_fetch_add(&pings, 1, __ATOMIC_RELAXED);
+  link_direct(link, lob_set(lob_new(),"type","pong"));
+  lob_free(open);
+  return NULL;
+}
+
+static uint32_t pongs = 0;
+lob_t pong_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","pong")) return open;
+  pongs++;
+  lob_free(open);
+  return NULL;
+}
+
+// ping straight out of another socket, as if the client moved
+static void roam(net_udp4_t net, link_t link, uint16_t port)
+{
+  lob_t ping = lob_set(lob_new(),"type","ping");
+  lob_set_uint(ping,"c",e3x_exchange_cid(link->x, NULL));
+  net_udp4_direct(net, e3x_exchange_wrap(link->x, ping), "127.0.0.1", port);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t i, j, r, up;
+  mesh_t meshes[CLIENTS];
+  net_udp4_t nets[CLIENTS], roams[16];
+  link_t links[CLIENTS];
+
+  fail_unless(!e3x_init(NULL));
+  lob_t secrets = e3x_generate();
+  fail_unless(secrets);
+
+  lob_t options = lob_set_uint(lob_new(),"threads",4);
+  net_shards_t shards = net_shards_new(secrets, lob_linked(secrets), options);
+  lob_free(options);
+  fail_unless(shards);
+  fail_unless(net_shards_count(shards) == 4);
+  fail_unless(net_shards_port(shards));
+  fail_unless(!net_shards_mesh(shards, 4));
+
+  // same hashname everywhere, each takes anyone that echoes a cookie
+  options = lob_set_raw(lob_new(),"cookie",0,"true",4);
+  for(i=0;i<4;i++)
+  {
+    mesh_t mesh = net_shards_mesh(shards, i);
+    fail_unless(mesh);
+    fail_unless(hashname_cmp(mesh->id, net_shards_mesh(shards, 0)->id) == 0);
+    mesh_on_discover(mesh,"auto",mesh_add);
+    mesh_on_open(mesh,"ping",ping_on_open);
+    fail_unless(mesh_admission(mesh, options));
+  }
+  lob_free(options);
+  fail_unless(net_shards_start(shards));
+
+  // clients from their own addresses get spread across the threads
+  options = lob_set_uint(lob_new(),"mtu",1472);
+  for(i=0;i<CLIENTS;i++)
+  {
+    meshes[i] = mesh_new();
+    fail_unless(meshes[i]);
+    lob_free(mesh_generate(meshes[i]));
+    mesh_on_open(meshes[i],"pong",pong_on_open);
+    nets[i] = net_udp4_new(meshes[i], options);
+    fail_unless(nets[i]);
+    links[i] = link_get_keys(meshes[i], lob_linked(secrets));
+    fail_unless(links[i]);
+    net_udp4_direct(nets[i],link_handshake(links[i]),"127.0.0.1",net_shards_port(shards));
+  }
+  for(j=1000;j;j--)
+  {
+    for(up=i=0;i<CLIENTS;i++)
+    {
+      net_udp4_process(nets[i]);
+      if(link_up(links[i])) up++;
+    }
+    if(up == CLIENTS) break;
+  }
+  fail_unless(j);
+
+  // each was challenged at its own address and admitted once it came back w/ the cookie
+  for(r=i=0;i<4;i++)
+  {
+    util_admit_stats_t stats = util_admit_stats(net_shards_mesh(shards, i)->admit);
+    fail_unless(!stats->limited && !stats->bad_cookies);
+    fail_unless(stats->admitted >= stats->challenged);
+    r += stats->challenged;
+  }
+  fail_unless(r == CLIENTS);
+
+  // every one gets answered by the thread that has its link
+  for(i=0;i<CLIENTS;i++) fail_unless(link_direct(links[i], lob_set(lob_new(),"type","ping")));
+  for(j=1000;j && pongs < CLIENTS;j--) for(i=0;i<CLIENTS;i++) net_udp4_process(nets[i]);
+  fail_unless(pongs == CLIENTS);
+  fail_unless(__atomic_load_n(&pings, __ATOMIC_RELAXED) == CLIENTS);
+  fail_unless(net_shards_received(shards) >= CLIENTS * 2);
+  fail_unless(net_shards_forwarded(shards) == 0);
+
+  // a client moving to new addresses keeps its link, until one lands on a different thread and is forwarded
+  for(r=0;r<16 && !net_shards_forwarded(shards);r++)
+  {
+    meshes[0]->port_local = 0; // any new port
+    roams[r] = net_udp4_new(meshes[0], options);
+    fail_unless(roams[r]);
+    up = pongs;
+    roam(roams[r], links[0], net_shards_port(shards));
+    // the reply to the first packet from a new address still goes to the last one
+    for(j=1000;j && pongs == up;j--)
+    {
+      net_udp4_process(nets[0]);
+      for(i=0;i<=r;i++) net_udp4_process(roams[i]);
+    }
+    fail_unless(pongs == up + 1);
+  }
+  fail_unless(net_shards_forwarded(shards));
+  lob_free(options);
+
+  // replies now come back to the new address
+  up = pongs;
+  fail_unless(link_direct(links[0], lob_set(lob_new(),"type","ping")));
+  for(j=1000;j && pongs == up;j--) net_udp4_process(roams[r-1]);
+  fail_unless(pongs == up + 1);
+
+  net_shards_free(shards);
+  for(i=0;i<CLIENTS;i++) mesh_free(meshes[i]);
+  for(i=0;i<CLIENTS;i++) net_udp4_free(nets[i]);
+  for(i=0;i<r;i++) net_udp4_free(roams[i]);
+  lob_free(secrets);
+
+  return 0;
+}
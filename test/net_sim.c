@@ -0,0 +1,140 @@
+#include "telehash.h"
+#include "net_sim.h"
+#include "unit_test.h"
+
+#define PACKETS 100
+#define PAYLOAD 500
+
+// reliable channel packets must arrive in order, once
+static uint32_t received, misordered, first;
+static net_sim_t sim;
+static void sim_handler(chan_t chan, void *arg)
+{
+  lob_t packet;
+  while((packet = chan_receiving(chan)))
+  {
+    if(lob_get(packet,"n") && lob_get_uint(packet,"n") != received++) misordered++;
+    if(!first) first = net_sim_now(sim);
+    lob_free(packet);
+  }
+}
+
+static lob_t sim_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","sim")) return open;
+  chan_t chan = link_chan(link, open);
+  fail_unless(chan && chan->window);
+  chan_handle(chan,sim_handler,NULL);
+  chan_receive(chan,open);
+  chan_process(chan,0);
+  return NULL;
+}
+
+// handshake and send PACKETS from B to A over a pair w/ these conditions, returns when they were all received
+static uint32_t transfer(uint32_t seed, lob_t options, struct net_sim_path_struct *ab, struct net_sim_path_struct *ba, uint32_t *up)
+{
+  uint8_t payload[PAYLOAD];
+  uint32_t i, done;
+
+  memset(payload,42,PAYLOAD);
+  received = misordered = first = 0;
+  sim = net_sim_new(seed);
+  fail_unless(sim);
+
+  mesh_t meshA = mesh_new();
+  lob_free(mesh_generate(meshA));
+  mesh_on_open(meshA,"sim",sim_on_open);
+  mesh_t meshB = mesh_new();
+  lob_free(mesh_generate(meshB));
+  net_sim_pair_t pair = net_sim_pair(sim,meshA,meshB,options);
+  fail_unless(pair);
+  fail_unless(net_sim_path(pair,meshA) == &pair->ab);
+  fail_unless(net_sim_path(pair,meshB) == &pair->ba);
+  fail_unless(!net_sim_path(pair,NULL));
+
+  link_t link = link_get(meshB, meshA->id);
+  fail_unless(link_resync(link));
+  while(!link_up(link) && net_sim_now(sim) < 10000) net_sim_step(sim, 10000);
+  fail_unless(link_up(link));
+  if(up) *up = net_sim_now(sim);
+
+  lob_t open = lob_set(lob_new(),"type","sim");
+  chan_t chan = link_chan(link, open);
+  fail_unless(chan_reliable(chan, 0));
+  fail_unless(chan_send(chan, open));
+  for(i=0;i<PACKETS;i++)
+  {
+    lob_t packet = chan_packet(chan);
+    lob_set_uint(packet,"n",i);
+    lob_body(packet,payload,PAYLOAD);
+    fail_unless(chan_send(chan, packet));
+  }
+  while(received < PACKETS && net_sim_now(sim) < 100000) net_sim_step(sim, 100000);
+  done = net_sim_now(sim);
+  fail_unless(received == PACKETS);
+  fail_unless(misordered == 0);
+
+  if(ab) memcpy(ab,&pair->ab,sizeof(struct net_sim_path_struct));
+  if(ba) memcpy(ba,&pair->ba,sizeof(struct net_sim_path_struct));
+  mesh_free(meshA);
+  mesh_free(meshB);
+  net_sim_free(sim);
+  return done;
+}
+
+int main(int argc, char **argv)
+{
+  struct net_sim_path_struct ab, ba, ab2, ba2;
+  uint32_t up, done, again;
+
+  fail_unless(!e3x_init(NULL));
+
+  // nothing in the way, the clock only moves as far as it must
+  done = transfer(1, NULL, &ab, &ba, &up);
+  fail_unless(up < 5);
+  fail_unless(ba.sent >= PACKETS && ba.delivered == ba.sent);
+  fail_unless(!ba.lost && !ba.duplicated && !ba.reordered && !ba.overflowed);
+
+  // the handshake takes a round trip, and the first packet at least the latency after that
+  lob_t options = lob_set_uint(lob_new(),"latency",20);
+  done = transfer(1, options, NULL, NULL, &up);
+  fail_unless(up >= 40 && up < 60);
+  fail_unless(first >= up + 20);
+  lob_free(options);
+
+  // a bandwidth limit spaces them out, a small queue drops the rest (and they're resent)
+  options = lob_set_uint(lob_set_uint(lob_set_uint(lob_new(),"latency",5),"bandwidth",1000),"queue",5000);
+  done = transfer(1, options, NULL, &ba, NULL);
+  fail_unless(done > (PACKETS * PAYLOAD) / 1000);
+  fail_unless(ba.delivered == ba.sent - ba.overflowed);
+  lob_free(options);
+
+  // loss, duplicates and reordering are all counted and the channel still gets everything in order
+  options = lob_set_uint(lob_set_uint(lob_set_uint(lob_set_uint(lob_set_uint(lob_new(),"latency",10),"jitter",5),"loss",10),"duplicate",10),"reorder",10);
+  done = transfer(42, options, &ab, &ba, NULL);
+  LOG("lossy done at %u, sent %u lost %u duplicated %u reordered %u",done,ba.sent,ba.lost,ba.duplicated,ba.reordered);
+  fail_unless(ba.lost && ba.duplicated && ba.reordered);
+  fail_unless(ba.sent > PACKETS);
+  fail_unless(ba.delivered == ba.sent - ba.lost + ba.duplicated);
+
+  // the same seed plays out exactly the same
+  again = transfer(42, options, &ab2, &ba2, NULL);
+  fail_unless(again == done);
+  fail_unless(ba2.sent == ba.sent && ba2.lost == ba.lost && ba2.duplicated == ba.duplicated && ba2.reordered == ba.reordered);
+  fail_unless(ab2.sent == ab.sent && ab2.delivered == ab.delivered);
+
+  // and a different one doesn't
+  transfer(43, options, NULL, &ba2, NULL);
+  fail_unless(ba2.sent != ba.sent || ba2.lost != ba.lost || ba2.reordered != ba.reordered);
+  lob_free(options);
+
+  // never past until, even when there's nothing to do
+  sim = net_sim_new(1);
+  fail_unless(net_sim_step(sim, 10) == 10);
+  fail_unless(net_sim_step(sim, 10) == 10);
+  fail_unless(net_sim_step(sim, 5) == 10);
+  fail_unless(net_sim_run(sim, 20) && net_sim_now(sim) == 20);
+  net_sim_free(sim);
+
+  return 0;
+}
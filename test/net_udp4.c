@@ -1,7 +1,40 @@
+#include <unistd.h>
 #include "net_udp4.h"
 #include "util_sys.h"
 #include "unit_test.h"
 
+int bigs = 0;
+lob_t big_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","big")) return open;
+  if(open->body_len == 1000) bigs++;
+  lob_free(open);
+  return NULL;
+}
+
+// a reliable channel's packets, in order
+uint32_t paced = 0, misordered = 0;
+void paced_handler(chan_t chan, void *arg)
+{
+  lob_t packet;
+  while((packet = chan_receiving(chan)))
+  {
+    if(lob_get(packet,"n") && lob_get_uint(packet,"n") != paced++) misordered++;
+    lob_free(packet);
+  }
+}
+
+lob_t paced_on_open(link_t link, lob_t open)
+{
+  if(lob_get_cmp(open,"type","paced")) return open;
+  chan_t chan = link_chan(link, open);
+  fail_unless(chan && chan->window);
+  chan_handle(chan,paced_handler,NULL);
+  chan_receive(chan,open);
+  chan_process(chan,0);
+  return NULL;
+}
+
 int main(int argc, char **argv)
 {
   mesh_t meshA = mesh_new();
@@ -18,7 +51,10 @@ int main(int argc, char **argv)
   fail_unless(netA);
   fail_unless(net_udp4_socket(netA) > 0);
 
-  net_udp4_t netB = net_udp4_new(meshB, NULL);
+  // one side w/o batching, both paths have to interoperate
+  lob_t options = lob_set_raw(lob_new(),"batch",0,"false",5);
+  net_udp4_t netB = net_udp4_new(meshB, options);
+  lob_free(options);
   fail_unless(netB);
   fail_unless(net_udp4_socket(netA) > 0);
   
@@ -40,6 +76,107 @@ int main(int argc, char **argv)
   fail_unless(i);
   LOG_DEBUG("done in %d loops",32-i);
 
+  // large datagram mode, a packet bigger than a frame goes through whole
+  lob_t big = lob_set_uint(lob_new(),"mtu",1472);
+  mesh_t meshC = mesh_new();
+  lob_free(mesh_generate(meshC));
+  mesh_t meshD = mesh_new();
+  lob_free(mesh_generate(meshD));
+  mesh_on_open(meshD, "big", big_on_open);
+  net_udp4_t netC = net_udp4_new(meshC, big);
+  net_udp4_t netD = net_udp4_new(meshD, big);
+  lob_free(big);
+  fail_unless(netC && netD);
+  link_t linkCD = link_get_keys(meshC, meshD->keys);
+  link_t linkDC = link_get_keys(meshD, meshC->keys);
+  net_udp4_direct(netC,link_handshake(linkCD),"127.0.0.1",net_udp4_port(netD));
+  for(i=32;i && !(link_up(linkCD) && link_up(linkDC));i--)
+  {
+    net_udp4_process(netC);
+    net_udp4_process(netD);
+  }
+  fail_unless(i);
+
+  big = lob_set(lob_new(),"type","big");
+  lob_body(big,NULL,1000);
+  fail_unless(link_direct(linkCD,big));
+  for(i=8;i && !bigs;i--)
+  {
+    net_udp4_process(netC);
+    net_udp4_process(netD);
+  }
+  fail_unless(bigs == 1);
+
+  // w/ a ms clock (5 a round here) the rtt is measurable and sends are paced, while the channel timeouts stay on seconds,
+  // it starts just short of wrapping and keeps going across it
+  uint32_t ms = UINT32_MAX - 500, n;
+  mesh_on_open(meshD, "paced", paced_on_open);
+  lob_t open = lob_set(lob_new(),"type","paced");
+  chan_t chan = link_chan(linkCD, open);
+  fail_unless(chan_reliable(chan, 0));
+  fail_unless(chan_send(chan, open));
+  for(n=0;n<200;n++)
+  {
+    lob_t packet = chan_packet(chan);
+    lob_set_uint(packet,"n",n);
+    lob_body(packet,NULL,1000);
+    fail_unless(chan_send(chan, packet));
+  }
+  for(i=2000;i && (paced < 200 || chan->out);i--)
+  {
+    ms += 5;
+    fail_unless(mesh_clock(meshC, ms) && mesh_clock(meshD, ms));
+    if(mesh_due(meshC)) mesh_process(meshC, util_sys_seconds());
+    if(mesh_due(meshD)) mesh_process(meshD, util_sys_seconds());
+    net_udp4_process(netC);
+    net_udp4_process(netD);
+  }
+  fail_unless(i);
+  fail_unless(paced == 200 && !misordered);
+  LOG_DEBUG("paced %u times, rtt %u cwnd %u",linkCD->paced,linkCD->cc.srtt/8,linkCD->cc.cwnd);
+  fail_unless(linkCD->cc.samples && linkCD->cc.srtt >= 8);
+  fail_unless(linkCD->paced);
+  fail_unless(ms < 1000 && link_now(linkCD) == ms && !mesh_clock_due(meshC));
+
+  // flood from many source addresses, the oldest are evicted and a real peer still gets through
+  lob_t limit = lob_set_uint(lob_new(),"pipes",64);
+  mesh_t meshE = mesh_new();
+  lob_free(mesh_generate(meshE));
+  net_udp4_t netE = net_udp4_new(meshE, limit);
+  lob_free(limit);
+  fail_unless(netE);
+  struct sockaddr_in sa;
+  memset(&sa,0,sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  sa.sin_port = htons(net_udp4_port(netE));
+  uint8_t junk[128];
+  memset(junk,0,sizeof(junk));
+  for(i=0;i<500;i++)
+  {
+    int sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    fail_unless(sock >= 0);
+    fail_unless(sendto(sock, junk, sizeof(junk), 0, (struct sockaddr *)&sa, sizeof(sa)) == sizeof(junk));
+    close(sock);
+    if(i % 50 == 49) net_udp4_process(netE);
+  }
+  net_udp4_process(netE);
+  fail_unless(net_udp4_pipes(netE) == 64);
+
+  mesh_t meshF = mesh_new();
+  lob_free(mesh_generate(meshF));
+  net_udp4_t netF = net_udp4_new(meshF, NULL);
+  link_t linkFE = link_get_keys(meshF, meshE->keys);
+  link_t linkEF = link_get_keys(meshE, meshF->keys);
+  net_udp4_direct(netF,link_handshake(linkFE),"127.0.0.1",net_udp4_port(netE));
+  for(i=32;i && !(link_up(linkFE) && link_up(linkEF));i--)
+  {
+    net_udp4_process(netF);
+    net_udp4_process(netE);
+  }
+  fail_unless(i);
+  fail_unless(net_udp4_pipes(netE) == 64);
+
   return 0;
 }
 
@@ -4,10 +4,13 @@
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <unistd.h>
 
 #include "mesh.h"
 #include "util_unix.h"
 #include "net_udp4.h"
+#include "net_loop.h"
+#include "net_shard.h"
 #include "ext.h"
 
 int main(int argc, char *argv[])
@@ -15,15 +18,41 @@ int main(int argc, char *argv[])
   lob_t id, options, json;
   mesh_t mesh;
   net_udp4_t udp4;
-  int port = 0;
+  int port = 0, threads = 1; // 0 is one per core
 
-  if(argc==2)
+  if(argc>=2)
   {
     port = atoi(argv[1]);
   }
+  if(argc>=3)
+  {
+    threads = atoi(argv[2]);
+  }
 
   id = util_fjson("id.json");
   if(!id) return -1;
+
+#if defined(__linux__)
+  // several threads all serving the same port
+  if(threads != 1)
+  {
+    uint32_t i;
+    options = lob_new();
+    lob_set_int(options,"port",port);
+    lob_set_int(options,"threads",threads);
+    net_shards_t shards = net_shards_new(lob_get_json(id,"secrets"),lob_get_json(id,"keys"),options);
+    if(!shards) return -1;
+    for(i=0;i<net_shards_count(shards);i++) mesh_on_discover(net_shards_mesh(shards,i),"auto",mesh_add);
+
+    json = mesh_json(net_shards_mesh(shards,0));
+    lob_set_int(json,"port",net_shards_port(shards));
+    printf("%s\n",lob_json(json));
+    fflush(stdout);
+
+    net_shards_start(shards);
+    while(1) pause();
+  }
+#endif
   
   mesh = mesh_new();
   mesh_load(mesh,lob_get_json(id,"secrets"),lob_get_json(id,"keys"));
@@ -33,12 +62,21 @@ int main(int argc, char *argv[])
   lob_set_int(options,"port",port);
 
   udp4 = net_udp4_new(mesh, options);
+#if defined(__linux__)
+  net_loop_t loop = net_loop_new(mesh, NULL);
+  net_loop_udp4(loop, udp4);
+#else
   util_sock_timeout(net_udp4_socket(udp4),100);
+#endif
 
   json = mesh_json(mesh);
   printf("%s\n",lob_json(json));
 
+#if defined(__linux__)
+  while(net_loop_run(loop, -1));
+#else
   while(net_udp4_process(udp4));
+#endif
 
   /*
   if(util_loadjson(s) != 0 || (sock = util_server(0,1000)) <= 0)